@@ -68,6 +68,8 @@ FLUID_DEPRECATED FLUIDSYNTH_API const char *fluid_synth_error(fluid_synth_t *syn
  */
 FLUIDSYNTH_API int fluid_synth_noteon(fluid_synth_t *synth, int chan, int key, int vel);
 FLUIDSYNTH_API int fluid_synth_noteoff(fluid_synth_t *synth, int chan, int key);
+FLUIDSYNTH_API int fluid_synth_noteon_at(fluid_synth_t *synth, int frame_offset, int chan, int key, int vel);
+FLUIDSYNTH_API int fluid_synth_noteoff_at(fluid_synth_t *synth, int frame_offset, int chan, int key);
 FLUIDSYNTH_API int fluid_synth_cc(fluid_synth_t *synth, int chan, int ctrl, int val);
 FLUIDSYNTH_API int fluid_synth_get_cc(fluid_synth_t *synth, int chan, int ctrl, int *pval);
 FLUIDSYNTH_API int fluid_synth_sysex(fluid_synth_t *synth, const char *data, int len,
@@ -177,6 +179,9 @@ FLUIDSYNTH_API int fluid_synth_set_reverb_group_roomsize(fluid_synth_t *synth, i
 FLUIDSYNTH_API int fluid_synth_set_reverb_group_damp(fluid_synth_t *synth, int fx_group, double damping);
 FLUIDSYNTH_API int fluid_synth_set_reverb_group_width(fluid_synth_t *synth, int fx_group, double width);
 FLUIDSYNTH_API int fluid_synth_set_reverb_group_level(fluid_synth_t *synth, int fx_group, double level);
+FLUIDSYNTH_API int fluid_synth_set_reverb_group_impulse_response(fluid_synth_t *synth, int fx_group, const char *filename);
+FLUIDSYNTH_API int fluid_synth_set_reverb_group_impulse_response_data(fluid_synth_t *synth, int fx_group,
+        const float *left, const float *right, int frames, double sample_rate);
 
 FLUIDSYNTH_API int fluid_synth_get_reverb_group_roomsize(fluid_synth_t *synth, int fx_group, double *roomsize);
 FLUIDSYNTH_API int fluid_synth_get_reverb_group_damp(fluid_synth_t *synth, int fx_group, double *damping);
@@ -234,6 +239,60 @@ FLUIDSYNTH_API int fluid_synth_get_chorus_group_depth(fluid_synth_t *synth, int
 FLUIDSYNTH_API int fluid_synth_get_chorus_group_type(fluid_synth_t *synth, int fx_group, int *type);
 /** @} Chorus */
 
+
+/**
+ * @defgroup insert_effects Effect - Insert Effects
+ * @ingroup synth
+ *
+ * Functions for configuring the built-in insert effects: an equalizer, a compressor
+ * and a limiter, in this order, on the stereo output of every audio group and of
+ * the reverb and chorus of every fx group. All of them are off by default.
+ *
+ * @{
+ */
+
+/**
+ * Where the insert effects are, see fluid_synth_set_insert_fx_param().
+ */
+enum fluid_insert_fx_target
+{
+    FLUID_INSERT_FX_AUDIO_GROUP,  /**< The stereo output of an audio group (see synth.audio-groups), after the reverb and chorus have been mixed into it */
+    FLUID_INSERT_FX_EFFECTS_GROUP /**< The stereo outputs of the reverb and chorus of an fx group (see synth.effects-groups), before they are mixed into the output of an audio group */
+};
+
+/**
+ * Parameters of the insert effects. Frequencies are in Hz, gains, thresholds and ceilings
+ * in dB, times in ms. Each parameter has a setting of the same name that applies to all
+ * audio groups, e.g. synth.limiter.ceiling for #FLUID_INSERT_LIMITER_CEILING.
+ */
+enum fluid_insert_fx_param
+{
+    FLUID_INSERT_EQ_ACTIVE,             /**< Equalizer on (1) or off (0) */
+    FLUID_INSERT_EQ_LOW_FREQ,           /**< Corner frequency of the low shelf */
+    FLUID_INSERT_EQ_LOW_GAIN,           /**< Gain of the low shelf */
+    FLUID_INSERT_EQ_MID_FREQ,           /**< Center frequency of the peaking band */
+    FLUID_INSERT_EQ_MID_GAIN,           /**< Gain of the peaking band */
+    FLUID_INSERT_EQ_MID_Q,              /**< Q of the peaking band */
+    FLUID_INSERT_EQ_HIGH_FREQ,          /**< Corner frequency of the high shelf */
+    FLUID_INSERT_EQ_HIGH_GAIN,          /**< Gain of the high shelf */
+    FLUID_INSERT_COMPRESSOR_ACTIVE,     /**< Compressor on (1) or off (0) */
+    FLUID_INSERT_COMPRESSOR_THRESHOLD,  /**< Level above which the compressor reduces the gain */
+    FLUID_INSERT_COMPRESSOR_RATIO,      /**< Compression ratio above the threshold */
+    FLUID_INSERT_COMPRESSOR_ATTACK,     /**< Attack time of the level detector */
+    FLUID_INSERT_COMPRESSOR_RELEASE,    /**< Release time of the level detector */
+    FLUID_INSERT_COMPRESSOR_MAKEUP,     /**< Gain added after the compression */
+    FLUID_INSERT_COMPRESSOR_RMS,        /**< Level detector on the RMS (1) or the peak (0) level */
+    FLUID_INSERT_LIMITER_ACTIVE,        /**< Limiter on (1) or off (0) */
+    FLUID_INSERT_LIMITER_CEILING,       /**< Level the output of the limiter never exceeds */
+    FLUID_INSERT_LIMITER_LOOKAHEAD,     /**< Lookahead time of the limiter, i.e. the latency it adds */
+    FLUID_INSERT_LIMITER_RELEASE,       /**< Release time of the limiter */
+    FLUID_INSERT_FX_PARAM_LAST          /**< @internal Value defines the count of insert effects parameters (#fluid_insert_fx_param) @warning This symbol is not part of the public API and ABI stability guarantee and may change at any time! */
+};
+
+FLUIDSYNTH_API int fluid_synth_set_insert_fx_param(fluid_synth_t *synth, int target, int index, int param, double value);
+FLUIDSYNTH_API int fluid_synth_get_insert_fx_param(fluid_synth_t *synth, int target, int index, int param, double *value);
+/** @} Insert Effects */
+
 /**
  * @defgroup synthesis_params Synthesis Parameters
  * @ingroup synth
@@ -363,6 +422,9 @@ FLUID_DEPRECATED FLUIDSYNTH_API int fluid_synth_nwrite_float(fluid_synth_t *synt
 FLUIDSYNTH_API int fluid_synth_process(fluid_synth_t *synth, int len,
                                        int nfx, float *fx[],
                                        int nout, float *out[]);
+FLUIDSYNTH_API int fluid_synth_get_silent_buffers(fluid_synth_t *synth,
+        int nfx, int fx_silent[],
+        int nout, int out_silent[]);
 /** @} Audio Rendering */
 
 
@@ -24,6 +24,7 @@
 #include "fluid_midi_router.h"
 #include "fluid_sfont.h"
 #include "fluid_chan.h"
+#include "fluid_insertfx.h"
 
 /* FIXME: LADSPA used to need a lot of parameters on a single line. This is not
  * necessary anymore, so the limits below could probably be reduced */
@@ -254,6 +255,17 @@ static const fluid_cmd_t fluid_commands[] =
         "sleep", "general", fluid_handle_sleep,
         "sleep  duration            sleep duration (in ms)"
     },
+    /* insert effects commands */
+    {
+        "insert_set", "insert", fluid_handle_insert_set,
+        "insert_set audio|fx num|all param value\n"
+        "                           Set an insert effect parameter of an audio or effects group"
+    },
+    {
+        "insert_get", "insert", fluid_handle_insert_get,
+        "insert_get audio|fx num [param]\n"
+        "                           Print one or all insert effect parameters of an audio or effects group"
+    },
     /* LADSPA-related commands */
 #ifdef LADSPA
     {
@@ -1124,6 +1136,154 @@ fluid_handle_sleep(void *data, int ac, char **av, fluid_ostream_t out)
     return 0;
 }
 
+/* Purpose:
+ * Parses the target of the insert effect commands: 'audio' selects the
+ * audio groups, 'fx' the effects groups.
+ */
+static int
+fluid_parse_insert_target(const char *name)
+{
+    if(FLUID_STRCMP(name, "audio") == 0)
+    {
+        return FLUID_INSERT_FX_AUDIO_GROUP;
+    }
+
+    if(FLUID_STRCMP(name, "fx") == 0)
+    {
+        return FLUID_INSERT_FX_EFFECTS_GROUP;
+    }
+
+    return -1;
+}
+
+/* Purpose:
+ * Response to 'insert_set' command.
+ * insert_set audio|fx num|all param value
+ */
+int
+fluid_handle_insert_set(void *data, int ac, char **av, fluid_ostream_t out)
+{
+    FLUID_ENTRY_COMMAND(data);
+    int target, index, param;
+    double min, max;
+
+    if(ac < 4)
+    {
+        fluid_ostream_printf(out, "insert_set: too few arguments.\n");
+        return FLUID_FAILED;
+    }
+
+    target = fluid_parse_insert_target(av[0]);
+
+    if(target < 0)
+    {
+        fluid_ostream_printf(out, "insert_set: target should be 'audio' or 'fx'.\n");
+        return FLUID_FAILED;
+    }
+
+    if(FLUID_STRCMP(av[1], "all") == 0)
+    {
+        index = -1;
+    }
+    else if(fluid_is_number(av[1]))
+    {
+        index = atoi(av[1]);
+    }
+    else
+    {
+        fluid_ostream_printf(out, "insert_set: invalid group number.\n");
+        return FLUID_FAILED;
+    }
+
+    param = fluid_insertfx_param_index(av[2]);
+
+    if(param < 0)
+    {
+        fluid_ostream_printf(out, "insert_set: unknown parameter '%s'.\n", av[2]);
+        return FLUID_FAILED;
+    }
+
+    if(!fluid_is_number(av[3]))
+    {
+        fluid_ostream_printf(out, "insert_set: invalid value.\n");
+        return FLUID_FAILED;
+    }
+
+    if(fluid_synth_set_insert_fx_param(handler->synth, target, index, param, atof(av[3])) != FLUID_OK)
+    {
+        fluid_insertfx_param_info(param, NULL, NULL, &min, &max, NULL);
+        fluid_ostream_printf(out, "insert_set: invalid group number, or value not in range %g..%g.\n",
+                             min, max);
+        return FLUID_FAILED;
+    }
+
+    return FLUID_OK;
+}
+
+/* Purpose:
+ * Response to 'insert_get' command.
+ * insert_get audio|fx num [param]
+ */
+int
+fluid_handle_insert_get(void *data, int ac, char **av, fluid_ostream_t out)
+{
+    FLUID_ENTRY_COMMAND(data);
+    int target, index, param, first, last;
+    const char *name;
+    double value;
+
+    if(ac < 2)
+    {
+        fluid_ostream_printf(out, "insert_get: too few arguments.\n");
+        return FLUID_FAILED;
+    }
+
+    target = fluid_parse_insert_target(av[0]);
+
+    if(target < 0)
+    {
+        fluid_ostream_printf(out, "insert_get: target should be 'audio' or 'fx'.\n");
+        return FLUID_FAILED;
+    }
+
+    if(!fluid_is_number(av[1]))
+    {
+        fluid_ostream_printf(out, "insert_get: invalid group number.\n");
+        return FLUID_FAILED;
+    }
+
+    index = atoi(av[1]);
+
+    /* without a parameter name all of them are printed */
+    first = 0;
+    last = FLUID_INSERT_FX_PARAM_LAST - 1;
+
+    if(ac > 2)
+    {
+        first = last = fluid_insertfx_param_index(av[2]);
+
+        if(first < 0)
+        {
+            fluid_ostream_printf(out, "insert_get: unknown parameter '%s'.\n", av[2]);
+            return FLUID_FAILED;
+        }
+    }
+
+    for(param = first; param <= last; param++)
+    {
+        if(fluid_synth_get_insert_fx_param(handler->synth, target, index, param, &value) != FLUID_OK)
+        {
+            fluid_ostream_printf(out, "insert_get: invalid group number.\n");
+            return FLUID_FAILED;
+        }
+
+        fluid_insertfx_param_info(param, &name, NULL, NULL, NULL, NULL);
+        fluid_ostream_printf(out, "%-22s %g\n", name, value);
+    }
+
+    return FLUID_OK;
+}
+
 int
 fluid_handle_source(void *data, int ac, char **av, fluid_ostream_t out)
 {
@@ -1334,6 +1334,8 @@ fluid_alsa_seq_run(void *d)
     fluid_midi_event_t evt;
     fluid_alsa_seq_driver_t *dev = (fluid_alsa_seq_driver_t *) d;
 
+    evt.frame_offset = 0;
+
     /* go into a loop until someone tells us to stop */
     while(!fluid_atomic_int_get(&dev->should_quit))
     {
@@ -682,7 +682,7 @@ fluid_jack_driver_process(jack_nframes_t nframes, void *arg)
     fluid_jack_audio_driver_t *audio_driver;
     fluid_jack_midi_driver_t *midi_driver;
     float *left, *right;
-    int i;
+    int i, timed;
 
     jack_midi_event_t midi_event;
     fluid_midi_event_t *evt;
@@ -693,6 +693,11 @@ fluid_jack_driver_process(jack_nframes_t nframes, void *arg)
 
     /* Process MIDI events first, so that they take effect before audio synthesis */
     midi_driver = fluid_atomic_pointer_get(&client->midi_driver);
+    audio_driver = fluid_atomic_pointer_get(&client->audio_driver);
+
+    /* If the synth renders this very period, let the events take effect at
+     * the frame they have been received at, see fluid_synth_noteon_at() */
+    timed = (audio_driver != NULL && audio_driver->callback == NULL);
 
     if(midi_driver)
     {
@@ -719,6 +724,7 @@ fluid_jack_driver_process(jack_nframes_t nframes, void *arg)
                     if(evt != NULL)
                     {
                         fluid_midi_event_set_channel(evt, fluid_midi_event_get_channel(evt) + i * 16);
+                        evt->frame_offset = timed ? midi_event.time : 0;
                         midi_driver->driver.handler(midi_driver->driver.data, evt);
                     }
                 }
@@ -726,8 +732,6 @@ fluid_jack_driver_process(jack_nframes_t nframes, void *arg)
         }
     }
 
-    audio_driver = fluid_atomic_pointer_get(&client->audio_driver);
-
     if(audio_driver == NULL)
     {
         // shutting down
@@ -216,6 +216,7 @@ static void fluid_midishare_keyoff_task(long date, short ref, long a1, long a2,
     fluid_midi_event_t new_event;
     MidiEvPtr e = (MidiEvPtr)a1;
 
+    new_event.frame_offset = 0;
     fluid_midi_event_set_type(&new_event, NOTE_OFF);
     fluid_midi_event_set_channel(&new_event, Chan(e));
     fluid_midi_event_set_pitch(&new_event, Pitch(e));
@@ -238,6 +239,8 @@ static void fluid_midishare_midi_driver_receive(short ref)
     MidiEvPtr e;
     int count, i;
 
+    new_event.frame_offset = 0;
+
     while((e = MidiGetEv(ref)))
     {
         switch(EvType(e))
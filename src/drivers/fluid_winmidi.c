@@ -144,6 +144,8 @@ fluid_winmidi_callback(HMIDIIN hmi, UINT wMsg, DWORD_PTR dwInstance,
     unsigned char *data;
     unsigned int msg_param = (unsigned int) dwParam1;
 
+    event.frame_offset = 0;
+
     switch(wMsg)
     {
     case MIM_OPEN:
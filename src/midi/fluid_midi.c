@@ -1078,6 +1078,7 @@ new_fluid_midi_event(void)
     }
 
     evt->dtime = 0;
+    evt->frame_offset = 0;
     evt->type = 0;
     evt->channel = 0;
     evt->param1 = 0;
@@ -2133,6 +2134,7 @@ fluid_player_callback(void *data, unsigned int msec)
     loadnextfile = player->currentfile == NULL ? 1 : 0;
     
     fluid_midi_event_set_type(&mute_event, CONTROL_CHANGE);
+    mute_event.frame_offset = 0;
     mute_event.param1 = ALL_SOUND_OFF;
     mute_event.param2 = 1;
 
@@ -2715,6 +2717,7 @@ new_fluid_midi_parser(void)
     }
 
     parser->status = 0; /* As long as the status is 0, the parser won't do anything -> no need to initialize all the fields. */
+    parser->event.frame_offset = 0;
     return parser;
 }
 
@@ -851,6 +851,7 @@ send_event:
         fluid_midi_event_set_channel(&new_event, chan);
         new_event.param1 = par1;
         new_event.param2 = par2;
+        new_event.frame_offset = event->frame_offset;
 
         /* On failure, continue to process events, but return failure to caller. */
         if(router->event_handler(router->event_handler_data, &new_event) != FLUID_OK)
@@ -161,6 +161,18 @@
 //#define INTERP_SAMPLES_NBR 0
 #define INTERP_SAMPLES_NBR 1
 
+/*
+ Number of samples processed at once by the vectorized process (see
+ fluid_chorus_process_vector()). The delay line is made longer by this
+ amount, so that the input of a whole chunk can be pushed before the chunk
+ is read.
+*/
+#define CHORUS_CHUNK 64
+
+/* maximum number of samples read by the blocks between two updates of the
+   modulators in the vectorized process (longer runs are split) */
+#define CHORUS_RUN 8
+
 
 /*-----------------------------------------------------------------------------
  Sinusoidal modulator
@@ -231,6 +243,13 @@ struct _fluid_chorus_t
 
     /* modulator member */
     modulator mod[MAX_CHORUS]; /* sinus/triangle modulator */
+
+    int cpu_isa; /* instruction set level of the chorus kernel, see fluid_chorus_set_cpu_isa() */
+
+#if FLUID_CPU_DISPATCH
+    /* scratch buffer of the vectorized process: samples read by the blocks, one column per block */
+    fluid_real_t tap[CHORUS_RUN + 1][MAX_CHORUS];
+#endif
 };
 
 /*-----------------------------------------------------------------------------
@@ -566,7 +585,8 @@ static void update_parameters_from_sample_rate(fluid_chorus_t *chorus)
 
  Sets the length line ( alloc delay samples).
  Remark: the function sets the internal size according to the length delay_length.
- The size is augmented by INTERP_SAMPLES_NBR to take account of interpolation.
+ The size is augmented by INTERP_SAMPLES_NBR to take account of interpolation,
+ and by CHORUS_CHUNK for the vectorized process.
 
  @param chorus, pointer on chorus unit.
  @param delay_length the length of the delay line in samples.
@@ -587,8 +607,8 @@ static int new_mod_delay_line(fluid_chorus_t *chorus, int delay_length)
     /*-----------------------------------------------------------------------
      allocates delay_line and initialize members: - line, size, line_in...
     */
-    /* total size of the line:  size = INTERP_SAMPLES_NBR + delay_length */
-    chorus->size = delay_length + INTERP_SAMPLES_NBR;
+    /* total size of the line:  size = INTERP_SAMPLES_NBR + delay_length + CHORUS_CHUNK */
+    chorus->size = delay_length + INTERP_SAMPLES_NBR + CHORUS_CHUNK;
     chorus->line = FLUID_ARRAY(fluid_real_t, chorus->size);
 
     if(! chorus->line)
@@ -645,6 +665,7 @@ new_fluid_chorus(fluid_real_t sample_rate)
     FLUID_MEMSET(chorus, 0, sizeof(fluid_chorus_t));
 
     chorus->sample_rate = sample_rate;
+    chorus->cpu_isa = FLUID_CPU_ISA_GENERIC;
 
 #ifdef DEBUG_PRINT
     printf("fluid_chorus_t:%d bytes\n", sizeof(fluid_chorus_t));
@@ -924,22 +945,414 @@ fluid_chorus_samplerate_change(fluid_chorus_t *chorus, fluid_real_t sample_rate)
     update_parameters_from_sample_rate(chorus);
 }
 
+/*
+* Selects the instruction set level of the chorus kernel. At FLUID_CPU_ISA_GENERIC,
+* the scalar loops of fluid_chorus_processmix() and fluid_chorus_processreplace()
+* are used, they are the reference implementation. Above, the vectorized kernel
+* compiled for that level is used, see fluid_chorus_process_vector().
+*
+* @param chorus pointer on the chorus.
+* @param cpu_isa One of #fluid_cpu_isa, must be supported by the CPU.
+*/
+void
+fluid_chorus_set_cpu_isa(fluid_chorus_t *chorus, int cpu_isa)
+{
+    fluid_return_if_fail(chorus != NULL);
+
+    chorus->cpu_isa = cpu_isa;
+}
+
+/*
+* Returns an upper bound of the level the chorus outputs when it gets no more
+* input, from the samples left in its delay line and interpolators.
+*
+* @param chorus pointer on the chorus.
+* @return the level bound (1.0 being full scale).
+*/
+fluid_real_t
+fluid_chorus_get_tail_level(fluid_chorus_t *chorus)
+{
+    const fluid_real_t *line;
+    fluid_real_t peak = 0, buffer = 0;
+    int i;
+
+    fluid_return_val_if_fail(chorus != NULL, 0);
+
+    line = chorus->line;
+
+    #pragma omp simd reduction(max:peak)
+    for(i = 0; i < chorus->size; i++)
+    {
+        fluid_real_t v = FLUID_FABS(line[i]);
+        peak = (v > peak) ? v : peak;
+    }
+
+    for(i = 0; i < chorus->number_blocks; i++)
+    {
+        if(FLUID_FABS(chorus->mod[i].buffer) > buffer)
+        {
+            buffer = FLUID_FABS(chorus->mod[i].buffer);
+        }
+    }
+
+    /* an interpolator outputs at most 2 line samples plus its buffer, a stereo
+       input sums at most number_blocks + 1 of them (see the odd number_blocks
+       adjustment) */
+    return (2 * peak + buffer) * (chorus->number_blocks + 1)
+           * (FLUID_FABS(chorus->wet1) + FLUID_FABS(chorus->wet2));
+}
+
+/*
+* Returns the number of samples after which all the samples in the delay line
+* of the chorus have been read out, i.e. the length of the tail if the chorus
+* gets no more input.
+*
+* @param chorus pointer on the chorus.
+* @return the number of samples.
+*/
+int
+fluid_chorus_get_tail_length(fluid_chorus_t *chorus)
+{
+    fluid_return_val_if_fail(chorus != NULL, 0);
+
+    return chorus->size;
+}
+
+#if FLUID_CPU_DISPATCH
+/*-----------------------------------------------------------------------------
+ Vectorized chorus process.
+
+ Same algorithm as the scalar loops of fluid_chorus_processmix() and
+ fluid_chorus_processreplace(), with one chorus block per vector lane. The
+ blocks are put in lanes in the order of the stereo unit inputs they feed:
+ even blocks first, then odd blocks.
+
+ The samples are processed by chunks of at most CHORUS_CHUNK samples:
+ - the input of the chunk is pushed into the delay line first. The line is
+   CHORUS_CHUNK samples longer than the longest delay, so this doesn't
+   overwrite any sample read by the chunk. The newest sample read by a block
+   is the one pushed just before, except when the interpolator reads one
+   sample further with a null fractional part.
+ - the modulators of all blocks are updated on the same sample, so the chunk
+   is cut into runs of at most mod_rate samples. At the start of a run the
+   modulators and read positions of all blocks are updated side by side.
+   Within a run, the read position of every block moves by one sample per
+   sample: the samples read by the blocks are copied into tap[], one column
+   per block (gather), then the all-pass interpolators of all blocks run side
+   by side on the rows of tap[], and their outputs are summed into the stereo
+   unit inputs.
+ The result only differs by the rounding of fused multiply-adds and of the
+ sums.
+
+ @param mix TRUE to mix the output into left_out and right_out, FALSE to
+  replace it.
+-----------------------------------------------------------------------------*/
+static FLUID_INLINE void
+fluid_chorus_process_vector_generic(fluid_chorus_t *chorus, const fluid_real_t *in,
+                                    fluid_real_t *left_out, fluid_real_t *right_out,
+                                    int count, int mix)
+{
+    /* modulators and interpolators members, one lane per block */
+    double a1[MAX_CHORUS], buffer1[MAX_CHORUS], buffer2[MAX_CHORUS], reset_buffer2[MAX_CHORUS];
+    fluid_real_t val[MAX_CHORUS], inc[MAX_CHORUS];
+    fluid_real_t mod_value[MAX_CHORUS], frac_pos_mod[MAX_CHORUS], buffer[MAX_CHORUS];
+    int line_out[MAX_CHORUS];
+    fluid_real_t d_out[2][CHORUS_CHUNK];   /* stereo unit input */
+    const fluid_real_t *line = chorus->line;
+    const fluid_real_t wet1 = chorus->wet1, wet2 = chorus->wet2;
+    const int nr = chorus->number_blocks;
+    const int nr_even = (nr + 1) / 2; /* number of even blocks, in lanes 0 to nr_even - 1 */
+    const int size = chorus->size;
+    const int mod_depth = chorus->mod_depth;
+    const int sine = (chorus->type == FLUID_CHORUS_MOD_SINE);
+    int k, n, t, r, i, j;
+
+    for(i = 0; i < nr; i++)
+    {
+        const modulator *mod = &chorus->mod[i];
+        int c = (i & 1) ? nr_even + i / 2 : i / 2;
+
+        a1[c] = mod->sinus.a1;
+        buffer1[c] = mod->sinus.buffer1;
+        buffer2[c] = mod->sinus.buffer2;
+        reset_buffer2[c] = mod->sinus.reset_buffer2;
+        val[c] = mod->triang.val;
+        inc[c] = mod->triang.inc;
+        line_out[c] = mod->line_out;
+        frac_pos_mod[c] = mod->frac_pos_mod;
+        buffer[c] = mod->buffer;
+    }
+
+    for(k = 0; k < count; k += n)
+    {
+        n = count - k;
+
+        if(n > CHORUS_CHUNK)
+        {
+            n = CHORUS_CHUNK;
+        }
+
+        /* Write the input of the chunk into the circular buffer.
+         * Note that 'in' may be aliased with 'left_out', this must be done
+         * before processing the stereo unit.
+         */
+        for(t = 0; t < n; t++)
+        {
+            push_in_delay_line(chorus, in[k + t]);
+        }
+
+        /* foreach run of samples sharing the same modulators values */
+        for(t = 0; t < n; t += r)
+        {
+            if(++chorus->index_rate >= chorus->mod_rate)
+            {
+                const fluid_real_t center_pos_mod = chorus->center_pos_mod;
+
+                /* same as the modulator update of get_mod_delay() for all
+                   blocks, see get_mod_sinus() and get_mod_triang() */
+                if(sine)
+                {
+                    #pragma omp simd
+                    for(i = 0; i < nr; i++)
+                    {
+                        double out = a1[i] * buffer1[i] - buffer2[i];
+                        double b2 = buffer1[i];
+
+                        /* reset in case of instability near PI/2 or -PI/2 */
+                        b2 = (out >= 1.0) ? reset_buffer2[i] : b2;
+                        out = (out >= 1.0) ? 1.0 : out;
+                        b2 = (out <= -1.0) ? -reset_buffer2[i] : b2;
+                        out = (out <= -1.0) ? -1.0 : out;
+
+                        buffer2[i] = b2;
+                        buffer1[i] = out;
+                        mod_value[i] = out;
+                    }
+                }
+                else
+                {
+                    #pragma omp simd
+                    for(i = 0; i < nr; i++)
+                    {
+                        fluid_real_t v = val[i] + inc[i];
+
+                        val[i] = v;
+                        inc[i] = (v >= 1.0 || v <= -1.0) ? -inc[i] : inc[i];
+                        mod_value[i] = (v >= 1.0) ? 1.0 : ((v <= -1.0) ? -1.0 : v);
+                    }
+                }
+
+                #pragma omp simd
+                for(i = 0; i < nr; i++)
+                {
+                    fluid_real_t out_index = center_pos_mod + mod_value[i] * mod_depth;
+                    int int_out_index = (out_index >= 0.0f) ? (int)out_index : (int)(out_index - 1);
+                    int pos = int_out_index;
+
+                    /* circular motion as needed */
+                    pos = (pos < 0) ? pos + size : pos;
+                    pos = (pos >= size) ? pos - size : pos;
+
+                    line_out[i] = pos;
+                    frac_pos_mod[i] = out_index - int_out_index;
+                }
+
+                chorus->index_rate = 0;
+
+                if((chorus->center_pos_mod += chorus->mod_rate) >= chorus->size)
+                {
+                    chorus->center_pos_mod -= chorus->size;
+                }
+            }
+
+            /* samples until the next update of the modulators */
+            r = chorus->mod_rate - chorus->index_rate;
+
+            if(r > n - t)
+            {
+                r = n - t;
+            }
+
+            if(r > CHORUS_RUN)
+            {
+                r = CHORUS_RUN;
+            }
+
+            chorus->index_rate += r - 1;
+
+            /* gather the r + 1 samples read by each block */
+            for(i = 0; i < nr; i++)
+            {
+                int pos = line_out[i];
+
+                if(pos + r < size)
+                {
+                    const fluid_real_t *src = &line[pos];
+
+                    for(j = 0; j <= r; j++)
+                    {
+                        chorus->tap[j][i] = src[j];
+                    }
+
+                    pos += r;
+                }
+                else
+                {
+                    /* circular motion */
+                    for(j = 0; j <= r; j++)
+                    {
+                        chorus->tap[j][i] = line[pos];
+
+                        if(j < r && ++pos >= size)
+                        {
+                            pos -= size;
+                        }
+                    }
+                }
+
+                line_out[i] = pos;
+            }
+
+            /* first order all-pass interpolation of all blocks, their output
+               is accumulated into stereo unit input */
+            for(j = 0; j < r; j++)
+            {
+                const fluid_real_t *cur = chorus->tap[j];
+                const fluid_real_t *next = chorus->tap[j + 1];
+                fluid_real_t even = 0.0f, odd = 0.0f;
+
+                #pragma omp simd reduction(+:even)
+                for(i = 0; i < nr_even; i++)
+                {
+                    fluid_real_t out = cur[i] + frac_pos_mod[i] * (next[i] - buffer[i]);
+
+                    buffer[i] = out;
+                    even += out;
+                }
+
+                #pragma omp simd reduction(+:odd)
+                for(i = nr_even; i < nr; i++)
+                {
+                    fluid_real_t out = cur[i] + frac_pos_mod[i] * (next[i] - buffer[i]);
+
+                    buffer[i] = out;
+                    odd += out;
+                }
+
+                /* Adjust stereo input level in case of number_blocks odd,
+                   see fluid_chorus_processmix() */
+                if((nr & 1) && nr > 2)
+                {
+                    odd += buffer[nr_even - 1];
+                }
+
+                d_out[0][t + j] = even;
+                d_out[1][t + j] = odd;
+            }
+        }
+
+        /* process stereo unit */
+        if(mix)
+        {
+            #pragma omp simd
+            for(t = 0; t < n; t++)
+            {
+                left_out[k + t]  += d_out[0][t] * wet1  + d_out[1][t] * wet2;
+                right_out[k + t] += d_out[1][t] * wet1  + d_out[0][t] * wet2;
+            }
+        }
+        else
+        {
+            #pragma omp simd
+            for(t = 0; t < n; t++)
+            {
+                left_out[k + t]  = d_out[0][t] * wet1  + d_out[1][t] * wet2;
+                right_out[k + t] = d_out[1][t] * wet1  + d_out[0][t] * wet2;
+            }
+        }
+    }
+
+    for(i = 0; i < nr; i++)
+    {
+        modulator *mod = &chorus->mod[i];
+        int c = (i & 1) ? nr_even + i / 2 : i / 2;
+
+        mod->sinus.buffer1 = buffer1[c];
+        mod->sinus.buffer2 = buffer2[c];
+        mod->triang.val = val[c];
+        mod->triang.inc = inc[c];
+        mod->line_out = line_out[c];
+        mod->frac_pos_mod = frac_pos_mod[c];
+        mod->buffer = buffer[c];
+    }
+}
+
+FLUID_TARGET_AVX2 static void
+fluid_chorus_process_vector_avx2(fluid_chorus_t *chorus, const fluid_real_t *in,
+                                 fluid_real_t *left_out, fluid_real_t *right_out,
+                                 int count, int mix)
+{
+    fluid_chorus_process_vector_generic(chorus, in, left_out, right_out, count, mix);
+}
+
+FLUID_TARGET_AVX512 static void
+fluid_chorus_process_vector_avx512(fluid_chorus_t *chorus, const fluid_real_t *in,
+                                   fluid_real_t *left_out, fluid_real_t *right_out,
+                                   int count, int mix)
+{
+    fluid_chorus_process_vector_generic(chorus, in, left_out, right_out, count, mix);
+}
+
+/*-----------------------------------------------------------------------------
+ Runs the vectorized chorus built for chorus->cpu_isa.
+ @return TRUE if the samples have been processed, FALSE if the scalar loops
+  must be used.
+-----------------------------------------------------------------------------*/
+static FLUID_INLINE int
+fluid_chorus_process_vector(fluid_chorus_t *chorus, const fluid_real_t *in,
+                            fluid_real_t *left_out, fluid_real_t *right_out,
+                            int count, int mix)
+{
+    switch(chorus->cpu_isa)
+    {
+    case FLUID_CPU_ISA_AVX512:
+        fluid_chorus_process_vector_avx512(chorus, in, left_out, right_out, count, mix);
+        return TRUE;
+
+    case FLUID_CPU_ISA_AVX2:
+        fluid_chorus_process_vector_avx2(chorus, in, left_out, right_out, count, mix);
+        return TRUE;
+
+    default:
+        return FALSE;
+    }
+}
+#endif
+
 /**
  * Process chorus by mixing the result in output buffer.
  * @param chorus pointer on chorus unit returned by new_fluid_chorus().
- * @param in, pointer on monophonic input buffer of FLUID_BUFSIZE samples.
+ * @param in, pointer on monophonic input buffer of count samples.
  * @param left_out, right_out, pointers on stereo output buffers of
- *  FLUID_BUFSIZE samples.
+ *  count samples.
+ * @param count, number of samples to process.
  */
 void fluid_chorus_processmix(fluid_chorus_t *chorus, const fluid_real_t *in,
-                             fluid_real_t *left_out, fluid_real_t *right_out)
+                             fluid_real_t *left_out, fluid_real_t *right_out, int count)
 {
     int sample_index;
     int i;
     fluid_real_t d_out[2];               /* output stereo Left and Right  */
 
+#if FLUID_CPU_DISPATCH
+    if(fluid_chorus_process_vector(chorus, in, left_out, right_out, count, TRUE))
+    {
+        return;
+    }
+#endif
+
     /* foreach sample, process output sample then input sample */
-    for(sample_index = 0; sample_index < FLUID_BUFSIZE; sample_index++)
+    for(sample_index = 0; sample_index < count; sample_index++)
     {
         fluid_real_t out; /* block output */
 
@@ -1002,20 +1415,28 @@ void fluid_chorus_processmix(fluid_chorus_t *chorus, const fluid_real_t *in,
 /**
  * Process chorus by putting the result in output buffer (no mixing).
  * @param chorus pointer on chorus unit returned by new_fluid_chorus().
- * @param in, pointer on monophonic input buffer of FLUID_BUFSIZE samples.
+ * @param in, pointer on monophonic input buffer of count samples.
  * @param left_out, right_out, pointers on stereo output buffers of
- *  FLUID_BUFSIZE samples.
+ *  count samples.
+ * @param count, number of samples to process.
  */
 /* Duplication of code ... (replaces sample data instead of mixing) */
 void fluid_chorus_processreplace(fluid_chorus_t *chorus, const fluid_real_t *in,
-                                 fluid_real_t *left_out, fluid_real_t *right_out)
+                                 fluid_real_t *left_out, fluid_real_t *right_out, int count)
 {
     int sample_index;
     int i;
     fluid_real_t d_out[2];               /* output stereo Left and Right  */
 
+#if FLUID_CPU_DISPATCH
+    if(fluid_chorus_process_vector(chorus, in, left_out, right_out, count, FALSE))
+    {
+        return;
+    }
+#endif
+
     /* foreach sample, process output sample then input sample */
-    for(sample_index = 0; sample_index < FLUID_BUFSIZE; sample_index++)
+    for(sample_index = 0; sample_index < count; sample_index++)
     {
         fluid_real_t out; /* block output */
 
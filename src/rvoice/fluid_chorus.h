@@ -72,10 +72,14 @@ void fluid_chorus_set(fluid_chorus_t *chorus, int set, int nr, fluid_real_t leve
 void
 fluid_chorus_samplerate_change(fluid_chorus_t *chorus, fluid_real_t sample_rate);
 
+void fluid_chorus_set_cpu_isa(fluid_chorus_t *chorus, int cpu_isa);
+fluid_real_t fluid_chorus_get_tail_level(fluid_chorus_t *chorus);
+int fluid_chorus_get_tail_length(fluid_chorus_t *chorus);
+
 void fluid_chorus_processmix(fluid_chorus_t *chorus, const fluid_real_t *in,
-                             fluid_real_t *left_out, fluid_real_t *right_out);
+                             fluid_real_t *left_out, fluid_real_t *right_out, int count);
 void fluid_chorus_processreplace(fluid_chorus_t *chorus, const fluid_real_t *in,
-                                 fluid_real_t *left_out, fluid_real_t *right_out);
+                                 fluid_real_t *left_out, fluid_real_t *right_out, int count);
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,1049 @@
+/* FluidSynth - A Software Synthesizer
+ *
+ * Copyright (C) 2003  Peter Hanappe and others.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1 of
+ * the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see
+ * <https://www.gnu.org/licenses/>.
+ */
+
+/*
+  Convolution reverb: a mono input convolved with a stereo impulse response.
+
+  The convolution has no latency. The impulse response is cut into:
+  - a head of CONV_HEAD samples, convolved directly in the time domain,
+  - up to CONV_STAGES stages of uniformly partitioned convolution in the
+    frequency domain (overlap-save). The partitions of stage k are
+    CONV_HEAD_PART * CONV_STAGE_RATIO^k samples long (Q), the stage starts at
+    sample 2 * Q of the impulse response and ends where the next stage
+    starts, the last stage covers the rest of the impulse response.
+
+  Every Q samples, a stage gets a new block of input. As the stage starts at
+  2 * Q, the output of that block is only due Q samples later, so the work of
+  a stage (fft of the input, products with the spectra of the partitions,
+  inverse fft) is a job spread over the following Q samples. This keeps the
+  cost of each call to the process functions close to the average, even with
+  partitions of several thousand samples.
+
+  Both channels of the impulse response are processed at once, as the real
+  and imaginary parts of one complex signal: the input being real, the real
+  part of the result is the left output and the imaginary part the right one.
+  The spectra are kept in the bit reversed order of the decimation in
+  frequency fft, which the decimation in time inverse fft takes as input.
+
+  The impulse response (its head, the spectra of the partitions and the
+  twiddle factors) is read-only once computed, and may be shared by several
+  reverbs, each of them only holding its own input and output state.
+*/
+
+#include "fluid_convrev.h"
+#include "fluid_rev.h"
+#include "fluid_sys.h"
+
+#if LIBSNDFILE_SUPPORT
+#include <sndfile.h>
+#endif
+
+#define CONV_HEAD_PART   32 /* partition size of the first stage */
+#define CONV_HEAD        (2 * CONV_HEAD_PART) /* impulse response samples convolved directly */
+#define CONV_STAGE_RATIO 16 /* partition size ratio between consecutive stages */
+#define CONV_STAGES      3  /* maximum count of frequency domain stages */
+
+/* same compensation of the width as the fdn reverb, see fluid_revmodel_update() */
+#define CONV_SCALE_WET_WIDTH 0.2f
+
+/*-----------------------------------------------------------------------------
+ Partitions of the impulse response of a uniformly partitioned stage
+-----------------------------------------------------------------------------*/
+typedef struct
+{
+    int part;     /* partition size (Q) */
+    int size;     /* fft size, 2 * Q */
+    int nparts;   /* partitions count */
+    fluid_real_t *re, *im; /* spectra of the nparts partitions */
+} fluid_conv_stage_ir;
+
+/*-----------------------------------------------------------------------------
+ Uniformly partitioned convolution stage
+-----------------------------------------------------------------------------*/
+typedef struct
+{
+    int part;     /* partition size (Q) */
+    int size;     /* fft size, 2 * Q */
+    int log2size;
+    int nparts;   /* partitions count */
+    int slot;     /* slot of the newest input spectrum in fdl */
+    int pos;      /* position in the current block of Q samples */
+    int step;     /* next step of the job, see fluid_conv_stage_step() */
+    int nsteps;   /* steps count of the job */
+
+    fluid_real_t *in;              /* the last 2 blocks of input (size samples) */
+    fluid_real_t *fdl_re, *fdl_im; /* spectra of the last nparts input windows */
+    const fluid_real_t *ir_re, *ir_im; /* spectra of the nparts partitions, shared */
+    fluid_real_t *acc_re, *acc_im; /* spectrum and then output of the job */
+    fluid_real_t *out_l, *out_r;   /* output of the current block */
+    fluid_real_t *next_l, *next_r; /* output of the next block, written by the job */
+
+    fluid_real_t *mem; /* the allocation holding the buffers above, except the spectra */
+} fluid_conv_stage;
+
+struct _fluid_convrev_ir_t
+{
+    fluid_atomic_int_t refcount; /* the creator and each reverb using it */
+
+    int length;        /* impulse response length (in samples) */
+    fluid_real_t gain; /* sum of the absolute impulse response samples, louder channel */
+
+    fluid_real_t head_l[CONV_HEAD]; /* head of the impulse response, reversed */
+    fluid_real_t head_r[CONV_HEAD];
+
+    fluid_conv_stage_ir stage[CONV_STAGES];
+    int nstages;
+    fluid_real_t *tw_re, *tw_im; /* twiddle factors, see fluid_conv_fft_dif_pass() */
+};
+
+struct _fluid_convrev_t
+{
+    fluid_convrev_ir_t *ir;
+
+    /* reverb parameters */
+    fluid_real_t level, width;
+    fluid_real_t wet1, wet2; /* output gains */
+
+    /* direct convolution of the head */
+    fluid_real_t hist[2 * CONV_HEAD]; /* last CONV_HEAD input samples, twice */
+    int hist_pos;
+
+    /* frequency domain stages */
+    fluid_conv_stage stage[CONV_STAGES];
+    int nstages;
+
+    /* input peaks of the last length samples, one per CONV_HEAD_PART block,
+       see fluid_convrev_get_tail_level() */
+    fluid_real_t *peaks;
+    int npeaks;
+    int peak_idx;
+    fluid_real_t peak; /* peak of the current block */
+    int pos;           /* position in the current block */
+};
+
+/*-----------------------------------------------------------------------------
+ One pass of a decimation in frequency fft (natural order in, bit reversed
+ order out), on the butterflies of span m. The twiddle factors of the pass,
+ exp(-2i * pi * k / (2 * m)) for k < m, are stored at tw[m - 1].
+-----------------------------------------------------------------------------*/
+static void
+fluid_conv_fft_dif_pass(fluid_real_t *re, fluid_real_t *im, int size, int m,
+                        const fluid_real_t *tw_re, const fluid_real_t *tw_im)
+{
+    const fluid_real_t *wr = tw_re + m - 1;
+    const fluid_real_t *wi = tw_im + m - 1;
+    int s, k;
+
+    for(s = 0; s < size; s += 2 * m)
+    {
+        fluid_real_t *ar = re + s, *ai = im + s;
+        fluid_real_t *br = ar + m, *bi = ai + m;
+
+        #pragma omp simd
+        for(k = 0; k < m; k++)
+        {
+            fluid_real_t dr = ar[k] - br[k];
+            fluid_real_t di = ai[k] - bi[k];
+
+            ar[k] += br[k];
+            ai[k] += bi[k];
+            br[k] = dr * wr[k] - di * wi[k];
+            bi[k] = dr * wi[k] + di * wr[k];
+        }
+    }
+}
+
+/*-----------------------------------------------------------------------------
+ One pass of a decimation in time inverse fft (bit reversed order in,
+ natural order out), on the butterflies of span m. The result isn't scaled.
+-----------------------------------------------------------------------------*/
+static void
+fluid_conv_fft_dit_pass(fluid_real_t *re, fluid_real_t *im, int size, int m,
+                        const fluid_real_t *tw_re, const fluid_real_t *tw_im)
+{
+    const fluid_real_t *wr = tw_re + m - 1;
+    const fluid_real_t *wi = tw_im + m - 1;
+    int s, k;
+
+    for(s = 0; s < size; s += 2 * m)
+    {
+        fluid_real_t *ar = re + s, *ai = im + s;
+        fluid_real_t *br = ar + m, *bi = ai + m;
+
+        #pragma omp simd
+        for(k = 0; k < m; k++)
+        {
+            /* b * conj(w) */
+            fluid_real_t tr = br[k] * wr[k] + bi[k] * wi[k];
+            fluid_real_t ti = bi[k] * wr[k] - br[k] * wi[k];
+
+            br[k] = ar[k] - tr;
+            bi[k] = ai[k] - ti;
+            ar[k] += tr;
+            ai[k] += ti;
+        }
+    }
+}
+
+/*-----------------------------------------------------------------------------
+ Runs one step of the job of a stage. The job computes the output of the
+ input window loaded in fdl[slot], in 2 * log2size + nparts + 1 steps:
+ - log2size passes of the fft of the input window,
+ - one product with the spectrum of each partition, accumulated in acc,
+ - log2size passes of the inverse fft of acc,
+ - the copy of the last half of acc to next_l (real part) and next_r
+   (imaginary part).
+-----------------------------------------------------------------------------*/
+static void
+fluid_conv_stage_step(fluid_conv_stage *st, int step,
+                      const fluid_real_t *tw_re, const fluid_real_t *tw_im)
+{
+    int size = st->size;
+    int k;
+
+    if(step < st->log2size)
+    {
+        fluid_conv_fft_dif_pass(st->fdl_re + st->slot * size, st->fdl_im + st->slot * size,
+                                size, size >> (step + 1), tw_re, tw_im);
+        return;
+    }
+
+    step -= st->log2size;
+
+    if(step < st->nparts)
+    {
+        /* input window of step blocks ago times partition step */
+        int slot = (st->slot - step + st->nparts) % st->nparts;
+        const fluid_real_t *xr = st->fdl_re + slot * size, *xi = st->fdl_im + slot * size;
+        const fluid_real_t *hr = st->ir_re + step * size, *hi = st->ir_im + step * size;
+        fluid_real_t *ar = st->acc_re, *ai = st->acc_im;
+
+        if(step == 0)
+        {
+            #pragma omp simd
+            for(k = 0; k < size; k++)
+            {
+                ar[k] = xr[k] * hr[k] - xi[k] * hi[k];
+                ai[k] = xr[k] * hi[k] + xi[k] * hr[k];
+            }
+        }
+        else
+        {
+            #pragma omp simd
+            for(k = 0; k < size; k++)
+            {
+                ar[k] += xr[k] * hr[k] - xi[k] * hi[k];
+                ai[k] += xr[k] * hi[k] + xi[k] * hr[k];
+            }
+        }
+
+        return;
+    }
+
+    step -= st->nparts;
+
+    if(step < st->log2size)
+    {
+        fluid_conv_fft_dit_pass(st->acc_re, st->acc_im, size, 1 << step, tw_re, tw_im);
+        return;
+    }
+
+    /* overlap-save: only the last half of the circular convolution is kept */
+    FLUID_MEMCPY(st->next_l, st->acc_re + st->part, st->part * sizeof(fluid_real_t));
+    FLUID_MEMCPY(st->next_r, st->acc_im + st->part, st->part * sizeof(fluid_real_t));
+}
+
+/* Runs the job of a stage up to step until */
+static FLUID_INLINE void
+fluid_conv_stage_run(fluid_conv_stage *st, int until,
+                     const fluid_real_t *tw_re, const fluid_real_t *tw_im)
+{
+    while(st->step < until)
+    {
+        fluid_conv_stage_step(st, st->step++, tw_re, tw_im);
+    }
+}
+
+/*-----------------------------------------------------------------------------
+ Called when a stage has got a whole block of input: finishes the job of the
+ previous block, whose output is played next, and starts the job of the block.
+-----------------------------------------------------------------------------*/
+static void
+fluid_conv_stage_next_block(fluid_conv_stage *st,
+                            const fluid_real_t *tw_re, const fluid_real_t *tw_im)
+{
+    fluid_real_t *tmp;
+    int size = st->size;
+
+    fluid_conv_stage_run(st, st->nsteps, tw_re, tw_im);
+
+    tmp = st->out_l;
+    st->out_l = st->next_l;
+    st->next_l = tmp;
+    tmp = st->out_r;
+    st->out_r = st->next_r;
+    st->next_r = tmp;
+
+    /* the input window of the new job: the previous block and this one */
+    st->slot = (st->slot + 1) % st->nparts;
+    FLUID_MEMCPY(st->fdl_re + st->slot * size, st->in, size * sizeof(fluid_real_t));
+    FLUID_MEMSET(st->fdl_im + st->slot * size, 0, size * sizeof(fluid_real_t));
+    FLUID_MEMCPY(st->in, st->in + st->part, st->part * sizeof(fluid_real_t));
+
+    st->step = 0;
+    st->pos = 0;
+}
+
+static void
+fluid_conv_stage_reset(fluid_conv_stage *st)
+{
+    int size = st->size;
+
+    FLUID_MEMSET(st->in, 0, size * sizeof(fluid_real_t));
+    FLUID_MEMSET(st->fdl_re, 0, st->nparts * size * sizeof(fluid_real_t));
+    FLUID_MEMSET(st->fdl_im, 0, st->nparts * size * sizeof(fluid_real_t));
+    FLUID_MEMSET(st->out_l, 0, st->part * sizeof(fluid_real_t));
+    FLUID_MEMSET(st->out_r, 0, st->part * sizeof(fluid_real_t));
+    FLUID_MEMSET(st->next_l, 0, st->part * sizeof(fluid_real_t));
+    FLUID_MEMSET(st->next_r, 0, st->part * sizeof(fluid_real_t));
+
+    st->slot = 0;
+    st->pos = 0;
+    st->step = st->nsteps; /* no job pending */
+}
+
+/*-----------------------------------------------------------------------------
+ Computes the spectra of count samples of the impulse response (left and
+ right), cut into partitions of part samples.
+ @return FLUID_OK or FLUID_FAILED if memory error.
+-----------------------------------------------------------------------------*/
+static int
+fluid_conv_stage_ir_init(fluid_conv_stage_ir *st, int part, const fluid_real_t *left,
+                         const fluid_real_t *right, int count,
+                         const fluid_real_t *tw_re, const fluid_real_t *tw_im)
+{
+    int size = 2 * part;
+    int p, k, m;
+
+    st->part = part;
+    st->size = size;
+    st->nparts = (count + part - 1) / part;
+    st->re = FLUID_ARRAY(fluid_real_t, 2 * st->nparts * size);
+
+    if(st->re == NULL)
+    {
+        FLUID_LOG(FLUID_ERR, "Out of memory");
+        return FLUID_FAILED;
+    }
+
+    st->im = st->re + st->nparts * size;
+
+    /* spectra of the partitions, zero padded to size, scaled by the 1 / size
+       the inverse fft doesn't apply */
+    for(p = 0; p < st->nparts; p++)
+    {
+        fluid_real_t *hr = st->re + p * size, *hi = st->im + p * size;
+
+        FLUID_MEMSET(hr, 0, size * sizeof(fluid_real_t));
+        FLUID_MEMSET(hi, 0, size * sizeof(fluid_real_t));
+
+        for(k = 0; k < part && p * part + k < count; k++)
+        {
+            hr[k] = left[p * part + k] / size;
+            hi[k] = right[p * part + k] / size;
+        }
+
+        for(m = size / 2; m > 0; m /= 2)
+        {
+            fluid_conv_fft_dif_pass(hr, hi, size, m, tw_re, tw_im);
+        }
+    }
+
+    return FLUID_OK;
+}
+
+/*-----------------------------------------------------------------------------
+ Sets up a stage convolving with the partitions of ir.
+ @return FLUID_OK or FLUID_FAILED if memory error.
+-----------------------------------------------------------------------------*/
+static int
+fluid_conv_stage_init(fluid_conv_stage *st, const fluid_conv_stage_ir *ir)
+{
+    int size = ir->size;
+    int part = ir->part;
+    fluid_real_t *mem;
+
+    st->part = part;
+    st->size = size;
+    st->nparts = ir->nparts;
+    st->ir_re = ir->re;
+    st->ir_im = ir->im;
+
+    for(st->log2size = 0; (1 << st->log2size) < size; st->log2size++)
+    {
+    }
+
+    st->nsteps = 2 * st->log2size + st->nparts + 1;
+
+    /* in, fdl, acc and the output blocks */
+    mem = FLUID_ARRAY(fluid_real_t, size + 2 * st->nparts * size + 2 * size + 4 * part);
+
+    if(mem == NULL)
+    {
+        FLUID_LOG(FLUID_ERR, "Out of memory");
+        return FLUID_FAILED;
+    }
+
+    st->mem = mem;
+    st->in = mem;
+    mem += size;
+    st->fdl_re = mem;
+    mem += st->nparts * size;
+    st->fdl_im = mem;
+    mem += st->nparts * size;
+    st->acc_re = mem;
+    mem += size;
+    st->acc_im = mem;
+    mem += size;
+    st->out_l = mem;
+    mem += part;
+    st->out_r = mem;
+    mem += part;
+    st->next_l = mem;
+    mem += part;
+    st->next_r = mem;
+
+    fluid_conv_stage_reset(st);
+
+    return FLUID_OK;
+}
+
+/*-----------------------------------------------------------------------------
+ Updates the output gains from the parameters.
+-----------------------------------------------------------------------------*/
+static void
+fluid_convrev_update(fluid_convrev_t *conv)
+{
+    fluid_real_t wet = conv->level / (1.0f + conv->width * CONV_SCALE_WET_WIDTH);
+
+    conv->wet1 = wet * (conv->width / 2.0f + 0.5f);
+    conv->wet2 = wet * ((1.0f - conv->width) / 2.0f);
+}
+
+/*----------------------------------------------------------------------------
+                            Convolution reverb API
+-----------------------------------------------------------------------------*/
+/*
+* Prepares an impulse response for convolution reverbs.
+*
+* The impulse response is resampled to sample_rate (linear interpolation) and
+* normalized to unit energy on its louder channel, then transformed once, for
+* all the reverbs created from it by new_fluid_convrev().
+*
+* @param left left channel of the impulse response.
+* @param right right channel of the impulse response, NULL for a mono one.
+* @param frames length of the impulse response.
+* @param ir_sample_rate sample rate of the impulse response in Hz.
+* @param sample_rate sample rate of the reverb in Hz.
+* @return pointer on the new impulse response or NULL if invalid arguments or
+*  memory error.
+*/
+fluid_convrev_ir_t *
+new_fluid_convrev_ir(const float *left, const float *right, int frames,
+                     fluid_real_t ir_sample_rate, fluid_real_t sample_rate)
+{
+    fluid_convrev_ir_t *ir;
+    fluid_real_t *ir_l, *ir_r;
+    fluid_real_t energy_l = 0, energy_r = 0, gain_l = 0, gain_r = 0, norm;
+    int length, i, k, part, start, end;
+
+    fluid_return_val_if_fail(left != NULL, NULL);
+    fluid_return_val_if_fail(frames > 0, NULL);
+    fluid_return_val_if_fail(ir_sample_rate > 0 && sample_rate > 0, NULL);
+
+    if(right == NULL)
+    {
+        right = left;
+    }
+
+    length = (int)((frames - 1) * sample_rate / ir_sample_rate) + 1;
+
+    ir = FLUID_NEW(fluid_convrev_ir_t);
+    ir_l = FLUID_ARRAY(fluid_real_t, 2 * length);
+
+    if(ir == NULL || ir_l == NULL)
+    {
+        FLUID_LOG(FLUID_ERR, "Out of memory");
+        FLUID_FREE(ir);
+        FLUID_FREE(ir_l);
+        return NULL;
+    }
+
+    FLUID_MEMSET(ir, 0, sizeof(*ir));
+    fluid_atomic_int_set(&ir->refcount, 1);
+    ir_r = ir_l + length;
+
+    /* resampling */
+    for(i = 0; i < length; i++)
+    {
+        double t = i * (double)ir_sample_rate / sample_rate;
+        fluid_real_t frac;
+
+        k = (int)t;
+        frac = (fluid_real_t)(t - k);
+
+        if(k + 1 < frames)
+        {
+            ir_l[i] = left[k] + frac * (left[k + 1] - left[k]);
+            ir_r[i] = right[k] + frac * (right[k + 1] - right[k]);
+        }
+        else
+        {
+            ir_l[i] = left[frames - 1];
+            ir_r[i] = right[frames - 1];
+        }
+
+        energy_l += ir_l[i] * ir_l[i];
+        energy_r += ir_r[i] * ir_r[i];
+    }
+
+    /* normalization */
+    norm = (energy_l > energy_r) ? energy_l : energy_r;
+    norm = (norm > 0) ? 1 / FLUID_SQRT(norm) : 0;
+
+    for(i = 0; i < length; i++)
+    {
+        ir_l[i] *= norm;
+        ir_r[i] *= norm;
+        gain_l += FLUID_FABS(ir_l[i]);
+        gain_r += FLUID_FABS(ir_r[i]);
+    }
+
+    ir->length = length;
+    ir->gain = (gain_l > gain_r) ? gain_l : gain_r;
+
+    /* head */
+    for(i = 0; i < CONV_HEAD && i < length; i++)
+    {
+        ir->head_l[CONV_HEAD - 1 - i] = ir_l[i];
+        ir->head_r[CONV_HEAD - 1 - i] = ir_r[i];
+    }
+
+    /* stages, and twiddle factors for the fft of the largest one */
+    for(part = CONV_HEAD_PART, start = CONV_HEAD;
+            ir->nstages < CONV_STAGES && start < length;
+            part *= CONV_STAGE_RATIO, start = 2 * part)
+    {
+        ir->nstages++;
+    }
+
+    if(ir->nstages > 0)
+    {
+        int size = 2 * CONV_HEAD_PART;
+        int m;
+
+        for(i = 1; i < ir->nstages; i++)
+        {
+            size *= CONV_STAGE_RATIO;
+        }
+
+        ir->tw_re = FLUID_ARRAY(fluid_real_t, 2 * size);
+
+        if(ir->tw_re == NULL)
+        {
+            FLUID_LOG(FLUID_ERR, "Out of memory");
+            ir->nstages = 0;
+            goto error_recovery;
+        }
+
+        ir->tw_im = ir->tw_re + size;
+
+        for(m = 1; m < size; m *= 2)
+        {
+            for(k = 0; k < m; k++)
+            {
+                ir->tw_re[m - 1 + k] = FLUID_COS(FLUID_M_PI * k / m);
+                ir->tw_im[m - 1 + k] = -FLUID_SIN(FLUID_M_PI * k / m);
+            }
+        }
+    }
+
+    for(i = 0, part = CONV_HEAD_PART, start = CONV_HEAD; i < ir->nstages; i++)
+    {
+        end = (i == ir->nstages - 1) ? length : 2 * part * CONV_STAGE_RATIO;
+
+        if(fluid_conv_stage_ir_init(&ir->stage[i], part, ir_l + start, ir_r + start,
+                                    end - start, ir->tw_re, ir->tw_im) != FLUID_OK)
+        {
+            ir->nstages = i;
+            goto error_recovery;
+        }
+
+        start = end;
+        part *= CONV_STAGE_RATIO;
+    }
+
+    FLUID_FREE(ir_l);
+
+    return ir;
+
+error_recovery:
+    FLUID_FREE(ir_l);
+    delete_fluid_convrev_ir(ir);
+    return NULL;
+}
+
+/*
+* Releases an impulse response. It is freed once the reverbs created from it
+* have been deleted as well.
+* @param ir the impulse response.
+*/
+void
+delete_fluid_convrev_ir(fluid_convrev_ir_t *ir)
+{
+    int i;
+
+    fluid_return_if_fail(ir != NULL);
+
+    if(!fluid_atomic_int_dec_and_test(&ir->refcount))
+    {
+        return;
+    }
+
+    for(i = 0; i < ir->nstages; i++)
+    {
+        FLUID_FREE(ir->stage[i].re);
+    }
+
+    FLUID_FREE(ir->tw_re);
+    FLUID_FREE(ir);
+}
+
+/*
+* Creates a convolution reverb. The reverb keeps a reference to the impulse
+* response, which the caller may release right away.
+*
+* Until set, the reverb outputs the impulse response at level 1 and width 1,
+* see fluid_convrev_set().
+*
+* @param ir the impulse response, see new_fluid_convrev_ir().
+* @return pointer on the new reverb or NULL if memory error.
+*/
+fluid_convrev_t *
+new_fluid_convrev(fluid_convrev_ir_t *ir)
+{
+    fluid_convrev_t *conv;
+    int i;
+
+    fluid_return_val_if_fail(ir != NULL, NULL);
+
+    conv = FLUID_NEW(fluid_convrev_t);
+
+    if(conv == NULL)
+    {
+        FLUID_LOG(FLUID_ERR, "Out of memory");
+        return NULL;
+    }
+
+    FLUID_MEMSET(conv, 0, sizeof(*conv));
+    fluid_atomic_int_inc(&ir->refcount);
+    conv->ir = ir;
+
+    for(i = 0; i < ir->nstages; i++)
+    {
+        if(fluid_conv_stage_init(&conv->stage[i], &ir->stage[i]) != FLUID_OK)
+        {
+            goto error_recovery;
+        }
+
+        conv->nstages++;
+    }
+
+    /* input peaks */
+    conv->npeaks = (ir->length + CONV_HEAD_PART - 1) / CONV_HEAD_PART + 1;
+    conv->peaks = FLUID_ARRAY(fluid_real_t, conv->npeaks);
+
+    if(conv->peaks == NULL)
+    {
+        FLUID_LOG(FLUID_ERR, "Out of memory");
+        goto error_recovery;
+    }
+
+    conv->level = 1.0f;
+    conv->width = 1.0f;
+    fluid_convrev_update(conv);
+    fluid_convrev_reset(conv);
+
+    return conv;
+
+error_recovery:
+    delete_fluid_convrev(conv);
+    return NULL;
+}
+
+/*
+* Prepares an impulse response stored in a sound file (mono or stereo, any
+* format libsndfile can read), see new_fluid_convrev_ir().
+*
+* @param filename the sound file.
+* @param sample_rate sample rate of the reverb in Hz.
+* @return pointer on the new impulse response or NULL on error.
+*/
+fluid_convrev_ir_t *
+new_fluid_convrev_ir_from_file(const char *filename, fluid_real_t sample_rate)
+{
+#if LIBSNDFILE_SUPPORT
+    fluid_convrev_ir_t *ir;
+    SNDFILE *sndfile;
+    SF_INFO info;
+    float *data, *left, *right;
+    int i;
+
+    fluid_return_val_if_fail(filename != NULL, NULL);
+
+    FLUID_MEMSET(&info, 0, sizeof(info));
+    sndfile = sf_open(filename, SFM_READ, &info);
+
+    if(sndfile == NULL)
+    {
+        FLUID_LOG(FLUID_ERR, "Failed to open impulse response '%s': %s", filename, sf_strerror(NULL));
+        return NULL;
+    }
+
+    if(info.channels < 1 || info.frames < 1 || info.frames > 0x7FFFFFFF / info.channels)
+    {
+        FLUID_LOG(FLUID_ERR, "Impulse response '%s' has no usable audio", filename);
+        sf_close(sndfile);
+        return NULL;
+    }
+
+    if(info.channels > 2)
+    {
+        FLUID_LOG(FLUID_WARN, "Impulse response '%s' has %d channels, only the first 2 are used",
+                  filename, info.channels);
+    }
+
+    data = FLUID_ARRAY(float, info.frames * (info.channels + 2));
+
+    if(data == NULL)
+    {
+        FLUID_LOG(FLUID_ERR, "Out of memory");
+        sf_close(sndfile);
+        return NULL;
+    }
+
+    if(sf_readf_float(sndfile, data, info.frames) < info.frames)
+    {
+        FLUID_LOG(FLUID_ERR, "Failed to read impulse response '%s': %s", filename, sf_strerror(sndfile));
+        FLUID_FREE(data);
+        sf_close(sndfile);
+        return NULL;
+    }
+
+    sf_close(sndfile);
+
+    /* deinterleave */
+    left = data + info.frames * info.channels;
+    right = left + info.frames;
+
+    for(i = 0; i < info.frames; i++)
+    {
+        left[i] = data[i * info.channels];
+        right[i] = data[i * info.channels + (info.channels > 1)];
+    }
+
+    ir = new_fluid_convrev_ir(left, (info.channels > 1) ? right : NULL, (int)info.frames,
+                              info.samplerate, sample_rate);
+    FLUID_FREE(data);
+
+    return ir;
+#else
+    FLUID_LOG(FLUID_ERR, "Can't load impulse response '%s': libsndfile support is disabled", filename);
+    return NULL;
+#endif
+}
+
+/*
+* Deletes a convolution reverb, and its impulse response if no other reverb
+* uses it.
+* @param conv the reverb.
+*/
+void
+delete_fluid_convrev(fluid_convrev_t *conv)
+{
+    int i;
+
+    fluid_return_if_fail(conv != NULL);
+
+    for(i = 0; i < conv->nstages; i++)
+    {
+        FLUID_FREE(conv->stage[i].mem);
+    }
+
+    FLUID_FREE(conv->peaks);
+    delete_fluid_convrev_ir(conv->ir);
+    FLUID_FREE(conv);
+}
+
+/*
+* Clears the state of the reverb, i.e. damps its tail.
+* @param conv the reverb.
+*/
+void
+fluid_convrev_reset(fluid_convrev_t *conv)
+{
+    int i;
+
+    fluid_return_if_fail(conv != NULL);
+
+    for(i = 0; i < conv->nstages; i++)
+    {
+        fluid_conv_stage_reset(&conv->stage[i]);
+    }
+
+    FLUID_MEMSET(conv->hist, 0, sizeof(conv->hist));
+    FLUID_MEMSET(conv->peaks, 0, conv->npeaks * sizeof(fluid_real_t));
+    conv->hist_pos = 0;
+    conv->peak_idx = 0;
+    conv->peak = 0;
+    conv->pos = 0;
+}
+
+/*
+* Sets the output parameters of the reverb. They have the same meaning as for
+* the fdn reverb, the room size and damping of which are up to the impulse
+* response here.
+*
+* @param conv the reverb.
+* @param set one or more flags from #fluid_revmodel_set_t, only
+*  FLUID_REVMODEL_SET_WIDTH and FLUID_REVMODEL_SET_LEVEL are used.
+* @param width stereo width, 0 to 100.
+* @param level output level, 0 to 1.
+*/
+void
+fluid_convrev_set(fluid_convrev_t *conv, int set, fluid_real_t width, fluid_real_t level)
+{
+    fluid_return_if_fail(conv != NULL);
+
+    if(set & FLUID_REVMODEL_SET_WIDTH)
+    {
+        conv->width = width;
+    }
+
+    if(set & FLUID_REVMODEL_SET_LEVEL)
+    {
+        conv->level = level;
+    }
+
+    fluid_convrev_update(conv);
+}
+
+/*
+* Returns an upper bound of the level the reverb outputs when it gets no more
+* input: the peak of its input over the length of the impulse response, times
+* the sum of the absolute samples of the impulse response.
+*
+* @param conv the reverb.
+* @return the level bound (1.0 being full scale).
+*/
+fluid_real_t
+fluid_convrev_get_tail_level(fluid_convrev_t *conv)
+{
+    fluid_real_t peak;
+    int i;
+
+    fluid_return_val_if_fail(conv != NULL, 0);
+
+    peak = conv->peak;
+
+    for(i = 0; i < conv->npeaks; i++)
+    {
+        if(conv->peaks[i] > peak)
+        {
+            peak = conv->peaks[i];
+        }
+    }
+
+    return peak * conv->ir->gain * (FLUID_FABS(conv->wet1) + FLUID_FABS(conv->wet2));
+}
+
+/*
+* Returns the number of samples after which all the input the reverb has got
+* so far has left it.
+*
+* @param conv the reverb.
+* @return the number of samples.
+*/
+int
+fluid_convrev_get_tail_length(fluid_convrev_t *conv)
+{
+    fluid_return_val_if_fail(conv != NULL, 0);
+
+    return conv->npeaks * CONV_HEAD_PART;
+}
+
+/*-----------------------------------------------------------------------------
+ Convolution process, in blocks of at most CONV_HEAD_PART samples.
+ The output replaces or is mixed with what is in left_out and right_out.
+ Note that in may be aliased with left_out.
+-----------------------------------------------------------------------------*/
+static FLUID_INLINE void
+fluid_convrev_process(fluid_convrev_t *conv, const fluid_real_t *in,
+                      fluid_real_t *left_out, fluid_real_t *right_out, int count, int mix)
+{
+    fluid_real_t out_l[CONV_HEAD_PART], out_r[CONV_HEAD_PART];
+    const fluid_convrev_ir_t *ir = conv->ir;
+    const fluid_real_t wet1 = conv->wet1, wet2 = conv->wet2;
+    int done, run, i, k, s;
+
+    for(done = 0; done < count; done += run, in += run, left_out += run, right_out += run)
+    {
+        fluid_real_t peak = conv->peak;
+
+        run = CONV_HEAD_PART - conv->pos;
+
+        if(run > count - done)
+        {
+            run = count - done;
+        }
+
+        /* head, direct convolution */
+        for(i = 0; i < run; i++)
+        {
+            const fluid_real_t *hist = conv->hist + conv->hist_pos + 1;
+            fluid_real_t l = 0, r = 0;
+
+            conv->hist[conv->hist_pos] = conv->hist[conv->hist_pos + CONV_HEAD] = in[i];
+            conv->hist_pos = (conv->hist_pos + 1) & (CONV_HEAD - 1);
+
+            #pragma omp simd reduction(+:l,r)
+            for(k = 0; k < CONV_HEAD; k++)
+            {
+                l += ir->head_l[k] * hist[k];
+                r += ir->head_r[k] * hist[k];
+            }
+
+            out_l[i] = l;
+            out_r[i] = r;
+        }
+
+        #pragma omp simd reduction(max:peak)
+        for(i = 0; i < run; i++)
+        {
+            fluid_real_t v = FLUID_FABS(in[i]);
+            peak = (v > peak) ? v : peak;
+        }
+
+        /* stages */
+        for(s = 0; s < conv->nstages; s++)
+        {
+            fluid_conv_stage *st = &conv->stage[s];
+            const fluid_real_t *sl = st->out_l + st->pos, *sr = st->out_r + st->pos;
+            fluid_real_t *st_in = st->in + st->part + st->pos;
+
+            #pragma omp simd
+            for(i = 0; i < run; i++)
+            {
+                out_l[i] += sl[i];
+                out_r[i] += sr[i];
+                st_in[i] = in[i];
+            }
+
+            st->pos += run;
+
+            if(st->pos == st->part)
+            {
+                fluid_conv_stage_next_block(st, ir->tw_re, ir->tw_im);
+            }
+            else
+            {
+                /* spread the job over the block */
+                fluid_conv_stage_run(st, (int)((long long)st->nsteps * st->pos / st->part),
+                                     ir->tw_re, ir->tw_im);
+            }
+        }
+
+        /* stereo output */
+        if(mix)
+        {
+            #pragma omp simd
+            for(i = 0; i < run; i++)
+            {
+                left_out[i] += out_l[i] * wet1 + out_r[i] * wet2;
+                right_out[i] += out_r[i] * wet1 + out_l[i] * wet2;
+            }
+        }
+        else
+        {
+            #pragma omp simd
+            for(i = 0; i < run; i++)
+            {
+                left_out[i] = out_l[i] * wet1 + out_r[i] * wet2;
+                right_out[i] = out_r[i] * wet1 + out_l[i] * wet2;
+            }
+        }
+
+        /* input peaks */
+        conv->pos += run;
+
+        if(conv->pos == CONV_HEAD_PART)
+        {
+            conv->peaks[conv->peak_idx] = peak;
+            conv->peak_idx = (conv->peak_idx + 1) % conv->npeaks;
+            conv->pos = 0;
+            peak = 0;
+        }
+
+        conv->peak = peak;
+    }
+}
+
+/*
+* Convolution reverb process mix.
+* @param conv the reverb.
+* @param in monophonic buffer input (count samples).
+* @param left_out stereo left processed output (count samples).
+* @param right_out stereo right processed output (count samples).
+* @param count number of samples to process.
+*
+* The processed reverb is mixed in out with samples already there in out.
+*/
+void
+fluid_convrev_processmix(fluid_convrev_t *conv, const fluid_real_t *in,
+                         fluid_real_t *left_out, fluid_real_t *right_out, int count)
+{
+    fluid_convrev_process(conv, in, left_out, right_out, count, TRUE);
+}
+
+/*
+* Convolution reverb process replace.
+* @param conv the reverb.
+* @param in monophonic buffer input (count samples).
+* @param left_out stereo left processed output (count samples).
+* @param right_out stereo right processed output (count samples).
+* @param count number of samples to process.
+*
+* The processed reverb is replacing anything there in out.
+*/
+void
+fluid_convrev_processreplace(fluid_convrev_t *conv, const fluid_real_t *in,
+                             fluid_real_t *left_out, fluid_real_t *right_out, int count)
+{
+    fluid_convrev_process(conv, in, left_out, right_out, count, FALSE);
+}
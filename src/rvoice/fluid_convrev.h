@@ -0,0 +1,62 @@
+/* FluidSynth - A Software Synthesizer
+ *
+ * Copyright (C) 2003  Peter Hanappe and others.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1 of
+ * the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see
+ * <https://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef _FLUID_CONVREV_H
+#define _FLUID_CONVREV_H
+
+#include "fluidsynth_priv.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct _fluid_convrev_t fluid_convrev_t;
+typedef struct _fluid_convrev_ir_t fluid_convrev_ir_t;
+
+/*
+ * impulse response, shared by the convolution reverbs created from it
+ */
+fluid_convrev_ir_t *new_fluid_convrev_ir(const float *left, const float *right, int frames,
+                                         fluid_real_t ir_sample_rate, fluid_real_t sample_rate);
+fluid_convrev_ir_t *new_fluid_convrev_ir_from_file(const char *filename, fluid_real_t sample_rate);
+void delete_fluid_convrev_ir(fluid_convrev_ir_t *ir);
+
+/*
+ * convolution reverb
+ */
+fluid_convrev_t *new_fluid_convrev(fluid_convrev_ir_t *ir);
+void delete_fluid_convrev(fluid_convrev_t *conv);
+void fluid_convrev_reset(fluid_convrev_t *conv);
+
+void fluid_convrev_set(fluid_convrev_t *conv, int set, fluid_real_t width, fluid_real_t level);
+
+fluid_real_t fluid_convrev_get_tail_level(fluid_convrev_t *conv);
+int fluid_convrev_get_tail_length(fluid_convrev_t *conv);
+
+void fluid_convrev_processmix(fluid_convrev_t *conv, const fluid_real_t *in,
+                              fluid_real_t *left_out, fluid_real_t *right_out, int count);
+void fluid_convrev_processreplace(fluid_convrev_t *conv, const fluid_real_t *in,
+                                  fluid_real_t *left_out, fluid_real_t *right_out, int count);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _FLUID_CONVREV_H */
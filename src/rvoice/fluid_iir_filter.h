@@ -71,6 +71,11 @@ struct _fluid_iir_filter_t
     fluid_real_t last_q;            /* The filter's current (smoothed) Q-factor (or "bandwidth", or "resonance-friendlyness") on a linear scale. Just like fres, this will converge towards its target Q once q_incr_count has become zero. */
     fluid_real_t q_incr;            /* The linear increment of q each sample */
     int q_incr_count;               /* The number of samples left for the smoothed Q adjustment to complete */
+
+    /* Inputs and outcome of the last fluid_iir_filter_calc(), used to skip it while nothing changes */
+    fluid_real_t calc_fres_in;      /* fres + fres_mod in absolute cents */
+    fluid_real_t calc_output_rate;  /* output rate the frequency was clipped against */
+    fluid_real_t calc_fres;         /* resulting resonance frequency in absolute cents */
 #ifdef DBG_FILTER
     fluid_real_t target_fres;       /* The filter's target fres, that last_fres should converge towards - for debugging only */
     fluid_real_t target_q;          /* The filter's target Q - for debugging only */
@@ -78,7 +83,7 @@ struct _fluid_iir_filter_t
 
     // the final gain amplifier to be applied by the last filter in the chain, zero for all other filters
     fluid_real_t amp;                /* current linear amplitude */
-    fluid_real_t amp_incr;           /* amplitude increment value for the next FLUID_BUFSIZE samples */
+    fluid_real_t amp_incr;           /* amplitude increment value for the samples of the next block */
 
     fluid_iir_sincos_t *sincos_table; /* pointer to the precalculated sin and cos values, owned by the synth */
 };
@@ -96,6 +101,17 @@ enum
 
 typedef struct _fluid_iir_filter_t fluid_iir_filter_t;
 
+/* Maximum number of filters run side by side by fluid_iir_filter_apply_bank() */
+#define FLUID_IIR_BANK_LANES 8
+
+/* A buffer that a filtered block gets mixed into, see fluid_iir_filter_apply_mix() */
+typedef struct
+{
+    fluid_real_t *buf;          /* one block of samples to add the block to */
+    fluid_real_t amp;           /* amplitude of the first sample */
+    fluid_real_t amp_incr;      /* amplitude increment per sample */
+} fluid_iir_filter_dest_t;
+
 DECLARE_FLUID_RVOICE_FUNCTION(fluid_iir_filter_init);
 DECLARE_FLUID_RVOICE_FUNCTION(fluid_iir_filter_set_fres);
 DECLARE_FLUID_RVOICE_FUNCTION(fluid_iir_filter_set_q);
@@ -110,7 +126,31 @@ void fluid_iir_filter_calc(fluid_iir_filter_t *iir_filter,
 void fluid_iir_filter_apply(fluid_iir_filter_t *iir_filter,
                             fluid_iir_filter_t *custom_filter,
                             fluid_real_t *dsp_buf,
-                            unsigned int count);
+                            unsigned int count,
+                            int cpu_isa);
+
+void fluid_iir_filter_apply_bank(fluid_iir_filter_t *iir_filters[],
+                                 fluid_iir_filter_t *custom_filters[],
+                                 fluid_real_t *dsp_bufs[],
+                                 int count,
+                                 int block_size,
+                                 int cpu_isa);
+
+int fluid_iir_filter_apply_mix(fluid_iir_filter_t *iir_filter,
+                               fluid_iir_filter_t *custom_filter,
+                               fluid_real_t *dsp_buf,
+                               int block_size,
+                               const fluid_iir_filter_dest_t *dests,
+                               int dest_count,
+                               int cpu_isa);
+
+/* TRUE if the filter is going to process the next samples, FALSE if it lets them pass unmodified */
+static FLUID_INLINE int
+fluid_iir_filter_is_active(const fluid_iir_filter_t *iir_filter)
+{
+    // FLUID_IIR_Q_LINEAR may switch the filter off by setting Q==0
+    return iir_filter->type != FLUID_IIR_DISABLED && iir_filter->last_q >= Q_MIN;
+}
 
 #ifdef __cplusplus
 }
@@ -141,6 +141,8 @@ static inline void fluid_iir_filter_calculate_coefficients(R fres,
  * @param iir_filter Filter parameter
  * @param dsp_buf Pointer to the synthesized audio data
  * @param count Count of samples in dsp_buf
+ * @param dests If MIX, buffers to add the filtered samples to, dsp_buf is left untouched then
+ * @param dest_count Length of dests
  */
 /*
  * Variable description:
@@ -154,9 +156,10 @@ static inline void fluid_iir_filter_calculate_coefficients(R fres,
  * - dsp_hist1: same
  * - dsp_hist2: same
  */
-template<bool GAIN_NORM, bool AMPLIFY, enum fluid_iir_filter_type TYPE>
+template<bool GAIN_NORM, bool AMPLIFY, enum fluid_iir_filter_type TYPE, bool MIX = false>
 static void
-fluid_iir_filter_apply_local(fluid_iir_filter_t *iir_filter, fluid_real_t *dsp_buf, unsigned int count)
+fluid_iir_filter_apply_local(fluid_iir_filter_t *iir_filter, fluid_real_t *dsp_buf, unsigned int count,
+                             const fluid_iir_filter_dest_t *dests = NULL, int dest_count = 0)
 {
     // FLUID_IIR_Q_LINEAR may switch the filter off by setting Q==0
     // Due to the linear smoothing, last_q may not exactly become zero.
@@ -214,9 +217,18 @@ fluid_iir_filter_apply_local(fluid_iir_filter_t *iir_filter, fluid_real_t *dsp_b
 
             if(AMPLIFY)
             {
-                dsp_buf[dsp_i] = dsp_amp * sample;
+                sample = dsp_amp * sample;
                 dsp_amp += dsp_amp_incr;
             }
+
+            if(MIX)
+            {
+                /* same arithmetic as fluid_rvoice_buffers_mix() */
+                for(int i = 0; i < dest_count; i++)
+                {
+                    dests[i].buf[dsp_i] += (dests[i].amp + dests[i].amp_incr * static_cast<int>(dsp_i)) * sample;
+                }
+            }
             else
             {
                 dsp_buf[dsp_i] = sample;
@@ -274,10 +286,9 @@ fluid_iir_filter_apply_local(fluid_iir_filter_t *iir_filter, fluid_real_t *dsp_b
     }
 }
 
-extern "C" void fluid_iir_filter_apply(fluid_iir_filter_t *resonant_filter,
-                                       fluid_iir_filter_t *resonant_custom_filter,
-                                       fluid_real_t *dsp_buf,
-                                       unsigned int count)
+static void fluid_iir_filter_apply_custom(fluid_iir_filter_t *resonant_custom_filter,
+                                          fluid_real_t *dsp_buf,
+                                          unsigned int count)
 {
     if(resonant_custom_filter->flags & FLUID_IIR_NO_GAIN_AMP)
     {
@@ -301,25 +312,341 @@ extern "C" void fluid_iir_filter_apply(fluid_iir_filter_t *resonant_filter,
             fluid_iir_filter_apply_local<true, false, FLUID_IIR_LOWPASS>(resonant_custom_filter, dsp_buf, count);
         }
     }
+}
+
+static void fluid_iir_filter_apply_generic(fluid_iir_filter_t *resonant_filter,
+                                          fluid_iir_filter_t *resonant_custom_filter,
+                                          fluid_real_t *dsp_buf,
+                                          unsigned int count)
+{
+    fluid_iir_filter_apply_custom(resonant_custom_filter, dsp_buf, count);
 
     // This is the last filter in the chain - the default SF2 filter that always runs. This one must apply the final envelope gain.
     fluid_iir_filter_apply_local<true, true, FLUID_IIR_LOWPASS>(resonant_filter, dsp_buf, count);
 }
 
+#if FLUID_CPU_DISPATCH
+FLUID_TARGET_AVX2 static void fluid_iir_filter_apply_avx2(fluid_iir_filter_t *resonant_filter,
+                                                          fluid_iir_filter_t *resonant_custom_filter,
+                                                          fluid_real_t *dsp_buf,
+                                                          unsigned int count)
+{
+    fluid_iir_filter_apply_generic(resonant_filter, resonant_custom_filter, dsp_buf, count);
+}
+
+FLUID_TARGET_AVX512 static void fluid_iir_filter_apply_avx512(fluid_iir_filter_t *resonant_filter,
+                                                              fluid_iir_filter_t *resonant_custom_filter,
+                                                              fluid_real_t *dsp_buf,
+                                                              unsigned int count)
+{
+    fluid_iir_filter_apply_generic(resonant_filter, resonant_custom_filter, dsp_buf, count);
+}
+#endif
+
+extern "C" void fluid_iir_filter_apply(fluid_iir_filter_t *resonant_filter,
+                                       fluid_iir_filter_t *resonant_custom_filter,
+                                       fluid_real_t *dsp_buf,
+                                       unsigned int count,
+                                       int cpu_isa)
+{
+    switch(cpu_isa)
+    {
+#if FLUID_CPU_DISPATCH
+    case FLUID_CPU_ISA_AVX512:
+        fluid_iir_filter_apply_avx512(resonant_filter, resonant_custom_filter, dsp_buf, count);
+        break;
+
+    case FLUID_CPU_ISA_AVX2:
+        fluid_iir_filter_apply_avx2(resonant_filter, resonant_custom_filter, dsp_buf, count);
+        break;
+#endif
+
+    default:
+        fluid_iir_filter_apply_generic(resonant_filter, resonant_custom_filter, dsp_buf, count);
+        break;
+    }
+}
+
+/**
+ * Applies the filters of several voices to a full block each.
+ *
+ * The biquad's feedback path prevents vectorizing a single filter over time. Instead, the
+ * default filters of up to #FLUID_IIR_BANK_LANES voices are transposed into arrays and the
+ * innermost loop runs across voices, so that each SIMD instruction advances several filters
+ * by one sample. Coefficient smoothing is done per lane, with the same arithmetic as in
+ * fluid_iir_filter_apply_local(), i.e. the output is identical to fluid_iir_filter_apply().
+ *
+ * The custom filters are applied one by one beforehand, they are rarely active.
+ *
+ * @param resonant_filters The default SF2 filters, must all be active, see fluid_iir_filter_is_active()
+ * @param resonant_custom_filters The custom filters, one per voice
+ * @param dsp_bufs The blocks to filter in place (block_size in length each)
+ * @param count Number of voices, must not exceed #FLUID_IIR_BANK_LANES
+ * @param block_size Number of samples per block
+ */
+static void fluid_iir_filter_apply_bank_generic(fluid_iir_filter_t *resonant_filters[],
+                                                fluid_iir_filter_t *resonant_custom_filters[],
+                                                fluid_real_t *dsp_bufs[],
+                                                int count, int block_size)
+{
+    fluid_real_t dsp_hist1[FLUID_IIR_BANK_LANES], dsp_hist2[FLUID_IIR_BANK_LANES];
+    fluid_real_t dsp_amp[FLUID_IIR_BANK_LANES], dsp_amp_incr[FLUID_IIR_BANK_LANES];
+    IIR_COEFF_T dsp_a1[FLUID_IIR_BANK_LANES], dsp_a2[FLUID_IIR_BANK_LANES];
+    IIR_COEFF_T dsp_b02[FLUID_IIR_BANK_LANES], dsp_b1[FLUID_IIR_BANK_LANES];
+    IIR_COEFF_T fres[FLUID_IIR_BANK_LANES], fres_incr[FLUID_IIR_BANK_LANES];
+    IIR_COEFF_T q[FLUID_IIR_BANK_LANES], q_incr[FLUID_IIR_BANK_LANES];
+    int fres_incr_count[FLUID_IIR_BANK_LANES], q_incr_count[FLUID_IIR_BANK_LANES];
+    fluid_iir_sincos_t *sincos_table[FLUID_IIR_BANK_LANES];
+    int lane;
+
+    FLUID_ASSERT(count <= FLUID_IIR_BANK_LANES);
+
+    for(lane = 0; lane < count; lane++)
+    {
+        fluid_iir_filter_t *iir_filter = resonant_filters[lane];
+
+        FLUID_ASSERT(fluid_iir_filter_is_active(iir_filter));
+
+        fluid_iir_filter_apply_custom(resonant_custom_filters[lane], dsp_bufs[lane], block_size);
+
+        dsp_hist1[lane] = iir_filter->hist1;
+        dsp_hist2[lane] = iir_filter->hist2;
+        dsp_a1[lane] = iir_filter->a1;
+        dsp_a2[lane] = iir_filter->a2;
+        dsp_b02[lane] = iir_filter->b02;
+        dsp_b1[lane] = iir_filter->b1;
+        dsp_amp[lane] = iir_filter->amp;
+        dsp_amp_incr[lane] = iir_filter->amp_incr;
+        fres[lane] = static_cast<IIR_COEFF_T>(iir_filter->last_fres);
+        fres_incr[lane] = static_cast<IIR_COEFF_T>(iir_filter->fres_incr);
+        fres_incr_count[lane] = iir_filter->fres_incr_count;
+        q[lane] = static_cast<IIR_COEFF_T>(iir_filter->last_q);
+        q_incr[lane] = static_cast<IIR_COEFF_T>(iir_filter->q_incr);
+        q_incr_count[lane] = iir_filter->q_incr_count;
+        sincos_table[lane] = iir_filter->sincos_table;
+    }
+
+    for(int dsp_i = 0; dsp_i < block_size; dsp_i++)
+    {
+        #pragma omp simd
+        for(lane = 0; lane < count; lane++)
+        {
+            /* The filter is implemented in Direct-II form. */
+            fluid_real_t dsp_centernode = dsp_bufs[lane][dsp_i] - dsp_a1[lane] * dsp_hist1[lane] - dsp_a2[lane] * dsp_hist2[lane];
+            fluid_real_t sample = dsp_b02[lane] * (dsp_centernode + dsp_hist2[lane]) + dsp_b1[lane] * dsp_hist1[lane];
+            dsp_hist2[lane] = dsp_hist1[lane];
+            dsp_hist1[lane] = dsp_centernode;
+
+            dsp_bufs[lane][dsp_i] = dsp_amp[lane] * sample;
+            dsp_amp[lane] += dsp_amp_incr[lane];
+
+            if(fres_incr_count[lane] > 0 || q_incr_count[lane] > 0)
+            {
+                if(fres_incr_count[lane] > 0)
+                {
+                    --fres_incr_count[lane];
+                    fres[lane] += fres_incr[lane];
+                }
+                if(q_incr_count[lane] > 0)
+                {
+                    --q_incr_count[lane];
+                    q[lane] += q_incr[lane];
+                    if(q[lane] < Q_MIN)
+                    {
+                        q_incr_count[lane] = 0;
+                        q[lane] = Q_MIN;
+                    }
+                }
+
+                fluid_iir_filter_calculate_coefficients<IIR_COEFF_T, true, FLUID_IIR_LOWPASS>(fres[lane], q[lane], sincos_table[lane],
+                        &dsp_a1[lane], &dsp_a2[lane], &dsp_b02[lane], &dsp_b1[lane]);
+            }
+        }
+    }
+
+    for(lane = 0; lane < count; lane++)
+    {
+        fluid_iir_filter_t *iir_filter = resonant_filters[lane];
+
+        iir_filter->a1 = dsp_a1[lane];
+        iir_filter->a2 = dsp_a2[lane];
+        iir_filter->b02 = dsp_b02[lane];
+        iir_filter->b1 = dsp_b1[lane];
+
+        /* Check for denormal number (too close to zero). */
+        if (FLUID_FABS(dsp_hist1[lane]) < 1e-20f)
+        {
+            dsp_hist1[lane] = 0.0f;
+        }
+        if (FLUID_FABS(dsp_hist2[lane]) < 1e-20f)
+        {
+            dsp_hist2[lane] = 0.0f;
+        }
+        iir_filter->hist1 = dsp_hist1[lane];
+        iir_filter->hist2 = dsp_hist2[lane];
+
+        iir_filter->last_fres = fres[lane];
+        iir_filter->fres_incr_count = fres_incr_count[lane];
+        iir_filter->last_q = q[lane];
+        iir_filter->q_incr_count = q_incr_count[lane];
+        iir_filter->amp = dsp_amp[lane];
+    }
+}
+
+#if FLUID_CPU_DISPATCH
+FLUID_TARGET_AVX2 static void fluid_iir_filter_apply_bank_avx2(fluid_iir_filter_t *resonant_filters[],
+                                                               fluid_iir_filter_t *resonant_custom_filters[],
+                                                               fluid_real_t *dsp_bufs[],
+                                                               int count, int block_size)
+{
+    fluid_iir_filter_apply_bank_generic(resonant_filters, resonant_custom_filters, dsp_bufs, count, block_size);
+}
+
+FLUID_TARGET_AVX512 static void fluid_iir_filter_apply_bank_avx512(fluid_iir_filter_t *resonant_filters[],
+                                                                   fluid_iir_filter_t *resonant_custom_filters[],
+                                                                   fluid_real_t *dsp_bufs[],
+                                                                   int count, int block_size)
+{
+    fluid_iir_filter_apply_bank_generic(resonant_filters, resonant_custom_filters, dsp_bufs, count, block_size);
+}
+#endif
+
+extern "C" void fluid_iir_filter_apply_bank(fluid_iir_filter_t *resonant_filters[],
+                                            fluid_iir_filter_t *resonant_custom_filters[],
+                                            fluid_real_t *dsp_bufs[],
+                                            int count,
+                                            int block_size,
+                                            int cpu_isa)
+{
+    switch(cpu_isa)
+    {
+#if FLUID_CPU_DISPATCH
+    case FLUID_CPU_ISA_AVX512:
+        fluid_iir_filter_apply_bank_avx512(resonant_filters, resonant_custom_filters, dsp_bufs, count, block_size);
+        break;
+
+    case FLUID_CPU_ISA_AVX2:
+        fluid_iir_filter_apply_bank_avx2(resonant_filters, resonant_custom_filters, dsp_bufs, count, block_size);
+        break;
+#endif
+
+    default:
+        fluid_iir_filter_apply_bank_generic(resonant_filters, resonant_custom_filters, dsp_bufs, count, block_size);
+        break;
+    }
+}
+
+/**
+ * Applies the filters of a voice to a full block and mixes the result into several buffers
+ * in one go.
+ *
+ * This is the fused counterpart of fluid_iir_filter_apply() followed by a mixdown into each
+ * buffer. The feedback path of the last filter is a chain of dependent multiplications per
+ * sample, the additions into the destination buffers are independent of it and fill the
+ * pipeline for free. It also saves writing back the filtered block and reading it once per
+ * destination buffer. The result is identical to the separate passes.
+ *
+ * @param resonant_filter The default SF2 filter of the voice, also applies the envelope gain
+ * @param resonant_custom_filter The custom filter of the voice, applied to dsp_buf in place
+ * @param dsp_buf The interpolated block
+ * @param block_size Length of dsp_buf
+ * @param dests Buffers to mix into
+ * @param dest_count Length of dests
+ * @return TRUE if the block has been processed, FALSE if the default filter is inactive and
+ *   the block has to go through fluid_iir_filter_apply() (nothing has been modified then)
+ */
+static int fluid_iir_filter_apply_mix_generic(fluid_iir_filter_t *resonant_filter,
+                                              fluid_iir_filter_t *resonant_custom_filter,
+                                              fluid_real_t *dsp_buf,
+                                              int block_size,
+                                              const fluid_iir_filter_dest_t *dests,
+                                              int dest_count)
+{
+    // An inactive filter does not apply the envelope gain either, let the caller deal with that.
+    if(!fluid_iir_filter_is_active(resonant_filter))
+    {
+        return FALSE;
+    }
+
+    fluid_iir_filter_apply_custom(resonant_custom_filter, dsp_buf, block_size);
+    fluid_iir_filter_apply_local<true, true, FLUID_IIR_LOWPASS, true>(resonant_filter, dsp_buf, block_size,
+                                                                      dests, dest_count);
+    return TRUE;
+}
+
+#if FLUID_CPU_DISPATCH
+FLUID_TARGET_AVX2 static int fluid_iir_filter_apply_mix_avx2(fluid_iir_filter_t *resonant_filter,
+                                                             fluid_iir_filter_t *resonant_custom_filter,
+                                                             fluid_real_t *dsp_buf,
+                                                             int block_size,
+                                                             const fluid_iir_filter_dest_t *dests,
+                                                             int dest_count)
+{
+    return fluid_iir_filter_apply_mix_generic(resonant_filter, resonant_custom_filter, dsp_buf, block_size, dests, dest_count);
+}
+
+FLUID_TARGET_AVX512 static int fluid_iir_filter_apply_mix_avx512(fluid_iir_filter_t *resonant_filter,
+                                                                 fluid_iir_filter_t *resonant_custom_filter,
+                                                                 fluid_real_t *dsp_buf,
+                                                                 int block_size,
+                                                                 const fluid_iir_filter_dest_t *dests,
+                                                                 int dest_count)
+{
+    return fluid_iir_filter_apply_mix_generic(resonant_filter, resonant_custom_filter, dsp_buf, block_size, dests, dest_count);
+}
+#endif
+
+extern "C" int fluid_iir_filter_apply_mix(fluid_iir_filter_t *resonant_filter,
+                                          fluid_iir_filter_t *resonant_custom_filter,
+                                          fluid_real_t *dsp_buf,
+                                          int block_size,
+                                          const fluid_iir_filter_dest_t *dests,
+                                          int dest_count,
+                                          int cpu_isa)
+{
+    switch(cpu_isa)
+    {
+#if FLUID_CPU_DISPATCH
+    case FLUID_CPU_ISA_AVX512:
+        return fluid_iir_filter_apply_mix_avx512(resonant_filter, resonant_custom_filter, dsp_buf, block_size, dests, dest_count);
+
+    case FLUID_CPU_ISA_AVX2:
+        return fluid_iir_filter_apply_mix_avx2(resonant_filter, resonant_custom_filter, dsp_buf, block_size, dests, dest_count);
+#endif
+
+    default:
+        return fluid_iir_filter_apply_mix_generic(resonant_filter, resonant_custom_filter, dsp_buf, block_size, dests, dest_count);
+    }
+}
+
 void fluid_iir_filter_calc(fluid_iir_filter_t *iir_filter,
                            fluid_real_t output_rate,
                            fluid_real_t fres_mod)
 {
     bool calc_coeff_flag = false;
-    fluid_real_t fres, fres_diff;
+    fluid_real_t fres, fres_diff, fres_in;
     
     if(iir_filter->type == FLUID_IIR_DISABLED)
     {
         return;
     }
 
+    fres_in = iir_filter->fres + fres_mod;
+
+    /* The filter has settled on the same frequency it was given last time,
+     * so the code below would neither change last_fres nor the coefficients.
+     * Skip the expensive cents <-> Hz conversions in that case. */
+    if(!iir_filter->filter_startup
+            && iir_filter->fres_incr_count == 0
+            && fres_in == iir_filter->calc_fres_in
+            && output_rate == iir_filter->calc_output_rate
+            && iir_filter->last_fres == iir_filter->calc_fres)
+    {
+        return;
+    }
+
     /* calculate the frequency of the resonant filter in Hz */
-    fres = fluid_ct2hz(iir_filter->fres + fres_mod);
+    fres = fluid_ct2hz(fres_in);
 
     /* I removed the optimization of turning the filter off when the
      * resonance frequency is above the maximum frequency. Instead, the
@@ -343,6 +670,10 @@ void fluid_iir_filter_calc(fluid_iir_filter_t *iir_filter,
     LOG_FILTER("%f + %f = %f cents = %f Hz | Q: %f", iir_filter->fres, fres_mod, iir_filter->fres + fres_mod, fres, iir_filter->last_q);
     
     fres = fluid_hz2ct(fres);
+
+    iir_filter->calc_fres_in = fres_in;
+    iir_filter->calc_output_rate = output_rate;
+    iir_filter->calc_fres = fres;
     
     /* if filter enabled and there is a significant frequency change.. */
     fres_diff = fres - iir_filter->last_fres;
@@ -0,0 +1,816 @@
+/* FluidSynth - A Software Synthesizer
+ *
+ * Copyright (C) 2003  Peter Hanappe and others.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1 of
+ * the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see
+ * <https://www.gnu.org/licenses/>.
+ */
+
+/*
+  Insert effects of a stereo channel: a three band equalizer, a compressor
+  and a lookahead limiter, in this order. Each of them can be switched on and
+  off on its own, the channel is left untouched while all are off.
+
+  The channel is processed in chunks of INSERTFX_CHUNK samples. The recursive
+  parts (the biquads of the equalizer, the envelope of the compressor and the
+  running minimum of the limiter) go sample by sample, with both channels in
+  the same loop. Everything else (levels, gain ramps, gains) is done in simd
+  loops over the whole chunk.
+
+  - Equalizer: low shelf, peaking and high shelf biquads (RBJ cookbook),
+    transposed direct form II. A band with a gain of 0 dB is skipped.
+  - Compressor: peak or RMS envelope of the louder channel, with separate
+    attack and release times. In RMS mode the squared signal is first
+    averaged over INSERTFX_RMS_WINDOW. The gain is computed at the end of every chunk
+    and ramped linearly over the chunk.
+  - Limiter: brickwall, the output never exceeds the ceiling. The signal is
+    delayed by the lookahead time (L samples). The gain needed by every input
+    sample is held for L + 1 samples (running minimum), released towards 1,
+    then smoothed by a moving average over L + 1 samples. The average reaches
+    the gain needed by a sample at the latest when that sample leaves the
+    delay line, as all the averaged values are below it.
+*/
+
+#include "fluid_insertfx.h"
+#include "fluid_rvoice_mixer.h"
+#include "fluid_sys.h"
+
+#define INSERTFX_CHUNK 32 /* samples per gain update of the compressor */
+#define INSERTFX_BANDS 3  /* low shelf, peaking, high shelf */
+#define INSERTFX_MAX_LOOKAHEAD 10.0 /* ms */
+#define INSERTFX_RMS_WINDOW 10.0 /* ms, averaging time of the RMS level */
+#define INSERTFX_SHELF_Q ((fluid_real_t)0.70710678118654752440) /* slope of 1 */
+
+/* description of the parameters, in the order of #fluid_insert_fx_param */
+static const struct
+{
+    const char *name;
+    double def, min, max;
+    int toggle;
+} fluid_insertfx_params[FLUID_INSERT_FX_PARAM_LAST] =
+{
+    { "eq.active", 0, 0, 1, TRUE },
+    { "eq.low.freq", 100, 20, 20000, FALSE },
+    { "eq.low.gain", 0, -24, 24, FALSE },
+    { "eq.mid.freq", 1000, 20, 20000, FALSE },
+    { "eq.mid.gain", 0, -24, 24, FALSE },
+    { "eq.mid.q", 0.7, 0.1, 10, FALSE },
+    { "eq.high.freq", 8000, 20, 20000, FALSE },
+    { "eq.high.gain", 0, -24, 24, FALSE },
+    { "compressor.active", 0, 0, 1, TRUE },
+    { "compressor.threshold", -20, -60, 0, FALSE },
+    { "compressor.ratio", 4, 1, 20, FALSE },
+    { "compressor.attack", 5, 0.1, 100, FALSE },
+    { "compressor.release", 100, 1, 2000, FALSE },
+    { "compressor.makeup", 0, 0, 24, FALSE },
+    { "compressor.rms", 0, 0, 1, TRUE },
+    { "limiter.active", 0, 0, 1, TRUE },
+    { "limiter.ceiling", -1, -24, 0, FALSE },
+    { "limiter.lookahead", 2, 0, INSERTFX_MAX_LOOKAHEAD, FALSE },
+    { "limiter.release", 50, 1, 2000, FALSE }
+};
+
+typedef struct
+{
+    fluid_real_t b0, b1, b2, a1, a2; /* coefficients, normalized by a0 */
+    fluid_real_t z1[2], z2[2];       /* state of each channel */
+    int on;
+} fluid_insertfx_biquad;
+
+struct _fluid_insertfx_t
+{
+    fluid_real_t sample_rate;
+    fluid_real_t param[FLUID_INSERT_FX_PARAM_LAST];
+
+    /* equalizer */
+    fluid_insertfx_biquad band[INSERTFX_BANDS];
+
+    /* compressor */
+    fluid_real_t comp_env;        /* envelope, mean square in rms mode */
+    fluid_real_t comp_ms;         /* mean square of the signal, rms mode */
+    fluid_real_t comp_rms;        /* averaging coefficient of the mean square */
+    fluid_real_t comp_gain;       /* gain at the end of the last chunk */
+    fluid_real_t comp_attack;     /* envelope coefficients */
+    fluid_real_t comp_release;
+    fluid_real_t comp_threshold;  /* linear */
+    fluid_real_t comp_slope;      /* 1 / ratio - 1 */
+    fluid_real_t comp_makeup;     /* linear */
+
+    /* limiter */
+    fluid_real_t lim_ceiling;     /* linear */
+    fluid_real_t lim_release;     /* release coefficient */
+    int lim_len;                  /* lookahead + 1 samples, length of the minimum and the average */
+    int lim_size;                 /* size of the rings below, a power of 2 */
+    fluid_real_t *lim_delay_l;    /* delay lines */
+    fluid_real_t *lim_delay_r;
+    fluid_real_t *lim_min_val;    /* running minimum: increasing gains and their */
+    unsigned int *lim_min_time;   /* times, from lim_min_head to lim_min_tail */
+    unsigned int lim_min_head, lim_min_tail;
+    fluid_real_t *lim_avg;        /* moving average: the last lim_len held gains */
+    double lim_sum;
+    int lim_avg_pos;
+    fluid_real_t lim_hold;        /* held gain, with release */
+    unsigned int lim_time;        /* samples processed, modulo 2^32 */
+
+    /* silent samples in a row at the input, see fluid_insertfx_is_idle() */
+    int silent;
+    int idle;
+};
+
+/*-----------------------------------------------------------------------------
+ Computes the coefficients of one band of the equalizer.
+-----------------------------------------------------------------------------*/
+static void
+fluid_insertfx_update_band(fluid_insertfx_t *fx, int band, fluid_real_t freq,
+                           fluid_real_t gain, fluid_real_t q)
+{
+    fluid_insertfx_biquad *bq = &fx->band[band];
+    fluid_real_t a = FLUID_POW(10.0, gain / 40.0);
+    fluid_real_t w0, cosw0, alpha, sqa, a0;
+
+    if(gain == 0)
+    {
+        /* flat, the band is skipped */
+        FLUID_MEMSET(bq, 0, sizeof(*bq));
+        return;
+    }
+
+    if(freq > 0.45 * fx->sample_rate)
+    {
+        freq = 0.45 * fx->sample_rate;
+    }
+
+    w0 = 2.0 * FLUID_M_PI * freq / fx->sample_rate;
+    cosw0 = FLUID_COS(w0);
+    alpha = FLUID_SIN(w0) / (2.0 * q);
+    sqa = 2.0 * FLUID_SQRT(a) * alpha;
+
+    if(band == 1)
+    {
+        /* peaking */
+        a0 = 1 + alpha / a;
+        bq->b0 = (1 + alpha * a) / a0;
+        bq->b1 = -2 * cosw0 / a0;
+        bq->b2 = (1 - alpha * a) / a0;
+        bq->a1 = -2 * cosw0 / a0;
+        bq->a2 = (1 - alpha / a) / a0;
+    }
+    else if(band == 0)
+    {
+        /* low shelf */
+        a0 = (a + 1) + (a - 1) * cosw0 + sqa;
+        bq->b0 = a * ((a + 1) - (a - 1) * cosw0 + sqa) / a0;
+        bq->b1 = 2 * a * ((a - 1) - (a + 1) * cosw0) / a0;
+        bq->b2 = a * ((a + 1) - (a - 1) * cosw0 - sqa) / a0;
+        bq->a1 = -2 * ((a - 1) + (a + 1) * cosw0) / a0;
+        bq->a2 = ((a + 1) + (a - 1) * cosw0 - sqa) / a0;
+    }
+    else
+    {
+        /* high shelf */
+        a0 = (a + 1) - (a - 1) * cosw0 + sqa;
+        bq->b0 = a * ((a + 1) + (a - 1) * cosw0 + sqa) / a0;
+        bq->b1 = -2 * a * ((a - 1) + (a + 1) * cosw0) / a0;
+        bq->b2 = a * ((a + 1) + (a - 1) * cosw0 - sqa) / a0;
+        bq->a1 = 2 * ((a - 1) - (a + 1) * cosw0) / a0;
+        bq->a2 = ((a + 1) - (a - 1) * cosw0 - sqa) / a0;
+    }
+
+    bq->on = TRUE;
+}
+
+/*-----------------------------------------------------------------------------
+ Coefficient of a one pole smoother with a time constant of n samples.
+-----------------------------------------------------------------------------*/
+static fluid_real_t
+fluid_insertfx_coef(fluid_real_t n)
+{
+    return (fluid_real_t)(1.0 - exp(-1.0 / n));
+}
+
+/*-----------------------------------------------------------------------------
+ Updates the coefficients of the effects from the parameters.
+-----------------------------------------------------------------------------*/
+/* Clears the state of the equalizer filters */
+static void
+fluid_insertfx_reset_eq(fluid_insertfx_t *fx)
+{
+    int i;
+
+    for(i = 0; i < INSERTFX_BANDS; i++)
+    {
+        FLUID_MEMSET(fx->band[i].z1, 0, sizeof(fx->band[i].z1));
+        FLUID_MEMSET(fx->band[i].z2, 0, sizeof(fx->band[i].z2));
+    }
+}
+
+/* Clears the envelope of the compressor, the gain restarting from the makeup */
+static void
+fluid_insertfx_reset_compressor(fluid_insertfx_t *fx)
+{
+    fx->comp_env = 0;
+    fx->comp_ms = 0;
+    fx->comp_gain = fx->comp_makeup;
+}
+
+/* Clears the delay line and the gain tracking of the limiter */
+static void
+fluid_insertfx_reset_limiter(fluid_insertfx_t *fx)
+{
+    int i;
+
+    FLUID_MEMSET(fx->lim_delay_l, 0, 2 * fx->lim_size * sizeof(fluid_real_t));
+
+    for(i = 0; i < fx->lim_len; i++)
+    {
+        fx->lim_avg[i] = 1;
+    }
+
+    fx->lim_sum = fx->lim_len;
+    fx->lim_avg_pos = 0;
+    fx->lim_hold = 1;
+    fx->lim_min_head = fx->lim_min_tail = 0;
+    fx->lim_time = 0;
+}
+
+static void
+fluid_insertfx_update(fluid_insertfx_t *fx)
+{
+    const fluid_real_t *p = fx->param;
+    fluid_real_t ms = fx->sample_rate / 1000.0; /* samples per ms */
+    int lim_len;
+
+    fluid_insertfx_update_band(fx, 0, p[FLUID_INSERT_EQ_LOW_FREQ], p[FLUID_INSERT_EQ_LOW_GAIN], INSERTFX_SHELF_Q);
+    fluid_insertfx_update_band(fx, 1, p[FLUID_INSERT_EQ_MID_FREQ], p[FLUID_INSERT_EQ_MID_GAIN], p[FLUID_INSERT_EQ_MID_Q]);
+    fluid_insertfx_update_band(fx, 2, p[FLUID_INSERT_EQ_HIGH_FREQ], p[FLUID_INSERT_EQ_HIGH_GAIN], INSERTFX_SHELF_Q);
+
+    fx->comp_attack = fluid_insertfx_coef(p[FLUID_INSERT_COMPRESSOR_ATTACK] * ms);
+    fx->comp_release = fluid_insertfx_coef(p[FLUID_INSERT_COMPRESSOR_RELEASE] * ms);
+    fx->comp_rms = fluid_insertfx_coef(INSERTFX_RMS_WINDOW * ms);
+    fx->comp_threshold = FLUID_POW(10.0, p[FLUID_INSERT_COMPRESSOR_THRESHOLD] / 20.0);
+    fx->comp_slope = 1.0 / p[FLUID_INSERT_COMPRESSOR_RATIO] - 1.0;
+    fx->comp_makeup = FLUID_POW(10.0, p[FLUID_INSERT_COMPRESSOR_MAKEUP] / 20.0);
+
+    fx->lim_ceiling = FLUID_POW(10.0, p[FLUID_INSERT_LIMITER_CEILING] / 20.0);
+    fx->lim_release = fluid_insertfx_coef(p[FLUID_INSERT_LIMITER_RELEASE] * ms);
+
+    lim_len = (int)(p[FLUID_INSERT_LIMITER_LOOKAHEAD] * ms + 0.5) + 1;
+
+    if(lim_len > fx->lim_size)
+    {
+        lim_len = fx->lim_size;
+    }
+
+    if(lim_len != fx->lim_len)
+    {
+        /* the delay changes, the limiter starts over */
+        fx->lim_len = lim_len;
+        fluid_insertfx_reset_limiter(fx);
+    }
+}
+
+/*----------------------------------------------------------------------------
+                            Insert effects API
+-----------------------------------------------------------------------------*/
+/*
+* Creates the insert effects of a stereo channel, all switched off.
+*
+* @param sample_rate_max maximum sample rate expected, sizes the delay line of
+*  the limiter.
+* @param sample_rate sample rate in Hz.
+* @return pointer on the new effects or NULL if memory error.
+*/
+fluid_insertfx_t *
+new_fluid_insertfx(fluid_real_t sample_rate_max, fluid_real_t sample_rate)
+{
+    fluid_insertfx_t *fx;
+    int i, size = 1;
+
+    fluid_return_val_if_fail(sample_rate > 0, NULL);
+
+    if(sample_rate_max < sample_rate)
+    {
+        sample_rate_max = sample_rate;
+    }
+
+    while(size < INSERTFX_MAX_LOOKAHEAD * sample_rate_max / 1000.0 + 1)
+    {
+        size <<= 1;
+    }
+
+    fx = FLUID_NEW(fluid_insertfx_t);
+
+    if(fx == NULL)
+    {
+        FLUID_LOG(FLUID_ERR, "Out of memory");
+        return NULL;
+    }
+
+    FLUID_MEMSET(fx, 0, sizeof(*fx));
+    fx->sample_rate = sample_rate;
+    fx->lim_size = size;
+    fx->lim_delay_l = FLUID_ARRAY(fluid_real_t, 4 * size);
+    fx->lim_min_time = FLUID_ARRAY(unsigned int, size);
+
+    if(fx->lim_delay_l == NULL || fx->lim_min_time == NULL)
+    {
+        FLUID_LOG(FLUID_ERR, "Out of memory");
+        delete_fluid_insertfx(fx);
+        return NULL;
+    }
+
+    fx->lim_delay_r = fx->lim_delay_l + size;
+    fx->lim_min_val = fx->lim_delay_r + size;
+    fx->lim_avg = fx->lim_min_val + size;
+
+    for(i = 0; i < FLUID_INSERT_FX_PARAM_LAST; i++)
+    {
+        fx->param[i] = fluid_insertfx_params[i].def;
+    }
+
+    fx->lim_len = 1;
+    fluid_insertfx_update(fx);
+    fluid_insertfx_reset(fx);
+
+    return fx;
+}
+
+/*
+* Deletes the insert effects.
+* @param fx the insert effects.
+*/
+void
+delete_fluid_insertfx(fluid_insertfx_t *fx)
+{
+    fluid_return_if_fail(fx != NULL);
+
+    FLUID_FREE(fx->lim_delay_l);
+    FLUID_FREE(fx->lim_min_time);
+    FLUID_FREE(fx);
+}
+
+/*
+* Clears the state of the effects: filters, envelope and delay line.
+* @param fx the insert effects.
+*/
+void
+fluid_insertfx_reset(fluid_insertfx_t *fx)
+{
+    fluid_return_if_fail(fx != NULL);
+
+    fluid_insertfx_reset_eq(fx);
+    fluid_insertfx_reset_compressor(fx);
+    fluid_insertfx_reset_limiter(fx);
+
+    fx->silent = 0;
+    fx->idle = TRUE;
+}
+
+/*
+* Applies a change of the sample rate. The state of the effects is cleared.
+* @param fx the insert effects.
+* @param sample_rate new sample rate in Hz.
+*/
+void
+fluid_insertfx_samplerate_change(fluid_insertfx_t *fx, fluid_real_t sample_rate)
+{
+    fluid_return_if_fail(fx != NULL);
+    fluid_return_if_fail(sample_rate > 0);
+
+    fx->sample_rate = sample_rate;
+    fluid_insertfx_update(fx);
+    fluid_insertfx_reset(fx);
+}
+
+/*
+* Sets one parameter of the effects.
+* @param fx the insert effects.
+* @param param the parameter (#fluid_insert_fx_param).
+* @param value the value, clipped to the range of the parameter.
+*/
+void
+fluid_insertfx_set_param(fluid_insertfx_t *fx, int param, fluid_real_t value)
+{
+    int switched_on;
+
+    fluid_return_if_fail(fx != NULL);
+    fluid_return_if_fail(param >= 0 && param < FLUID_INSERT_FX_PARAM_LAST);
+
+    fluid_clip(value, fluid_insertfx_params[param].min, fluid_insertfx_params[param].max);
+
+    if(fluid_insertfx_params[param].toggle)
+    {
+        value = (value != 0);
+    }
+
+    switched_on = (value != 0 && fx->param[param] == 0);
+    fx->param[param] = value;
+    fluid_insertfx_update(fx);
+
+    /* an effect switched on starts from a clear state, the others keep
+       running undisturbed */
+    if(switched_on)
+    {
+        switch(param)
+        {
+        case FLUID_INSERT_EQ_ACTIVE:
+            fluid_insertfx_reset_eq(fx);
+            break;
+
+        case FLUID_INSERT_COMPRESSOR_ACTIVE:
+            fluid_insertfx_reset_compressor(fx);
+            break;
+
+        case FLUID_INSERT_LIMITER_ACTIVE:
+            fluid_insertfx_reset_limiter(fx);
+            break;
+
+        default:
+            break;
+        }
+    }
+}
+
+/*
+* Tells whether any of the effects is switched on.
+* @param fx the insert effects.
+* @return TRUE if the channel has to be processed.
+*/
+int
+fluid_insertfx_is_active(const fluid_insertfx_t *fx)
+{
+    return fx->param[FLUID_INSERT_EQ_ACTIVE] != 0
+           || fx->param[FLUID_INSERT_COMPRESSOR_ACTIVE] != 0
+           || fx->param[FLUID_INSERT_LIMITER_ACTIVE] != 0;
+}
+
+/*
+* Tells whether the effects would only output silence for a silent input,
+* i.e. if processing them can be skipped while the input stays silent.
+* @param fx the insert effects.
+* @return TRUE if idle.
+*/
+int
+fluid_insertfx_is_idle(const fluid_insertfx_t *fx)
+{
+    return fx->idle;
+}
+
+/*-----------------------------------------------------------------------------
+ Equalizer, in place.
+-----------------------------------------------------------------------------*/
+static void
+fluid_insertfx_eq(fluid_insertfx_t *fx, fluid_real_t *left, fluid_real_t *right, int count)
+{
+    int b, i;
+
+    for(b = 0; b < INSERTFX_BANDS; b++)
+    {
+        fluid_insertfx_biquad *bq = &fx->band[b];
+        fluid_real_t z1l = bq->z1[0], z2l = bq->z2[0];
+        fluid_real_t z1r = bq->z1[1], z2r = bq->z2[1];
+
+        if(!bq->on)
+        {
+            continue;
+        }
+
+        for(i = 0; i < count; i++)
+        {
+            fluid_real_t xl = left[i], xr = right[i];
+            fluid_real_t yl = bq->b0 * xl + z1l;
+            fluid_real_t yr = bq->b0 * xr + z1r;
+
+            z1l = bq->b1 * xl - bq->a1 * yl + z2l;
+            z1r = bq->b1 * xr - bq->a1 * yr + z2r;
+            z2l = bq->b2 * xl - bq->a2 * yl;
+            z2r = bq->b2 * xr - bq->a2 * yr;
+            left[i] = yl;
+            right[i] = yr;
+        }
+
+        bq->z1[0] = z1l;
+        bq->z2[0] = z2l;
+        bq->z1[1] = z1r;
+        bq->z2[1] = z2r;
+    }
+}
+
+/*-----------------------------------------------------------------------------
+ Compressor, in place.
+-----------------------------------------------------------------------------*/
+static void
+fluid_insertfx_compressor(fluid_insertfx_t *fx, fluid_real_t *left, fluid_real_t *right, int count)
+{
+    fluid_real_t level[INSERTFX_CHUNK];
+    fluid_real_t env = fx->comp_env;
+    fluid_real_t gain0 = fx->comp_gain, gain1, step;
+    int rms = fx->param[FLUID_INSERT_COMPRESSOR_RMS] != 0;
+    int i;
+
+    /* level of the louder channel */
+    if(rms)
+    {
+        fluid_real_t mean = fx->comp_ms;
+
+        for(i = 0; i < count; i++)
+        {
+            fluid_real_t l2 = left[i] * left[i], r2 = right[i] * right[i];
+            mean += (((l2 > r2) ? l2 : r2) - mean) * fx->comp_rms;
+            level[i] = mean;
+        }
+
+        fx->comp_ms = mean;
+    }
+    else
+    {
+        #pragma omp simd
+        for(i = 0; i < count; i++)
+        {
+            fluid_real_t l = FLUID_FABS(left[i]), r = FLUID_FABS(right[i]);
+            level[i] = (l > r) ? l : r;
+        }
+    }
+
+    /* envelope */
+    for(i = 0; i < count; i++)
+    {
+        env += (level[i] - env) * ((level[i] > env) ? fx->comp_attack : fx->comp_release);
+    }
+
+    fx->comp_env = env;
+
+    if(rms)
+    {
+        env = FLUID_SQRT(env);
+    }
+
+    /* gain at the end of the chunk, ramped from the previous one */
+    gain1 = fx->comp_makeup;
+
+    if(env > fx->comp_threshold)
+    {
+        gain1 *= FLUID_POW(env / fx->comp_threshold, fx->comp_slope);
+    }
+
+    fx->comp_gain = gain1;
+    step = (gain1 - gain0) / count;
+
+    #pragma omp simd
+    for(i = 0; i < count; i++)
+    {
+        fluid_real_t gain = gain0 + step * (i + 1);
+        left[i] *= gain;
+        right[i] *= gain;
+    }
+}
+
+/*-----------------------------------------------------------------------------
+ Limiter, in place.
+-----------------------------------------------------------------------------*/
+static void
+fluid_insertfx_limiter(fluid_insertfx_t *fx, fluid_real_t *left, fluid_real_t *right, int count)
+{
+    fluid_real_t gain[INSERTFX_CHUNK];
+    const fluid_real_t ceiling = fx->lim_ceiling;
+    const unsigned int len = fx->lim_len;
+    const int mask = fx->lim_size - 1;
+    int i;
+
+    /* gain needed by each sample */
+    #pragma omp simd
+    for(i = 0; i < count; i++)
+    {
+        fluid_real_t l = FLUID_FABS(left[i]), r = FLUID_FABS(right[i]);
+        fluid_real_t peak = (l > r) ? l : r;
+        gain[i] = ceiling / ((peak > ceiling) ? peak : ceiling);
+    }
+
+    for(i = 0; i < count; i++)
+    {
+        unsigned int now = fx->lim_time++;
+        fluid_real_t hold;
+
+        /* running minimum over the last len samples: the queue holds
+           increasing gains, each one being the minimum until the next */
+        while(fx->lim_min_tail != fx->lim_min_head
+                && fx->lim_min_val[(fx->lim_min_tail - 1) & mask] >= gain[i])
+        {
+            fx->lim_min_tail--;
+        }
+
+        fx->lim_min_val[fx->lim_min_tail & mask] = gain[i];
+        fx->lim_min_time[fx->lim_min_tail & mask] = now;
+        fx->lim_min_tail++;
+
+        if(now - fx->lim_min_time[fx->lim_min_head & mask] >= len)
+        {
+            fx->lim_min_head++;
+        }
+
+        /* release */
+        hold = fx->lim_hold + (1 - fx->lim_hold) * fx->lim_release;
+        hold = (fx->lim_min_val[fx->lim_min_head & mask] < hold) ? fx->lim_min_val[fx->lim_min_head & mask] : hold;
+        fx->lim_hold = hold;
+
+        /* moving average, summed again at every turn so that no error builds up */
+        fx->lim_sum += hold - fx->lim_avg[fx->lim_avg_pos];
+        fx->lim_avg[fx->lim_avg_pos] = hold;
+
+        if(++fx->lim_avg_pos == (int)len)
+        {
+            int k;
+
+            fx->lim_avg_pos = 0;
+            fx->lim_sum = 0;
+
+            for(k = 0; k < (int)len; k++)
+            {
+                fx->lim_sum += fx->lim_avg[k];
+            }
+        }
+
+        gain[i] = (fluid_real_t)(fx->lim_sum / len);
+    }
+
+    /* delay and gain */
+    for(i = 0; i < count; i++)
+    {
+        unsigned int now = fx->lim_time - count + i;
+        int in_pos = now & mask;
+        int out_pos = (now - (len - 1)) & mask;
+
+        fx->lim_delay_l[in_pos] = left[i];
+        fx->lim_delay_r[in_pos] = right[i];
+        left[i] = fx->lim_delay_l[out_pos];
+        right[i] = fx->lim_delay_r[out_pos];
+    }
+
+    #pragma omp simd
+    for(i = 0; i < count; i++)
+    {
+        fluid_real_t g = (gain[i] < 1) ? gain[i] : 1;
+        left[i] *= g;
+        right[i] *= g;
+    }
+}
+
+/*
+* Processes count samples of a stereo channel, in place.
+* @param fx the insert effects.
+* @param left left channel.
+* @param right right channel.
+* @param count number of samples to process.
+*/
+void
+fluid_insertfx_process(fluid_insertfx_t *fx, fluid_real_t *left, fluid_real_t *right, int count)
+{
+    int done, run, i;
+
+    for(done = 0; done < count; done += run, left += run, right += run)
+    {
+        fluid_real_t in_peak = 0, out_peak = 0;
+
+        run = count - done;
+
+        if(run > INSERTFX_CHUNK)
+        {
+            run = INSERTFX_CHUNK;
+        }
+
+        #pragma omp simd reduction(max:in_peak)
+        for(i = 0; i < run; i++)
+        {
+            fluid_real_t l = FLUID_FABS(left[i]), r = FLUID_FABS(right[i]);
+            fluid_real_t v = (l > r) ? l : r;
+            in_peak = (v > in_peak) ? v : in_peak;
+        }
+
+        if(in_peak < FLUID_MIXER_FX_SILENCE)
+        {
+            if(fx->idle)
+            {
+                continue;
+            }
+
+            fx->silent += run;
+        }
+        else
+        {
+            fx->silent = 0;
+            fx->idle = FALSE;
+        }
+
+        if(fx->param[FLUID_INSERT_EQ_ACTIVE] != 0)
+        {
+            fluid_insertfx_eq(fx, left, right, run);
+        }
+
+        if(fx->param[FLUID_INSERT_COMPRESSOR_ACTIVE] != 0)
+        {
+            fluid_insertfx_compressor(fx, left, right, run);
+        }
+
+        if(fx->param[FLUID_INSERT_LIMITER_ACTIVE] != 0)
+        {
+            fluid_insertfx_limiter(fx, left, right, run);
+        }
+
+        /* once the delay line of the limiter has been flushed and the
+           filters have rung out, the effects can be skipped until the input
+           comes back */
+        if(fx->silent >= fx->lim_len)
+        {
+            #pragma omp simd reduction(max:out_peak)
+            for(i = 0; i < run; i++)
+            {
+                fluid_real_t l = FLUID_FABS(left[i]), r = FLUID_FABS(right[i]);
+                fluid_real_t v = (l > r) ? l : r;
+                out_peak = (v > out_peak) ? v : out_peak;
+            }
+
+            if(out_peak < FLUID_MIXER_FX_SILENCE)
+            {
+                fluid_insertfx_reset(fx);
+            }
+        }
+    }
+}
+
+/*
+* Describes one parameter of the insert effects.
+* @param param the parameter (#fluid_insert_fx_param).
+* @param name if not NULL, receives its name, the setting being "synth." name.
+* @param def if not NULL, receives its default value.
+* @param min if not NULL, receives its minimum value.
+* @param max if not NULL, receives its maximum value.
+* @param toggle if not NULL, receives TRUE if the parameter is a switch (0 or 1).
+* @return FLUID_OK, or FLUID_FAILED if param is out of range.
+*/
+int
+fluid_insertfx_param_info(int param, const char **name, double *def,
+                          double *min, double *max, int *toggle)
+{
+    fluid_return_val_if_fail(param >= 0 && param < FLUID_INSERT_FX_PARAM_LAST, FLUID_FAILED);
+
+    if(name != NULL)
+    {
+        *name = fluid_insertfx_params[param].name;
+    }
+
+    if(def != NULL)
+    {
+        *def = fluid_insertfx_params[param].def;
+    }
+
+    if(min != NULL)
+    {
+        *min = fluid_insertfx_params[param].min;
+    }
+
+    if(max != NULL)
+    {
+        *max = fluid_insertfx_params[param].max;
+    }
+
+    if(toggle != NULL)
+    {
+        *toggle = fluid_insertfx_params[param].toggle;
+    }
+
+    return FLUID_OK;
+}
+
+/*
+* Looks up a parameter of the insert effects by name.
+* @param name name of the parameter, e.g. "limiter.ceiling".
+* @return the parameter (#fluid_insert_fx_param), -1 if unknown.
+*/
+int
+fluid_insertfx_param_index(const char *name)
+{
+    int i;
+
+    fluid_return_val_if_fail(name != NULL, -1);
+
+    for(i = 0; i < FLUID_INSERT_FX_PARAM_LAST; i++)
+    {
+        if(FLUID_STRCMP(name, fluid_insertfx_params[i].name) == 0)
+        {
+            return i;
+        }
+    }
+
+    return -1;
+}
@@ -0,0 +1,55 @@
+/* FluidSynth - A Software Synthesizer
+ *
+ * Copyright (C) 2003  Peter Hanappe and others.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1 of
+ * the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see
+ * <https://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef _FLUID_INSERTFX_H
+#define _FLUID_INSERTFX_H
+
+#include "fluidsynth_priv.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct _fluid_insertfx_t fluid_insertfx_t;
+
+/*
+ * insert effects: equalizer, compressor and limiter of a stereo channel
+ */
+fluid_insertfx_t *new_fluid_insertfx(fluid_real_t sample_rate_max, fluid_real_t sample_rate);
+void delete_fluid_insertfx(fluid_insertfx_t *fx);
+void fluid_insertfx_reset(fluid_insertfx_t *fx);
+void fluid_insertfx_samplerate_change(fluid_insertfx_t *fx, fluid_real_t sample_rate);
+
+void fluid_insertfx_set_param(fluid_insertfx_t *fx, int param, fluid_real_t value);
+int fluid_insertfx_is_active(const fluid_insertfx_t *fx);
+int fluid_insertfx_is_idle(const fluid_insertfx_t *fx);
+
+void fluid_insertfx_process(fluid_insertfx_t *fx, fluid_real_t *left, fluid_real_t *right, int count);
+
+/* description of the parameters (#fluid_insert_fx_param) */
+int fluid_insertfx_param_info(int param, const char **name, double *def,
+                              double *min, double *max, int *toggle);
+int fluid_insertfx_param_index(const char *name);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _FLUID_INSERTFX_H */
@@ -510,6 +510,53 @@ static int get_mod_delay_line_length(mod_delay_line *mdl)
     return (mdl->dl.size - mdl->mod_depth - INTERP_SAMPLES_NBR);
 }
 
+/*-----------------------------------------------------------------------------
+ Moves the read position of the modulated delay line to the next value of
+ the modulator (line_out and frac_pos_mod).
+ @param mdl, pointer on modulated delay line.
+-----------------------------------------------------------------------------*/
+static FLUID_INLINE void update_mod_delay_pos(mod_delay_line *mdl)
+{
+    fluid_real_t out_index;  /* new modulated index position */
+    int int_out_index; /* integer part of out_index */
+
+    /* out_index = center position (center_pos_mod) + sinus waweform */
+    out_index = mdl->center_pos_mod +
+                get_mod_sinus(&mdl->mod) * mdl->mod_depth;
+
+    /* extracts integer part in int_out_index */
+    if(out_index >= 0.0f)
+    {
+        int_out_index = (int)out_index; /* current integer part */
+
+        /* forces read index (line_out)  with integer modulation value  */
+        /* Boundary check and circular motion as needed */
+        if((mdl->dl.line_out = int_out_index) >= mdl->dl.size)
+        {
+            mdl->dl.line_out -= mdl->dl.size;
+        }
+    }
+    else /* negative */
+    {
+        int_out_index = (int)(out_index - 1); /* previous integer part */
+        /* forces read index (line_out) with integer modulation value  */
+        /* circular motion as needed */
+        mdl->dl.line_out   = int_out_index + mdl->dl.size;
+    }
+
+    /* extracts fractionnal part. (it will be used when interpolating
+      between line_out and line_out +1) and memorize it.
+      Memorizing is necessary for modulation rate above 1 */
+    mdl->frac_pos_mod = out_index - int_out_index;
+
+    /* updates center position (center_pos_mod) to the next position
+       specified by modulation rate */
+    if((mdl->center_pos_mod += mdl->mod_rate) >= mdl->dl.size)
+    {
+        mdl->center_pos_mod -= mdl->dl.size;
+    }
+}
+
 /*-----------------------------------------------------------------------------
  Reads the sample value out of the modulated delay line.
  @param mdl, pointer on modulated delay line.
@@ -517,8 +564,6 @@ static int get_mod_delay_line_length(mod_delay_line *mdl)
 -----------------------------------------------------------------------------*/
 static FLUID_INLINE fluid_real_t get_mod_delay(mod_delay_line *mdl)
 {
-    fluid_real_t out_index;  /* new modulated index position */
-    int int_out_index; /* integer part of out_index */
     fluid_real_t out; /* value to return */
 
     /* Checks if the modulator must be updated (every mod_rate samples). */
@@ -529,42 +574,7 @@ static FLUID_INLINE fluid_real_t get_mod_delay(mod_delay_line *mdl)
     if(++mdl->index_rate >= mdl->mod_rate)
     {
         mdl->index_rate = 0;
-
-        /* out_index = center position (center_pos_mod) + sinus waweform */
-        out_index = mdl->center_pos_mod +
-                    get_mod_sinus(&mdl->mod) * mdl->mod_depth;
-
-        /* extracts integer part in int_out_index */
-        if(out_index >= 0.0f)
-        {
-            int_out_index = (int)out_index; /* current integer part */
-
-            /* forces read index (line_out)  with integer modulation value  */
-            /* Boundary check and circular motion as needed */
-            if((mdl->dl.line_out = int_out_index) >= mdl->dl.size)
-            {
-                mdl->dl.line_out -= mdl->dl.size;
-            }
-        }
-        else /* negative */
-        {
-            int_out_index = (int)(out_index - 1); /* previous integer part */
-            /* forces read index (line_out) with integer modulation value  */
-            /* circular motion as needed */
-            mdl->dl.line_out   = int_out_index + mdl->dl.size;
-        }
-
-        /* extracts fractionnal part. (it will be used when interpolating
-          between line_out and line_out +1) and memorize it.
-          Memorizing is necessary for modulation rate above 1 */
-        mdl->frac_pos_mod = out_index - int_out_index;
-
-        /* updates center position (center_pos_mod) to the next position
-           specified by modulation rate */
-        if((mdl->center_pos_mod += mdl->mod_rate) >= mdl->dl.size)
-        {
-            mdl->center_pos_mod -= mdl->dl.size;
-        }
+        update_mod_delay_pos(mdl);
     }
 
     /*  First order all-pass interpolation ----------------------------------*/
@@ -594,11 +604,13 @@ struct _fluid_late
 {
     fluid_real_t samplerate;       /* sample rate */
     fluid_real_t sample_rate_max;  /* sample rate maximum */
+    fluid_real_t dc_rev_time;      /* reverb time at 0 Hz (in seconds) */
     /*----- High pass tone corrector -------------------------------------*/
     fluid_real_t tone_buffer;
     fluid_real_t b1, b2;
     /*----- Modulated delay lines lines ----------------------------------*/
     mod_delay_line mod_delay_lines[NBR_DELAYS];
+    fluid_real_t *lines; /* one buffer holding the lines one after the other */
     /*-----------------------------------------------------------------------*/
     /* Output coefficients for separate Left and right stereo outputs */
     fluid_real_t out_left_gain[NBR_DELAYS]; /* Left delay lines' output gains */
@@ -617,6 +629,8 @@ struct _fluid_revmodel_t
     fluid_real_t level, wet1, wet2; /* output level */
     fluid_real_t width; /* width stereo separation */
 
+    int cpu_isa; /* instruction set level of the fdn kernel, see fluid_revmodel_set_cpu_isa() */
+
     /* fdn reverberation structure */
     fluid_late  late;
 };
@@ -696,6 +710,8 @@ static void update_rev_time_damping(fluid_late *late,
         alpha = FLUID_SQRT(alpha2); /* R */
     }
 
+    late->dc_rev_time = dc_rev_time;
+
     /* updates tone corrector coefficients b1,b2 from alpha */
     {
         /*
@@ -786,14 +802,10 @@ static void update_stereo_coefficient(fluid_late *late, fluid_real_t wet1)
 -----------------------------------------------------------------------------*/
 static void delete_fluid_rev_late(fluid_late *late)
 {
-    int i;
     fluid_return_if_fail(late != NULL);
 
     /* free the delay lines */
-    for(i = 0; i < NBR_DELAYS; i++)
-    {
-        FLUID_FREE(late->mod_delay_lines[i].dl.line);
-    }
+    FLUID_FREE(late->lines);
 }
 
 
@@ -852,6 +864,7 @@ static int create_mod_delay_lines(fluid_late *late,
                                   fluid_real_t sample_rate_max)
 {
     int i;
+    int total_size = 0;
 
     fluid_real_t mod_depth, length_factor;
 
@@ -900,20 +913,31 @@ static int create_mod_delay_lines(fluid_late *late,
             mod_depth = delay_length - 1;
         }
 
-        /*---------------------------------------------------------------------
-         allocates delay lines
-        */
-
         /* real size of the line in use (in samples):
         size = INTERP_SAMPLES_NBR + mod_depth + delay_length */
         mdl->dl.size = delay_length + mod_depth + INTERP_SAMPLES_NBR;
-        mdl->dl.line = FLUID_ARRAY(fluid_real_t, mdl->dl.size);
+        total_size += mdl->dl.size;
+    }
 
-        if(! mdl->dl.line)
-        {
-            return FLUID_FAILED;
-        }
+    /*---------------------------------------------------------------------
+     allocates delay lines. They share one buffer, so that the vectorized
+     fdn can address all of them from the same base pointer.
+    */
+    late->lines = FLUID_ARRAY(fluid_real_t, total_size);
+
+    if(! late->lines)
+    {
+        return FLUID_FAILED;
     }
+
+    for(i = 0, total_size = 0; i < NBR_DELAYS; i++)
+    {
+        mod_delay_line *mdl = &late->mod_delay_lines[i];
+
+        mdl->dl.line = late->lines + total_size;
+        total_size += mdl->dl.size;
+    }
+
     return FLUID_OK;
 }
 
@@ -1100,6 +1124,7 @@ new_fluid_revmodel(fluid_real_t sample_rate_max, fluid_real_t sample_rate)
     }
 
     FLUID_MEMSET(&rev->late, 0,  sizeof(fluid_late));
+    rev->cpu_isa = FLUID_CPU_ISA_GENERIC;
 
     /*--------------------------------------------------------------------------
       Create fdn late reverb.
@@ -1280,19 +1305,380 @@ fluid_revmodel_reset(fluid_revmodel_t *rev)
     fluid_revmodel_init(rev);
 }
 
+/*
+* Selects the instruction set level of the fdn kernel. At FLUID_CPU_ISA_GENERIC,
+* the scalar loops of fluid_revmodel_processreplace() and
+* fluid_revmodel_processmix() are used, they are the reference implementation.
+* Above, the vectorized kernel compiled for that level is used, see
+* fluid_revmodel_process_vector().
+*
+* @param rev the reverb.
+* @param cpu_isa One of #fluid_cpu_isa, must be supported by the CPU.
+*
+* Reverb API.
+*/
+void
+fluid_revmodel_set_cpu_isa(fluid_revmodel_t *rev, int cpu_isa)
+{
+    fluid_return_if_fail(rev != NULL);
+
+    rev->cpu_isa = cpu_isa;
+}
+
+/*
+* Returns an upper bound of the level the reverb outputs when it gets no more
+* input, from the deviation of its delay lines and filters from their rest state.
+* As long as no input is fed, this level decays with the reverb time.
+*
+* @param rev the reverb.
+* @return the level bound (1.0 being full scale).
+*
+* Reverb API.
+*/
+fluid_real_t
+fluid_revmodel_get_tail_level(fluid_revmodel_t *rev)
+{
+    fluid_real_t level = 0;
+    int i, k;
+
+    fluid_return_val_if_fail(rev != NULL, 0);
+
+    for(i = 0; i < NBR_DELAYS; i++)
+    {
+        mod_delay_line *mdl = &rev->late.mod_delay_lines[i];
+        const fluid_real_t *line = mdl->dl.line;
+        fluid_real_t peak = FLUID_FABS(mdl->dl.damping.buffer);
+
+        if(FLUID_FABS(mdl->buffer) > peak)
+        {
+            peak = FLUID_FABS(mdl->buffer);
+        }
+
+        #pragma omp simd reduction(max:peak)
+        for(k = 0; k < mdl->dl.size; k++)
+        {
+            fluid_real_t v = FLUID_FABS(line[k] - DC_OFFSET);
+            peak = (v > peak) ? v : peak;
+        }
+
+        if(peak > level)
+        {
+            level = peak;
+        }
+    }
+
+    /* each stereo output sums all the lines, weighted by wet1 and wet1 * wet2 */
+    return level * NBR_DELAYS * FLUID_FABS(rev->wet1) * (1 + FLUID_FABS(rev->wet2));
+}
+
+/*
+* Returns the number of samples after which the tail of the reverb has decayed
+* by a given ratio, provided that it gets no more input.
+* This is the time the signal needs to leave the longest delay line plus the
+* time the reverb takes to decay by ratio (T60 being the time for a ratio of 1000).
+*
+* @param rev the reverb.
+* @param ratio the amplitude ratio, >= 1.
+* @return the number of samples.
+*
+* Reverb API.
+*/
+int
+fluid_revmodel_get_tail_length(fluid_revmodel_t *rev, fluid_real_t ratio)
+{
+    fluid_real_t decay;
+
+    fluid_return_val_if_fail(rev != NULL, 0);
+
+    decay = (ratio > 1) ? rev->late.dc_rev_time * FLUID_LOGF(ratio) / (3 * FLUID_M_LN10) : 0;
+
+    return rev->late.mod_delay_lines[NBR_DELAYS - 1].dl.size
+           + (int)(decay * rev->late.samplerate);
+}
+
+#if FLUID_CPU_DISPATCH
+/*-----------------------------------------------------------------------------
+ Vectorized fdn process.
+
+ Same algorithm as the scalar loops of fluid_revmodel_processreplace() and
+ fluid_revmodel_processmix(), with one delay line per vector lane.
+
+ The modulators of all lines are updated on the same sample, so the block is
+ cut into runs of at most mod_rate samples. Within a run, the read position of
+ a line moves by one sample per sample and stays ahead of its write position
+ by at least INTERP_SAMPLES_NBR, so a run only reads samples written before it.
+ A run is therefore processed in 3 steps:
+ - the samples read by the lines are copied into tap[], one column per line
+   (gather),
+ - the interpolators and damping filters of all lines run side by side on the
+   rows of tap[] (vector lowpass),
+ - the matrix and stereo outputs are computed for every sample of the run and
+   the line inputs are copied back into the lines (scatter).
+ The operations are done in the same order as in the scalar code, the result
+ only differs by the rounding of fused multiply-adds.
+
+ @param mix TRUE to mix the output into left_out and right_out, FALSE to
+  replace it.
+-----------------------------------------------------------------------------*/
+static FLUID_INLINE void
+fluid_revmodel_process_vector_generic(fluid_revmodel_t *rev, const fluid_real_t *in,
+                                      fluid_real_t *left_out, fluid_real_t *right_out,
+                                      int count, int mix)
+{
+    fluid_late *late = &rev->late;
+    int i, k, t, n;
+    int index_rate, mod_rate; /* shared by all the lines */
+
+    /* state of the lines */
+    fluid_real_t frac_pos_mod[NBR_DELAYS], buffer[NBR_DELAYS];
+    fluid_real_t damping[NBR_DELAYS], b0[NBR_DELAYS], a1[NBR_DELAYS];
+
+    /* samples read by the run (one more for the interpolation) and their
+       damped output, one column per line */
+    fluid_real_t tap[MOD_RATE + 1][NBR_DELAYS];
+    fluid_real_t delay_out[NBR_DELAYS][MOD_RATE];
+    fluid_real_t matrix_factor[MOD_RATE], sum[MOD_RATE];
+    fluid_real_t out_left[MOD_RATE], out_right[MOD_RATE];
+
+    for(i = 0; i < NBR_DELAYS; i++)
+    {
+        mod_delay_line *mdl = &late->mod_delay_lines[i];
+
+        frac_pos_mod[i] = mdl->frac_pos_mod;
+        buffer[i] = mdl->buffer;
+        damping[i] = mdl->dl.damping.buffer;
+        b0[i] = mdl->dl.damping.b0;
+        a1[i] = mdl->dl.damping.a1;
+    }
+
+    index_rate = late->mod_delay_lines[0].index_rate;
+    mod_rate = late->mod_delay_lines[0].mod_rate;
+
+    for(k = 0; k < count; k += n)
+    {
+        /* update the modulators, see get_mod_delay() */
+        if(++index_rate >= mod_rate)
+        {
+            index_rate = 0;
+
+            for(i = 0; i < NBR_DELAYS; i++)
+            {
+                update_mod_delay_pos(&late->mod_delay_lines[i]);
+                frac_pos_mod[i] = late->mod_delay_lines[i].frac_pos_mod;
+            }
+        }
+
+        /* samples until the next update */
+        n = mod_rate - index_rate;
+
+        if(n > count - k)
+        {
+            n = count - k;
+        }
+
+        index_rate += n - 1;
+
+        /* gather the modulated output of the lines */
+        for(i = 0; i < NBR_DELAYS; i++)
+        {
+            delay_line *dl = &late->mod_delay_lines[i].dl;
+            const fluid_real_t *line = &dl->line[dl->line_out];
+            int len = dl->size - dl->line_out; /* samples before wrapping */
+
+            if(len > n + 1)
+            {
+                len = n + 1;
+            }
+
+            for(t = 0; t < len; t++)
+            {
+                tap[t][i] = line[t];
+            }
+
+            for(line = dl->line; t <= n; t++)
+            {
+                tap[t][i] = line[t - len];
+            }
+
+            /* the last sample is read again by the next run */
+            if((dl->line_out += n) >= dl->size)
+            {
+                dl->line_out -= dl->size;
+            }
+        }
+
+        /* first order all-pass interpolation + low pass damping filter */
+        for(t = 0; t < n; t++)
+        {
+            #pragma omp simd
+            for(i = 0; i < NBR_DELAYS; i++)
+            {
+                fluid_real_t out = tap[t][i];
+
+                out += frac_pos_mod[i] * (tap[t + 1][i] - buffer[i]);
+                buffer[i] = out;
+
+                out = out * b0[i] - damping[i] * a1[i];
+                damping[i] = out;
+                delay_out[i][t] = out;
+            }
+        }
+
+        /* input + tone correction */
+        for(t = 0; t < n; t++)
+        {
+            fluid_real_t xn;
+
+#ifdef DENORMALISING
+            xn = in[k + t] * FIXED_GAIN + DC_OFFSET;
+#else
+            xn = in[k + t] * FIXED_GAIN;
+#endif
+            matrix_factor[t] = xn * late->b1 - late->b2 * late->tone_buffer;
+            late->tone_buffer = xn;
+        }
+
+        /* feedback matrix and stereo output */
+        for(t = 0; t < n; t++)
+        {
+            out_left[t] = out_right[t] = sum[t] = 0;
+        }
+
+        for(i = 0; i < NBR_DELAYS; i++)
+        {
+            fluid_real_t left_gain = late->out_left_gain[i];
+            fluid_real_t right_gain = late->out_right_gain[i];
+
+            #pragma omp simd
+            for(t = 0; t < n; t++)
+            {
+                sum[t] += delay_out[i][t];
+                out_left[t] += left_gain * delay_out[i][t];
+                out_right[t] += right_gain * delay_out[i][t];
+            }
+        }
+
+        #pragma omp simd
+        for(t = 0; t < n; t++)
+        {
+            fluid_real_t l = out_left[t], r = out_right[t];
+
+            matrix_factor[t] += sum[t] * FDN_MATRIX_FACTOR;
+
+#ifdef DENORMALISING
+            l -= DC_OFFSET;
+            r -= DC_OFFSET;
+#endif
+
+            if(mix)
+            {
+                left_out[k + t]  += l + r * rev->wet2;
+                right_out[k + t] += r + l * rev->wet2;
+            }
+            else
+            {
+                left_out[k + t]  = l + r * rev->wet2;
+                right_out[k + t] = r + l * rev->wet2;
+            }
+        }
+
+        /* scatter the inputs into the lines: delay_in[i] = delay_out[i + 1] + matrix_factor */
+        for(i = 0; i < NBR_DELAYS; i++)
+        {
+            delay_line *dl = &late->mod_delay_lines[i].dl;
+            int from = (i + 1 < NBR_DELAYS) ? i + 1 : 0;
+            fluid_real_t *line = &dl->line[dl->line_in];
+            int len = dl->size - dl->line_in; /* samples before wrapping */
+
+            if(len > n)
+            {
+                len = n;
+            }
+
+            for(t = 0; t < len; t++)
+            {
+                line[t] = delay_out[from][t] + matrix_factor[t];
+            }
+
+            for(line = dl->line; t < n; t++)
+            {
+                line[t - len] = delay_out[from][t] + matrix_factor[t];
+            }
+
+            if((dl->line_in += n) >= dl->size)
+            {
+                dl->line_in -= dl->size;
+            }
+        }
+    }
+
+    for(i = 0; i < NBR_DELAYS; i++)
+    {
+        mod_delay_line *mdl = &late->mod_delay_lines[i];
+
+        mdl->frac_pos_mod = frac_pos_mod[i];
+        mdl->buffer = buffer[i];
+        mdl->dl.damping.buffer = damping[i];
+        mdl->index_rate = index_rate;
+    }
+}
+
+FLUID_TARGET_AVX2 static void
+fluid_revmodel_process_vector_avx2(fluid_revmodel_t *rev, const fluid_real_t *in,
+                                   fluid_real_t *left_out, fluid_real_t *right_out,
+                                   int count, int mix)
+{
+    fluid_revmodel_process_vector_generic(rev, in, left_out, right_out, count, mix);
+}
+
+FLUID_TARGET_AVX512 static void
+fluid_revmodel_process_vector_avx512(fluid_revmodel_t *rev, const fluid_real_t *in,
+                                     fluid_real_t *left_out, fluid_real_t *right_out,
+                                     int count, int mix)
+{
+    fluid_revmodel_process_vector_generic(rev, in, left_out, right_out, count, mix);
+}
+
+/*-----------------------------------------------------------------------------
+ Runs the vectorized fdn built for rev->cpu_isa.
+ @return TRUE if the samples have been processed, FALSE if the scalar loops
+  must be used.
+-----------------------------------------------------------------------------*/
+static FLUID_INLINE int
+fluid_revmodel_process_vector(fluid_revmodel_t *rev, const fluid_real_t *in,
+                              fluid_real_t *left_out, fluid_real_t *right_out,
+                              int count, int mix)
+{
+    switch(rev->cpu_isa)
+    {
+    case FLUID_CPU_ISA_AVX512:
+        fluid_revmodel_process_vector_avx512(rev, in, left_out, right_out, count, mix);
+        return TRUE;
+
+    case FLUID_CPU_ISA_AVX2:
+        fluid_revmodel_process_vector_avx2(rev, in, left_out, right_out, count, mix);
+        return TRUE;
+
+    default:
+        return FALSE;
+    }
+}
+#endif
+
 /*-----------------------------------------------------------------------------
 * fdn reverb process replace.
 * @param rev pointer on reverb.
-* @param in monophonic buffer input (FLUID_BUFSIZE sample).
-* @param left_out stereo left processed output (FLUID_BUFSIZE sample).
-* @param right_out stereo right processed output (FLUID_BUFSIZE sample).
+* @param in monophonic buffer input (count samples).
+* @param left_out stereo left processed output (count samples).
+* @param right_out stereo right processed output (count samples).
+* @param count number of samples to process.
 *
 * The processed reverb is replacing anything there in out.
 * Reverb API.
 -----------------------------------------------------------------------------*/
 void
 fluid_revmodel_processreplace(fluid_revmodel_t *rev, const fluid_real_t *in,
-                              fluid_real_t *left_out, fluid_real_t *right_out)
+                              fluid_real_t *left_out, fluid_real_t *right_out, int count)
 {
     int i, k;
 
@@ -1303,7 +1689,14 @@ fluid_revmodel_processreplace(fluid_revmodel_t *rev, const fluid_real_t *in,
     fluid_real_t delay_out_s;          /* sample */
     fluid_real_t delay_out[NBR_DELAYS]; /* Line output + damper output */
 
-    for(k = 0; k < FLUID_BUFSIZE; k++)
+#if FLUID_CPU_DISPATCH
+    if(fluid_revmodel_process_vector(rev, in, left_out, right_out, count, FALSE))
+    {
+        return;
+    }
+#endif
+
+    for(k = 0; k < count; k++)
     {
         /* stereo output */
         out_left = out_right = 0;
@@ -1406,15 +1799,16 @@ fluid_revmodel_processreplace(fluid_revmodel_t *rev, const fluid_real_t *in,
 /*-----------------------------------------------------------------------------
 * fdn reverb process mix.
 * @param rev pointer on reverb.
-* @param in monophonic buffer input (FLUID_BUFSIZE samples).
-* @param left_out stereo left processed output (FLUID_BUFSIZE samples).
-* @param right_out stereo right processed output (FLUID_BUFSIZE samples).
+* @param in monophonic buffer input (count samples).
+* @param left_out stereo left processed output (count samples).
+* @param right_out stereo right processed output (count samples).
+* @param count number of samples to process.
 *
 * The processed reverb is mixed in out with samples already there in out.
 * Reverb API.
 -----------------------------------------------------------------------------*/
 void fluid_revmodel_processmix(fluid_revmodel_t *rev, const fluid_real_t *in,
-                               fluid_real_t *left_out, fluid_real_t *right_out)
+                               fluid_real_t *left_out, fluid_real_t *right_out, int count)
 {
     int i, k;
 
@@ -1425,7 +1819,14 @@ void fluid_revmodel_processmix(fluid_revmodel_t *rev, const fluid_real_t *in,
     fluid_real_t delay_out_s;          /* sample */
     fluid_real_t delay_out[NBR_DELAYS]; /* Line output + damper output */
 
-    for(k = 0; k < FLUID_BUFSIZE; k++)
+#if FLUID_CPU_DISPATCH
+    if(fluid_revmodel_process_vector(rev, in, left_out, right_out, count, TRUE))
+    {
+        return;
+    }
+#endif
+
+    for(k = 0; k < count; k++)
     {
         /* stereo output */
         out_left = out_right = 0;
@@ -79,10 +79,10 @@ new_fluid_revmodel(fluid_real_t sample_rate_max, fluid_real_t sample_rate);
 void delete_fluid_revmodel(fluid_revmodel_t *rev);
 
 void fluid_revmodel_processmix(fluid_revmodel_t *rev, const fluid_real_t *in,
-                               fluid_real_t *left_out, fluid_real_t *right_out);
+                               fluid_real_t *left_out, fluid_real_t *right_out, int count);
 
 void fluid_revmodel_processreplace(fluid_revmodel_t *rev, const fluid_real_t *in,
-                                   fluid_real_t *left_out, fluid_real_t *right_out);
+                                   fluid_real_t *left_out, fluid_real_t *right_out, int count);
 
 void fluid_revmodel_reset(fluid_revmodel_t *rev);
 
@@ -91,6 +91,12 @@ void fluid_revmodel_set(fluid_revmodel_t *rev, int set, fluid_real_t roomsize,
 
 int fluid_revmodel_samplerate_change(fluid_revmodel_t *rev, fluid_real_t sample_rate);
 
+void fluid_revmodel_set_cpu_isa(fluid_revmodel_t *rev, int cpu_isa);
+
+fluid_real_t fluid_revmodel_get_tail_level(fluid_revmodel_t *rev);
+
+int fluid_revmodel_get_tail_length(fluid_revmodel_t *rev, fluid_real_t ratio);
+
 #ifdef __cplusplus
 }
 #endif
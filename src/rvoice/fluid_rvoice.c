@@ -23,6 +23,7 @@
 
 
 static void fluid_rvoice_noteoff_LOCAL(fluid_rvoice_t *voice, unsigned int min_ticks);
+static void fluid_rvoice_update_features(fluid_rvoice_t *voice);
 
 /**
  * @return -1 if voice is quiet, 0 if voice has finished, 1 otherwise
@@ -94,8 +95,8 @@ fluid_rvoice_calc_amp(fluid_rvoice_t *voice)
         }
     }
 
-    /* Volume increment to go from voice->amp to target_amp in FLUID_BUFSIZE steps */
-    voice->resonant_filter.amp_incr = (target_amp - voice->resonant_filter.amp) / FLUID_BUFSIZE;
+    /* Volume increment to go from voice->amp to target_amp in block_size steps */
+    voice->resonant_filter.amp_incr = (target_amp - voice->resonant_filter.amp) / voice->dsp.block_size;
 
     fluid_check_fpe("voice_write amplitude calculation");
 
@@ -288,29 +289,43 @@ fluid_rvoice_check_sample_sanity(fluid_rvoice_t *voice)
 }
 
 
+/* Outcome of fluid_rvoice_write_prepare_local(), tells what's left to do for the current block */
+enum fluid_rvoice_write_state
+{
+    FLUID_RVOICE_WRITE_FINISHED, /* voice has finished, remove from dsp loop */
+    FLUID_RVOICE_WRITE_QUIET,    /* voice waits for its release phase (FLUID_START_ON_RELEASE) */
+    FLUID_RVOICE_WRITE_SILENT,   /* delay phase or zero volume, only advance the sample phase */
+    FLUID_RVOICE_WRITE_AUDIBLE   /* interpolate and filter */
+};
+
 /**
- * Synthesize a voice to a buffer.
+ * Prepare a voice for synthesizing the next block.
  *
- * @param voice rvoice to synthesize
- * @param dsp_buf Audio buffer to synthesize to (#FLUID_BUFSIZE in length)
- * @return Count of samples written to dsp_buf. (-1 means voice is currently
- * quiet, 0 .. #FLUID_BUFSIZE-1 means voice finished.)
+ * Runs envelopes, LFOs, amplitude, pitch and filter coefficient calculation,
+ * i.e. everything that happens once per block, but does not touch the
+ * sample data yet.
  *
- * Panning, reverb and chorus are processed separately. The dsp interpolation
- * routine is in (fluid_rvoice_dsp.c).
+ * This is expanded once for each combination of enum fluid_rvoice_features,
+ * so that the compiler drops the work of any feature that is not set. Use
+ * the voice->write_prepare variant picked by fluid_rvoice_update_features().
+ *
+ * @param voice rvoice to prepare
+ * @param is_looping Set to TRUE if the voice is currently looping
+ * @param features Constant combination of enum fluid_rvoice_features
+ * @return One of enum fluid_rvoice_write_state
  */
-int
-fluid_rvoice_write(fluid_rvoice_t *voice, fluid_real_t *dsp_buf)
+static FLUID_INLINE int
+fluid_rvoice_write_prepare_local(fluid_rvoice_t *voice, int *is_looping, const int features)
 {
     int ticks = voice->envlfo.ticks;
-    int count, is_looping;
-    fluid_real_t modenv_val, fmod;
+    int count;
+    fluid_real_t modenv_val = 0, fmod;
 
     /******************* sample sanity check **********/
 
     if(!voice->dsp.sample)
     {
-        return 0;
+        return FLUID_RVOICE_WRITE_FINISHED;
     }
 
     if(voice->dsp.check_sample_sanity_flag)
@@ -326,7 +341,7 @@ fluid_rvoice_write(fluid_rvoice_t *voice, fluid_real_t *dsp_buf)
         fluid_rvoice_noteoff_LOCAL(voice, 0);
     }
 
-    voice->envlfo.ticks += FLUID_BUFSIZE;
+    voice->envlfo.ticks += voice->dsp.block_size;
 
     /******************* vol env **********************/
 
@@ -335,11 +350,13 @@ fluid_rvoice_write(fluid_rvoice_t *voice, fluid_real_t *dsp_buf)
 
     if(fluid_adsr_env_get_section(&voice->envlfo.volenv) == FLUID_VOICE_ENVFINISHED)
     {
-        return 0;
+        return FLUID_RVOICE_WRITE_FINISHED;
     }
 
     /******************* mod env **********************/
 
+    /* Envelopes and LFOs always have to advance, a modulator may route them
+     * to the pitch or the filter at any time. */
     fluid_adsr_env_calc(&voice->envlfo.modenv);
     fluid_check_fpe("voice_write mod env");
 
@@ -356,30 +373,42 @@ fluid_rvoice_write(fluid_rvoice_t *voice, fluid_real_t *dsp_buf)
     if(count == 0)
     {
         // Voice has finished, remove from dsp loop
-        return 0;
+        return FLUID_RVOICE_WRITE_FINISHED;
     }
     // else if count is negative, still process the voice
 
 
     /******************* phase **********************/
 
-    /* SF2.04 section 8.1.2 #26:
-     * attack of modEnv is convex ?!?
-     */
-    modenv_val = (fluid_adsr_env_get_section(&voice->envlfo.modenv) == FLUID_VOICE_ENVATTACK)
-                 ? fluid_convex(127 * fluid_adsr_env_get_val(&voice->envlfo.modenv))
-                 : fluid_adsr_env_get_val(&voice->envlfo.modenv);
-    /* Calculate the number of samples, that the DSP loop advances
-     * through the original waveform with each step in the output
-     * buffer. It is the ratio between the frequencies of original
-     * waveform and output waveform.*/
-    voice->dsp.phase_incr = fluid_ct2hz_real(voice->dsp.pitch +
-                            voice->dsp.pitchoffset +
-                            fluid_lfo_get_val(&voice->envlfo.modlfo) * voice->envlfo.modlfo_to_pitch
-                            + fluid_lfo_get_val(&voice->envlfo.viblfo) * voice->envlfo.viblfo_to_pitch
-                            + modenv_val * voice->envlfo.modenv_to_pitch)
-                            / 
-                            voice->dsp.root_pitch_hz;
+    if(features & (FLUID_RVOICE_PITCH_MOD | FLUID_RVOICE_FILTER_MOD))
+    {
+        /* SF2.04 section 8.1.2 #26:
+         * attack of modEnv is convex ?!?
+         */
+        modenv_val = (fluid_adsr_env_get_section(&voice->envlfo.modenv) == FLUID_VOICE_ENVATTACK)
+                     ? fluid_convex(127 * fluid_adsr_env_get_val(&voice->envlfo.modenv))
+                     : fluid_adsr_env_get_val(&voice->envlfo.modenv);
+    }
+
+    if(features & (FLUID_RVOICE_PITCH_MOD | FLUID_RVOICE_PORTAMENTO))
+    {
+        /* Calculate the number of samples, that the DSP loop advances
+         * through the original waveform with each step in the output
+         * buffer. It is the ratio between the frequencies of original
+         * waveform and output waveform.*/
+        voice->dsp.phase_incr = fluid_ct2hz_real(voice->dsp.pitch +
+                                voice->dsp.pitchoffset +
+                                fluid_lfo_get_val(&voice->envlfo.modlfo) * voice->envlfo.modlfo_to_pitch
+                                + fluid_lfo_get_val(&voice->envlfo.viblfo) * voice->envlfo.viblfo_to_pitch
+                                + modenv_val * voice->envlfo.modenv_to_pitch)
+                                / 
+                                voice->dsp.root_pitch_hz;
+    }
+    else
+    {
+        /* the pitch is constant until the next pitch related event */
+        voice->dsp.phase_incr = voice->dsp.base_phase_incr;
+    }
 
     /******************* portamento ****************/
     /* pitchoffset is updated if enabled.
@@ -391,26 +420,31 @@ fluid_rvoice_write(fluid_rvoice_t *voice, fluid_real_t *dsp_buf)
      * If the algorithm would first update pitchoffset and then verify if portamento
      * needs to be disabled, there would be a significant performance drop on a x87 FPU
      */
-    if(voice->dsp.pitchinc > 0.0f)
+    if(features & FLUID_RVOICE_PORTAMENTO)
     {
-        /* portamento is enabled, so update pitchoffset */
-        voice->dsp.pitchoffset += voice->dsp.pitchinc;
-
-        /* when pitchoffset reaches 0.0f, portamento is disabled */
-        if(voice->dsp.pitchoffset > 0.0f)
+        if(voice->dsp.pitchinc > 0.0f)
         {
-            voice->dsp.pitchoffset = voice->dsp.pitchinc = 0.0f;
-        }
-    }
-    else if(voice->dsp.pitchinc < 0.0f)
-    {
-        /* portamento is enabled, so update pitchoffset */
-        voice->dsp.pitchoffset += voice->dsp.pitchinc;
+            /* portamento is enabled, so update pitchoffset */
+            voice->dsp.pitchoffset += voice->dsp.pitchinc;
 
-        /* when pitchoffset reaches 0.0f, portamento is disabled */
-        if(voice->dsp.pitchoffset < 0.0f)
+            /* when pitchoffset reaches 0.0f, portamento is disabled */
+            if(voice->dsp.pitchoffset > 0.0f)
+            {
+                voice->dsp.pitchoffset = voice->dsp.pitchinc = 0.0f;
+                fluid_rvoice_update_features(voice);
+            }
+        }
+        else if(voice->dsp.pitchinc < 0.0f)
         {
-            voice->dsp.pitchoffset = voice->dsp.pitchinc = 0.0f;
+            /* portamento is enabled, so update pitchoffset */
+            voice->dsp.pitchoffset += voice->dsp.pitchinc;
+
+            /* when pitchoffset reaches 0.0f, portamento is disabled */
+            if(voice->dsp.pitchoffset < 0.0f)
+            {
+                voice->dsp.pitchoffset = voice->dsp.pitchinc = 0.0f;
+                fluid_rvoice_update_features(voice);
+            }
         }
     }
 
@@ -427,13 +461,13 @@ fluid_rvoice_write(fluid_rvoice_t *voice, fluid_real_t *dsp_buf)
      * since that's what polyphone does (PR #1400) */
     if(voice->dsp.samplemode == FLUID_START_ON_RELEASE && fluid_adsr_env_get_section(&voice->envlfo.volenv) < FLUID_VOICE_ENVRELEASE)
     {
-        return -1;
+        return FLUID_RVOICE_WRITE_QUIET;
     }
 
     /* voice is currently looping? */
-    is_looping = voice->dsp.samplemode == FLUID_LOOP_DURING_RELEASE
-                 || (voice->dsp.samplemode == FLUID_LOOP_UNTIL_RELEASE
-                     && fluid_adsr_env_get_section(&voice->envlfo.volenv) < FLUID_VOICE_ENVRELEASE);
+    *is_looping = voice->dsp.samplemode == FLUID_LOOP_DURING_RELEASE
+                  || (voice->dsp.samplemode == FLUID_LOOP_UNTIL_RELEASE
+                      && fluid_adsr_env_get_section(&voice->envlfo.volenv) < FLUID_VOICE_ENVRELEASE);
 
     /*************** resonant filter ******************/
     // Only "prepare" the filter here, the filter itself will be applied in the dsp_interpolation routines below.
@@ -444,49 +478,410 @@ fluid_rvoice_write(fluid_rvoice_t *voice, fluid_real_t *dsp_buf)
     // Note that at this point we are using voice->dsp.output_rate which is set to the synth's output rate, because
     // the filter will receive the interpolated waveform.
 
-    fmod = fluid_lfo_get_val(&voice->envlfo.modlfo) * voice->envlfo.modlfo_to_fc + modenv_val * voice->envlfo.modenv_to_fc;
+    fmod = (features & FLUID_RVOICE_FILTER_MOD)
+           ? fluid_lfo_get_val(&voice->envlfo.modlfo) * voice->envlfo.modlfo_to_fc + modenv_val * voice->envlfo.modenv_to_fc
+           : 0;
     fluid_iir_filter_calc(&voice->resonant_filter, voice->dsp.output_rate, fmod);
 
     fluid_check_fpe("voice_write IIR coefficients");
 
     /* additional custom filter */
-    fmod = voice->resonant_custom_filter.flags & FLUID_IIR_BEANLAND
-         ? (voice->dsp.pitch + voice->dsp.pitchoffset) - (voice->dsp.sample->origpitch * 100 + voice->dsp.sample->pitchadj)
-         : 0;
-    fluid_iir_filter_calc(&voice->resonant_custom_filter, voice->dsp.output_rate, fmod);
+    if(features & FLUID_RVOICE_CUSTOM_FILTER)
+    {
+        fmod = voice->resonant_custom_filter.flags & FLUID_IIR_BEANLAND
+             ? (voice->dsp.pitch + voice->dsp.pitchoffset) - (voice->dsp.sample->origpitch * 100 + voice->dsp.sample->pitchadj)
+             : 0;
+        fluid_iir_filter_calc(&voice->resonant_custom_filter, voice->dsp.output_rate, fmod);
+
+        fluid_check_fpe("voice_write IIR (custom) coefficients");
+    }
+
+    return count < 0 ? FLUID_RVOICE_WRITE_SILENT : FLUID_RVOICE_WRITE_AUDIBLE;
+}
+
+#define FLUID_RVOICE_WRITE_PREPARE_VARIANT(features) \
+static int fluid_rvoice_write_prepare_##features(fluid_rvoice_t *voice, int *is_looping) \
+{ \
+    return fluid_rvoice_write_prepare_local(voice, is_looping, features); \
+}
+
+FLUID_RVOICE_WRITE_PREPARE_VARIANT(0)
+FLUID_RVOICE_WRITE_PREPARE_VARIANT(1)
+FLUID_RVOICE_WRITE_PREPARE_VARIANT(2)
+FLUID_RVOICE_WRITE_PREPARE_VARIANT(3)
+FLUID_RVOICE_WRITE_PREPARE_VARIANT(4)
+FLUID_RVOICE_WRITE_PREPARE_VARIANT(5)
+FLUID_RVOICE_WRITE_PREPARE_VARIANT(6)
+FLUID_RVOICE_WRITE_PREPARE_VARIANT(7)
+FLUID_RVOICE_WRITE_PREPARE_VARIANT(8)
+FLUID_RVOICE_WRITE_PREPARE_VARIANT(9)
+FLUID_RVOICE_WRITE_PREPARE_VARIANT(10)
+FLUID_RVOICE_WRITE_PREPARE_VARIANT(11)
+FLUID_RVOICE_WRITE_PREPARE_VARIANT(12)
+FLUID_RVOICE_WRITE_PREPARE_VARIANT(13)
+FLUID_RVOICE_WRITE_PREPARE_VARIANT(14)
+FLUID_RVOICE_WRITE_PREPARE_VARIANT(15)
+
+/* indexed by a combination of enum fluid_rvoice_features */
+static int (*const fluid_rvoice_write_prepare_variants[FLUID_RVOICE_FEATURE_COMBINATIONS])(fluid_rvoice_t *, int *) =
+{
+    fluid_rvoice_write_prepare_0, fluid_rvoice_write_prepare_1, fluid_rvoice_write_prepare_2, fluid_rvoice_write_prepare_3,
+    fluid_rvoice_write_prepare_4, fluid_rvoice_write_prepare_5, fluid_rvoice_write_prepare_6, fluid_rvoice_write_prepare_7,
+    fluid_rvoice_write_prepare_8, fluid_rvoice_write_prepare_9, fluid_rvoice_write_prepare_10, fluid_rvoice_write_prepare_11,
+    fluid_rvoice_write_prepare_12, fluid_rvoice_write_prepare_13, fluid_rvoice_write_prepare_14, fluid_rvoice_write_prepare_15
+};
+
+/**
+ * Determine which features of the per-block processing a voice needs and pick
+ * the matching variant of fluid_rvoice_write_prepare_local().
+ *
+ * Must be called whenever one of the parameters tested here changes.
+ *
+ * @param voice rvoice to update
+ */
+static void
+fluid_rvoice_update_features(fluid_rvoice_t *voice)
+{
+    int features = 0;
 
-    fluid_check_fpe("voice_write IIR (custom) coefficients");
+    if(voice->envlfo.modlfo_to_pitch != 0
+            || voice->envlfo.viblfo_to_pitch != 0
+            || voice->envlfo.modenv_to_pitch != 0)
+    {
+        features |= FLUID_RVOICE_PITCH_MOD;
+    }
+
+    if(voice->dsp.pitchinc != 0)
+    {
+        features |= FLUID_RVOICE_PORTAMENTO;
+    }
+
+    if(voice->envlfo.modlfo_to_fc != 0 || voice->envlfo.modenv_to_fc != 0)
+    {
+        features |= FLUID_RVOICE_FILTER_MOD;
+    }
+
+    if(voice->resonant_custom_filter.type != FLUID_IIR_DISABLED)
+    {
+        features |= FLUID_RVOICE_CUSTOM_FILTER;
+    }
+
+    voice->features = features;
+    voice->write_prepare = fluid_rvoice_write_prepare_variants[features];
+
+    /* Without pitch modulation, the pitch terms of the modulators all add up
+     * to zero. Precalculate the phase increment for that case.
+     * The root pitch is still unknown while the voice is being initialized,
+     * fluid_rvoice_set_root_pitch_hz() gets back here once it has been set. */
+    voice->dsp.base_phase_incr = (voice->dsp.root_pitch_hz > 0)
+                                 ? fluid_ct2hz_real(voice->dsp.pitch + voice->dsp.pitchoffset) / voice->dsp.root_pitch_hz
+                                 : 0;
+}
+
+/**
+ * Run the dsp chain of a prepared voice, except for the voice filters.
+ *
+ * @param voice rvoice to synthesize
+ * @param dsp_buf Audio buffer to synthesize to (voice->dsp.block_size in length)
+ * @param state Return value of voice->write_prepare()
+ * @param is_looping TRUE if the voice is currently looping
+ * @param cpu_isa Instruction set level of the dsp kernels, see #fluid_cpu_isa
+ * @return Count of samples written to dsp_buf, see fluid_rvoice_write()
+ */
+static int
+fluid_rvoice_write_dsp(fluid_rvoice_t *voice, fluid_real_t *dsp_buf, int state, int is_looping, int cpu_isa)
+{
+    int count;
 
     /*********************** run the dsp chain ************************
      * The sample is mixed with the output buffer.
-     * The buffer has to be filled from 0 to FLUID_BUFSIZE-1.
+     * The buffer has to be filled from 0 to voice->dsp.block_size-1.
      * Depending on the position in the loop and the loop size, this
      * may require several runs. */
 
-    if(count < 0)
+    if(voice->dsp.start_offset > 0 && state >= FLUID_RVOICE_WRITE_SILENT)
+    {
+        /* the kernels start writing at start_offset, leave silence in front of it */
+        FLUID_MEMSET(dsp_buf, 0, voice->dsp.start_offset * sizeof(fluid_real_t));
+    }
+
+    switch(state)
     {
+    case FLUID_RVOICE_WRITE_FINISHED:
+        count = 0;
+        break;
+
+    case FLUID_RVOICE_WRITE_QUIET:
+        count = -1;
+        break;
+
+    case FLUID_RVOICE_WRITE_SILENT:
         // The voice is quite, i.e. either in delay phase or zero volume.
         // We need to update the rvoice's dsp phase, as the delay phase shall not "postpone" the sound, rather
         // it should be played silently, see https://github.com/FluidSynth/fluidsynth/issues/1312
-        return fluid_rvoice_dsp_silence(voice, dsp_buf, is_looping);
+        count = fluid_rvoice_dsp_silence(voice, dsp_buf, is_looping);
+        break;
+
+    default:
+        count = fluid_rvoice_dsp_interpolate(voice, dsp_buf, is_looping, cpu_isa);
+        fluid_check_fpe("voice_write interpolation");
+        break;
     }
 
-    count = fluid_rvoice_dsp_interpolate(voice, dsp_buf, is_looping);
+    voice->dsp.start_offset = 0;
 
-    fluid_check_fpe("voice_write interpolation");
+    return count;
+}
 
-    if (count == 0)
+/**
+ * Let a voice wait for the block it starts in.
+ *
+ * A voice started with a frame offset (see fluid_synth_noteon_at()) doesn't
+ * render anything, nor advances its envelopes, until the block holding its
+ * first frame is due. Within that block, the dsp kernels begin writing at
+ * dsp.start_offset.
+ *
+ * @return TRUE if the voice is to stay quiet for the current block
+ */
+static FLUID_INLINE int
+fluid_rvoice_wait_start(fluid_rvoice_t *voice)
+{
+    if(voice->dsp.start_offset < (unsigned int)voice->dsp.block_size)
     {
-        // voice has finished
-        return count;
+        return FALSE;
+    }
+
+    voice->dsp.start_offset -= voice->dsp.block_size;
+    return TRUE;
+}
+
+/**
+ * Synthesize a voice to a buffer.
+ *
+ * This is the path of a voice that is rendered on its own, i.e. without any
+ * other voice to be interpolated side by side with. Like fluid_rvoice_write_batch(),
+ * it doesn't apply the voice filters, so that the caller can run them fused with
+ * the mixdown of the block.
+ *
+ * @param voice rvoice to synthesize
+ * @param dsp_buf Audio buffer to synthesize to (voice->dsp.block_size in length)
+ * @param filter Receives TRUE if dsp_buf still has to go through fluid_iir_filter_apply()
+ * or an equivalent
+ * @param cpu_isa Instruction set level of the dsp kernels, see #fluid_cpu_isa
+ * @return Count of samples written to dsp_buf. (-1 means voice is currently
+ * quiet, 0 .. voice->dsp.block_size-1 means voice finished.)
+ *
+ * Panning, reverb and chorus are processed separately. The dsp interpolation
+ * routine is in (fluid_rvoice_dsp.c).
+ */
+int
+fluid_rvoice_write(fluid_rvoice_t *voice, fluid_real_t *dsp_buf, int *filter, int cpu_isa)
+{
+    int is_looping = FALSE;
+    int state, count;
+
+    *filter = FALSE;
+
+    if(fluid_rvoice_wait_start(voice))
+    {
+        return -1;
     }
-    
-    fluid_iir_filter_apply(&voice->resonant_filter, &voice->resonant_custom_filter, dsp_buf, count);
-    fluid_check_fpe("voice_filter fluid_iir_filter_apply()");
+
+    state = voice->write_prepare(voice, &is_looping);
+    count = fluid_rvoice_write_dsp(voice, dsp_buf, state, is_looping, cpu_isa);
+    *filter = (state == FLUID_RVOICE_WRITE_AUDIBLE && count > 0);
 
     return count;
 }
 
+/**
+ * Synthesize one block of several voices at once.
+ *
+ * Voices whose next block can be interpolated without hitting any sample or
+ * loop boundary, are grouped by interpolation method and sample format and
+ * rendered side by side by fluid_rvoice_dsp_interpolate_batch(). All other
+ * voices, as well as a batch of a single voice, take the scalar path of
+ * fluid_rvoice_write().
+ *
+ * If the full blocks of at least two voices have to be filtered, their filters
+ * are run side by side by fluid_iir_filter_apply_bank(). Otherwise the voice
+ * filters are not applied, so that the caller can run them fused with the
+ * mixdown of the block. \c filter tells which blocks have to go through
+ * fluid_iir_filter_apply() or an equivalent.
+ *
+ * @param voices Array of rvoices to synthesize
+ * @param dsp_bufs Array of audio buffers (one block in length each), one per voice
+ * @param counts Receives the return value of fluid_rvoice_write() for each voice
+ * @param filter Receives TRUE for each voice whose block still has to be filtered
+ * @param count Number of voices, must not exceed #FLUID_RVOICE_BATCH_LANES
+ * @param cpu_isa Instruction set level of the dsp kernels, see #fluid_cpu_isa
+ */
+void
+fluid_rvoice_write_batch(fluid_rvoice_t *voices[], fluid_real_t *dsp_bufs[], int counts[], int filter[],
+                         int count, int cpu_isa)
+{
+    fluid_rvoice_t *lane_voices[FLUID_RVOICE_BATCH_LANES];
+    fluid_real_t *lane_bufs[FLUID_RVOICE_BATCH_LANES];
+    fluid_iir_filter_t *lane_filters[FLUID_RVOICE_BATCH_LANES];
+    fluid_iir_filter_t *lane_custom_filters[FLUID_RVOICE_BATCH_LANES];
+    int lane_index[FLUID_RVOICE_BATCH_LANES];
+    int batched[FLUID_RVOICE_BATCH_LANES];
+    int i, j, lanes;
+
+    FLUID_ASSERT(count <= FLUID_RVOICE_BATCH_LANES);
+
+    if(count == 1)
+    {
+        counts[0] = fluid_rvoice_write(voices[0], dsp_bufs[0], &filter[0], cpu_isa);
+        return;
+    }
+
+    for(i = 0; i < count; i++)
+    {
+        int is_looping = FALSE;
+        int state;
+
+        if(fluid_rvoice_wait_start(voices[i]))
+        {
+            batched[i] = FALSE;
+            counts[i] = -1;
+            filter[i] = FALSE;
+            continue;
+        }
+
+        state = voices[i]->write_prepare(voices[i], &is_looping);
+
+        batched[i] = (state == FLUID_RVOICE_WRITE_AUDIBLE && fluid_rvoice_dsp_can_batch(voices[i], is_looping));
+
+        if(!batched[i])
+        {
+            counts[i] = fluid_rvoice_write_dsp(voices[i], dsp_bufs[i], state, is_looping, cpu_isa);
+            filter[i] = (state == FLUID_RVOICE_WRITE_AUDIBLE && counts[i] > 0);
+        }
+    }
+
+    for(i = 0; i < count; i++)
+    {
+        if(!batched[i])
+        {
+            continue;
+        }
+
+        /* collect all remaining voices that share the same kernel */
+        lanes = 0;
+
+        for(j = i; j < count; j++)
+        {
+            if(batched[j]
+                    && voices[j]->dsp.interp_method == voices[i]->dsp.interp_method
+                    && fluid_rvoice_get_sample_fmt(voices[j]->dsp.sample) == fluid_rvoice_get_sample_fmt(voices[i]->dsp.sample))
+            {
+                lane_voices[lanes] = voices[j];
+                lane_bufs[lanes] = dsp_bufs[j];
+                lanes++;
+
+                batched[j] = FALSE;
+                counts[j] = voices[j]->dsp.block_size;
+                filter[j] = TRUE;
+            }
+        }
+
+        fluid_rvoice_dsp_interpolate_batch(lane_voices, lane_bufs, lanes, cpu_isa);
+        fluid_check_fpe("voice_write batch interpolation");
+    }
+
+    /* collect all full blocks that need filtering */
+    lanes = 0;
+
+    for(i = 0; i < count; i++)
+    {
+        if(filter[i] && counts[i] == voices[i]->dsp.block_size && fluid_iir_filter_is_active(&voices[i]->resonant_filter))
+        {
+            lane_filters[lanes] = &voices[i]->resonant_filter;
+            lane_custom_filters[lanes] = &voices[i]->resonant_custom_filter;
+            lane_bufs[lanes] = dsp_bufs[i];
+            lane_index[lanes] = i;
+            lanes++;
+        }
+    }
+
+    /* a single voice is better off with the fused filter and mixdown */
+    if(lanes < 2)
+    {
+        return;
+    }
+
+    FLUID_ASSERT(lanes <= FLUID_IIR_BANK_LANES);
+    fluid_iir_filter_apply_bank(lane_filters, lane_custom_filters, lane_bufs, lanes,
+                                voices[lane_index[0]]->dsp.block_size, cpu_isa);
+    fluid_check_fpe("voice_filter fluid_iir_filter_apply_bank()");
+
+    for(i = 0; i < lanes; i++)
+    {
+        filter[lane_index[i]] = FALSE;
+    }
+}
+
+/**
+ * Estimate the cost of rendering the next block of a voice.
+ *
+ * The estimate is roughly the number of multiply-adds per output sample:
+ * one for the per-block bookkeeping, one for each point the interpolator
+ * reads, five for each active biquad filter and one for each buffer the
+ * voice is mixed into. Voices that are not audible yet only pay for the
+ * bookkeeping.
+ *
+ * @param voice rvoice to estimate
+ * @return Relative cost in the range 1 ... #FLUID_RVOICE_COST_MAX
+ */
+int
+fluid_rvoice_get_cost(fluid_rvoice_t *voice)
+{
+    int cost = 1;
+    int section = fluid_adsr_env_get_section(&voice->envlfo.volenv);
+
+    if(voice->dsp.sample == NULL
+            || section == FLUID_VOICE_ENVDELAY
+            || section == FLUID_VOICE_ENVFINISHED
+            || (voice->dsp.samplemode == FLUID_START_ON_RELEASE && section < FLUID_VOICE_ENVRELEASE))
+    {
+        return cost;
+    }
+
+    switch(voice->dsp.interp_method)
+    {
+    case FLUID_INTERP_NONE:
+        cost += 1;
+        break;
+
+    case FLUID_INTERP_LINEAR:
+        cost += 2;
+        break;
+
+    case FLUID_INTERP_7THORDER:
+        cost += 7;
+        break;
+
+    default:
+        cost += 4;
+        break;
+    }
+
+    if(fluid_iir_filter_is_active(&voice->resonant_filter))
+    {
+        cost += 5;
+    }
+
+    if(voice->resonant_custom_filter.type != FLUID_IIR_DISABLED)
+    {
+        cost += 5;
+    }
+
+    cost += voice->buffers.count;
+
+    return cost > FLUID_RVOICE_COST_MAX ? FLUID_RVOICE_COST_MAX : cost;
+}
+
 /**
  * Initialize buffers up to (and including) bufnum
  */
@@ -577,6 +972,8 @@ DECLARE_FLUID_RVOICE_FUNCTION(fluid_rvoice_reset)
      * This cannot be done earlier, because it depends on modulators.
        [DH] Is that comment really true? */
     voice->dsp.check_sample_sanity_flag |= FLUID_SAMPLESANITY_STARTUP;
+
+    fluid_rvoice_update_features(voice);
 }
 
 DECLARE_FLUID_RVOICE_FUNCTION(fluid_rvoice_noteoff)
@@ -757,6 +1154,7 @@ DECLARE_FLUID_RVOICE_FUNCTION(fluid_rvoice_set_portamento)
     {
         voice->dsp.pitchoffset += pitchoffset;
         voice->dsp.pitchinc = - voice->dsp.pitchoffset / countinc;
+        fluid_rvoice_update_features(voice);
     }
 
     /* Then during the voice processing (in fluid_rvoice_write()),
@@ -786,6 +1184,7 @@ DECLARE_FLUID_RVOICE_FUNCTION(fluid_rvoice_set_root_pitch_hz)
     fluid_real_t value = param[0].real;
 
     voice->dsp.root_pitch_hz = value;
+    fluid_rvoice_update_features(voice);
 }
 
 DECLARE_FLUID_RVOICE_FUNCTION(fluid_rvoice_set_pitch)
@@ -794,6 +1193,7 @@ DECLARE_FLUID_RVOICE_FUNCTION(fluid_rvoice_set_pitch)
     fluid_real_t value = param[0].real;
 
     voice->dsp.pitch = value;
+    fluid_rvoice_update_features(voice);
 }
 
 
@@ -820,6 +1220,7 @@ DECLARE_FLUID_RVOICE_FUNCTION(fluid_rvoice_set_viblfo_to_pitch)
     fluid_real_t value = param[0].real;
 
     voice->envlfo.viblfo_to_pitch = value;
+    fluid_rvoice_update_features(voice);
 }
 
 DECLARE_FLUID_RVOICE_FUNCTION(fluid_rvoice_set_modlfo_to_pitch)
@@ -828,6 +1229,7 @@ DECLARE_FLUID_RVOICE_FUNCTION(fluid_rvoice_set_modlfo_to_pitch)
     fluid_real_t value = param[0].real;
 
     voice->envlfo.modlfo_to_pitch = value;
+    fluid_rvoice_update_features(voice);
 }
 
 DECLARE_FLUID_RVOICE_FUNCTION(fluid_rvoice_set_modlfo_to_vol)
@@ -844,6 +1246,7 @@ DECLARE_FLUID_RVOICE_FUNCTION(fluid_rvoice_set_modlfo_to_fc)
     fluid_real_t value = param[0].real;
 
     voice->envlfo.modlfo_to_fc = value;
+    fluid_rvoice_update_features(voice);
 }
 
 DECLARE_FLUID_RVOICE_FUNCTION(fluid_rvoice_set_modenv_to_fc)
@@ -852,6 +1255,7 @@ DECLARE_FLUID_RVOICE_FUNCTION(fluid_rvoice_set_modenv_to_fc)
     fluid_real_t value = param[0].real;
 
     voice->envlfo.modenv_to_fc = value;
+    fluid_rvoice_update_features(voice);
 }
 
 DECLARE_FLUID_RVOICE_FUNCTION(fluid_rvoice_set_modenv_to_pitch)
@@ -860,6 +1264,7 @@ DECLARE_FLUID_RVOICE_FUNCTION(fluid_rvoice_set_modenv_to_pitch)
     fluid_real_t value = param[0].real;
 
     voice->envlfo.modenv_to_pitch = value;
+    fluid_rvoice_update_features(voice);
 }
 
 DECLARE_FLUID_RVOICE_FUNCTION(fluid_rvoice_set_synth_gain)
@@ -937,6 +1342,17 @@ DECLARE_FLUID_RVOICE_FUNCTION(fluid_rvoice_set_sample)
     }
 }
 
+/**
+ * Set the type of the custom filter of a voice, see fluid_iir_filter_init().
+ */
+DECLARE_FLUID_RVOICE_FUNCTION(fluid_rvoice_set_custom_filter)
+{
+    fluid_rvoice_t *voice = obj;
+
+    fluid_iir_filter_init(&voice->resonant_custom_filter, param);
+    fluid_rvoice_update_features(voice);
+}
+
 DECLARE_FLUID_RVOICE_FUNCTION(fluid_rvoice_voiceoff)
 {
     fluid_rvoice_t *voice = obj;
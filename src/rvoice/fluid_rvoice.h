@@ -112,6 +112,8 @@ struct _fluid_rvoice_dsp_t
     fluid_real_t pitch;              /* the pitch in midicents */
     fluid_real_t root_pitch_hz;      /* the base note of the note in hz */
     fluid_real_t output_rate;
+    int block_size;                  /* number of samples rendered per call, see synth.block-size */
+    unsigned int start_offset;       /* frames to stay silent before the voice starts, see fluid_synth_noteon_at() */
 
     /* Stuff needed for amplitude calculations */
 
@@ -127,7 +129,8 @@ struct _fluid_rvoice_dsp_t
     /* Dynamic input to the interpolator below */
 
     fluid_phase_t phase;             /* the phase (current sample offset) of the sample wave */
-    fluid_real_t phase_incr;	/* the phase increment for the next FLUID_BUFSIZE samples */
+    fluid_real_t phase_incr;	/* the phase increment for the next block_size samples */
+    fluid_real_t base_phase_incr;   /* phase_incr of an unmodulated pitch, see fluid_rvoice_update_features() */
 };
 
 /* Currently left, right, reverb, chorus. To be changed if we
@@ -154,6 +157,20 @@ struct _fluid_rvoice_buffers_t
 };
 
 
+/*
+ * Per-block work a voice needs to do. Each combination of these flags has
+ * its own specialized variant of the per-block preparation, so that voices
+ * don't pay for the features they don't use.
+ */
+enum fluid_rvoice_features
+{
+    FLUID_RVOICE_PITCH_MOD = 1 << 0,     /* an LFO or the mod env modulates the pitch */
+    FLUID_RVOICE_PORTAMENTO = 1 << 1,    /* the pitch glides towards its target */
+    FLUID_RVOICE_FILTER_MOD = 1 << 2,    /* an LFO or the mod env modulates the filter cutoff */
+    FLUID_RVOICE_CUSTOM_FILTER = 1 << 3, /* the custom filter is enabled */
+    FLUID_RVOICE_FEATURE_COMBINATIONS = 1 << 4
+};
+
 /*
  * Hard real-time parameters needed to synthesize a voice
  */
@@ -164,10 +181,22 @@ struct _fluid_rvoice_t
     fluid_iir_filter_t resonant_filter; /* IIR resonant dsp filter */
     fluid_iir_filter_t resonant_custom_filter; /* optional custom/general-purpose IIR resonant filter */
     fluid_rvoice_buffers_t buffers;
+
+    int features; /* combination of enum fluid_rvoice_features */
+    int (*write_prepare)(fluid_rvoice_t *voice, int *is_looping); /* per-block preparation specialized on features */
 };
 
 
-int fluid_rvoice_write(fluid_rvoice_t *voice, fluid_real_t *dsp_buf);
+/* Maximum number of voices rendered side by side by fluid_rvoice_write_batch() */
+#define FLUID_RVOICE_BATCH_LANES 8
+
+/* Upper bound of fluid_rvoice_get_cost() */
+#define FLUID_RVOICE_COST_MAX 31
+
+int fluid_rvoice_write(fluid_rvoice_t *voice, fluid_real_t *dsp_buf, int *filter, int cpu_isa);
+void fluid_rvoice_write_batch(fluid_rvoice_t *voices[], fluid_real_t *dsp_bufs[], int counts[], int filter[],
+                              int count, int cpu_isa);
+int fluid_rvoice_get_cost(fluid_rvoice_t *voice);
 
 DECLARE_FLUID_RVOICE_FUNCTION(fluid_rvoice_buffers_set_amp);
 DECLARE_FLUID_RVOICE_FUNCTION(fluid_rvoice_buffers_set_mapping);
@@ -196,12 +225,33 @@ DECLARE_FLUID_RVOICE_FUNCTION(fluid_rvoice_set_loopstart);
 DECLARE_FLUID_RVOICE_FUNCTION(fluid_rvoice_set_loopend);
 DECLARE_FLUID_RVOICE_FUNCTION(fluid_rvoice_set_samplemode);
 DECLARE_FLUID_RVOICE_FUNCTION(fluid_rvoice_set_sample);
+DECLARE_FLUID_RVOICE_FUNCTION(fluid_rvoice_set_custom_filter);
 
 
 int fluid_rvoice_dsp_silence(fluid_rvoice_t *rvoice, fluid_real_t *FLUID_RESTRICT dsp_buf, int looping);
-int fluid_rvoice_dsp_interpolate(fluid_rvoice_t *voice, fluid_real_t *FLUID_RESTRICT dsp_buf, int is_looping);
+int fluid_rvoice_dsp_interpolate(fluid_rvoice_t *voice, fluid_real_t *FLUID_RESTRICT dsp_buf, int is_looping, int cpu_isa);
+int fluid_rvoice_dsp_can_batch(const fluid_rvoice_t *voice, int is_looping);
+void fluid_rvoice_dsp_interpolate_batch(fluid_rvoice_t *voices[], fluid_real_t *dsp_bufs[], int count, int cpu_isa);
 
 
+/* Storage format of the sample data the dsp kernels read from */
+enum fluid_rvoice_sample_fmt
+{
+    FLUID_SAMPLE_FMT_S16,   /* 16 bit data only */
+    FLUID_SAMPLE_FMT_S24,   /* 16 bit data + 8 bit data24 */
+    FLUID_SAMPLE_FMT_FLOAT  /* pre-converted data_float */
+};
+
+static FLUID_INLINE int
+fluid_rvoice_get_sample_fmt(const fluid_sample_t *sample)
+{
+    if(sample->data_float != NULL)
+    {
+        return FLUID_SAMPLE_FMT_FLOAT;
+    }
+
+    return sample->data24 != NULL ? FLUID_SAMPLE_FMT_S24 : FLUID_SAMPLE_FMT_S16;
+}
 /*
  * Combines the most significant 16 bit part of a sample with a potentially present
  * least sig. 8 bit part in order to create a 24 bit sample.
@@ -41,7 +41,7 @@
  *
  * A couple of variables are used internally, their results are discarded:
  * - dsp_i: Index through the output buffer
- * - dsp_buf: Output buffer of floating point values (FLUID_BUFSIZE in length)
+ * - dsp_buf: Output buffer of floating point values (block_size in length)
  */
 
 /* Interpolation (find a value between two samples of the original waveform) */
@@ -50,12 +50,18 @@ extern "C" const fluid_real_t *const interp_coeff_linear;
 extern "C" const fluid_real_t *const interp_coeff;
 extern "C" const fluid_real_t *const sinc_table7;
 
-template<bool IS_24BIT>
+template<int SAMPLE_FMT>
 static FLUID_INLINE fluid_real_t
-fluid_rvoice_get_float_sample(const short int *FLUID_RESTRICT dsp_msb, const char *FLUID_RESTRICT dsp_lsb, unsigned int idx)
+fluid_rvoice_get_float_sample(const short int *FLUID_RESTRICT dsp_msb, const char *FLUID_RESTRICT dsp_lsb,
+                              const float *FLUID_RESTRICT dsp_float, unsigned int idx)
 {
     int32_t sample;
-    if (IS_24BIT)
+    if (SAMPLE_FMT == FLUID_SAMPLE_FMT_FLOAT)
+    {
+        /* already converted at load time, see synth.sample-format */
+        return (fluid_real_t)dsp_float[idx];
+    }
+    else if (SAMPLE_FMT == FLUID_SAMPLE_FMT_S24)
     {
         sample = fluid_rvoice_get_sample24(dsp_msb, dsp_lsb, idx);
     }
@@ -72,9 +78,10 @@ template<bool LOOPING>
 static int fluid_rvoice_dsp_silence_local(fluid_rvoice_t *rvoice, fluid_real_t *FLUID_RESTRICT dsp_buf)
 {
     fluid_rvoice_dsp_t *voice = &rvoice->dsp;
+    const int block_size = voice->block_size;
     fluid_phase_t dsp_phase = voice->phase;
     fluid_phase_t dsp_phase_incr;
-    unsigned short dsp_i = 0;
+    unsigned short dsp_i = voice->start_offset;
     unsigned int dsp_phase_index;
     unsigned int end_index;
 
@@ -88,7 +95,7 @@ static int fluid_rvoice_dsp_silence_local(fluid_rvoice_t *rvoice, fluid_real_t *
         dsp_phase_index = fluid_phase_index_round(dsp_phase); /* round to nearest point */
 
         /* interpolate sequence of sample points */
-        for (; dsp_i < FLUID_BUFSIZE && dsp_phase_index <= end_index; dsp_i++)
+        for (; dsp_i < block_size && dsp_phase_index <= end_index; dsp_i++)
         {
             fluid_real_t sample = 0;
             dsp_buf[dsp_i] = sample;
@@ -112,7 +119,7 @@ static int fluid_rvoice_dsp_silence_local(fluid_rvoice_t *rvoice, fluid_real_t *
         }
 
         /* break out if filled buffer */
-        if (dsp_i >= FLUID_BUFSIZE)
+        if (dsp_i >= block_size)
         {
             break;
         }
@@ -128,16 +135,18 @@ static int fluid_rvoice_dsp_silence_local(fluid_rvoice_t *rvoice, fluid_real_t *
 /* No interpolation. Just take the sample, which is closest to
   * the playback pointer.  Questionable quality, but very
   * efficient. */
-template<bool IS_24BIT, bool LOOPING>
+template<int SAMPLE_FMT, bool LOOPING>
 static int
 fluid_rvoice_dsp_interpolate_none_local(fluid_rvoice_t *rvoice, fluid_real_t *FLUID_RESTRICT dsp_buf)
 {
     fluid_rvoice_dsp_t *voice = &rvoice->dsp;
+    const int block_size = voice->block_size;
     fluid_phase_t dsp_phase = voice->phase;
     fluid_phase_t dsp_phase_incr;
     const short int *FLUID_RESTRICT dsp_data = voice->sample->data;
     const char *FLUID_RESTRICT dsp_data24 = voice->sample->data24;
-    unsigned short dsp_i = 0;
+    const float *FLUID_RESTRICT dsp_dataf = voice->sample->data_float;
+    unsigned short dsp_i = voice->start_offset;
     unsigned int dsp_phase_index;
     unsigned int end_index;
 
@@ -151,9 +160,9 @@ fluid_rvoice_dsp_interpolate_none_local(fluid_rvoice_t *rvoice, fluid_real_t *FL
         dsp_phase_index = fluid_phase_index_round(dsp_phase);	/* round to nearest point */
 
         /* interpolate sequence of sample points */
-        for(; dsp_i < FLUID_BUFSIZE && dsp_phase_index <= end_index; dsp_i++)
+        for(; dsp_i < block_size && dsp_phase_index <= end_index; dsp_i++)
         {
-            fluid_real_t sample = fluid_rvoice_get_float_sample<IS_24BIT>(dsp_data, dsp_data24, dsp_phase_index);
+            fluid_real_t sample = fluid_rvoice_get_float_sample<SAMPLE_FMT>(dsp_data, dsp_data24, dsp_dataf, dsp_phase_index);
             
             dsp_buf[dsp_i] = sample;
 
@@ -176,7 +185,7 @@ fluid_rvoice_dsp_interpolate_none_local(fluid_rvoice_t *rvoice, fluid_real_t *FL
         }
 
         /* break out if filled buffer */
-        if(dsp_i >= FLUID_BUFSIZE)
+        if(dsp_i >= block_size)
         {
             break;
         }
@@ -188,19 +197,21 @@ fluid_rvoice_dsp_interpolate_none_local(fluid_rvoice_t *rvoice, fluid_real_t *FL
 }
 
 /* Straight line interpolation.
- * Returns number of samples processed (usually FLUID_BUFSIZE but could be
+ * Returns number of samples processed (usually block_size but could be
  * smaller if end of sample occurs).
  */
-template<bool IS_24BIT, bool LOOPING>
+template<int SAMPLE_FMT, bool LOOPING>
 static int
 fluid_rvoice_dsp_interpolate_linear_local(fluid_rvoice_t *rvoice, fluid_real_t *FLUID_RESTRICT dsp_buf)
 {
     fluid_rvoice_dsp_t *voice = &rvoice->dsp;
+    const int block_size = voice->block_size;
     fluid_phase_t dsp_phase = voice->phase;
     fluid_phase_t dsp_phase_incr;
     const short int *FLUID_RESTRICT dsp_data = voice->sample->data;
     const char *FLUID_RESTRICT dsp_data24 = voice->sample->data24;
-    unsigned short dsp_i = 0;
+    const float *FLUID_RESTRICT dsp_dataf = voice->sample->data_float;
+    unsigned short dsp_i = voice->start_offset;
     unsigned int dsp_phase_index;
     unsigned int end_index;
     fluid_real_t point;
@@ -215,11 +226,11 @@ fluid_rvoice_dsp_interpolate_linear_local(fluid_rvoice_t *rvoice, fluid_real_t *
     /* 2nd interpolation point to use at end of loop or sample */
     if(LOOPING)
     {
-        point = fluid_rvoice_get_float_sample<IS_24BIT>(dsp_data, dsp_data24, voice->loopstart);    /* loop start */
+        point = fluid_rvoice_get_float_sample<SAMPLE_FMT>(dsp_data, dsp_data24, dsp_dataf, voice->loopstart);    /* loop start */
     }
     else
     {
-        point = fluid_rvoice_get_float_sample<IS_24BIT>(dsp_data, dsp_data24, voice->end);    /* duplicate end for samples no longer looping */
+        point = fluid_rvoice_get_float_sample<SAMPLE_FMT>(dsp_data, dsp_data24, dsp_dataf, voice->end);    /* duplicate end for samples no longer looping */
     }
 
     while(1)
@@ -227,13 +238,13 @@ fluid_rvoice_dsp_interpolate_linear_local(fluid_rvoice_t *rvoice, fluid_real_t *
         dsp_phase_index = fluid_phase_index(dsp_phase);
 
         /* interpolate the sequence of sample points */
-        for(; dsp_i < FLUID_BUFSIZE && dsp_phase_index <= end_index; dsp_i++)
+        for(; dsp_i < block_size && dsp_phase_index <= end_index; dsp_i++)
         {
             fluid_real_t sample;
             coeffs = &interp_coeff_linear[fluid_phase_fract_to_tablerow(dsp_phase) * LINEAR_INTERP_ORDER];
             
-            sample =  (coeffs[0] * fluid_rvoice_get_float_sample<IS_24BIT>(dsp_data, dsp_data24, dsp_phase_index)
-                     + coeffs[1] * fluid_rvoice_get_float_sample<IS_24BIT>(dsp_data, dsp_data24, dsp_phase_index + 1));
+            sample =  (coeffs[0] * fluid_rvoice_get_float_sample<SAMPLE_FMT>(dsp_data, dsp_data24, dsp_dataf, dsp_phase_index)
+                     + coeffs[1] * fluid_rvoice_get_float_sample<SAMPLE_FMT>(dsp_data, dsp_data24, dsp_dataf, dsp_phase_index + 1));
                         
             dsp_buf[dsp_i] = sample;
 
@@ -243,7 +254,7 @@ fluid_rvoice_dsp_interpolate_linear_local(fluid_rvoice_t *rvoice, fluid_real_t *
         }
 
         /* break out if buffer filled */
-        if(dsp_i >= FLUID_BUFSIZE)
+        if(dsp_i >= block_size)
         {
             break;
         }
@@ -251,12 +262,12 @@ fluid_rvoice_dsp_interpolate_linear_local(fluid_rvoice_t *rvoice, fluid_real_t *
         end_index++;	/* we're now interpolating the last point */
 
         /* interpolate within last point */
-        for(; dsp_phase_index <= end_index && dsp_i < FLUID_BUFSIZE; dsp_i++)
+        for(; dsp_phase_index <= end_index && dsp_i < block_size; dsp_i++)
         {
             fluid_real_t sample;
             coeffs = &interp_coeff_linear[fluid_phase_fract_to_tablerow(dsp_phase) * LINEAR_INTERP_ORDER];
             
-            sample =  (coeffs[0] * fluid_rvoice_get_float_sample<IS_24BIT>(dsp_data, dsp_data24, dsp_phase_index)
+            sample =  (coeffs[0] * fluid_rvoice_get_float_sample<SAMPLE_FMT>(dsp_data, dsp_data24, dsp_dataf, dsp_phase_index)
                      + coeffs[1] * point);
 
             dsp_buf[dsp_i] = sample;
@@ -279,7 +290,7 @@ fluid_rvoice_dsp_interpolate_linear_local(fluid_rvoice_t *rvoice, fluid_real_t *
         }
 
         /* break out if filled buffer */
-        if(dsp_i >= FLUID_BUFSIZE)
+        if(dsp_i >= block_size)
         {
             break;
         }
@@ -293,19 +304,21 @@ fluid_rvoice_dsp_interpolate_linear_local(fluid_rvoice_t *rvoice, fluid_real_t *
 }
 
 /* 4th order (cubic) interpolation.
- * Returns number of samples processed (usually FLUID_BUFSIZE but could be
+ * Returns number of samples processed (usually block_size but could be
  * smaller if end of sample occurs).
  */
-template<bool IS_24BIT, bool LOOPING>
+template<int SAMPLE_FMT, bool LOOPING>
 static int
 fluid_rvoice_dsp_interpolate_4th_order_local(fluid_rvoice_t *rvoice, fluid_real_t *FLUID_RESTRICT dsp_buf)
 {
     fluid_rvoice_dsp_t *voice = &rvoice->dsp;
+    const int block_size = voice->block_size;
     fluid_phase_t dsp_phase = voice->phase;
     fluid_phase_t dsp_phase_incr;
     const short int *FLUID_RESTRICT dsp_data = voice->sample->data;
     const char *FLUID_RESTRICT dsp_data24 = voice->sample->data24;
-    unsigned short dsp_i = 0;
+    const float *FLUID_RESTRICT dsp_dataf = voice->sample->data_float;
+    unsigned short dsp_i = voice->start_offset;
     unsigned int dsp_phase_index;
     unsigned int start_index, end_index;
     fluid_real_t start_point, end_point1, end_point2;
@@ -320,23 +333,23 @@ fluid_rvoice_dsp_interpolate_4th_order_local(fluid_rvoice_t *rvoice, fluid_real_
     if(voice->has_looped)	/* set start_index and start point if looped or not */
     {
         start_index = voice->loopstart;
-        start_point = fluid_rvoice_get_float_sample<IS_24BIT>(dsp_data, dsp_data24, voice->loopend - 1);	/* last point in loop (wrap around) */
+        start_point = fluid_rvoice_get_float_sample<SAMPLE_FMT>(dsp_data, dsp_data24, dsp_dataf, voice->loopend - 1);	/* last point in loop (wrap around) */
     }
     else
     {
         start_index = voice->start;
-        start_point = fluid_rvoice_get_float_sample<IS_24BIT>(dsp_data, dsp_data24, voice->start);	/* just duplicate the point */
+        start_point = fluid_rvoice_get_float_sample<SAMPLE_FMT>(dsp_data, dsp_data24, dsp_dataf, voice->start);	/* just duplicate the point */
     }
 
     /* get points off the end (loop start if looping, duplicate point if end) */
     if(LOOPING)
     {
-        end_point1 = fluid_rvoice_get_float_sample<IS_24BIT>(dsp_data, dsp_data24, voice->loopstart);
-        end_point2 = fluid_rvoice_get_float_sample<IS_24BIT>(dsp_data, dsp_data24, voice->loopstart + 1);
+        end_point1 = fluid_rvoice_get_float_sample<SAMPLE_FMT>(dsp_data, dsp_data24, dsp_dataf, voice->loopstart);
+        end_point2 = fluid_rvoice_get_float_sample<SAMPLE_FMT>(dsp_data, dsp_data24, dsp_dataf, voice->loopstart + 1);
     }
     else
     {
-        end_point1 = fluid_rvoice_get_float_sample<IS_24BIT>(dsp_data, dsp_data24, voice->end);
+        end_point1 = fluid_rvoice_get_float_sample<SAMPLE_FMT>(dsp_data, dsp_data24, dsp_dataf, voice->end);
         end_point2 = end_point1;
     }
 
@@ -345,15 +358,15 @@ fluid_rvoice_dsp_interpolate_4th_order_local(fluid_rvoice_t *rvoice, fluid_real_
         dsp_phase_index = fluid_phase_index(dsp_phase);
 
         /* interpolate first sample point (start or loop start) if needed */
-        for(; dsp_phase_index == start_index && dsp_i < FLUID_BUFSIZE; dsp_i++)
+        for(; dsp_phase_index == start_index && dsp_i < block_size; dsp_i++)
         {
             fluid_real_t sample;
             coeffs = &interp_coeff[fluid_phase_fract_to_tablerow(dsp_phase) * CUBIC_INTERP_ORDER];
 
             sample =  (coeffs[0] * start_point
-                     + coeffs[1] * fluid_rvoice_get_float_sample<IS_24BIT>(dsp_data, dsp_data24, dsp_phase_index)
-                     + coeffs[2] * fluid_rvoice_get_float_sample<IS_24BIT>(dsp_data, dsp_data24, dsp_phase_index + 1)
-                     + coeffs[3] * fluid_rvoice_get_float_sample<IS_24BIT>(dsp_data, dsp_data24, dsp_phase_index + 2));
+                     + coeffs[1] * fluid_rvoice_get_float_sample<SAMPLE_FMT>(dsp_data, dsp_data24, dsp_dataf, dsp_phase_index)
+                     + coeffs[2] * fluid_rvoice_get_float_sample<SAMPLE_FMT>(dsp_data, dsp_data24, dsp_dataf, dsp_phase_index + 1)
+                     + coeffs[3] * fluid_rvoice_get_float_sample<SAMPLE_FMT>(dsp_data, dsp_data24, dsp_dataf, dsp_phase_index + 2));
                         
             dsp_buf[dsp_i] = sample;
 
@@ -363,15 +376,15 @@ fluid_rvoice_dsp_interpolate_4th_order_local(fluid_rvoice_t *rvoice, fluid_real_
         }
 
         /* interpolate the sequence of sample points */
-        for(; dsp_i < FLUID_BUFSIZE && dsp_phase_index <= end_index; dsp_i++)
+        for(; dsp_i < block_size && dsp_phase_index <= end_index; dsp_i++)
         {
             fluid_real_t sample;
             coeffs = &interp_coeff[fluid_phase_fract_to_tablerow(dsp_phase) * CUBIC_INTERP_ORDER];
 
-            sample =  (coeffs[0] * fluid_rvoice_get_float_sample<IS_24BIT>(dsp_data, dsp_data24, dsp_phase_index - 1)
-                     + coeffs[1] * fluid_rvoice_get_float_sample<IS_24BIT>(dsp_data, dsp_data24, dsp_phase_index)
-                     + coeffs[2] * fluid_rvoice_get_float_sample<IS_24BIT>(dsp_data, dsp_data24, dsp_phase_index + 1)
-                     + coeffs[3] * fluid_rvoice_get_float_sample<IS_24BIT>(dsp_data, dsp_data24, dsp_phase_index + 2));
+            sample =  (coeffs[0] * fluid_rvoice_get_float_sample<SAMPLE_FMT>(dsp_data, dsp_data24, dsp_dataf, dsp_phase_index - 1)
+                     + coeffs[1] * fluid_rvoice_get_float_sample<SAMPLE_FMT>(dsp_data, dsp_data24, dsp_dataf, dsp_phase_index)
+                     + coeffs[2] * fluid_rvoice_get_float_sample<SAMPLE_FMT>(dsp_data, dsp_data24, dsp_dataf, dsp_phase_index + 1)
+                     + coeffs[3] * fluid_rvoice_get_float_sample<SAMPLE_FMT>(dsp_data, dsp_data24, dsp_dataf, dsp_phase_index + 2));
 
             dsp_buf[dsp_i] = sample;
 
@@ -381,7 +394,7 @@ fluid_rvoice_dsp_interpolate_4th_order_local(fluid_rvoice_t *rvoice, fluid_real_
         }
 
         /* break out if buffer filled */
-        if(dsp_i >= FLUID_BUFSIZE)
+        if(dsp_i >= block_size)
         {
             break;
         }
@@ -389,14 +402,14 @@ fluid_rvoice_dsp_interpolate_4th_order_local(fluid_rvoice_t *rvoice, fluid_real_
         end_index++;	/* we're now interpolating the 2nd to last point */
 
         /* interpolate within 2nd to last point */
-        for(; dsp_phase_index <= end_index && dsp_i < FLUID_BUFSIZE; dsp_i++)
+        for(; dsp_phase_index <= end_index && dsp_i < block_size; dsp_i++)
         {
             fluid_real_t sample;
             coeffs = &interp_coeff[fluid_phase_fract_to_tablerow(dsp_phase) * CUBIC_INTERP_ORDER];
 
-            sample =  (coeffs[0] * fluid_rvoice_get_float_sample<IS_24BIT>(dsp_data, dsp_data24, dsp_phase_index - 1)
-                     + coeffs[1] * fluid_rvoice_get_float_sample<IS_24BIT>(dsp_data, dsp_data24, dsp_phase_index)
-                     + coeffs[2] * fluid_rvoice_get_float_sample<IS_24BIT>(dsp_data, dsp_data24, dsp_phase_index + 1)
+            sample =  (coeffs[0] * fluid_rvoice_get_float_sample<SAMPLE_FMT>(dsp_data, dsp_data24, dsp_dataf, dsp_phase_index - 1)
+                     + coeffs[1] * fluid_rvoice_get_float_sample<SAMPLE_FMT>(dsp_data, dsp_data24, dsp_dataf, dsp_phase_index)
+                     + coeffs[2] * fluid_rvoice_get_float_sample<SAMPLE_FMT>(dsp_data, dsp_data24, dsp_dataf, dsp_phase_index + 1)
                      + coeffs[3] * end_point1);
 
             dsp_buf[dsp_i] = sample;
@@ -409,14 +422,14 @@ fluid_rvoice_dsp_interpolate_4th_order_local(fluid_rvoice_t *rvoice, fluid_real_
         end_index++;	/* we're now interpolating the last point */
 
         /* interpolate within the last point */
-        for(; dsp_phase_index <= end_index && dsp_i < FLUID_BUFSIZE; dsp_i++)
+        for(; dsp_phase_index <= end_index && dsp_i < block_size; dsp_i++)
         {
             fluid_real_t sample;
             coeffs = &interp_coeff[fluid_phase_fract_to_tablerow(dsp_phase) * CUBIC_INTERP_ORDER];
 
             
-            sample =  (coeffs[0] * fluid_rvoice_get_float_sample<IS_24BIT>(dsp_data, dsp_data24, dsp_phase_index - 1)
-                     + coeffs[1] * fluid_rvoice_get_float_sample<IS_24BIT>(dsp_data, dsp_data24, dsp_phase_index)
+            sample =  (coeffs[0] * fluid_rvoice_get_float_sample<SAMPLE_FMT>(dsp_data, dsp_data24, dsp_dataf, dsp_phase_index - 1)
+                     + coeffs[1] * fluid_rvoice_get_float_sample<SAMPLE_FMT>(dsp_data, dsp_data24, dsp_dataf, dsp_phase_index)
                      + coeffs[2] * end_point1
                      + coeffs[3] * end_point2);
 
@@ -441,12 +454,12 @@ fluid_rvoice_dsp_interpolate_4th_order_local(fluid_rvoice_t *rvoice, fluid_real_
             {
                 voice->has_looped = 1;
                 start_index = voice->loopstart;
-                start_point = fluid_rvoice_get_float_sample<IS_24BIT>(dsp_data, dsp_data24, voice->loopend - 1);
+                start_point = fluid_rvoice_get_float_sample<SAMPLE_FMT>(dsp_data, dsp_data24, dsp_dataf, voice->loopend - 1);
             }
         }
 
         /* break out if filled buffer */
-        if(dsp_i >= FLUID_BUFSIZE)
+        if(dsp_i >= block_size)
         {
             break;
         }
@@ -460,19 +473,21 @@ fluid_rvoice_dsp_interpolate_4th_order_local(fluid_rvoice_t *rvoice, fluid_real_
 }
 
 /* 7th order interpolation.
- * Returns number of samples processed (usually FLUID_BUFSIZE but could be
+ * Returns number of samples processed (usually block_size but could be
  * smaller if end of sample occurs).
  */
-template<bool IS_24BIT, bool LOOPING>
+template<int SAMPLE_FMT, bool LOOPING>
 static int
 fluid_rvoice_dsp_interpolate_7th_order_local(fluid_rvoice_t *rvoice, fluid_real_t *FLUID_RESTRICT dsp_buf)
 {
     fluid_rvoice_dsp_t *voice = &rvoice->dsp;
+    const int block_size = voice->block_size;
     fluid_phase_t dsp_phase = voice->phase;
     fluid_phase_t dsp_phase_incr;
     const short int *FLUID_RESTRICT dsp_data = voice->sample->data;
     const char *FLUID_RESTRICT dsp_data24 = voice->sample->data24;
-    unsigned short dsp_i = 0;
+    const float *FLUID_RESTRICT dsp_dataf = voice->sample->data_float;
+    unsigned short dsp_i = voice->start_offset;
     unsigned int dsp_phase_index;
     unsigned int start_index, end_index;
     fluid_real_t start_points[3], end_points[3];
@@ -491,14 +506,14 @@ fluid_rvoice_dsp_interpolate_7th_order_local(fluid_rvoice_t *rvoice, fluid_real_
     if(voice->has_looped)	/* set start_index and start point if looped or not */
     {
         start_index = voice->loopstart;
-        start_points[0] = fluid_rvoice_get_float_sample<IS_24BIT>(dsp_data, dsp_data24, voice->loopend - 1);
-        start_points[1] = fluid_rvoice_get_float_sample<IS_24BIT>(dsp_data, dsp_data24, voice->loopend - 2);
-        start_points[2] = fluid_rvoice_get_float_sample<IS_24BIT>(dsp_data, dsp_data24, voice->loopend - 3);
+        start_points[0] = fluid_rvoice_get_float_sample<SAMPLE_FMT>(dsp_data, dsp_data24, dsp_dataf, voice->loopend - 1);
+        start_points[1] = fluid_rvoice_get_float_sample<SAMPLE_FMT>(dsp_data, dsp_data24, dsp_dataf, voice->loopend - 2);
+        start_points[2] = fluid_rvoice_get_float_sample<SAMPLE_FMT>(dsp_data, dsp_data24, dsp_dataf, voice->loopend - 3);
     }
     else
     {
         start_index = voice->start;
-        start_points[0] = fluid_rvoice_get_float_sample<IS_24BIT>(dsp_data, dsp_data24, voice->start);	/* just duplicate the start point */
+        start_points[0] = fluid_rvoice_get_float_sample<SAMPLE_FMT>(dsp_data, dsp_data24, dsp_dataf, voice->start);	/* just duplicate the start point */
         start_points[1] = start_points[0];
         start_points[2] = start_points[0];
     }
@@ -506,13 +521,13 @@ fluid_rvoice_dsp_interpolate_7th_order_local(fluid_rvoice_t *rvoice, fluid_real_
     /* get the 3 points off the end (loop start if looping, duplicate point if end) */
     if(LOOPING)
     {
-        end_points[0] = fluid_rvoice_get_float_sample<IS_24BIT>(dsp_data, dsp_data24, voice->loopstart);
-        end_points[1] = fluid_rvoice_get_float_sample<IS_24BIT>(dsp_data, dsp_data24, voice->loopstart + 1);
-        end_points[2] = fluid_rvoice_get_float_sample<IS_24BIT>(dsp_data, dsp_data24, voice->loopstart + 2);
+        end_points[0] = fluid_rvoice_get_float_sample<SAMPLE_FMT>(dsp_data, dsp_data24, dsp_dataf, voice->loopstart);
+        end_points[1] = fluid_rvoice_get_float_sample<SAMPLE_FMT>(dsp_data, dsp_data24, dsp_dataf, voice->loopstart + 1);
+        end_points[2] = fluid_rvoice_get_float_sample<SAMPLE_FMT>(dsp_data, dsp_data24, dsp_dataf, voice->loopstart + 2);
     }
     else
     {
-        end_points[0] = fluid_rvoice_get_float_sample<IS_24BIT>(dsp_data, dsp_data24, voice->end);
+        end_points[0] = fluid_rvoice_get_float_sample<SAMPLE_FMT>(dsp_data, dsp_data24, dsp_dataf, voice->end);
         end_points[1] = end_points[0];
         end_points[2] = end_points[0];
     }
@@ -522,7 +537,7 @@ fluid_rvoice_dsp_interpolate_7th_order_local(fluid_rvoice_t *rvoice, fluid_real_
         dsp_phase_index = fluid_phase_index(dsp_phase);
 
         /* interpolate first sample point (start or loop start) if needed */
-        for(; dsp_phase_index == start_index && dsp_i < FLUID_BUFSIZE; dsp_i++)
+        for(; dsp_phase_index == start_index && dsp_i < block_size; dsp_i++)
         {
             fluid_real_t sample;
             coeffs = &sinc_table7[fluid_phase_fract_to_tablerow(dsp_phase) * SINC_INTERP_ORDER];
@@ -530,10 +545,10 @@ fluid_rvoice_dsp_interpolate_7th_order_local(fluid_rvoice_t *rvoice, fluid_real_
             sample =  (coeffs[0] * start_points[2]
                      + coeffs[1] * start_points[1]
                      + coeffs[2] * start_points[0]
-                     + coeffs[3] * fluid_rvoice_get_float_sample<IS_24BIT>(dsp_data, dsp_data24, dsp_phase_index)
-                     + coeffs[4] * fluid_rvoice_get_float_sample<IS_24BIT>(dsp_data, dsp_data24, dsp_phase_index + 1)
-                     + coeffs[5] * fluid_rvoice_get_float_sample<IS_24BIT>(dsp_data, dsp_data24, dsp_phase_index + 2)
-                     + coeffs[6] * fluid_rvoice_get_float_sample<IS_24BIT>(dsp_data, dsp_data24, dsp_phase_index + 3));
+                     + coeffs[3] * fluid_rvoice_get_float_sample<SAMPLE_FMT>(dsp_data, dsp_data24, dsp_dataf, dsp_phase_index)
+                     + coeffs[4] * fluid_rvoice_get_float_sample<SAMPLE_FMT>(dsp_data, dsp_data24, dsp_dataf, dsp_phase_index + 1)
+                     + coeffs[5] * fluid_rvoice_get_float_sample<SAMPLE_FMT>(dsp_data, dsp_data24, dsp_dataf, dsp_phase_index + 2)
+                     + coeffs[6] * fluid_rvoice_get_float_sample<SAMPLE_FMT>(dsp_data, dsp_data24, dsp_dataf, dsp_phase_index + 3));
 
             dsp_buf[dsp_i] = sample;
 
@@ -545,18 +560,18 @@ fluid_rvoice_dsp_interpolate_7th_order_local(fluid_rvoice_t *rvoice, fluid_real_
         start_index++;
 
         /* interpolate 2nd to first sample point (start or loop start) if needed */
-        for(; dsp_phase_index == start_index && dsp_i < FLUID_BUFSIZE; dsp_i++)
+        for(; dsp_phase_index == start_index && dsp_i < block_size; dsp_i++)
         {
             fluid_real_t sample;
             coeffs = &sinc_table7[fluid_phase_fract_to_tablerow(dsp_phase) * SINC_INTERP_ORDER];
 
             sample =  (coeffs[0] * start_points[1]
                      + coeffs[1] * start_points[0]
-                     + coeffs[2] * fluid_rvoice_get_float_sample<IS_24BIT>(dsp_data, dsp_data24, dsp_phase_index - 1)
-                     + coeffs[3] * fluid_rvoice_get_float_sample<IS_24BIT>(dsp_data, dsp_data24, dsp_phase_index)
-                     + coeffs[4] * fluid_rvoice_get_float_sample<IS_24BIT>(dsp_data, dsp_data24, dsp_phase_index + 1)
-                     + coeffs[5] * fluid_rvoice_get_float_sample<IS_24BIT>(dsp_data, dsp_data24, dsp_phase_index + 2)
-                     + coeffs[6] * fluid_rvoice_get_float_sample<IS_24BIT>(dsp_data, dsp_data24, dsp_phase_index + 3));
+                     + coeffs[2] * fluid_rvoice_get_float_sample<SAMPLE_FMT>(dsp_data, dsp_data24, dsp_dataf, dsp_phase_index - 1)
+                     + coeffs[3] * fluid_rvoice_get_float_sample<SAMPLE_FMT>(dsp_data, dsp_data24, dsp_dataf, dsp_phase_index)
+                     + coeffs[4] * fluid_rvoice_get_float_sample<SAMPLE_FMT>(dsp_data, dsp_data24, dsp_dataf, dsp_phase_index + 1)
+                     + coeffs[5] * fluid_rvoice_get_float_sample<SAMPLE_FMT>(dsp_data, dsp_data24, dsp_dataf, dsp_phase_index + 2)
+                     + coeffs[6] * fluid_rvoice_get_float_sample<SAMPLE_FMT>(dsp_data, dsp_data24, dsp_dataf, dsp_phase_index + 3));
 
             dsp_buf[dsp_i] = sample;
 
@@ -568,18 +583,18 @@ fluid_rvoice_dsp_interpolate_7th_order_local(fluid_rvoice_t *rvoice, fluid_real_
         start_index++;
 
         /* interpolate 3rd to first sample point (start or loop start) if needed */
-        for(; dsp_phase_index == start_index && dsp_i < FLUID_BUFSIZE; dsp_i++)
+        for(; dsp_phase_index == start_index && dsp_i < block_size; dsp_i++)
         {
             fluid_real_t sample;
             coeffs = &sinc_table7[fluid_phase_fract_to_tablerow(dsp_phase) * SINC_INTERP_ORDER];
 
             sample =  (coeffs[0] * start_points[0]
-                     + coeffs[1] * fluid_rvoice_get_float_sample<IS_24BIT>(dsp_data, dsp_data24, dsp_phase_index - 2)
-                     + coeffs[2] * fluid_rvoice_get_float_sample<IS_24BIT>(dsp_data, dsp_data24, dsp_phase_index - 1)
-                     + coeffs[3] * fluid_rvoice_get_float_sample<IS_24BIT>(dsp_data, dsp_data24, dsp_phase_index)
-                     + coeffs[4] * fluid_rvoice_get_float_sample<IS_24BIT>(dsp_data, dsp_data24, dsp_phase_index + 1)
-                     + coeffs[5] * fluid_rvoice_get_float_sample<IS_24BIT>(dsp_data, dsp_data24, dsp_phase_index + 2)
-                     + coeffs[6] * fluid_rvoice_get_float_sample<IS_24BIT>(dsp_data, dsp_data24, dsp_phase_index + 3));
+                     + coeffs[1] * fluid_rvoice_get_float_sample<SAMPLE_FMT>(dsp_data, dsp_data24, dsp_dataf, dsp_phase_index - 2)
+                     + coeffs[2] * fluid_rvoice_get_float_sample<SAMPLE_FMT>(dsp_data, dsp_data24, dsp_dataf, dsp_phase_index - 1)
+                     + coeffs[3] * fluid_rvoice_get_float_sample<SAMPLE_FMT>(dsp_data, dsp_data24, dsp_dataf, dsp_phase_index)
+                     + coeffs[4] * fluid_rvoice_get_float_sample<SAMPLE_FMT>(dsp_data, dsp_data24, dsp_dataf, dsp_phase_index + 1)
+                     + coeffs[5] * fluid_rvoice_get_float_sample<SAMPLE_FMT>(dsp_data, dsp_data24, dsp_dataf, dsp_phase_index + 2)
+                     + coeffs[6] * fluid_rvoice_get_float_sample<SAMPLE_FMT>(dsp_data, dsp_data24, dsp_dataf, dsp_phase_index + 3));
 
             dsp_buf[dsp_i] = sample;
 
@@ -592,18 +607,18 @@ fluid_rvoice_dsp_interpolate_7th_order_local(fluid_rvoice_t *rvoice, fluid_real_
 
 
         /* interpolate the sequence of sample points */
-        for(; dsp_i < FLUID_BUFSIZE && dsp_phase_index <= end_index; dsp_i++)
+        for(; dsp_i < block_size && dsp_phase_index <= end_index; dsp_i++)
         {
             fluid_real_t sample;
             coeffs = &sinc_table7[fluid_phase_fract_to_tablerow(dsp_phase) * SINC_INTERP_ORDER];
 
-            sample =  (coeffs[0] * fluid_rvoice_get_float_sample<IS_24BIT>(dsp_data, dsp_data24, dsp_phase_index - 3)
-                     + coeffs[1] * fluid_rvoice_get_float_sample<IS_24BIT>(dsp_data, dsp_data24, dsp_phase_index - 2)
-                     + coeffs[2] * fluid_rvoice_get_float_sample<IS_24BIT>(dsp_data, dsp_data24, dsp_phase_index - 1)
-                     + coeffs[3] * fluid_rvoice_get_float_sample<IS_24BIT>(dsp_data, dsp_data24, dsp_phase_index)
-                     + coeffs[4] * fluid_rvoice_get_float_sample<IS_24BIT>(dsp_data, dsp_data24, dsp_phase_index + 1)
-                     + coeffs[5] * fluid_rvoice_get_float_sample<IS_24BIT>(dsp_data, dsp_data24, dsp_phase_index + 2)
-                     + coeffs[6] * fluid_rvoice_get_float_sample<IS_24BIT>(dsp_data, dsp_data24, dsp_phase_index + 3));
+            sample =  (coeffs[0] * fluid_rvoice_get_float_sample<SAMPLE_FMT>(dsp_data, dsp_data24, dsp_dataf, dsp_phase_index - 3)
+                     + coeffs[1] * fluid_rvoice_get_float_sample<SAMPLE_FMT>(dsp_data, dsp_data24, dsp_dataf, dsp_phase_index - 2)
+                     + coeffs[2] * fluid_rvoice_get_float_sample<SAMPLE_FMT>(dsp_data, dsp_data24, dsp_dataf, dsp_phase_index - 1)
+                     + coeffs[3] * fluid_rvoice_get_float_sample<SAMPLE_FMT>(dsp_data, dsp_data24, dsp_dataf, dsp_phase_index)
+                     + coeffs[4] * fluid_rvoice_get_float_sample<SAMPLE_FMT>(dsp_data, dsp_data24, dsp_dataf, dsp_phase_index + 1)
+                     + coeffs[5] * fluid_rvoice_get_float_sample<SAMPLE_FMT>(dsp_data, dsp_data24, dsp_dataf, dsp_phase_index + 2)
+                     + coeffs[6] * fluid_rvoice_get_float_sample<SAMPLE_FMT>(dsp_data, dsp_data24, dsp_dataf, dsp_phase_index + 3));
 
             dsp_buf[dsp_i] = sample;
 
@@ -613,7 +628,7 @@ fluid_rvoice_dsp_interpolate_7th_order_local(fluid_rvoice_t *rvoice, fluid_real_
         }
 
         /* break out if buffer filled */
-        if(dsp_i >= FLUID_BUFSIZE)
+        if(dsp_i >= block_size)
         {
             break;
         }
@@ -621,17 +636,17 @@ fluid_rvoice_dsp_interpolate_7th_order_local(fluid_rvoice_t *rvoice, fluid_real_
         end_index++;	/* we're now interpolating the 3rd to last point */
 
         /* interpolate within 3rd to last point */
-        for(; dsp_phase_index <= end_index && dsp_i < FLUID_BUFSIZE; dsp_i++)
+        for(; dsp_phase_index <= end_index && dsp_i < block_size; dsp_i++)
         {
             fluid_real_t sample;
             coeffs = &sinc_table7[fluid_phase_fract_to_tablerow(dsp_phase) * SINC_INTERP_ORDER];
 
-            sample =  (coeffs[0] * fluid_rvoice_get_float_sample<IS_24BIT>(dsp_data, dsp_data24, dsp_phase_index - 3)
-                     + coeffs[1] * fluid_rvoice_get_float_sample<IS_24BIT>(dsp_data, dsp_data24, dsp_phase_index - 2)
-                     + coeffs[2] * fluid_rvoice_get_float_sample<IS_24BIT>(dsp_data, dsp_data24, dsp_phase_index - 1)
-                     + coeffs[3] * fluid_rvoice_get_float_sample<IS_24BIT>(dsp_data, dsp_data24, dsp_phase_index)
-                     + coeffs[4] * fluid_rvoice_get_float_sample<IS_24BIT>(dsp_data, dsp_data24, dsp_phase_index + 1)
-                     + coeffs[5] * fluid_rvoice_get_float_sample<IS_24BIT>(dsp_data, dsp_data24, dsp_phase_index + 2)
+            sample =  (coeffs[0] * fluid_rvoice_get_float_sample<SAMPLE_FMT>(dsp_data, dsp_data24, dsp_dataf, dsp_phase_index - 3)
+                     + coeffs[1] * fluid_rvoice_get_float_sample<SAMPLE_FMT>(dsp_data, dsp_data24, dsp_dataf, dsp_phase_index - 2)
+                     + coeffs[2] * fluid_rvoice_get_float_sample<SAMPLE_FMT>(dsp_data, dsp_data24, dsp_dataf, dsp_phase_index - 1)
+                     + coeffs[3] * fluid_rvoice_get_float_sample<SAMPLE_FMT>(dsp_data, dsp_data24, dsp_dataf, dsp_phase_index)
+                     + coeffs[4] * fluid_rvoice_get_float_sample<SAMPLE_FMT>(dsp_data, dsp_data24, dsp_dataf, dsp_phase_index + 1)
+                     + coeffs[5] * fluid_rvoice_get_float_sample<SAMPLE_FMT>(dsp_data, dsp_data24, dsp_dataf, dsp_phase_index + 2)
                      + coeffs[6] * end_points[0]);
 
             dsp_buf[dsp_i] = sample;
@@ -644,16 +659,16 @@ fluid_rvoice_dsp_interpolate_7th_order_local(fluid_rvoice_t *rvoice, fluid_real_
         end_index++;	/* we're now interpolating the 2nd to last point */
 
         /* interpolate within 2nd to last point */
-        for(; dsp_phase_index <= end_index && dsp_i < FLUID_BUFSIZE; dsp_i++)
+        for(; dsp_phase_index <= end_index && dsp_i < block_size; dsp_i++)
         {
             fluid_real_t sample;
             coeffs = &sinc_table7[fluid_phase_fract_to_tablerow(dsp_phase) * SINC_INTERP_ORDER];
 
-            sample =  (coeffs[0] * fluid_rvoice_get_float_sample<IS_24BIT>(dsp_data, dsp_data24, dsp_phase_index - 3)
-                     + coeffs[1] * fluid_rvoice_get_float_sample<IS_24BIT>(dsp_data, dsp_data24, dsp_phase_index - 2)
-                     + coeffs[2] * fluid_rvoice_get_float_sample<IS_24BIT>(dsp_data, dsp_data24, dsp_phase_index - 1)
-                     + coeffs[3] * fluid_rvoice_get_float_sample<IS_24BIT>(dsp_data, dsp_data24, dsp_phase_index)
-                     + coeffs[4] * fluid_rvoice_get_float_sample<IS_24BIT>(dsp_data, dsp_data24, dsp_phase_index + 1)
+            sample =  (coeffs[0] * fluid_rvoice_get_float_sample<SAMPLE_FMT>(dsp_data, dsp_data24, dsp_dataf, dsp_phase_index - 3)
+                     + coeffs[1] * fluid_rvoice_get_float_sample<SAMPLE_FMT>(dsp_data, dsp_data24, dsp_dataf, dsp_phase_index - 2)
+                     + coeffs[2] * fluid_rvoice_get_float_sample<SAMPLE_FMT>(dsp_data, dsp_data24, dsp_dataf, dsp_phase_index - 1)
+                     + coeffs[3] * fluid_rvoice_get_float_sample<SAMPLE_FMT>(dsp_data, dsp_data24, dsp_dataf, dsp_phase_index)
+                     + coeffs[4] * fluid_rvoice_get_float_sample<SAMPLE_FMT>(dsp_data, dsp_data24, dsp_dataf, dsp_phase_index + 1)
                      + coeffs[5] * end_points[0]
                      + coeffs[6] * end_points[1]);
 
@@ -667,15 +682,15 @@ fluid_rvoice_dsp_interpolate_7th_order_local(fluid_rvoice_t *rvoice, fluid_real_
         end_index++;	/* we're now interpolating the last point */
 
         /* interpolate within last point */
-        for(; dsp_phase_index <= end_index && dsp_i < FLUID_BUFSIZE; dsp_i++)
+        for(; dsp_phase_index <= end_index && dsp_i < block_size; dsp_i++)
         {
             fluid_real_t sample;
             coeffs = &sinc_table7[fluid_phase_fract_to_tablerow(dsp_phase) * SINC_INTERP_ORDER];
 
-            sample =  (coeffs[0] * fluid_rvoice_get_float_sample<IS_24BIT>(dsp_data, dsp_data24, dsp_phase_index - 3)
-                     + coeffs[1] * fluid_rvoice_get_float_sample<IS_24BIT>(dsp_data, dsp_data24, dsp_phase_index - 2)
-                     + coeffs[2] * fluid_rvoice_get_float_sample<IS_24BIT>(dsp_data, dsp_data24, dsp_phase_index - 1)
-                     + coeffs[3] * fluid_rvoice_get_float_sample<IS_24BIT>(dsp_data, dsp_data24, dsp_phase_index)
+            sample =  (coeffs[0] * fluid_rvoice_get_float_sample<SAMPLE_FMT>(dsp_data, dsp_data24, dsp_dataf, dsp_phase_index - 3)
+                     + coeffs[1] * fluid_rvoice_get_float_sample<SAMPLE_FMT>(dsp_data, dsp_data24, dsp_dataf, dsp_phase_index - 2)
+                     + coeffs[2] * fluid_rvoice_get_float_sample<SAMPLE_FMT>(dsp_data, dsp_data24, dsp_dataf, dsp_phase_index - 1)
+                     + coeffs[3] * fluid_rvoice_get_float_sample<SAMPLE_FMT>(dsp_data, dsp_data24, dsp_dataf, dsp_phase_index)
                      + coeffs[4] * end_points[0]
                      + coeffs[5] * end_points[1]
                      + coeffs[6] * end_points[2]);
@@ -701,14 +716,14 @@ fluid_rvoice_dsp_interpolate_7th_order_local(fluid_rvoice_t *rvoice, fluid_real_
             {
                 voice->has_looped = 1;
                 start_index = voice->loopstart;
-                start_points[0] = fluid_rvoice_get_float_sample<IS_24BIT>(dsp_data, dsp_data24, voice->loopend - 1);
-                start_points[1] = fluid_rvoice_get_float_sample<IS_24BIT>(dsp_data, dsp_data24, voice->loopend - 2);
-                start_points[2] = fluid_rvoice_get_float_sample<IS_24BIT>(dsp_data, dsp_data24, voice->loopend - 3);
+                start_points[0] = fluid_rvoice_get_float_sample<SAMPLE_FMT>(dsp_data, dsp_data24, dsp_dataf, voice->loopend - 1);
+                start_points[1] = fluid_rvoice_get_float_sample<SAMPLE_FMT>(dsp_data, dsp_data24, dsp_dataf, voice->loopend - 2);
+                start_points[2] = fluid_rvoice_get_float_sample<SAMPLE_FMT>(dsp_data, dsp_data24, dsp_dataf, voice->loopend - 3);
             }
         }
 
         /* break out if filled buffer */
-        if(dsp_i >= FLUID_BUFSIZE)
+        if(dsp_i >= block_size)
         {
             break;
         }
@@ -727,7 +742,7 @@ fluid_rvoice_dsp_interpolate_7th_order_local(fluid_rvoice_t *rvoice, fluid_real_
 
 struct ProcessSilence
 {
-    template<bool IS_24BIT, bool LOOPING>
+    template<int SAMPLE_FMT, bool LOOPING>
     int operator()(fluid_rvoice_t *rvoice, fluid_real_t *FLUID_RESTRICT dsp_buf) const
     {
         return fluid_rvoice_dsp_silence_local<LOOPING>(rvoice, dsp_buf);
@@ -736,68 +751,69 @@ struct ProcessSilence
 
 struct InterpolateNone
 {
-    template<bool IS_24BIT, bool LOOPING>
+    template<int SAMPLE_FMT, bool LOOPING>
     int operator()(fluid_rvoice_t *rvoice, fluid_real_t *FLUID_RESTRICT dsp_buf) const
     {
-        return fluid_rvoice_dsp_interpolate_none_local<IS_24BIT, LOOPING>(rvoice, dsp_buf);
+        return fluid_rvoice_dsp_interpolate_none_local<SAMPLE_FMT, LOOPING>(rvoice, dsp_buf);
     }
 };
 
 struct InterpolateLinear
 {
-    template<bool IS_24BIT, bool LOOPING>
+    template<int SAMPLE_FMT, bool LOOPING>
     int operator()(fluid_rvoice_t *rvoice, fluid_real_t *FLUID_RESTRICT dsp_buf) const
     {
-        return fluid_rvoice_dsp_interpolate_linear_local<IS_24BIT, LOOPING>(rvoice, dsp_buf);
+        return fluid_rvoice_dsp_interpolate_linear_local<SAMPLE_FMT, LOOPING>(rvoice, dsp_buf);
     }
 };
 
 struct Interpolate4thOrder
 {
-    template<bool IS_24BIT, bool LOOPING>
+    template<int SAMPLE_FMT, bool LOOPING>
     int operator()(fluid_rvoice_t *rvoice, fluid_real_t *FLUID_RESTRICT dsp_buf) const
     {
-        return fluid_rvoice_dsp_interpolate_4th_order_local<IS_24BIT, LOOPING>(rvoice, dsp_buf);
+        return fluid_rvoice_dsp_interpolate_4th_order_local<SAMPLE_FMT, LOOPING>(rvoice, dsp_buf);
     }
 };
 
 struct Interpolate7thOrder
 {
-    template<bool IS_24BIT, bool LOOPING>
+    template<int SAMPLE_FMT, bool LOOPING>
     int operator()(fluid_rvoice_t *rvoice, fluid_real_t *FLUID_RESTRICT dsp_buf) const
     {
-        return fluid_rvoice_dsp_interpolate_7th_order_local<IS_24BIT, LOOPING>(rvoice, dsp_buf);
+        return fluid_rvoice_dsp_interpolate_7th_order_local<SAMPLE_FMT, LOOPING>(rvoice, dsp_buf);
     }
 };
 
-template<typename T>
-int dsp_invoker(fluid_rvoice_t *rvoice, fluid_real_t *FLUID_RESTRICT dsp_buf, int looping)
+template<typename T, int SAMPLE_FMT>
+static FLUID_INLINE int dsp_invoker_looping(fluid_rvoice_t *rvoice, fluid_real_t *FLUID_RESTRICT dsp_buf, int looping)
 {
     T func;
-    bool is_24bit = rvoice->dsp.sample->data24 != NULL;
 
-    if (is_24bit)
+    if (looping)
     {
-        if (looping)
-        {
-            return func.template operator()<true, true>(rvoice, dsp_buf);
-        }
-        else
-        {
-            return func.template operator()<true, false>(rvoice, dsp_buf);
-        }
+        return func.template operator()<SAMPLE_FMT, true>(rvoice, dsp_buf);
     }
     else
     {
-        // This case is most common, thanks to templating it will also become the fastest one
-        if (looping)
-        {
-            return func.template operator()<false, true>(rvoice, dsp_buf);
-        }
-        else
-        {
-            return func.template operator()<false, false>(rvoice, dsp_buf);
-        }
+        return func.template operator()<SAMPLE_FMT, false>(rvoice, dsp_buf);
+    }
+}
+
+template<typename T>
+int dsp_invoker(fluid_rvoice_t *rvoice, fluid_real_t *FLUID_RESTRICT dsp_buf, int looping)
+{
+    switch (fluid_rvoice_get_sample_fmt(rvoice->dsp.sample))
+    {
+        case FLUID_SAMPLE_FMT_FLOAT:
+            return dsp_invoker_looping<T, FLUID_SAMPLE_FMT_FLOAT>(rvoice, dsp_buf, looping);
+
+        case FLUID_SAMPLE_FMT_S24:
+            return dsp_invoker_looping<T, FLUID_SAMPLE_FMT_S24>(rvoice, dsp_buf, looping);
+
+        default:
+            // This case is most common, thanks to templating it will also become the fastest one
+            return dsp_invoker_looping<T, FLUID_SAMPLE_FMT_S16>(rvoice, dsp_buf, looping);
     }
 }
 
@@ -807,9 +823,174 @@ fluid_rvoice_dsp_silence(fluid_rvoice_t *rvoice, fluid_real_t *FLUID_RESTRICT ds
     return dsp_invoker<ProcessSilence>(rvoice, dsp_buf, looping);
 }
 
-extern "C" int
-fluid_rvoice_dsp_interpolate(fluid_rvoice_t *rvoice, fluid_real_t *FLUID_RESTRICT dsp_buf, int looping)
+/* Interpolation of looping voices from the unrolled loop buffer of a sample.
+ *
+ * The kernels above split every block into start, sequence, end and loop
+ * segments and check the loop end on every output sample, which is costly for
+ * short loops that wrap several times per block. If the sample comes with an
+ * unrolled loop buffer (see fluid_sample_build_loop_guard()), the points
+ * around the loop boundaries are materialized in memory and a single loop
+ * can interpolate the whole block. The loop wraparound is only checked once
+ * at the beginning and at the end of the block.
+ *
+ * The guard points hold the same values the kernels above substitute at the
+ * loop boundaries, so the output is bit-identical.
+ *
+ * Returns block_size, or 0 if the voice has to be rendered by the
+ * regular kernel, e.g. because its loop points are modulated or the block
+ * would reach beyond the unrolled loop.
+ */
+template<int INTERP_METHOD>
+static int
+fluid_rvoice_dsp_interpolate_loop_guard_local(fluid_rvoice_t *rvoice, fluid_real_t *FLUID_RESTRICT dsp_buf)
 {
+    fluid_rvoice_dsp_t *voice = &rvoice->dsp;
+    const int block_size = voice->block_size;
+    const fluid_sample_t *sample = voice->sample;
+    const float *FLUID_RESTRICT dsp_data = sample->loop_guard + FLUID_LOOP_GUARD_PAD;
+    /* number of points read before and after the current point */
+    const unsigned int points_before = INTERP_METHOD == FLUID_INTERP_7THORDER ? 3
+                                       : INTERP_METHOD == FLUID_INTERP_4THORDER ? 1 : 0;
+    const unsigned int points_after = INTERP_METHOD == FLUID_INTERP_7THORDER ? 3
+                                      : INTERP_METHOD == FLUID_INTERP_4THORDER ? 2
+                                      : INTERP_METHOD == FLUID_INTERP_LINEAR ? 1 : 0;
+    /* 7th order interpolation is centered on the 4th sample point, no
+     * interpolation rounds to the nearest point */
+    const fluid_phase_t phase_offset = (INTERP_METHOD == FLUID_INTERP_7THORDER
+                                        || INTERP_METHOD == FLUID_INTERP_NONE) ? 0x80000000 : 0;
+    fluid_phase_t dsp_phase, dsp_phase_incr, last_phase;
+    fluid_phase_t loop_phase, loop_len;
+    int has_looped = voice->has_looped;
+    int dsp_i;
+
+    /* the buffer has been unrolled for the loop points of the sample, and
+     * the block has to be filled from its first frame */
+    if(voice->loopstart != (int)sample->loopstart || voice->loopend != (int)sample->loopend
+            || voice->start > voice->loopstart || voice->start_offset != 0)
+    {
+        return 0;
+    }
+
+    fluid_phase_set_float(dsp_phase_incr, voice->phase_incr);
+    fluid_phase_set_int(loop_phase, voice->loopstart);
+    fluid_phase_set_int(loop_len, voice->loopend - voice->loopstart);
+
+    dsp_phase = voice->phase + phase_offset;
+
+    /* the guard points before the loop start are only valid once the voice
+     * has looped, until then the points before the loop must not be touched */
+    if(fluid_phase_index(dsp_phase) < voice->loopstart + (has_looped ? 0 : points_before))
+    {
+        return 0;
+    }
+
+    /* make the phase relative to the loop start and wrap it into the loop */
+    dsp_phase -= loop_phase;
+
+    if(dsp_phase >= loop_len)
+    {
+        dsp_phase %= loop_len;
+        has_looped = 1;
+    }
+
+    last_phase = dsp_phase + dsp_phase_incr * (block_size - 1);
+
+    if((uint64_t)fluid_phase_index(last_phase) + points_after >= sample->loop_guard_size + FLUID_LOOP_GUARD_PAD)
+    {
+        return 0;
+    }
+
+    for(dsp_i = 0; dsp_i < block_size; dsp_i++)
+    {
+        unsigned int dsp_phase_index = fluid_phase_index(dsp_phase);
+        const fluid_real_t *FLUID_RESTRICT coeffs;
+        fluid_real_t sample_value;
+
+        switch(INTERP_METHOD)
+        {
+        case FLUID_INTERP_NONE:
+            sample_value = dsp_data[dsp_phase_index];
+            break;
+
+        case FLUID_INTERP_LINEAR:
+            coeffs = &interp_coeff_linear[fluid_phase_fract_to_tablerow(dsp_phase) * LINEAR_INTERP_ORDER];
+            sample_value = (coeffs[0] * dsp_data[dsp_phase_index]
+                            + coeffs[1] * dsp_data[dsp_phase_index + 1]);
+            break;
+
+        case FLUID_INTERP_4THORDER:
+        default:
+            coeffs = &interp_coeff[fluid_phase_fract_to_tablerow(dsp_phase) * CUBIC_INTERP_ORDER];
+            sample_value = (coeffs[0] * dsp_data[(int)dsp_phase_index - 1]
+                            + coeffs[1] * dsp_data[dsp_phase_index]
+                            + coeffs[2] * dsp_data[dsp_phase_index + 1]
+                            + coeffs[3] * dsp_data[dsp_phase_index + 2]);
+            break;
+
+        case FLUID_INTERP_7THORDER:
+            coeffs = &sinc_table7[fluid_phase_fract_to_tablerow(dsp_phase) * SINC_INTERP_ORDER];
+            sample_value = (coeffs[0] * dsp_data[(int)dsp_phase_index - 3]
+                            + coeffs[1] * dsp_data[(int)dsp_phase_index - 2]
+                            + coeffs[2] * dsp_data[(int)dsp_phase_index - 1]
+                            + coeffs[3] * dsp_data[dsp_phase_index]
+                            + coeffs[4] * dsp_data[dsp_phase_index + 1]
+                            + coeffs[5] * dsp_data[dsp_phase_index + 2]
+                            + coeffs[6] * dsp_data[dsp_phase_index + 3]);
+            break;
+        }
+
+        dsp_buf[dsp_i] = sample_value;
+
+        /* increment phase */
+        fluid_phase_incr(dsp_phase, dsp_phase_incr);
+    }
+
+    /* go back into the loop */
+    if(dsp_phase >= loop_len)
+    {
+        dsp_phase %= loop_len;
+        has_looped = 1;
+    }
+
+    voice->phase = dsp_phase + loop_phase - phase_offset;
+    voice->has_looped = has_looped;
+
+    return block_size;
+}
+
+static int
+fluid_rvoice_dsp_interpolate_loop_guard(fluid_rvoice_t *rvoice, fluid_real_t *FLUID_RESTRICT dsp_buf)
+{
+    switch(rvoice->dsp.interp_method)
+    {
+    case FLUID_INTERP_NONE:
+        return fluid_rvoice_dsp_interpolate_loop_guard_local<FLUID_INTERP_NONE>(rvoice, dsp_buf);
+
+    case FLUID_INTERP_LINEAR:
+        return fluid_rvoice_dsp_interpolate_loop_guard_local<FLUID_INTERP_LINEAR>(rvoice, dsp_buf);
+
+    case FLUID_INTERP_4THORDER:
+    default:
+        return fluid_rvoice_dsp_interpolate_loop_guard_local<FLUID_INTERP_4THORDER>(rvoice, dsp_buf);
+
+    case FLUID_INTERP_7THORDER:
+        return fluid_rvoice_dsp_interpolate_loop_guard_local<FLUID_INTERP_7THORDER>(rvoice, dsp_buf);
+    }
+}
+
+static int
+fluid_rvoice_dsp_interpolate_generic(fluid_rvoice_t *rvoice, fluid_real_t *FLUID_RESTRICT dsp_buf, int looping)
+{
+    if(looping && rvoice->dsp.sample->loop_guard != NULL)
+    {
+        int count = fluid_rvoice_dsp_interpolate_loop_guard(rvoice, dsp_buf);
+
+        if(count > 0)
+        {
+            return count;
+        }
+    }
+
     switch (rvoice->dsp.interp_method)
     {
         case FLUID_INTERP_NONE:
@@ -825,4 +1006,295 @@ fluid_rvoice_dsp_interpolate(fluid_rvoice_t *rvoice, fluid_real_t *FLUID_RESTRIC
         case FLUID_INTERP_7THORDER:
             return dsp_invoker<Interpolate7thOrder>(rvoice, dsp_buf, looping);
     }
-}
\ No newline at end of file
+}
+#if FLUID_CPU_DISPATCH
+FLUID_TARGET_AVX2 static int
+fluid_rvoice_dsp_interpolate_avx2(fluid_rvoice_t *rvoice, fluid_real_t *FLUID_RESTRICT dsp_buf, int looping)
+{
+    return fluid_rvoice_dsp_interpolate_generic(rvoice, dsp_buf, looping);
+}
+
+FLUID_TARGET_AVX512 static int
+fluid_rvoice_dsp_interpolate_avx512(fluid_rvoice_t *rvoice, fluid_real_t *FLUID_RESTRICT dsp_buf, int looping)
+{
+    return fluid_rvoice_dsp_interpolate_generic(rvoice, dsp_buf, looping);
+}
+#endif
+
+extern "C" int
+fluid_rvoice_dsp_interpolate(fluid_rvoice_t *rvoice, fluid_real_t *FLUID_RESTRICT dsp_buf, int looping, int cpu_isa)
+{
+    switch(cpu_isa)
+    {
+#if FLUID_CPU_DISPATCH
+    case FLUID_CPU_ISA_AVX512:
+        return fluid_rvoice_dsp_interpolate_avx512(rvoice, dsp_buf, looping);
+
+    case FLUID_CPU_ISA_AVX2:
+        return fluid_rvoice_dsp_interpolate_avx2(rvoice, dsp_buf, looping);
+#endif
+
+    default:
+        return fluid_rvoice_dsp_interpolate_generic(rvoice, dsp_buf, looping);
+    }
+}
+
+/* Cross-voice batch interpolation.
+ *
+ * The kernels above render one voice at a time and spend most of their time
+ * in the "sequence of sample points" loop, which is free of any start, end or
+ * loop point handling. If a voice's next block lies completely within that
+ * region, it can be rendered together with other voices using the same
+ * interpolation method: the voice parameters are transposed into arrays and
+ * the innermost loop runs across voices rather than across samples, so that
+ * phase accumulation, table lookup and sample gathering are vectorized over
+ * the voices.
+ *
+ * The arithmetic is the very same as in the scalar kernels, i.e. a batched
+ * voice produces bit-identical output.
+ */
+
+/**
+ * Tells whether the next block of a voice can be rendered by
+ * fluid_rvoice_dsp_interpolate_batch().
+ *
+ * @param rvoice prepared rvoice, see fluid_rvoice_write()
+ * @param looping TRUE if the voice is currently looping
+ * @return TRUE if all samples of the block stay clear of the sample boundaries
+ */
+extern "C" int
+fluid_rvoice_dsp_can_batch(const fluid_rvoice_t *rvoice, int looping)
+{
+    const fluid_rvoice_dsp_t *voice = &rvoice->dsp;
+    const int block_size = voice->block_size;
+    fluid_phase_t first_phase = voice->phase;
+    fluid_phase_t last_phase;
+    fluid_phase_t dsp_phase_incr;
+    int64_t first_index, last_index, start_index, end_index;
+
+    /* the batch kernel always fills the whole block */
+    if(voice->start_offset != 0)
+    {
+        return FALSE;
+    }
+
+    fluid_phase_set_float(dsp_phase_incr, voice->phase_incr);
+
+    end_index = looping ? voice->loopend - 1 : voice->end;
+    start_index = voice->has_looped ? voice->loopstart : voice->start;
+
+    switch(voice->interp_method)
+    {
+    case FLUID_INTERP_NONE:
+        /* the scalar kernel checks for the loop end once more after the
+         * buffer has been filled, so include the phase of the next block */
+        last_phase = first_phase + dsp_phase_incr * block_size;
+        return (int64_t)fluid_phase_index_round(last_phase) <= end_index;
+
+    case FLUID_INTERP_LINEAR:
+        last_phase = first_phase + dsp_phase_incr * (block_size - 1);
+        return (int64_t)fluid_phase_index(last_phase) <= end_index - 1;
+
+    case FLUID_INTERP_4THORDER:
+    default:
+        last_phase = first_phase + dsp_phase_incr * (block_size - 1);
+        first_index = fluid_phase_index(first_phase);
+        last_index = fluid_phase_index(last_phase);
+        return first_index > start_index && last_index <= end_index - 2;
+
+    case FLUID_INTERP_7THORDER:
+        first_phase += (fluid_phase_t)0x80000000;
+        last_phase = first_phase + dsp_phase_incr * (block_size - 1);
+        first_index = fluid_phase_index(first_phase);
+        last_index = fluid_phase_index(last_phase);
+        return first_index > start_index + 2 && last_index <= end_index - 3;
+    }
+}
+
+template<int INTERP_METHOD, int SAMPLE_FMT>
+static void
+fluid_rvoice_dsp_interpolate_batch_local(fluid_rvoice_t *voices[], fluid_real_t *dsp_bufs[], int count)
+{
+    fluid_phase_t dsp_phase[FLUID_RVOICE_BATCH_LANES];
+    fluid_phase_t dsp_phase_incr[FLUID_RVOICE_BATCH_LANES];
+    const short int *dsp_data[FLUID_RVOICE_BATCH_LANES];
+    const char *dsp_data24[FLUID_RVOICE_BATCH_LANES];
+    const float *dsp_dataf[FLUID_RVOICE_BATCH_LANES];
+    /* all voices of a synth share the same block size */
+    const int block_size = voices[0]->dsp.block_size;
+    int dsp_i, lane;
+
+    for(lane = 0; lane < count; lane++)
+    {
+        fluid_rvoice_dsp_t *voice = &voices[lane]->dsp;
+
+        dsp_phase[lane] = voice->phase;
+        fluid_phase_set_float(dsp_phase_incr[lane], voice->phase_incr);
+        dsp_data[lane] = voice->sample->data;
+        dsp_data24[lane] = voice->sample->data24;
+        dsp_dataf[lane] = voice->sample->data_float;
+
+        if(INTERP_METHOD == FLUID_INTERP_7THORDER)
+        {
+            /* 7th order interpolation is centered on the 4th sample point */
+            fluid_phase_incr(dsp_phase[lane], (fluid_phase_t)0x80000000);
+        }
+    }
+
+    for(dsp_i = 0; dsp_i < block_size; dsp_i++)
+    {
+        #pragma omp simd
+        for(lane = 0; lane < count; lane++)
+        {
+            const short int *FLUID_RESTRICT data = dsp_data[lane];
+            const char *FLUID_RESTRICT data24 = dsp_data24[lane];
+            const float *FLUID_RESTRICT dataf = dsp_dataf[lane];
+            fluid_phase_t phase = dsp_phase[lane];
+            const fluid_real_t *FLUID_RESTRICT coeffs;
+            unsigned int index;
+            fluid_real_t sample;
+
+            switch(INTERP_METHOD)
+            {
+            case FLUID_INTERP_NONE:
+                index = fluid_phase_index_round(phase);
+                sample = fluid_rvoice_get_float_sample<SAMPLE_FMT>(data, data24, dataf, index);
+                break;
+
+            case FLUID_INTERP_LINEAR:
+                index = fluid_phase_index(phase);
+                coeffs = &interp_coeff_linear[fluid_phase_fract_to_tablerow(phase) * LINEAR_INTERP_ORDER];
+                sample = (coeffs[0] * fluid_rvoice_get_float_sample<SAMPLE_FMT>(data, data24, dataf, index)
+                          + coeffs[1] * fluid_rvoice_get_float_sample<SAMPLE_FMT>(data, data24, dataf, index + 1));
+                break;
+
+            case FLUID_INTERP_4THORDER:
+            default:
+                index = fluid_phase_index(phase);
+                coeffs = &interp_coeff[fluid_phase_fract_to_tablerow(phase) * CUBIC_INTERP_ORDER];
+                sample = (coeffs[0] * fluid_rvoice_get_float_sample<SAMPLE_FMT>(data, data24, dataf, index - 1)
+                          + coeffs[1] * fluid_rvoice_get_float_sample<SAMPLE_FMT>(data, data24, dataf, index)
+                          + coeffs[2] * fluid_rvoice_get_float_sample<SAMPLE_FMT>(data, data24, dataf, index + 1)
+                          + coeffs[3] * fluid_rvoice_get_float_sample<SAMPLE_FMT>(data, data24, dataf, index + 2));
+                break;
+
+            case FLUID_INTERP_7THORDER:
+                index = fluid_phase_index(phase);
+                coeffs = &sinc_table7[fluid_phase_fract_to_tablerow(phase) * SINC_INTERP_ORDER];
+                sample = (coeffs[0] * fluid_rvoice_get_float_sample<SAMPLE_FMT>(data, data24, dataf, index - 3)
+                          + coeffs[1] * fluid_rvoice_get_float_sample<SAMPLE_FMT>(data, data24, dataf, index - 2)
+                          + coeffs[2] * fluid_rvoice_get_float_sample<SAMPLE_FMT>(data, data24, dataf, index - 1)
+                          + coeffs[3] * fluid_rvoice_get_float_sample<SAMPLE_FMT>(data, data24, dataf, index)
+                          + coeffs[4] * fluid_rvoice_get_float_sample<SAMPLE_FMT>(data, data24, dataf, index + 1)
+                          + coeffs[5] * fluid_rvoice_get_float_sample<SAMPLE_FMT>(data, data24, dataf, index + 2)
+                          + coeffs[6] * fluid_rvoice_get_float_sample<SAMPLE_FMT>(data, data24, dataf, index + 3));
+                break;
+            }
+
+            dsp_bufs[lane][dsp_i] = sample;
+
+            /* increment phase */
+            fluid_phase_incr(dsp_phase[lane], dsp_phase_incr[lane]);
+        }
+    }
+
+    for(lane = 0; lane < count; lane++)
+    {
+        if(INTERP_METHOD == FLUID_INTERP_7THORDER)
+        {
+            fluid_phase_decr(dsp_phase[lane], (fluid_phase_t)0x80000000);
+        }
+
+        voices[lane]->dsp.phase = dsp_phase[lane];
+    }
+}
+
+template<int INTERP_METHOD>
+static void
+fluid_rvoice_dsp_interpolate_batch_invoker(fluid_rvoice_t *voices[], fluid_real_t *dsp_bufs[], int count)
+{
+    switch(fluid_rvoice_get_sample_fmt(voices[0]->dsp.sample))
+    {
+    case FLUID_SAMPLE_FMT_FLOAT:
+        fluid_rvoice_dsp_interpolate_batch_local<INTERP_METHOD, FLUID_SAMPLE_FMT_FLOAT>(voices, dsp_bufs, count);
+        break;
+
+    case FLUID_SAMPLE_FMT_S24:
+        fluid_rvoice_dsp_interpolate_batch_local<INTERP_METHOD, FLUID_SAMPLE_FMT_S24>(voices, dsp_bufs, count);
+        break;
+
+    default:
+        fluid_rvoice_dsp_interpolate_batch_local<INTERP_METHOD, FLUID_SAMPLE_FMT_S16>(voices, dsp_bufs, count);
+        break;
+    }
+}
+
+static void
+fluid_rvoice_dsp_interpolate_batch_generic(fluid_rvoice_t *voices[], fluid_real_t *dsp_bufs[], int count)
+{
+    switch(voices[0]->dsp.interp_method)
+    {
+    case FLUID_INTERP_NONE:
+        fluid_rvoice_dsp_interpolate_batch_invoker<FLUID_INTERP_NONE>(voices, dsp_bufs, count);
+        break;
+
+    case FLUID_INTERP_LINEAR:
+        fluid_rvoice_dsp_interpolate_batch_invoker<FLUID_INTERP_LINEAR>(voices, dsp_bufs, count);
+        break;
+
+    case FLUID_INTERP_4THORDER:
+    default:
+        fluid_rvoice_dsp_interpolate_batch_invoker<FLUID_INTERP_4THORDER>(voices, dsp_bufs, count);
+        break;
+
+    case FLUID_INTERP_7THORDER:
+        fluid_rvoice_dsp_interpolate_batch_invoker<FLUID_INTERP_7THORDER>(voices, dsp_bufs, count);
+        break;
+    }
+}
+
+#if FLUID_CPU_DISPATCH
+FLUID_TARGET_AVX2 static void
+fluid_rvoice_dsp_interpolate_batch_avx2(fluid_rvoice_t *voices[], fluid_real_t *dsp_bufs[], int count)
+{
+    fluid_rvoice_dsp_interpolate_batch_generic(voices, dsp_bufs, count);
+}
+
+FLUID_TARGET_AVX512 static void
+fluid_rvoice_dsp_interpolate_batch_avx512(fluid_rvoice_t *voices[], fluid_real_t *dsp_bufs[], int count)
+{
+    fluid_rvoice_dsp_interpolate_batch_generic(voices, dsp_bufs, count);
+}
+#endif
+
+/**
+ * Interpolate one full block of several voices at once.
+ *
+ * All voices must use the same interpolation method and sample format, and
+ * fluid_rvoice_dsp_can_batch() must have returned TRUE for each of them.
+ *
+ * @param voices Array of rvoices to render
+ * @param dsp_bufs Array of output buffers (one block in length each), one per voice
+ * @param count Number of voices, must not exceed #FLUID_RVOICE_BATCH_LANES
+ * @param cpu_isa Instruction set level of the kernel to use, see #fluid_cpu_isa
+ */
+extern "C" void
+fluid_rvoice_dsp_interpolate_batch(fluid_rvoice_t *voices[], fluid_real_t *dsp_bufs[], int count, int cpu_isa)
+{
+    switch(cpu_isa)
+    {
+#if FLUID_CPU_DISPATCH
+    case FLUID_CPU_ISA_AVX512:
+        fluid_rvoice_dsp_interpolate_batch_avx512(voices, dsp_bufs, count);
+        break;
+
+    case FLUID_CPU_ISA_AVX2:
+        fluid_rvoice_dsp_interpolate_batch_avx2(voices, dsp_bufs, count);
+        break;
+#endif
+
+    default:
+        fluid_rvoice_dsp_interpolate_batch_generic(voices, dsp_bufs, count);
+        break;
+    }
+}
@@ -22,6 +22,8 @@
 #include "fluid_sys.h"
 #include "fluid_rev.h"
 #include "fluid_chorus.h"
+#include "fluid_convrev.h"
+#include "fluid_insertfx.h"
 #include "fluid_ladspa.h"
 #include "fluid_synth.h"
 
@@ -30,6 +32,10 @@
 // so don't activate the thread(s).
 #define VOICES_PER_THREAD 8
 
+// Ditto, in terms of fluid_rvoice_get_cost(). An audible, filtered voice
+// with linear or 4th order interpolation costs about 12.
+#define COST_PER_THREAD (VOICES_PER_THREAD * 12)
+
 typedef struct _fluid_mixer_buffers_t fluid_mixer_buffers_t;
 
 struct _fluid_mixer_buffers_t
@@ -38,8 +44,16 @@ struct _fluid_mixer_buffers_t
 #if ENABLE_MIXER_THREADS
     fluid_thread_t *thread;     /**< Thread object */
     fluid_atomic_int_t ready;   /**< Atomic: buffers are ready for mixing */
+    fluid_atomic_int_t chunks;  /**< Atomic: deque of the voice chunks left to render, see fluid_mixer_chunks_pack() */
 #endif
 
+    /** One flag per buffer returned by fluid_mixer_buffers_prepare(), followed by one
+     * per right effects buffer: TRUE if anything has been written to it since it was
+     * last zeroed. Buffers that are not dirty are all zero, so they can be skipped
+     * when zeroing, mixing, processing effects and copying out. */
+    char *dirty;
+    int dirty_blockcount;       /**< Number of blocks the dirty buffers have been rendered for */
+
     fluid_rvoice_t **finished_voices; /* List of voices who have finished */
     int finished_voice_count;
 
@@ -71,6 +85,13 @@ struct _fluid_mixer_buffers_t
     fluid_real_t *fx_right_buf;
 };
 
+/* A batch of consecutive voices in fluid_rvoice_mixer_t::mt_rvoices */
+typedef struct
+{
+    int first;
+    int count;
+} fluid_mixer_chunk_t;
+
 typedef struct _fluid_mixer_fx_t fluid_mixer_fx_t;
 
 struct _fluid_mixer_fx_t
@@ -79,16 +100,43 @@ struct _fluid_mixer_fx_t
     /* reverb shadow parameters here will be returned if queried */
     double reverb_param[FLUID_REVERB_PARAM_LAST];
     int reverb_on; /* reverb on/off */
+    fluid_convrev_t *convrev; /**< Convolution reverb, replaces the reverb unit if not NULL */
 
     fluid_chorus_t *chorus; /**< Chorus unit */
     /* chorus shadow parameters here will be returned if queried */
     double chorus_param[FLUID_CHORUS_PARAM_LAST];
     int chorus_on; /* chorus on/off */
+
+    /* TRUE once the unit has been fed some input since it was last reset.
+     * Until then its state is silent and processing it can be skipped. */
+    int reverb_fed;
+    int chorus_fed;
+
+    /* Samples of silent input after which the tail of the unit is checked
+     * again, see fluid_mixer_fx_tail_due(). */
+    int reverb_countdown;
+    int chorus_countdown;
+
+    /* Insert effects of the reverb and chorus outputs, indexed by
+     * SYNTH_REVERB_CHANNEL and SYNTH_CHORUS_CHANNEL. Both get the same parameters. */
+    fluid_insertfx_t *insert[2];
+    /* insert effects shadow parameters here will be returned if queried */
+    double insert_param[FLUID_INSERT_FX_PARAM_LAST];
+};
+
+typedef struct _fluid_mixer_out_t fluid_mixer_out_t;
+
+struct _fluid_mixer_out_t
+{
+    fluid_insertfx_t *insert; /**< Insert effects of the stereo output of an audio group */
+    /* insert effects shadow parameters here will be returned if queried */
+    double insert_param[FLUID_INSERT_FX_PARAM_LAST];
 };
 
 struct _fluid_rvoice_mixer_t
 {
     fluid_mixer_fx_t *fx;
+    fluid_mixer_out_t *out; /**< One per dry buffer, buffers.buf_count in length */
 
     fluid_mixer_buffers_t buffers; /**< Used by mixer only: own buffers */
     fluid_rvoice_eventhandler_t *eventhandler;
@@ -97,25 +145,33 @@ struct _fluid_rvoice_mixer_t
     int polyphony; /**< Read-only: Length of voices array */
     int active_voices; /**< Read-only: Number of non-null voices */
     int current_blockcount;      /**< Read-only: how many blocks to process this time */
+    int block_size;              /**< Read-only: samples per block, a power of two between #FLUID_BUFSIZE_MIN and #FLUID_BUFSIZE_MAX */
     int fx_units;
     int with_reverb;        /**< Should the synth use the built-in reverb unit? */
     int with_chorus;        /**< Should the synth use the built-in chorus unit? */
     int mix_fx_to_out;      /**< Should the effects be mixed in with the primary output? */
+    int cpu_isa;            /**< Instruction set level of the dsp kernels, see #fluid_cpu_isa */
 
 #ifdef LADSPA
     fluid_ladspa_fx_t *ladspa_fx; /**< Used by mixer only: Effects unit for LADSPA support. Never created or freed */
 #endif
 
 #if ENABLE_MIXER_THREADS
-//  int sleeping_threads;        /**< Atomic: number of threads currently asleep */
-//  int active_threads;          /**< Atomic: number of threads in the thread loop */
+    fluid_atomic_int_t sleeping_threads;         /**< Atomic: number of threads parked on wakeup_threads */
+    fluid_atomic_int_t main_waiting;             /**< Atomic: TRUE while the render thread is parked on thread_ready */
+    fluid_atomic_int_t pending_thread;           /**< Atomic: thread whose buffers wait to be merged, -1 if none */
     fluid_atomic_int_t threads_should_terminate; /**< Atomic: Set to TRUE when threads should terminate */
-    fluid_atomic_int_t current_rvoice;           /**< Atomic: for the threads to know next voice to  */
     fluid_cond_t *wakeup_threads; /**< Signalled when the threads should wake up */
     fluid_cond_mutex_t *wakeup_threads_m; /**< wakeup_threads mutex companion */
     fluid_cond_t *thread_ready; /**< Signalled from thread, when the thread has a buffer ready for mixing */
     fluid_cond_mutex_t *thread_ready_m; /**< thread_ready mutex companion */
 
+    int participants;            /**< Read-only: number of chunk deques in use for the current blocks, the mixer's own included */
+    fluid_rvoice_t **mt_rvoices; /**< Read-only: voices grouped by thread for the current blocks (polyphony in length) */
+    fluid_mixer_chunk_t *mt_chunks; /**< Read-only: batches of mt_rvoices the chunk deques refer to (polyphony in length) */
+    int *mt_costs;               /**< Used by mixer only: cost of each voice, see fluid_rvoice_get_cost() (polyphony in length) */
+    int *mt_order;               /**< Used by mixer only: voice indices by descending cost (polyphony in length) */
+    int *mt_owner;               /**< Used by mixer only: deque each voice has been assigned to (polyphony in length) */
     int thread_count;            /**< Number of extra mixer threads for multi-core rendering */
     fluid_mixer_buffers_t *threads;    /**< Array of mixer threads (thread_count in length) */
 #endif
@@ -124,8 +180,112 @@ struct _fluid_rvoice_mixer_t
 #if ENABLE_MIXER_THREADS
 static void delete_rvoice_mixer_threads(fluid_rvoice_mixer_t *mixer);
 static int fluid_rvoice_mixer_set_threads(fluid_rvoice_mixer_t *mixer, int thread_count, int prio_level);
+static void fluid_mixer_buffers_mix(fluid_mixer_buffers_t *dst, fluid_mixer_buffers_t *src, int current_blockcount);
 #endif
 
+/* Tells whether count samples of an effects input are silent. */
+static int
+fluid_mixer_fx_input_is_silent(const fluid_real_t *in, int count)
+{
+    fluid_real_t peak = 0;
+    int i;
+
+    #pragma omp simd reduction(max:peak)
+    for(i = 0; i < count; i++)
+    {
+        fluid_real_t v = FLUID_FABS(in[i]);
+        peak = (v > peak) ? v : peak;
+    }
+
+    return peak < FLUID_MIXER_FX_SILENCE;
+}
+
+/* Tracks the input of an effects unit before it processes the next count
+ * samples of it, returns TRUE if the tail of the unit has to be checked first.
+ *
+ * While the input of a unit is silent, its output is only made of the tail of
+ * the input it got before. The level of that tail is checked once the input
+ * stops, then again whenever the tail should have decayed below
+ * FLUID_MIXER_FX_SILENCE according to the model of the unit. Once the tail is
+ * below that level, the caller resets the unit and clears its fed flag, so
+ * that it is skipped until its input returns. */
+static int
+fluid_mixer_fx_tail_due(int *fed, int *countdown, int dirty, const fluid_real_t *in, int count)
+{
+    if(dirty && !fluid_mixer_fx_input_is_silent(in, count))
+    {
+        *fed = TRUE;
+        *countdown = 0;
+        return FALSE;
+    }
+
+    if(!*fed)
+    {
+        return FALSE;
+    }
+
+    if(*countdown > 0)
+    {
+        *countdown -= count;
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+/* Runs the insert effects of one effects channel of an fx group on the output of
+ * its unit, fed telling whether the unit has just been processed. In mix mode,
+ * the unit has rendered to the effects buffers instead of the dry buffer, so
+ * the result is mixed to the dry buffer here. */
+static void
+fluid_mixer_fx_insert(fluid_rvoice_mixer_t *mixer, int f, int chan, int fed, int count)
+{
+    fluid_insertfx_t *insert = mixer->fx[f].insert[chan];
+    int fx_channels_per_unit = mixer->buffers.fx_buf_count / mixer->fx_units;
+    int buf_idx = f * fx_channels_per_unit + chan;
+    int samp_idx = buf_idx * FLUID_MIXER_MAX_BUFFERS_DEFAULT * FLUID_BUFSIZE;
+    fluid_real_t *fx_l = fluid_align_ptr(mixer->buffers.fx_left_buf, FLUID_DEFAULT_ALIGNMENT);
+    fluid_real_t *fx_r = fluid_align_ptr(mixer->buffers.fx_right_buf, FLUID_DEFAULT_ALIGNMENT);
+    char *dirty = mixer->buffers.dirty;
+    int in_idx = mixer->buffers.buf_count * 2 + buf_idx;
+    int i;
+
+    if(!fluid_insertfx_is_active(insert) || (!fed && fluid_insertfx_is_idle(insert)))
+    {
+        return;
+    }
+
+    if(!fed)
+    {
+        /* the unit is silent, only the tail of the insert effects is left */
+        FLUID_MEMSET(&fx_l[samp_idx], 0, count * sizeof(fluid_real_t));
+        FLUID_MEMSET(&fx_r[samp_idx], 0, count * sizeof(fluid_real_t));
+    }
+
+    fluid_insertfx_process(insert, &fx_l[samp_idx], &fx_r[samp_idx], count);
+    dirty[in_idx] = dirty[in_idx + mixer->buffers.fx_buf_count] = TRUE;
+
+    if(mixer->mix_fx_to_out)
+    {
+        int dry_idx = (f % mixer->buffers.buf_count) * FLUID_MIXER_MAX_BUFFERS_DEFAULT * FLUID_BUFSIZE;
+        fluid_real_t *dry_l = fluid_align_ptr(mixer->buffers.left_buf, FLUID_DEFAULT_ALIGNMENT);
+        fluid_real_t *dry_r = fluid_align_ptr(mixer->buffers.right_buf, FLUID_DEFAULT_ALIGNMENT);
+        fluid_real_t *l = &fx_l[samp_idx], *r = &fx_r[samp_idx];
+
+        dry_l += dry_idx;
+        dry_r += dry_idx;
+
+        #pragma omp simd
+        for(i = 0; i < count; i++)
+        {
+            dry_l[i] += l[i];
+            dry_r[i] += r[i];
+        }
+
+        dirty[(f % mixer->buffers.buf_count) * 2] = dirty[(f % mixer->buffers.buf_count) * 2 + 1] = TRUE;
+    }
+}
+
 static FLUID_INLINE void
 fluid_rvoice_mixer_process_fx(fluid_rvoice_mixer_t *mixer, int current_blockcount)
 {
@@ -135,10 +295,11 @@ fluid_rvoice_mixer_process_fx(fluid_rvoice_mixer_t *mixer, int current_blockcoun
     /*const*/ int dry_count = mixer->buffers.buf_count; /* dry buffers count */
     /*const*/ int mix_fx_to_out = mixer->mix_fx_to_out; /* get mix_fx_to_out mode */
     
-    void (*reverb_process_func)(fluid_revmodel_t *rev, const fluid_real_t *in, fluid_real_t *left_out, fluid_real_t *right_out);
-    void (*chorus_process_func)(fluid_chorus_t *chorus, const fluid_real_t *in, fluid_real_t *left_out, fluid_real_t *right_out);
-
     fluid_real_t *out_rev_l, *out_rev_r, *out_ch_l, *out_ch_r;
+    fluid_real_t *dry_l = fluid_align_ptr(mixer->buffers.left_buf, FLUID_DEFAULT_ALIGNMENT);
+    fluid_real_t *dry_r = fluid_align_ptr(mixer->buffers.right_buf, FLUID_DEFAULT_ALIGNMENT);
+    fluid_real_t *fx_l = fluid_align_ptr(mixer->buffers.fx_left_buf, FLUID_DEFAULT_ALIGNMENT);
+    fluid_real_t *fx_r = fluid_align_ptr(mixer->buffers.fx_right_buf, FLUID_DEFAULT_ALIGNMENT);
 
     // all dry unprocessed mono input is stored in the left channel
     fluid_real_t *in_rev = fluid_align_ptr(mixer->buffers.fx_left_buf, FLUID_DEFAULT_ALIGNMENT);
@@ -152,29 +313,126 @@ fluid_rvoice_mixer_process_fx(fluid_rvoice_mixer_t *mixer, int current_blockcoun
      * set up in fluid_rvoice_mixer_set_ladspa. */
     if(mixer->ladspa_fx)
     {
-        fluid_ladspa_run(mixer->ladspa_fx, current_blockcount, FLUID_BUFSIZE);
+        fluid_ladspa_run(mixer->ladspa_fx, current_blockcount, mixer->block_size);
         fluid_check_fpe("LADSPA");
+
+        /* the effects may have written to any of the buffers */
+        FLUID_MEMSET(mixer->buffers.dirty, TRUE, (dry_count + mixer->buffers.fx_buf_count) * 2);
     }
 
 #endif
 
+    /* Tell the units which have to be processed, and mark their output buffers
+     * dirty. A unit that neither got any input so far nor gets some now would
+     * only output silence, so it is skipped. So is a unit whose input has been
+     * silent long enough for its tail to decay below FLUID_MIXER_FX_SILENCE. */
+    if(mixer->with_reverb || mixer->with_chorus)
+    {
+        int f;
+        int sample_count = current_blockcount * mixer->block_size;
+        char *dirty = mixer->buffers.dirty;
+
+        for(f = 0; f < mixer->fx_units; f++)
+        {
+            fluid_mixer_fx_t *fx = &mixer->fx[f];
+            int in_idx = dry_count * 2 + f * fx_channels_per_unit;
+            int out_idx = in_idx + mixer->buffers.fx_buf_count;
+
+            int rev_samp = (f * fx_channels_per_unit + SYNTH_REVERB_CHANNEL) * FLUID_MIXER_MAX_BUFFERS_DEFAULT * FLUID_BUFSIZE;
+            int ch_samp = (f * fx_channels_per_unit + SYNTH_CHORUS_CHANNEL) * FLUID_MIXER_MAX_BUFFERS_DEFAULT * FLUID_BUFSIZE;
+
+            if(mixer->with_reverb && fx->reverb_on
+                    && fluid_mixer_fx_tail_due(&fx->reverb_fed, &fx->reverb_countdown,
+                                               dirty[in_idx + SYNTH_REVERB_CHANNEL],
+                                               &in_rev[rev_samp],
+                                               sample_count))
+            {
+                if(fx->convrev != NULL)
+                {
+                    if(fluid_convrev_get_tail_level(fx->convrev) < FLUID_MIXER_FX_SILENCE)
+                    {
+                        fluid_convrev_reset(fx->convrev);
+                        fx->reverb_fed = FALSE;
+                    }
+                    else
+                    {
+                        fx->reverb_countdown = fluid_convrev_get_tail_length(fx->convrev);
+                    }
+                }
+                else
+                {
+                    fluid_real_t level = fluid_revmodel_get_tail_level(fx->reverb);
+
+                    if(level < FLUID_MIXER_FX_SILENCE)
+                    {
+                        fluid_revmodel_reset(fx->reverb);
+                        fx->reverb_fed = FALSE;
+                    }
+                    else
+                    {
+                        fx->reverb_countdown = fluid_revmodel_get_tail_length(fx->reverb, level / FLUID_MIXER_FX_SILENCE);
+                    }
+                }
+            }
+
+            if(mixer->with_chorus && fx->chorus_on
+                    && fluid_mixer_fx_tail_due(&fx->chorus_fed, &fx->chorus_countdown,
+                                               dirty[in_idx + SYNTH_CHORUS_CHANNEL],
+                                               &in_ch[ch_samp],
+                                               sample_count))
+            {
+                if(fluid_chorus_get_tail_level(fx->chorus) < FLUID_MIXER_FX_SILENCE)
+                {
+                    fluid_chorus_reset(fx->chorus);
+                    fx->chorus_fed = FALSE;
+                }
+                else
+                {
+                    fx->chorus_countdown = fluid_chorus_get_tail_length(fx->chorus);
+                }
+            }
+
+            /* with insert effects, the units render to their own buffers even
+             * in mix mode, see fluid_mixer_fx_insert() */
+            if(mixer->with_reverb && fx->reverb_on && fx->reverb_fed)
+            {
+                if(mix_fx_to_out)
+                {
+                    dirty[(f % dry_count) * 2] = dirty[(f % dry_count) * 2 + 1] = TRUE;
+                }
+
+                if(!mix_fx_to_out || fluid_insertfx_is_active(fx->insert[SYNTH_REVERB_CHANNEL]))
+                {
+                    dirty[in_idx + SYNTH_REVERB_CHANNEL] = dirty[out_idx + SYNTH_REVERB_CHANNEL] = TRUE;
+                }
+            }
+
+            if(mixer->with_chorus && fx->chorus_on && fx->chorus_fed)
+            {
+                if(mix_fx_to_out)
+                {
+                    dirty[(f % dry_count) * 2] = dirty[(f % dry_count) * 2 + 1] = TRUE;
+                }
+
+                if(!mix_fx_to_out || fluid_insertfx_is_active(fx->insert[SYNTH_CHORUS_CHANNEL]))
+                {
+                    dirty[in_idx + SYNTH_CHORUS_CHANNEL] = dirty[out_idx + SYNTH_CHORUS_CHANNEL] = TRUE;
+                }
+            }
+        }
+    }
+
     if(mix_fx_to_out)
     {
         // mix effects to first stereo channel
-        out_ch_l = out_rev_l = fluid_align_ptr(mixer->buffers.left_buf, FLUID_DEFAULT_ALIGNMENT);
-        out_ch_r = out_rev_r = fluid_align_ptr(mixer->buffers.right_buf, FLUID_DEFAULT_ALIGNMENT);
-
-        reverb_process_func = fluid_revmodel_processmix;
-        chorus_process_func = fluid_chorus_processmix;
+        out_ch_l = out_rev_l = dry_l;
+        out_ch_r = out_rev_r = dry_r;
     }
     else
     {
         // replace effects into respective stereo effects channel
-        out_ch_l = out_rev_l = fluid_align_ptr(mixer->buffers.fx_left_buf, FLUID_DEFAULT_ALIGNMENT);
-        out_ch_r = out_rev_r = fluid_align_ptr(mixer->buffers.fx_right_buf, FLUID_DEFAULT_ALIGNMENT);
-
-        reverb_process_func = fluid_revmodel_processreplace;
-        chorus_process_func = fluid_chorus_processreplace;
+        out_ch_l = out_rev_l = fx_l;
+        out_ch_r = out_rev_r = fx_r;
     }
 
     if(mixer->with_reverb || mixer->with_chorus)
@@ -182,14 +440,15 @@ fluid_rvoice_mixer_process_fx(fluid_rvoice_mixer_t *mixer, int current_blockcoun
 #if ENABLE_MIXER_THREADS && !defined(WITH_PROFILING)
         int fx_mixer_threads = mixer->fx_units;
         fluid_clip(fx_mixer_threads, 1, mixer->thread_count + 1);
-        #pragma omp parallel default(none) shared(mixer, reverb_process_func, chorus_process_func, dry_count, current_blockcount, mix_fx_to_out, fx_channels_per_unit) firstprivate(in_rev, in_ch, out_rev_l, out_rev_r, out_ch_l, out_ch_r) num_threads(fx_mixer_threads)
+        #pragma omp parallel default(none) shared(mixer, dry_count, current_blockcount, mix_fx_to_out, fx_channels_per_unit) firstprivate(in_rev, in_ch, out_rev_l, out_rev_r, out_ch_l, out_ch_r, fx_l, fx_r) num_threads(fx_mixer_threads)
 #endif
         {
-            int i, f;
+            int f;
             int buf_idx;  /* buffer index */
             int samp_idx; /* sample index in buffer */
             int dry_idx = 0; /* dry buffer index */
             int sample_count; /* sample count to process */
+            int to_dry; /* TRUE if the unit mixes its output to a dry buffer */
             if(mixer->with_reverb)
             {
 #if ENABLE_MIXER_THREADS && !defined(WITH_PROFILING)
@@ -197,33 +456,49 @@ fluid_rvoice_mixer_process_fx(fluid_rvoice_mixer_t *mixer, int current_blockcoun
 #endif
                 for(f = 0; f < mixer->fx_units; f++)
                 {
-                    if(!mixer->fx[f].reverb_on)
+                    if(!mixer->fx[f].reverb_on || !mixer->fx[f].reverb_fed)
                     {
-                        continue; /* this reverb unit is disabled */
+                        continue; /* this reverb unit is disabled or silent */
                     }
 
                     buf_idx = f * fx_channels_per_unit + SYNTH_REVERB_CHANNEL;
                     samp_idx = buf_idx * FLUID_MIXER_MAX_BUFFERS_DEFAULT * FLUID_BUFSIZE;
-                    sample_count = current_blockcount * FLUID_BUFSIZE;
+                    sample_count = current_blockcount * mixer->block_size;
 
-                    /* in mix mode, map fx out_rev at index f to a dry buffer at index dry_idx */
-                    if(mix_fx_to_out)
+                    /* in mix mode, map fx out_rev at index f to a dry buffer at index dry_idx,
+                       unless the output goes through the insert effects first */
+                    to_dry = mix_fx_to_out && !fluid_insertfx_is_active(mixer->fx[f].insert[SYNTH_REVERB_CHANNEL]);
+
+                    if(to_dry)
                     {
                         /* dry buffer mapping, should be done more flexible in the future */
                         dry_idx = (f % dry_count) * FLUID_MIXER_MAX_BUFFERS_DEFAULT * FLUID_BUFSIZE;
-                    }
 
-                    for(i = 0; i < sample_count; i += FLUID_BUFSIZE, samp_idx += FLUID_BUFSIZE)
+                        if(mixer->fx[f].convrev != NULL)
+                        {
+                            fluid_convrev_processmix(mixer->fx[f].convrev, &in_rev[samp_idx],
+                                                     &out_rev_l[dry_idx], &out_rev_r[dry_idx], sample_count);
+                        }
+                        else
+                        {
+                            fluid_revmodel_processmix(mixer->fx[f].reverb, &in_rev[samp_idx],
+                                                      &out_rev_l[dry_idx], &out_rev_r[dry_idx], sample_count);
+                        }
+                    }
+                    else if(mixer->fx[f].convrev != NULL)
+                    {
+                        fluid_convrev_processreplace(mixer->fx[f].convrev, &in_rev[samp_idx],
+                                                     &fx_l[samp_idx], &fx_r[samp_idx], sample_count);
+                    }
+                    else
                     {
-                        reverb_process_func(mixer->fx[f].reverb,
-                                            &in_rev[samp_idx],
-                                            mix_fx_to_out ? &out_rev_l[dry_idx + i] : &out_rev_l[samp_idx],
-                                            mix_fx_to_out ? &out_rev_r[dry_idx + i] : &out_rev_r[samp_idx]);
+                        fluid_revmodel_processreplace(mixer->fx[f].reverb, &in_rev[samp_idx],
+                                                      &fx_l[samp_idx], &fx_r[samp_idx], sample_count);
                     }
                 } // implicit omp barrier - required, because out_rev_l aliases with out_ch_l
 
                 fluid_profile(FLUID_PROF_ONE_BLOCK_REVERB, prof_ref, 0,
-                            current_blockcount * FLUID_BUFSIZE);
+                            current_blockcount * mixer->block_size);
             }
 
             if(mixer->with_chorus)
@@ -233,34 +508,77 @@ fluid_rvoice_mixer_process_fx(fluid_rvoice_mixer_t *mixer, int current_blockcoun
 #endif
                 for(f = 0; f < mixer->fx_units; f++)
                 {
-                    if(!mixer->fx[f].chorus_on)
+                    if(!mixer->fx[f].chorus_on || !mixer->fx[f].chorus_fed)
                     {
-                        continue; /* this chorus unit is disabled */
+                        continue; /* this chorus unit is disabled or silent */
                     }
 
                     buf_idx = f * fx_channels_per_unit + SYNTH_CHORUS_CHANNEL;
                     samp_idx = buf_idx * FLUID_MIXER_MAX_BUFFERS_DEFAULT * FLUID_BUFSIZE;
-                    sample_count = current_blockcount * FLUID_BUFSIZE;
+                    sample_count = current_blockcount * mixer->block_size;
+
+                    /* in mix mode, map fx out_ch at index f to a dry buffer at index dry_idx,
+                       unless the output goes through the insert effects first */
+                    to_dry = mix_fx_to_out && !fluid_insertfx_is_active(mixer->fx[f].insert[SYNTH_CHORUS_CHANNEL]);
 
-                    /* in mix mode, map fx out_ch at index f to a dry buffer at index dry_idx */
-                    if(mix_fx_to_out)
+                    if(to_dry)
                     {
                         /* dry buffer mapping, should be done more flexible in the future */
                         dry_idx = (f % dry_count) * FLUID_MIXER_MAX_BUFFERS_DEFAULT * FLUID_BUFSIZE;
-                    }
 
-                    for(i = 0; i < sample_count; i += FLUID_BUFSIZE, samp_idx += FLUID_BUFSIZE)
+                        fluid_chorus_processmix(mixer->fx[f].chorus, &in_ch[samp_idx],
+                                                &out_ch_l[dry_idx], &out_ch_r[dry_idx], sample_count);
+                    }
+                    else
                     {
-                        chorus_process_func(mixer->fx[f].chorus,
-                                            &in_ch [samp_idx],
-                                            mix_fx_to_out ? &out_ch_l[dry_idx + i] : &out_ch_l[samp_idx],
-                                            mix_fx_to_out ? &out_ch_r[dry_idx + i] : &out_ch_r[samp_idx]);
+                        fluid_chorus_processreplace(mixer->fx[f].chorus, &in_ch[samp_idx],
+                                                    &fx_l[samp_idx], &fx_r[samp_idx], sample_count);
                     }
                 }
 
                 fluid_profile(FLUID_PROF_ONE_BLOCK_CHORUS, prof_ref, 0,
-                            current_blockcount * FLUID_BUFSIZE);
+                            current_blockcount * mixer->block_size);
+            }
+        }
+    }
+
+    /* insert effects, of the fx groups first as they may mix to the dry buffers */
+    {
+        int f, i;
+        int sample_count = current_blockcount * mixer->block_size;
+        char *dirty = mixer->buffers.dirty;
+
+        if(mixer->with_reverb || mixer->with_chorus)
+        {
+            for(f = 0; f < mixer->fx_units; f++)
+            {
+                fluid_mixer_fx_t *fx = &mixer->fx[f];
+
+                if(mixer->with_reverb && fx->reverb_on)
+                {
+                    fluid_mixer_fx_insert(mixer, f, SYNTH_REVERB_CHANNEL, fx->reverb_fed, sample_count);
+                }
+
+                if(mixer->with_chorus && fx->chorus_on)
+                {
+                    fluid_mixer_fx_insert(mixer, f, SYNTH_CHORUS_CHANNEL, fx->chorus_fed, sample_count);
+                }
+            }
+        }
+
+        for(i = 0; i < dry_count; i++)
+        {
+            fluid_insertfx_t *insert = mixer->out[i].insert;
+            int samp_idx = i * FLUID_MIXER_MAX_BUFFERS_DEFAULT * FLUID_BUFSIZE;
+
+            if(!fluid_insertfx_is_active(insert)
+                    || (!dirty[i * 2] && !dirty[i * 2 + 1] && fluid_insertfx_is_idle(insert)))
+            {
+                continue;
             }
+
+            fluid_insertfx_process(insert, &dry_l[samp_idx], &dry_r[samp_idx], sample_count);
+            dirty[i * 2] = dirty[i * 2 + 1] = TRUE;
         }
     }
 }
@@ -411,20 +729,21 @@ get_dest_buf(fluid_rvoice_buffers_t *buffers, int index,
 }
 
 /**
- * Mix samples down from internal dsp_buf to output buffers
+ * Mix one block of samples down from internal dsp_buf to output buffers
  *
  * @param buffers Destination buffer(s)
- * @param dsp_buf Mono sample source
- * @param start_block starting sample in dsp_buf
- * @param sample_count number of samples to mix following \c start_block
+ * @param dsp_buf Mono sample source (block_size in length)
+ * @param start_block block index in the output buffers to mix to
+ * @param sample_count number of samples to mix (at most block_size)
+ * @param block_size number of samples per block
  * @param dest_bufs Array of buffers to mixdown to
  * @param dest_bufcount Length of dest_bufs (i.e count of buffers)
  */
-static void
-fluid_rvoice_buffers_mix(fluid_rvoice_buffers_t *buffers,
-                         const fluid_real_t *FLUID_RESTRICT dsp_buf,
-                         int start_block, int sample_count,
-                         fluid_real_t **dest_bufs, int dest_bufcount)
+static FLUID_INLINE void
+fluid_rvoice_buffers_mix_generic(fluid_rvoice_buffers_t *buffers,
+                                 const fluid_real_t *FLUID_RESTRICT dsp_buf,
+                                 int start_block, int sample_count, int block_size,
+                                 fluid_real_t **dest_bufs, int dest_bufcount)
 {
     /* buffers count to mixdown to */
     int bufcount = buffers->count;
@@ -436,8 +755,8 @@ fluid_rvoice_buffers_mix(fluid_rvoice_buffers_t *buffers,
         return;
     }
 
+    FLUID_ASSERT(sample_count <= block_size);
     FLUID_ASSERT((uintptr_t)dsp_buf % FLUID_DEFAULT_ALIGNMENT == 0);
-    FLUID_ASSERT((uintptr_t)(&dsp_buf[start_block * FLUID_BUFSIZE]) % FLUID_DEFAULT_ALIGNMENT == 0);
 
     /* mixdown for each buffer */
     for(i = 0; i < bufcount; i++)
@@ -452,25 +771,41 @@ fluid_rvoice_buffers_mix(fluid_rvoice_buffers_t *buffers,
             continue;
         }
 
-        amp_incr = (target_amp - current_amp) / FLUID_BUFSIZE;
-
         FLUID_ASSERT((uintptr_t)buf % FLUID_DEFAULT_ALIGNMENT == 0);
 
+        /* Index by blocks (not by samples) to let the compiler know that we always start accessing
+         * buf at the block_size*sizeof(fluid_real_t) byte boundary and never somewhere in between. */
+        buf = &buf[start_block * block_size];
+
+        if(current_amp == target_amp)
+        {
+            /* we have reached the target_amp, no need to interpolate */
+            #pragma omp simd aligned(dsp_buf,buf:FLUID_DEFAULT_ALIGNMENT)
+            for(dsp_i = 0; dsp_i < sample_count; dsp_i++)
+            {
+                buf[dsp_i] += target_amp * dsp_buf[dsp_i];
+            }
+
+            continue;
+        }
+
+        amp_incr = (target_amp - current_amp) / block_size;
+
         /* Mixdown sample_count samples in the current buffer buf
          *
-         * For the first FLUID_BUFSIZE samples, we linearly interpolate the buffers amplitude to
+         * For the first block after an amplitude change, we linearly interpolate the buffers amplitude to
          * avoid clicks/pops when rapidly changing the channels panning (issue 768).
-         * 
+         *
          * We could have squashed this into one single loop by using an if clause within the loop body.
          * But it seems like having two separate loops is easier for compilers to understand, and therefore
          * auto-vectorizing the loops.
          */
-        if(sample_count < FLUID_BUFSIZE)
+        if(sample_count < block_size)
         {
             // scalar loop variant, the voice will have finished afterwards
             for(dsp_i = 0; dsp_i < sample_count; dsp_i++)
             {
-                buf[start_block * FLUID_BUFSIZE + dsp_i] += current_amp * dsp_buf[start_block * FLUID_BUFSIZE + dsp_i];
+                buf[dsp_i] += current_amp * dsp_buf[dsp_i];
                 current_amp += amp_incr;
             }
         }
@@ -478,82 +813,241 @@ fluid_rvoice_buffers_mix(fluid_rvoice_buffers_t *buffers,
         {
             // here goes the vectorizable loop
             #pragma omp simd aligned(dsp_buf,buf:FLUID_DEFAULT_ALIGNMENT)
-            for(dsp_i = 0; dsp_i < FLUID_BUFSIZE; dsp_i++)
+            for(dsp_i = 0; dsp_i < block_size; dsp_i++)
             {
                 // We cannot simply increment current_amp by amp_incr during every iteration, as this would create a dependency and prevent vectorization.
-                buf[start_block * FLUID_BUFSIZE + dsp_i] += (current_amp + amp_incr * dsp_i) * dsp_buf[start_block * FLUID_BUFSIZE + dsp_i];
+                buf[dsp_i] += (current_amp + amp_incr * dsp_i) * dsp_buf[dsp_i];
+            }
+        }
+
+        buffers->bufs[i].current_amp = target_amp;
+    }
+}
+
+#if FLUID_CPU_DISPATCH
+FLUID_TARGET_AVX2 static void
+fluid_rvoice_buffers_mix_avx2(fluid_rvoice_buffers_t *buffers,
+                              const fluid_real_t *FLUID_RESTRICT dsp_buf,
+                              int start_block, int sample_count, int block_size,
+                              fluid_real_t **dest_bufs, int dest_bufcount)
+{
+    fluid_rvoice_buffers_mix_generic(buffers, dsp_buf, start_block, sample_count, block_size, dest_bufs, dest_bufcount);
+}
+
+FLUID_TARGET_AVX512 static void
+fluid_rvoice_buffers_mix_avx512(fluid_rvoice_buffers_t *buffers,
+                                const fluid_real_t *FLUID_RESTRICT dsp_buf,
+                                int start_block, int sample_count, int block_size,
+                                fluid_real_t **dest_bufs, int dest_bufcount)
+{
+    fluid_rvoice_buffers_mix_generic(buffers, dsp_buf, start_block, sample_count, block_size, dest_bufs, dest_bufcount);
+}
+#endif
+
+/**
+ * Mix one block of samples down using the kernel built for \c cpu_isa,
+ * see fluid_rvoice_buffers_mix_generic().
+ */
+static FLUID_INLINE void
+fluid_rvoice_buffers_mix(fluid_rvoice_buffers_t *buffers,
+                         const fluid_real_t *FLUID_RESTRICT dsp_buf,
+                         int start_block, int sample_count, int block_size,
+                         fluid_real_t **dest_bufs, int dest_bufcount, int cpu_isa)
+{
+    switch(cpu_isa)
+    {
+#if FLUID_CPU_DISPATCH
+    case FLUID_CPU_ISA_AVX512:
+        fluid_rvoice_buffers_mix_avx512(buffers, dsp_buf, start_block, sample_count, block_size, dest_bufs, dest_bufcount);
+        break;
+
+    case FLUID_CPU_ISA_AVX2:
+        fluid_rvoice_buffers_mix_avx2(buffers, dsp_buf, start_block, sample_count, block_size, dest_bufs, dest_bufcount);
+        break;
+#endif
+
+    default:
+        fluid_rvoice_buffers_mix_generic(buffers, dsp_buf, start_block, sample_count, block_size, dest_bufs, dest_bufcount);
+        break;
+    }
+}
+
+/**
+ * Apply the voice filters to one block of samples and mix it down.
+ *
+ * Full blocks are filtered and mixed into all buffers in a single pass, see
+ * fluid_iir_filter_apply_mix(). Partial blocks and filter configurations not
+ * covered by that kernel are filtered in place and mixed down separately.
+ *
+ * @param rvoice The voice that rendered dsp_buf
+ * @param dsp_buf Mono sample source (one block in length), unfiltered
+ * @param start_block block index in the output buffers to mix to
+ * @param sample_count number of samples to mix (at most one block)
+ * @param dest_bufs Array of buffers to mixdown to
+ * @param dest_bufcount Length of dest_bufs (i.e count of buffers)
+ */
+static FLUID_INLINE void
+fluid_rvoice_filter_mix(fluid_rvoice_t *rvoice,
+                        fluid_real_t *FLUID_RESTRICT dsp_buf,
+                        int start_block, int sample_count,
+                        fluid_real_t **dest_bufs, int dest_bufcount, int cpu_isa)
+{
+    fluid_rvoice_buffers_t *buffers = &rvoice->buffers;
+    int block_size = rvoice->dsp.block_size;
+
+    if(sample_count == block_size && dest_bufcount > 0)
+    {
+        fluid_iir_filter_dest_t dests[FLUID_RVOICE_MAX_BUFS];
+        int mixed[FLUID_RVOICE_MAX_BUFS];
+        unsigned int i;
+        int dest_count = 0;
+
+        for(i = 0; i < buffers->count; i++)
+        {
+            fluid_real_t *buf = get_dest_buf(buffers, i, dest_bufs, dest_bufcount);
+            fluid_real_t target_amp = buffers->bufs[i].target_amp;
+            fluid_real_t current_amp = buffers->bufs[i].current_amp;
+
+            mixed[i] = !(buf == NULL || (current_amp == 0.0f && target_amp == 0.0f));
+
+            if(!mixed[i])
+            {
+                continue;
             }
-            
-            // we have reached the target_amp
-            if(target_amp > 0)
+
+            FLUID_ASSERT((uintptr_t)buf % FLUID_DEFAULT_ALIGNMENT == 0);
+
+            dests[dest_count].buf = &buf[start_block * block_size];
+            dests[dest_count].amp = current_amp;
+            dests[dest_count].amp_incr = (current_amp == target_amp) ? 0 : (target_amp - current_amp) / block_size;
+            dest_count++;
+        }
+
+        if(fluid_iir_filter_apply_mix(&rvoice->resonant_filter, &rvoice->resonant_custom_filter,
+                                      dsp_buf, block_size, dests, dest_count, cpu_isa))
+        {
+            fluid_check_fpe("voice_filter fluid_iir_filter_apply_mix()");
+
+            for(i = 0; i < buffers->count; i++)
             {
-                /* Note, that this loop could be unrolled by FLUID_BUFSIZE elements */
-                #pragma omp simd aligned(dsp_buf,buf:FLUID_DEFAULT_ALIGNMENT)
-                for(dsp_i = FLUID_BUFSIZE; dsp_i < sample_count; dsp_i++)
+                if(mixed[i])
                 {
-                    // Index by blocks (not by samples) to let the compiler know that we always start accessing
-                    // buf and dsp_buf at the FLUID_BUFSIZE*sizeof(fluid_real_t) byte boundary and never somewhere
-                    // in between.
-                    // A good compiler should understand: Aha, so I don't need to add a peel loop when vectorizing
-                    // this loop. Great.
-                    buf[start_block * FLUID_BUFSIZE + dsp_i] += target_amp * dsp_buf[start_block * FLUID_BUFSIZE + dsp_i];
+                    buffers->bufs[i].current_amp = buffers->bufs[i].target_amp;
                 }
             }
+
+            return;
         }
-        
-        buffers->bufs[i].current_amp = target_amp;
     }
+
+    fluid_iir_filter_apply(&rvoice->resonant_filter, &rvoice->resonant_custom_filter, dsp_buf, sample_count, cpu_isa);
+    fluid_check_fpe("voice_filter fluid_iir_filter_apply()");
+
+    fluid_rvoice_buffers_mix(buffers, dsp_buf, start_block, sample_count, block_size, dest_bufs, dest_bufcount, cpu_isa);
 }
 
 /**
- * Synthesize one voice and add to buffer.
- * NOTE: If return value is less than blockcount*FLUID_BUFSIZE, that means
- * voice has been finished, removed and possibly replaced with another voice.
+ * Synthesize a batch of voices and add them to the buffers.
+ *
+ * The voices are rendered block by block, side by side, see fluid_rvoice_write_batch().
+ * Each block is mixed down right after it has been rendered, so that src_buf only
+ * needs to hold a single block per voice.
+ *
+ * NOTE: Voices that render less than blockcount*block_size samples have been
+ * finished, and will be removed and possibly replaced with another voice.
+ *
+ * @param rvoices Array of voices to render
+ * @param voice_count Length of rvoices, at most #FLUID_RVOICE_BATCH_LANES
+ * @param src_buf Scratch buffer of #FLUID_RVOICE_BATCH_LANES * #FLUID_BUFSIZE_MAX samples
  */
 static FLUID_INLINE void
-fluid_mixer_buffers_render_one(fluid_mixer_buffers_t *buffers,
-                               fluid_rvoice_t *rvoice, fluid_real_t **dest_bufs,
-                               unsigned int dest_bufcount, fluid_real_t *src_buf, int blockcount)
+fluid_mixer_buffers_render_batch(fluid_mixer_buffers_t *buffers,
+                                 fluid_rvoice_t **rvoices, int voice_count,
+                                 fluid_real_t **dest_bufs, unsigned int dest_bufcount,
+                                 fluid_real_t *src_buf, int blockcount)
 {
-    int i, total_samples = 0, last_block_mixed = 0;
+    fluid_rvoice_t *active[FLUID_RVOICE_BATCH_LANES];
+    fluid_real_t *dsp_bufs[FLUID_RVOICE_BATCH_LANES];
+    int counts[FLUID_RVOICE_BATCH_LANES];
+    int filter[FLUID_RVOICE_BATCH_LANES];
+    int alive[FLUID_RVOICE_BATCH_LANES];
+    int cpu_isa = buffers->mixer->cpu_isa;
+    int block_size = buffers->mixer->block_size;
+    int i, v, active_count;
 
-    for(i = 0; i < blockcount; i++)
+    for(v = 0; v < voice_count; v++)
     {
-        /* render one block in src_buf */
-        int s = fluid_rvoice_write(rvoice, &src_buf[FLUID_BUFSIZE * i]);
+        active[v] = rvoices[v];
+        dsp_bufs[v] = &src_buf[block_size * v];
+        alive[v] = FALSE;
 
-        if(s == -1)
-        {
-            /* the voice is silent, mix back all the previously rendered sound */
-            fluid_rvoice_buffers_mix(&rvoice->buffers, src_buf, last_block_mixed,
-                                     total_samples - (last_block_mixed * FLUID_BUFSIZE),
-                                     dest_bufs, dest_bufcount);
 
-            last_block_mixed = i + 1; /* future block start index to mix from */
-            total_samples += FLUID_BUFSIZE; /* accumulate samples count rendered */
+        for(i = 0; i < (int)rvoices[v]->buffers.count; i++)
+        {
+            if(get_dest_buf(&rvoices[v]->buffers, i, dest_bufs, dest_bufcount) != NULL)
+            {
+                buffers->dirty[rvoices[v]->buffers.bufs[i].mapping] = TRUE;
+            }
         }
-        else
+    }
+
+    active_count = voice_count;
+
+    for(i = 0; i < blockcount && active_count > 0; i++)
+    {
+        int still_active = 0;
+
+        /* render one block of each voice in src_buf */
+        fluid_rvoice_write_batch(active, dsp_bufs, counts, filter, active_count, cpu_isa);
+
+        for(v = 0; v < active_count; v++)
         {
-            /* the voice wasn't quiet. Some samples have been rendered [0..FLUID_BUFSIZE] */
-            total_samples += s;
+            int s = counts[v];
+
+            /* -1 means the voice is quiet, nothing to mix. Otherwise some samples
+             * have been rendered [0..block_size] */
+            if(filter[v])
+            {
+                fluid_rvoice_filter_mix(active[v], dsp_bufs[v], i, s, dest_bufs, dest_bufcount, cpu_isa);
+            }
+            else
+            {
+                fluid_rvoice_buffers_mix(&active[v]->buffers, dsp_bufs[v], i, s, block_size,
+                                         dest_bufs, dest_bufcount, cpu_isa);
+            }
 
-            if(s < FLUID_BUFSIZE)
+            if(s >= 0 && s < block_size)
             {
                 /* voice has finished */
-                break;
+                continue;
             }
+
+            active[still_active] = active[v];
+            dsp_bufs[still_active] = dsp_bufs[v];
+            still_active++;
         }
+
+        active_count = still_active;
+    }
+
+    if(active_count == voice_count)
+    {
+        return;
     }
 
-    /* Now mix the remaining blocks from last_block_mixed to total_sample */
-    fluid_rvoice_buffers_mix(&rvoice->buffers, src_buf, last_block_mixed,
-                             total_samples - (last_block_mixed * FLUID_BUFSIZE),
-                             dest_bufs, dest_bufcount);
+    /* Report finished voices in their original order, so that the order of the
+     * voice list does not depend on the batching. */
+    for(v = 0; v < active_count; v++)
+    {
+        alive[(dsp_bufs[v] - src_buf) / block_size] = TRUE;
+    }
 
-    if(total_samples < blockcount * FLUID_BUFSIZE)
+    for(v = 0; v < voice_count; v++)
     {
-        /* voice has finished */
-        fluid_finish_rvoice(buffers, rvoice);
+        if(!alive[v])
+        {
+            fluid_finish_rvoice(buffers, rvoices[v]);
+        }
     }
 }
 
@@ -612,37 +1106,92 @@ fluid_mixer_buffers_update_polyphony(fluid_mixer_buffers_t *buffers, int value)
     return FLUID_OK;
 }
 
-/**
- * Update polyphony - max number of voices (NOTE: not hard real-time capable)
- * @return FLUID_OK or FLUID_FAILED
- */
-DECLARE_FLUID_RVOICE_FUNCTION(fluid_rvoice_mixer_set_polyphony)
+#if ENABLE_MIXER_THREADS
+/* Resize the scratch arrays of fluid_mixer_partition_voices() */
+static int
+fluid_mixer_update_partition_polyphony(fluid_rvoice_mixer_t *mixer, int value)
 {
     void *newptr;
-    fluid_rvoice_mixer_t *handler = obj;
-    int value = param[0].i;
 
-    if(handler->active_voices > value)
+    newptr = FLUID_REALLOC(mixer->mt_rvoices, value * sizeof(*mixer->mt_rvoices));
+
+    if(newptr == NULL)
     {
-        return /*FLUID_FAILED*/;
+        return FLUID_FAILED;
     }
 
-    newptr = FLUID_REALLOC(handler->rvoices, value * sizeof(fluid_rvoice_t *));
+    mixer->mt_rvoices = newptr;
+
+    newptr = FLUID_REALLOC(mixer->mt_chunks, value * sizeof(*mixer->mt_chunks));
 
     if(newptr == NULL)
     {
-        return /*FLUID_FAILED*/;
+        return FLUID_FAILED;
     }
 
-    handler->rvoices = newptr;
+    mixer->mt_chunks = newptr;
 
-    if(fluid_mixer_buffers_update_polyphony(&handler->buffers, value)
-            == FLUID_FAILED)
+    newptr = FLUID_REALLOC(mixer->mt_costs, value * sizeof(*mixer->mt_costs));
+
+    if(newptr == NULL)
     {
-        return /*FLUID_FAILED*/;
+        return FLUID_FAILED;
     }
 
-#if ENABLE_MIXER_THREADS
+    mixer->mt_costs = newptr;
+
+    newptr = FLUID_REALLOC(mixer->mt_order, value * sizeof(*mixer->mt_order));
+
+    if(newptr == NULL)
+    {
+        return FLUID_FAILED;
+    }
+
+    mixer->mt_order = newptr;
+
+    newptr = FLUID_REALLOC(mixer->mt_owner, value * sizeof(*mixer->mt_owner));
+
+    if(newptr == NULL)
+    {
+        return FLUID_FAILED;
+    }
+
+    mixer->mt_owner = newptr;
+    return FLUID_OK;
+}
+#endif
+
+/**
+ * Update polyphony - max number of voices (NOTE: not hard real-time capable)
+ * @return FLUID_OK or FLUID_FAILED
+ */
+DECLARE_FLUID_RVOICE_FUNCTION(fluid_rvoice_mixer_set_polyphony)
+{
+    void *newptr;
+    fluid_rvoice_mixer_t *handler = obj;
+    int value = param[0].i;
+
+    if(handler->active_voices > value)
+    {
+        return /*FLUID_FAILED*/;
+    }
+
+    newptr = FLUID_REALLOC(handler->rvoices, value * sizeof(fluid_rvoice_t *));
+
+    if(newptr == NULL)
+    {
+        return /*FLUID_FAILED*/;
+    }
+
+    handler->rvoices = newptr;
+
+    if(fluid_mixer_buffers_update_polyphony(&handler->buffers, value)
+            == FLUID_FAILED)
+    {
+        return /*FLUID_FAILED*/;
+    }
+
+#if ENABLE_MIXER_THREADS
     {
         int i;
 
@@ -654,6 +1203,11 @@ DECLARE_FLUID_RVOICE_FUNCTION(fluid_rvoice_mixer_set_polyphony)
                 return /*FLUID_FAILED*/;
             }
         }
+
+        if(fluid_mixer_update_partition_polyphony(handler, value) == FLUID_FAILED)
+        {
+            return /*FLUID_FAILED*/;
+        }
     }
 #endif
 
@@ -674,40 +1228,68 @@ fluid_render_loop_singlethread(fluid_rvoice_mixer_t *mixer, int blockcount)
 
     fluid_profile_ref_var(prof_ref);
 
-    for(i = 0; i < mixer->active_voices; i++)
+    for(i = 0; i < mixer->active_voices; i += FLUID_RVOICE_BATCH_LANES)
     {
-        fluid_mixer_buffers_render_one(&mixer->buffers, mixer->rvoices[i], bufs,
-                                       bufcount, local_buf, blockcount);
-        fluid_profile(FLUID_PROF_ONE_BLOCK_VOICE, prof_ref, 1,
-                      blockcount * FLUID_BUFSIZE);
+        int count = mixer->active_voices - i;
+
+        if(count > FLUID_RVOICE_BATCH_LANES)
+        {
+            count = FLUID_RVOICE_BATCH_LANES;
+        }
+
+        fluid_mixer_buffers_render_batch(&mixer->buffers, &mixer->rvoices[i], count, bufs,
+                                         bufcount, local_buf, blockcount);
+        fluid_profile(FLUID_PROF_ONE_BLOCK_VOICE, prof_ref, count,
+                      blockcount * mixer->block_size);
     }
 }
 
-static FLUID_INLINE void
-fluid_mixer_buffers_zero(fluid_mixer_buffers_t *buffers, int current_blockcount)
+/**
+ * Get one of the buffers returned by fluid_mixer_buffers_prepare(), regardless
+ * of whether the effects are enabled. The right effects buffers follow them.
+ */
+static FLUID_INLINE fluid_real_t *
+fluid_mixer_buffers_get_buf(fluid_mixer_buffers_t *buffers, int index)
 {
-    int i, size = current_blockcount * FLUID_BUFSIZE * sizeof(fluid_real_t);
-
-    /* TODO: Optimize by only zero out the buffers we actually use later on. */
-    int buf_count = buffers->buf_count, fx_buf_count = buffers->fx_buf_count;
-
-    fluid_real_t *FLUID_RESTRICT buf_l = fluid_align_ptr(buffers->left_buf, FLUID_DEFAULT_ALIGNMENT);
-    fluid_real_t *FLUID_RESTRICT buf_r = fluid_align_ptr(buffers->right_buf, FLUID_DEFAULT_ALIGNMENT);
+    const int offset = buffers->buf_count * 2;
+    fluid_real_t *base_ptr;
 
-    for(i = 0; i < buf_count; i++)
+    if(index >= offset + buffers->fx_buf_count)
     {
-        FLUID_MEMSET(&buf_l[i * FLUID_MIXER_MAX_BUFFERS_DEFAULT * FLUID_BUFSIZE], 0, size);
-        FLUID_MEMSET(&buf_r[i * FLUID_MIXER_MAX_BUFFERS_DEFAULT * FLUID_BUFSIZE], 0, size);
+        base_ptr = fluid_align_ptr(buffers->fx_right_buf, FLUID_DEFAULT_ALIGNMENT);
+        index -= offset + buffers->fx_buf_count;
+    }
+    else if(index >= offset)
+    {
+        base_ptr = fluid_align_ptr(buffers->fx_left_buf, FLUID_DEFAULT_ALIGNMENT);
+        index -= offset;
+    }
+    else
+    {
+        base_ptr = fluid_align_ptr((index & 1) ? buffers->right_buf : buffers->left_buf, FLUID_DEFAULT_ALIGNMENT);
+        index /= 2;
     }
 
-    buf_l = fluid_align_ptr(buffers->fx_left_buf, FLUID_DEFAULT_ALIGNMENT);
-    buf_r = fluid_align_ptr(buffers->fx_right_buf, FLUID_DEFAULT_ALIGNMENT);
+    return &base_ptr[index * FLUID_BUFSIZE * FLUID_MIXER_MAX_BUFFERS_DEFAULT];
+}
 
-    for(i = 0; i < fx_buf_count; i++)
+/* Zero the dirty buffers, before rendering current_blockcount blocks */
+static void
+fluid_mixer_buffers_zero_dirty(fluid_mixer_buffers_t *buffers, int current_blockcount)
+{
+    int i, bufcount = (buffers->buf_count + buffers->fx_buf_count) * 2;
+
+    for(i = 0; i < bufcount; i++)
     {
-        FLUID_MEMSET(&buf_l[i * FLUID_MIXER_MAX_BUFFERS_DEFAULT * FLUID_BUFSIZE], 0, size);
-        FLUID_MEMSET(&buf_r[i * FLUID_MIXER_MAX_BUFFERS_DEFAULT * FLUID_BUFSIZE], 0, size);
+        if(buffers->dirty[i])
+        {
+            FLUID_MEMSET(fluid_mixer_buffers_get_buf(buffers, i), 0,
+                         buffers->dirty_blockcount * buffers->mixer->block_size * sizeof(fluid_real_t));
+            buffers->dirty[i] = FALSE;
+        }
     }
+
+    buffers->dirty_blockcount = current_blockcount;
 }
 
 static int
@@ -744,6 +1326,19 @@ fluid_mixer_buffers_init(fluid_mixer_buffers_t *buffers, fluid_rvoice_mixer_t *m
         return 0;
     }
 
+    buffers->dirty = FLUID_ARRAY(char, (buffers->buf_count + buffers->fx_buf_count) * 2);
+
+    if(buffers->dirty == NULL)
+    {
+        FLUID_LOG(FLUID_ERR, "Out of memory");
+        return 0;
+    }
+
+    /* The buffers' content is unknown yet: have them all zeroed by the first
+     * fluid_mixer_buffers_zero_dirty() */
+    FLUID_MEMSET(buffers->dirty, TRUE, (buffers->buf_count + buffers->fx_buf_count) * 2);
+    buffers->dirty_blockcount = fluid_rvoice_mixer_get_bufcount(mixer);
+
     buffers->finished_voices = NULL;
 
     if(fluid_mixer_buffers_update_polyphony(buffers, mixer->polyphony)
@@ -784,6 +1379,17 @@ DECLARE_FLUID_RVOICE_FUNCTION(fluid_rvoice_mixer_set_samplerate)
               lost of quality.
             */
         }
+
+        /* the impulse response stays at the former sample rate until loaded again */
+        fluid_convrev_reset(mixer->fx[i].convrev);
+
+        fluid_insertfx_samplerate_change(mixer->fx[i].insert[SYNTH_REVERB_CHANNEL], samplerate);
+        fluid_insertfx_samplerate_change(mixer->fx[i].insert[SYNTH_CHORUS_CHANNEL], samplerate);
+    }
+
+    for(i = 0; i < mixer->buffers.buf_count; i++)
+    {
+        fluid_insertfx_samplerate_change(mixer->out[i].insert, samplerate);
     }
 
 #if LADSPA
@@ -797,6 +1403,18 @@ DECLARE_FLUID_RVOICE_FUNCTION(fluid_rvoice_mixer_set_samplerate)
 }
 
 
+/* Sets shadow parameters of insert effects to their defaults */
+static void
+fluid_mixer_insert_param_init(double param[FLUID_INSERT_FX_PARAM_LAST])
+{
+    int i;
+
+    for(i = 0; i < FLUID_INSERT_FX_PARAM_LAST; i++)
+    {
+        fluid_insertfx_param_info(i, NULL, &param[i], NULL, NULL, NULL);
+    }
+}
+
 /**
  * @param buf_count number of primary stereo buffers
  * @param fx_buf_count number of stereo effect buffers
@@ -805,6 +1423,7 @@ fluid_rvoice_mixer_t *
 new_fluid_rvoice_mixer(int buf_count, int fx_buf_count, int fx_units,
                        fluid_real_t sample_rate_max,
                        fluid_real_t sample_rate,
+                       int block_size,
                        fluid_rvoice_eventhandler_t *evthandler,
                        int extra_threads, int prio)
 {
@@ -820,6 +1439,7 @@ new_fluid_rvoice_mixer(int buf_count, int fx_buf_count, int fx_units,
     FLUID_MEMSET(mixer, 0, sizeof(fluid_rvoice_mixer_t));
     mixer->eventhandler = evthandler;
     mixer->fx_units = fx_units;
+    mixer->block_size = block_size;
     mixer->buffers.buf_count = buf_count;
     mixer->buffers.fx_buf_count = fx_buf_count * fx_units;
 
@@ -845,6 +1465,40 @@ new_fluid_rvoice_mixer(int buf_count, int fx_buf_count, int fx_units,
             FLUID_LOG(FLUID_ERR, "Out of memory");
             goto error_recovery;
         }
+
+        /* create the insert effects of the units */
+        mixer->fx[i].insert[SYNTH_REVERB_CHANNEL] = new_fluid_insertfx(sample_rate_max, sample_rate);
+        mixer->fx[i].insert[SYNTH_CHORUS_CHANNEL] = new_fluid_insertfx(sample_rate_max, sample_rate);
+
+        if(mixer->fx[i].insert[SYNTH_REVERB_CHANNEL] == NULL || mixer->fx[i].insert[SYNTH_CHORUS_CHANNEL] == NULL)
+        {
+            goto error_recovery;
+        }
+
+        fluid_mixer_insert_param_init(mixer->fx[i].insert_param);
+    }
+
+    /* allocate the insert effects of the dry buffers */
+    mixer->out = FLUID_ARRAY(fluid_mixer_out_t, buf_count);
+
+    if(mixer->out == NULL)
+    {
+        FLUID_LOG(FLUID_ERR, "Out of memory");
+        goto error_recovery;
+    }
+
+    FLUID_MEMSET(mixer->out, 0, buf_count * sizeof(*mixer->out));
+
+    for(i = 0; i < buf_count; i++)
+    {
+        mixer->out[i].insert = new_fluid_insertfx(sample_rate_max, sample_rate);
+
+        if(mixer->out[i].insert == NULL)
+        {
+            goto error_recovery;
+        }
+
+        fluid_mixer_insert_param_init(mixer->out[i].insert_param);
     }
 
     if(!fluid_mixer_buffers_init(&mixer->buffers, mixer))
@@ -882,6 +1536,7 @@ static void
 fluid_mixer_buffers_free(fluid_mixer_buffers_t *buffers)
 {
     FLUID_FREE(buffers->finished_voices);
+    FLUID_FREE(buffers->dirty);
 
     /* free all the sample buffers */
     FLUID_FREE(buffers->local_buf);
@@ -931,14 +1586,35 @@ void delete_fluid_rvoice_mixer(fluid_rvoice_mixer_t *mixer)
             delete_fluid_revmodel(mixer->fx[i].reverb);
         }
 
+        delete_fluid_convrev(mixer->fx[i].convrev);
+
         if(mixer->fx[i].chorus)
         {
             delete_fluid_chorus(mixer->fx[i].chorus);
         }
+
+        delete_fluid_insertfx(mixer->fx[i].insert[SYNTH_REVERB_CHANNEL]);
+        delete_fluid_insertfx(mixer->fx[i].insert[SYNTH_CHORUS_CHANNEL]);
+    }
+
+    if(mixer->out != NULL)
+    {
+        for(i = 0; i < mixer->buffers.buf_count; i++)
+        {
+            delete_fluid_insertfx(mixer->out[i].insert);
+        }
     }
 
     FLUID_FREE(mixer->fx);
+    FLUID_FREE(mixer->out);
     FLUID_FREE(mixer->rvoices);
+#if ENABLE_MIXER_THREADS
+    FLUID_FREE(mixer->mt_rvoices);
+    FLUID_FREE(mixer->mt_chunks);
+    FLUID_FREE(mixer->mt_costs);
+    FLUID_FREE(mixer->mt_order);
+    FLUID_FREE(mixer->mt_owner);
+#endif
     FLUID_FREE(mixer);
 }
 
@@ -1202,6 +1878,32 @@ void fluid_rvoice_mixer_set_mix_fx(fluid_rvoice_mixer_t *mixer, int on)
     mixer->mix_fx_to_out = on;
 }
 
+/**
+ * Select the instruction set level of the dsp kernels (NOTE: not real-time capable,
+ * only call this before rendering starts)
+ * @param cpu_isa One of #fluid_cpu_isa, must be supported by the CPU
+ */
+void fluid_rvoice_mixer_set_cpu_isa(fluid_rvoice_mixer_t *mixer, int cpu_isa)
+{
+    int i;
+
+    mixer->cpu_isa = cpu_isa;
+
+    for(i = 0; i < mixer->fx_units; i++)
+    {
+        fluid_revmodel_set_cpu_isa(mixer->fx[i].reverb, cpu_isa);
+        fluid_chorus_set_cpu_isa(mixer->fx[i].chorus, cpu_isa);
+    }
+}
+
+/**
+ * @return The instruction set level of the dsp kernels, see #fluid_cpu_isa
+ */
+int fluid_rvoice_mixer_get_cpu_isa(const fluid_rvoice_mixer_t *mixer)
+{
+    return mixer->cpu_isa;
+}
+
 DECLARE_FLUID_RVOICE_FUNCTION(fluid_rvoice_mixer_set_chorus_params)
 {
     fluid_rvoice_mixer_t *mixer = obj;
@@ -1253,12 +1955,49 @@ DECLARE_FLUID_RVOICE_FUNCTION(fluid_rvoice_mixer_set_reverb_params)
         i = 0; /* parameters change must be applied to all fx groups */
     }
 
-    while(i < nr_units)
+    for(; i < nr_units; i++)
     {
-        fluid_revmodel_set(mixer->fx[i++].reverb, set, roomsize, damping, width, level);
+        fluid_revmodel_set(mixer->fx[i].reverb, set, roomsize, damping, width, level);
+
+        if(mixer->fx[i].convrev != NULL)
+        {
+            fluid_convrev_set(mixer->fx[i].convrev, set, width, level);
+        }
     }
 }
 
+/*
+ * Replaces the reverb units of some fx groups by convolution reverbs, or
+ * restores them where the convolution reverb is NULL. The previous convolution
+ * reverbs are handed back in the swap, as deleting them is up to the API thread.
+ */
+DECLARE_FLUID_RVOICE_FUNCTION(fluid_rvoice_mixer_set_reverb_convrev)
+{
+    fluid_rvoice_mixer_t *mixer = obj;
+    fluid_mixer_convrev_swap_t *swap = param[0].ptr;
+    fluid_convrev_t *convrev;
+    fluid_mixer_fx_t *fx;
+    int i;
+
+    if(swap->first >= 0 && swap->first + swap->count <= mixer->fx_units)
+    {
+        for(i = 0; i < swap->count; i++)
+        {
+            fx = &mixer->fx[swap->first + i];
+            convrev = fx->convrev;
+            fx->convrev = swap->convrev[i];
+            swap->convrev[i] = convrev;
+
+            /* both units start from silence */
+            fluid_revmodel_reset(fx->reverb);
+            fx->reverb_fed = FALSE;
+            fx->reverb_countdown = 0;
+        }
+    }
+
+    fluid_atomic_int_set(&swap->done, TRUE);
+}
+
 DECLARE_FLUID_RVOICE_FUNCTION(fluid_rvoice_mixer_reset_reverb)
 {
     fluid_rvoice_mixer_t *mixer = obj;
@@ -1267,6 +2006,14 @@ DECLARE_FLUID_RVOICE_FUNCTION(fluid_rvoice_mixer_reset_reverb)
     for(i = 0; i < mixer->fx_units; i++)
     {
         fluid_revmodel_reset(mixer->fx[i].reverb);
+
+        if(mixer->fx[i].convrev != NULL)
+        {
+            fluid_convrev_reset(mixer->fx[i].convrev);
+        }
+
+        mixer->fx[i].reverb_fed = FALSE;
+        mixer->fx[i].reverb_countdown = 0;
     }
 }
 
@@ -1278,6 +2025,102 @@ DECLARE_FLUID_RVOICE_FUNCTION(fluid_rvoice_mixer_reset_chorus)
     for(i = 0; i < mixer->fx_units; i++)
     {
         fluid_chorus_reset(mixer->fx[i].chorus);
+        mixer->fx[i].chorus_fed = FALSE;
+        mixer->fx[i].chorus_countdown = 0;
+    }
+}
+
+/**
+ * set one insert effects shadow parameter of one or all audio groups or fx groups.
+ * This parameter will be returned if queried.
+ * (see fluid_rvoice_mixer_insert_fx_get_param())
+ *
+ * @param mixer that contains all the insert effects.
+ * @param target #FLUID_INSERT_FX_AUDIO_GROUP or #FLUID_INSERT_FX_EFFECTS_GROUP.
+ * @param index index of the group, -1 for all groups of the target.
+ * @param param the parameter (#fluid_insert_fx_param).
+ * @param value the value.
+ */
+void
+fluid_rvoice_mixer_set_insert_fx_full(const fluid_rvoice_mixer_t *mixer,
+                                      int target, int index, int param, double value)
+{
+    int count = (target == FLUID_INSERT_FX_AUDIO_GROUP) ? mixer->buffers.buf_count : mixer->fx_units;
+
+    if(index >= 0) /* apply the parameter to this group only */
+    {
+        count = index + 1;
+    }
+    else /* apply the parameter to all groups */
+    {
+        index = 0;
+    }
+
+    for(; index < count; index++)
+    {
+        if(target == FLUID_INSERT_FX_AUDIO_GROUP)
+        {
+            mixer->out[index].insert_param[param] = value;
+        }
+        else
+        {
+            mixer->fx[index].insert_param[param] = value;
+        }
+    }
+}
+
+/**
+ * get one insert effects shadow parameter of one audio group or fx group.
+ * (see fluid_rvoice_mixer_set_insert_fx_full())
+ *
+ * @param mixer that contains all the insert effects.
+ * @param target #FLUID_INSERT_FX_AUDIO_GROUP or #FLUID_INSERT_FX_EFFECTS_GROUP.
+ * @param index index of the group, must be in range.
+ * @param param the parameter (#fluid_insert_fx_param).
+ * @return value.
+ */
+double
+fluid_rvoice_mixer_insert_fx_get_param(const fluid_rvoice_mixer_t *mixer,
+                                       int target, int index, int param)
+{
+    if(target == FLUID_INSERT_FX_AUDIO_GROUP)
+    {
+        return mixer->out[index].insert_param[param];
+    }
+
+    return mixer->fx[index].insert_param[param];
+}
+
+DECLARE_FLUID_RVOICE_FUNCTION(fluid_rvoice_mixer_set_insert_fx_param)
+{
+    fluid_rvoice_mixer_t *mixer = obj;
+    int target = param[0].i;
+    int i = param[1].i; /* group index */
+    int fx_param = param[2].i;
+    fluid_real_t value = param[3].real;
+    int count = (target == FLUID_INSERT_FX_AUDIO_GROUP) ? mixer->buffers.buf_count : mixer->fx_units;
+
+    /* does the change apply to group i only ? */
+    if(i >= 0)
+    {
+        count = i + 1;
+    }
+    else
+    {
+        i = 0;
+    }
+
+    for(; i < count; i++)
+    {
+        if(target == FLUID_INSERT_FX_AUDIO_GROUP)
+        {
+            fluid_insertfx_set_param(mixer->out[i].insert, fx_param, value);
+        }
+        else
+        {
+            fluid_insertfx_set_param(mixer->fx[i].insert[SYNTH_REVERB_CHANNEL], fx_param, value);
+            fluid_insertfx_set_param(mixer->fx[i].insert[SYNTH_CHORUS_CHANNEL], fx_param, value);
+        }
     }
 }
 
@@ -1297,9 +2140,35 @@ int fluid_rvoice_mixer_get_fx_bufs(fluid_rvoice_mixer_t *mixer,
     return mixer->buffers.fx_buf_count;
 }
 
+/**
+ * Tell whether the last fluid_rvoice_mixer_render() left a buffer silent.
+ * @param index index of the buffer, like for fluid_rvoice_mixer_get_bufs()
+ * @param right FALSE for the left buffer, TRUE for the right one
+ * @return TRUE if the buffer only holds zeros
+ */
+int fluid_rvoice_mixer_is_buf_silent(fluid_rvoice_mixer_t *mixer, int index, int right)
+{
+    return !mixer->buffers.dirty[index * 2 + (right ? 1 : 0)];
+}
+
+/**
+ * Ditto, for the effects buffers returned by fluid_rvoice_mixer_get_fx_bufs()
+ */
+int fluid_rvoice_mixer_is_fx_buf_silent(fluid_rvoice_mixer_t *mixer, int index, int right)
+{
+    int offset = mixer->buffers.buf_count * 2;
+
+    return !mixer->buffers.dirty[offset + (right ? mixer->buffers.fx_buf_count : 0) + index];
+}
+
+/**
+ * Get the number of blocks the mixer buffers can hold. The buffers are sized
+ * for #FLUID_MIXER_MAX_BUFFERS_DEFAULT blocks of #FLUID_BUFSIZE samples, so smaller
+ * blocks allow for more of them.
+ */
 int fluid_rvoice_mixer_get_bufcount(fluid_rvoice_mixer_t *mixer)
 {
-    return FLUID_MIXER_MAX_BUFFERS_DEFAULT;
+    return FLUID_MIXER_MAX_BUFFERS_DEFAULT * FLUID_BUFSIZE / mixer->block_size;
 }
 
 #if WITH_PROFILING
@@ -1311,17 +2180,219 @@ int fluid_rvoice_mixer_get_active_voices(fluid_rvoice_mixer_t *mixer)
 
 #if ENABLE_MIXER_THREADS
 
-static FLUID_INLINE fluid_rvoice_t *
-fluid_mixer_get_mt_rvoice(fluid_rvoice_mixer_t *mixer)
+/* Number of times a thread polls for work before it goes to sleep */
+#define FLUID_MIXER_SPIN_COUNT 4096
+
+/*
+ * Each thread taking part in rendering gets a contiguous range of chunks,
+ * see fluid_mixer_partition_voices(). The range is packed into a single
+ * atomic int, so that the owner can take chunks from its front and other
+ * threads can steal from its back without any locking. A chunk index fits
+ * in 16 bits for any valid polyphony.
+ */
+#define FLUID_MIXER_CHUNK_BITS 16
+#define FLUID_MIXER_CHUNK_MASK ((1 << FLUID_MIXER_CHUNK_BITS) - 1)
+
+static FLUID_INLINE int
+fluid_mixer_chunks_pack(int head, int tail)
+{
+    return head | (tail << FLUID_MIXER_CHUNK_BITS);
+}
+
+/* Take the first chunk of a deque, returns -1 if it is empty */
+static FLUID_INLINE int
+fluid_mixer_chunks_pop(fluid_atomic_int_t *chunks)
 {
-    int i = fluid_atomic_int_exchange_and_add(&mixer->current_rvoice, 1);
+    int value, head, tail;
 
-    if(i >= mixer->active_voices)
+    do
     {
-        return NULL;
+        value = fluid_atomic_int_get(chunks);
+        head = value & FLUID_MIXER_CHUNK_MASK;
+        tail = value >> FLUID_MIXER_CHUNK_BITS;
+
+        if(head >= tail)
+        {
+            return -1;
+        }
+    }
+    while(!fluid_atomic_int_compare_and_exchange(chunks, value, fluid_mixer_chunks_pack(head + 1, tail)));
+
+    return head;
+}
+
+/* Take the last chunk of a deque, returns -1 if it is empty */
+static FLUID_INLINE int
+fluid_mixer_chunks_steal(fluid_atomic_int_t *chunks)
+{
+    int value, head, tail;
+
+    do
+    {
+        value = fluid_atomic_int_get(chunks);
+        head = value & FLUID_MIXER_CHUNK_MASK;
+        tail = value >> FLUID_MIXER_CHUNK_BITS;
+
+        if(head >= tail)
+        {
+            return -1;
+        }
+    }
+    while(!fluid_atomic_int_compare_and_exchange(chunks, value, fluid_mixer_chunks_pack(head, tail - 1)));
+
+    return tail - 1;
+}
+
+/* Deques of the mixer (0) and its threads (1 ... thread_count) */
+static FLUID_INLINE fluid_mixer_buffers_t *
+fluid_mixer_get_participant(fluid_rvoice_mixer_t *mixer, int i)
+{
+    return i == 0 ? &mixer->buffers : &mixer->threads[i - 1];
+}
+
+/**
+ * Fetch the next batch of voices to render.
+ *
+ * Takes the next chunk of the calling thread's own deque. Once that has run
+ * dry, steals the last chunk of the other threads' deques.
+ *
+ * @param buffers Buffers of the calling thread, owning one of the deques
+ * @param rvoices Receives a pointer to the first voice of the batch
+ * @return Number of voices in the batch (0 if there are no voices left)
+ */
+static int
+fluid_mixer_get_mt_rvoices(fluid_rvoice_mixer_t *mixer, fluid_mixer_buffers_t *buffers, fluid_rvoice_t ***rvoices)
+{
+    int i, chunk = fluid_mixer_chunks_pop(&buffers->chunks);
+
+    if(chunk < 0)
+    {
+        int self = (buffers == &mixer->buffers) ? 0 : (int)(buffers - mixer->threads) + 1;
+
+        for(i = 1; i < mixer->participants && chunk < 0; i++)
+        {
+            int victim = (self + i) % mixer->participants;
+            chunk = fluid_mixer_chunks_steal(&fluid_mixer_get_participant(mixer, victim)->chunks);
+        }
+
+        if(chunk < 0)
+        {
+            return 0;
+        }
+    }
+
+    *rvoices = &mixer->mt_rvoices[mixer->mt_chunks[chunk].first];
+    return mixer->mt_chunks[chunk].count;
+}
+
+/**
+ * Estimate the cost of rendering the next blocks of all active voices.
+ * @return Sum of all voices' costs
+ */
+static int
+fluid_mixer_estimate_costs(fluid_rvoice_mixer_t *mixer)
+{
+    int i, total = 0;
+
+    for(i = 0; i < mixer->active_voices; i++)
+    {
+        mixer->mt_costs[i] = fluid_rvoice_get_cost(mixer->rvoices[i]);
+        total += mixer->mt_costs[i];
+    }
+
+    return total;
+}
+
+/**
+ * Balance the voices over the chunk deques of the threads taking part in
+ * rendering, based on the costs of fluid_mixer_estimate_costs().
+ *
+ * Uses the longest processing time first rule: starting with the most
+ * expensive voice, each voice is given to the least loaded thread. The
+ * voices of each thread are then split into chunks of up to
+ * #FLUID_RVOICE_BATCH_LANES voices. Any imbalance left is taken care of
+ * by work stealing.
+ *
+ * @param participants Number of deques to fill, the mixer's own included
+ */
+static void
+fluid_mixer_partition_voices(fluid_rvoice_mixer_t *mixer, int participants)
+{
+    int bucket[FLUID_RVOICE_COST_MAX + 2];
+    int i, k, p, chunk_count = 0;
+    FLUID_DECLARE_VLA(int, load, participants);
+    FLUID_DECLARE_VLA(int, offset, participants);
+
+    /* counting sort of the voices by descending cost */
+    FLUID_MEMSET(bucket, 0, sizeof(bucket));
+
+    for(i = 0; i < mixer->active_voices; i++)
+    {
+        bucket[FLUID_RVOICE_COST_MAX - mixer->mt_costs[i] + 1]++;
+    }
+
+    for(k = 1; k < FLUID_RVOICE_COST_MAX + 2; k++)
+    {
+        bucket[k] += bucket[k - 1];
+    }
+
+    for(i = 0; i < mixer->active_voices; i++)
+    {
+        mixer->mt_order[bucket[FLUID_RVOICE_COST_MAX - mixer->mt_costs[i]]++] = i;
+    }
+
+    /* give each voice to the least loaded thread */
+    for(p = 0; p < participants; p++)
+    {
+        load[p] = 0;
+        offset[p] = 0;
+    }
+
+    for(k = 0; k < mixer->active_voices; k++)
+    {
+        int v = mixer->mt_order[k];
+        int min = 0;
+
+        for(p = 1; p < participants; p++)
+        {
+            if(load[p] < load[min])
+            {
+                min = p;
+            }
+        }
+
+        load[min] += mixer->mt_costs[v];
+        offset[min]++;
+        mixer->mt_owner[v] = min;
+    }
+
+    /* lay out the voices thread by thread, keeping voices of similar cost
+     * (and thus likely the same interpolation method) in the same chunk */
+    for(p = 0, i = 0; p < participants; p++)
+    {
+        int n = offset[p];
+        int first_chunk = chunk_count;
+
+        for(k = 0; k < n; k += FLUID_RVOICE_BATCH_LANES)
+        {
+            mixer->mt_chunks[chunk_count].first = i + k;
+            mixer->mt_chunks[chunk_count].count = (n - k > FLUID_RVOICE_BATCH_LANES) ? FLUID_RVOICE_BATCH_LANES : n - k;
+            chunk_count++;
+        }
+
+        fluid_atomic_int_set(&fluid_mixer_get_participant(mixer, p)->chunks,
+                             fluid_mixer_chunks_pack(first_chunk, chunk_count));
+        offset[p] = i;
+        i += n;
     }
 
-    return mixer->rvoices[i];
+    for(k = 0; k < mixer->active_voices; k++)
+    {
+        int v = mixer->mt_order[k];
+        mixer->mt_rvoices[offset[mixer->mt_owner[v]]++] = mixer->rvoices[v];
+    }
+
+    mixer->participants = participants;
 }
 
 #define THREAD_BUF_PROCESSING 0
@@ -1329,13 +2400,90 @@ fluid_mixer_get_mt_rvoice(fluid_rvoice_mixer_t *mixer)
 #define THREAD_BUF_NODATA 2
 #define THREAD_BUF_TERMINATE 3
 
+/**
+ * Wait until a mixer thread is told to render or to terminate.
+ *
+ * Polls for a while first, so that a thread that is woken up block after
+ * block doesn't pay for going to sleep. Only after that it parks on
+ * wakeup_threads.
+ *
+ * @return THREAD_BUF_PROCESSING or THREAD_BUF_TERMINATE
+ */
+static int
+fluid_mixer_thread_wait(fluid_rvoice_mixer_t *mixer, fluid_mixer_buffers_t *buffers)
+{
+    int i, state;
+
+    for(i = 0; i < FLUID_MIXER_SPIN_COUNT; i++)
+    {
+        state = fluid_atomic_int_get(&buffers->ready);
+
+        if(state == THREAD_BUF_PROCESSING || state == THREAD_BUF_TERMINATE)
+        {
+            return state;
+        }
+    }
+
+    fluid_cond_mutex_lock(mixer->wakeup_threads_m);
+    fluid_atomic_int_inc(&mixer->sleeping_threads);
+
+    while(1)
+    {
+        state = fluid_atomic_int_get(&buffers->ready);
+
+        if(state == THREAD_BUF_PROCESSING || state == THREAD_BUF_TERMINATE)
+        {
+            break;
+        }
+
+        fluid_cond_wait(mixer->wakeup_threads, mixer->wakeup_threads_m);
+    }
+
+    fluid_atomic_int_add(&mixer->sleeping_threads, -1);
+    fluid_cond_mutex_unlock(mixer->wakeup_threads_m);
+
+    return state;
+}
+
+/**
+ * Merge the buffers of a mixer thread that finished rendering with those of
+ * another one.
+ *
+ * A thread's buffers are either parked in pending_thread or merged with the
+ * buffers parked there already, whichever is found first. The merged buffers
+ * are then given the same treatment, until they can be parked. That way the
+ * threads sum up each other's buffers as they finish, and only the buffers
+ * parked last need to be mixed by the render thread.
+ */
+static void
+fluid_mixer_thread_reduce(fluid_rvoice_mixer_t *mixer, fluid_mixer_buffers_t *buffers, int current_blockcount)
+{
+    int self = (int)(buffers - mixer->threads);
+
+    while(1)
+    {
+        int other = fluid_atomic_int_get(&mixer->pending_thread);
+
+        if(other < 0)
+        {
+            if(fluid_atomic_int_compare_and_exchange(&mixer->pending_thread, -1, self))
+            {
+                return;
+            }
+        }
+        else if(fluid_atomic_int_compare_and_exchange(&mixer->pending_thread, other, -1))
+        {
+            fluid_mixer_buffers_mix(buffers, &mixer->threads[other], current_blockcount);
+        }
+    }
+}
+
 /* Core thread function (processes voices in parallel to primary synthesis thread) */
 static fluid_thread_return_t
 fluid_mixer_thread_func(void *data)
 {
     fluid_mixer_buffers_t *buffers = data;
     fluid_rvoice_mixer_t *mixer = buffers->mixer;
-    int hasValidData = 0;
     FLUID_DECLARE_VLA(fluid_real_t *, bufs, buffers->buf_count * 2 + buffers->fx_buf_count * 2);
     int bufcount = 0;
     int current_blockcount = 0;
@@ -1343,62 +2491,56 @@ fluid_mixer_thread_func(void *data)
 
     while(!fluid_atomic_int_get(&mixer->threads_should_terminate))
     {
-        fluid_rvoice_t *rvoice = fluid_mixer_get_mt_rvoice(mixer);
+        fluid_rvoice_t **rvoices = NULL;
+        int count, hasValidData = 0;
 
-        if(rvoice == NULL)
+        if(fluid_mixer_thread_wait(mixer, buffers) == THREAD_BUF_TERMINATE)
         {
-            // if no voices: signal rendered buffers, sleep
-            fluid_atomic_int_set(&buffers->ready, hasValidData ? THREAD_BUF_VALID : THREAD_BUF_NODATA);
-            fluid_cond_mutex_lock(mixer->thread_ready_m);
-            fluid_cond_signal(mixer->thread_ready);
-            fluid_cond_mutex_unlock(mixer->thread_ready_m);
-
-            fluid_cond_mutex_lock(mixer->wakeup_threads_m);
-
-            while(1)
-            {
-                int j = fluid_atomic_int_get(&buffers->ready);
-
-                if(j == THREAD_BUF_PROCESSING || j == THREAD_BUF_TERMINATE)
-                {
-                    break;
-                }
-
-                fluid_cond_wait(mixer->wakeup_threads, mixer->wakeup_threads_m);
-            }
-
-            fluid_cond_mutex_unlock(mixer->wakeup_threads_m);
-
-            hasValidData = 0;
+            break;
         }
-        else
+
+        while((count = fluid_mixer_get_mt_rvoices(mixer, buffers, &rvoices)) > 0)
         {
-            // else: if buffer is not zeroed, zero buffers
+            // if buffer is not zeroed, zero buffers
             if(!hasValidData)
             {
                 // blockcount may have changed, since thread was put to sleep
                 current_blockcount = mixer->current_blockcount;
-                fluid_mixer_buffers_zero(buffers, current_blockcount);
+                fluid_mixer_buffers_zero_dirty(buffers, current_blockcount);
                 bufcount = fluid_mixer_buffers_prepare(buffers, bufs);
                 hasValidData = 1;
             }
 
-            // then render voice to buffers
-            fluid_mixer_buffers_render_one(buffers, rvoice, bufs, bufcount, local_buf, current_blockcount);
+            // then render voices to buffers
+            fluid_mixer_buffers_render_batch(buffers, rvoices, count, bufs, bufcount, local_buf, current_blockcount);
+        }
+
+        // no voices left: hand over the rendered buffers, then signal them
+        if(hasValidData)
+        {
+            fluid_mixer_thread_reduce(mixer, buffers, current_blockcount);
+        }
+
+        fluid_atomic_int_set(&buffers->ready, hasValidData ? THREAD_BUF_VALID : THREAD_BUF_NODATA);
+
+        if(fluid_atomic_int_get(&mixer->main_waiting))
+        {
+            fluid_cond_mutex_lock(mixer->thread_ready_m);
+            fluid_cond_signal(mixer->thread_ready);
+            fluid_cond_mutex_unlock(mixer->thread_ready_m);
         }
     }
 
     return FLUID_THREAD_RETURN_VALUE;
 }
 
+/* Add the dirty buffers of src to dst */
 static void
 fluid_mixer_buffers_mix(fluid_mixer_buffers_t *dst, fluid_mixer_buffers_t *src, int current_blockcount)
 {
     int i, j;
-    int scount = current_blockcount * FLUID_BUFSIZE;
-    int minbuf;
-    fluid_real_t *FLUID_RESTRICT base_src;
-    fluid_real_t *FLUID_RESTRICT base_dst;
+    int scount = current_blockcount * dst->mixer->block_size;
+    int minbuf, fx_minbuf;
 
     minbuf = dst->buf_count;
 
@@ -1407,117 +2549,68 @@ fluid_mixer_buffers_mix(fluid_mixer_buffers_t *dst, fluid_mixer_buffers_t *src,
         minbuf = src->buf_count;
     }
 
-    base_src = fluid_align_ptr(src->left_buf, FLUID_DEFAULT_ALIGNMENT);
-    base_dst = fluid_align_ptr(dst->left_buf, FLUID_DEFAULT_ALIGNMENT);
+    fx_minbuf = dst->fx_buf_count;
 
-    for(i = 0; i < minbuf; i++)
+    if(fx_minbuf > src->fx_buf_count)
     {
-        #pragma omp simd aligned(base_dst,base_src:FLUID_DEFAULT_ALIGNMENT)
-
-        for(j = 0; j < scount; j++)
-        {
-            int dsp_i = i * FLUID_MIXER_MAX_BUFFERS_DEFAULT * FLUID_BUFSIZE + j;
-            base_dst[dsp_i] += base_src[dsp_i];
-        }
+        fx_minbuf = src->fx_buf_count;
     }
 
-    base_src = fluid_align_ptr(src->right_buf, FLUID_DEFAULT_ALIGNMENT);
-    base_dst = fluid_align_ptr(dst->right_buf, FLUID_DEFAULT_ALIGNMENT);
-
-    for(i = 0; i < minbuf; i++)
+    for(i = 0; i < minbuf * 2 + fx_minbuf; i++)
     {
-        #pragma omp simd aligned(base_dst,base_src:FLUID_DEFAULT_ALIGNMENT)
+        /* dry buffers come first, followed by the effects buffers */
+        int src_i = (i < minbuf * 2) ? i : i - minbuf * 2 + src->buf_count * 2;
+        int dst_i = (i < minbuf * 2) ? i : i - minbuf * 2 + dst->buf_count * 2;
+        fluid_real_t *FLUID_RESTRICT base_src;
+        fluid_real_t *FLUID_RESTRICT base_dst;
 
-        for(j = 0; j < scount; j++)
+        if(!src->dirty[src_i])
         {
-            int dsp_i = i * FLUID_MIXER_MAX_BUFFERS_DEFAULT * FLUID_BUFSIZE + j;
-            base_dst[dsp_i] += base_src[dsp_i];
+            continue;
         }
-    }
-
-    minbuf = dst->fx_buf_count;
-
-    if(minbuf > src->fx_buf_count)
-    {
-        minbuf = src->fx_buf_count;
-    }
 
-    base_src = fluid_align_ptr(src->fx_left_buf, FLUID_DEFAULT_ALIGNMENT);
-    base_dst = fluid_align_ptr(dst->fx_left_buf, FLUID_DEFAULT_ALIGNMENT);
+        base_src = fluid_mixer_buffers_get_buf(src, src_i);
+        base_dst = fluid_mixer_buffers_get_buf(dst, dst_i);
 
-    for(i = 0; i < minbuf; i++)
-    {
         #pragma omp simd aligned(base_dst,base_src:FLUID_DEFAULT_ALIGNMENT)
 
         for(j = 0; j < scount; j++)
         {
-            int dsp_i = i * FLUID_MIXER_MAX_BUFFERS_DEFAULT * FLUID_BUFSIZE + j;
-            base_dst[dsp_i] += base_src[dsp_i];
+            base_dst[j] += base_src[j];
         }
-    }
 
-    base_src = fluid_align_ptr(src->fx_right_buf, FLUID_DEFAULT_ALIGNMENT);
-    base_dst = fluid_align_ptr(dst->fx_right_buf, FLUID_DEFAULT_ALIGNMENT);
-
-    for(i = 0; i < minbuf; i++)
-    {
-        #pragma omp simd aligned(base_dst,base_src:FLUID_DEFAULT_ALIGNMENT)
-
-        for(j = 0; j < scount; j++)
-        {
-            int dsp_i = i * FLUID_MIXER_MAX_BUFFERS_DEFAULT * FLUID_BUFSIZE + j;
-            base_dst[dsp_i] += base_src[dsp_i];
-        }
+        dst->dirty[dst_i] = TRUE;
     }
 }
 
-
-/**
- * Go through all threads and see if someone is finished for mixing
- */
+/* TRUE if any of the first extra_threads mixer threads is still rendering */
 static int
-fluid_mixer_mix_in(fluid_rvoice_mixer_t *mixer, int extra_threads, int current_blockcount)
+fluid_mixer_threads_processing(fluid_rvoice_mixer_t *mixer, int extra_threads)
 {
-    int i, result, hasmixed;
+    int i;
 
-    do
+    for(i = 0; i < extra_threads; i++)
     {
-        hasmixed = 0;
-        result = 0;
-
-        for(i = 0; i < extra_threads; i++)
+        if(fluid_atomic_int_get(&mixer->threads[i].ready) == THREAD_BUF_PROCESSING)
         {
-            int j = fluid_atomic_int_get(&mixer->threads[i].ready);
-
-            switch(j)
-            {
-            case THREAD_BUF_PROCESSING:
-                result = 1;
-                break;
-
-            case THREAD_BUF_VALID:
-                fluid_atomic_int_set(&mixer->threads[i].ready, THREAD_BUF_NODATA);
-                fluid_mixer_buffers_mix(&mixer->buffers, &mixer->threads[i], current_blockcount);
-                hasmixed = 1;
-                break;
-            }
+            return TRUE;
         }
     }
-    while(hasmixed);
 
-    return result;
+    return FALSE;
 }
 
 static void
 fluid_render_loop_multithread(fluid_rvoice_mixer_t *mixer, int current_blockcount)
 {
-    int i, bufcount;
+    int i, bufcount, count, spins;
+    fluid_rvoice_t **rvoices = NULL;
     fluid_real_t *local_buf = fluid_align_ptr(mixer->buffers.local_buf, FLUID_DEFAULT_ALIGNMENT);
 
     FLUID_DECLARE_VLA(fluid_real_t *, bufs,
                       mixer->buffers.buf_count * 2 + mixer->buffers.fx_buf_count * 2);
     // How many threads should we start this time?
-    int extra_threads = mixer->active_voices / VOICES_PER_THREAD;
+    int extra_threads = fluid_mixer_estimate_costs(mixer) / COST_PER_THREAD;
 
     if(extra_threads > mixer->thread_count)
     {
@@ -1533,60 +2626,69 @@ fluid_render_loop_multithread(fluid_rvoice_mixer_t *mixer, int current_blockcoun
 
     bufcount = fluid_mixer_buffers_prepare(&mixer->buffers, bufs);
 
-    // Prepare voice list
-    fluid_cond_mutex_lock(mixer->wakeup_threads_m);
-    fluid_atomic_int_set(&mixer->current_rvoice, 0);
+    // Balance the voices over the threads, idle threads will steal the rest
+    fluid_mixer_partition_voices(mixer, extra_threads + 1);
 
     for(i = 0; i < extra_threads; i++)
     {
         fluid_atomic_int_set(&mixer->threads[i].ready, THREAD_BUF_PROCESSING);
     }
 
-    // Signal threads to wake up
-    fluid_cond_broadcast(mixer->wakeup_threads);
-    fluid_cond_mutex_unlock(mixer->wakeup_threads_m);
+    // Only threads that went to sleep need a signal, the others are polling
+    if(fluid_atomic_int_get(&mixer->sleeping_threads) > 0)
+    {
+        fluid_cond_mutex_lock(mixer->wakeup_threads_m);
+        fluid_cond_broadcast(mixer->wakeup_threads);
+        fluid_cond_mutex_unlock(mixer->wakeup_threads_m);
+    }
+
+    // Render our own share of voices, and help out the others
+    while((count = fluid_mixer_get_mt_rvoices(mixer, &mixer->buffers, &rvoices)) > 0)
+    {
+        fluid_profile_ref_var(prof_ref);
+        fluid_mixer_buffers_render_batch(&mixer->buffers, rvoices, count, bufs, bufcount, local_buf, current_blockcount);
+        fluid_profile(FLUID_PROF_ONE_BLOCK_VOICE, prof_ref, count,
+                      current_blockcount * mixer->block_size);
+    }
+
+    // Help merging the threads' buffers as they finish their last chunk
+    spins = 0;
 
-    // If thread is finished, mix it in
-    while(fluid_mixer_mix_in(mixer, extra_threads, current_blockcount))
+    while(1)
     {
-        // Otherwise get a voice and render it
-        fluid_rvoice_t *rvoice = fluid_mixer_get_mt_rvoice(mixer);
+        // Check the threads first: once none is processing, pending_thread is final
+        int is_processing = fluid_mixer_threads_processing(mixer, extra_threads);
+        int other = fluid_atomic_int_get(&mixer->pending_thread);
 
-        if(rvoice != NULL)
+        if(other >= 0 && fluid_atomic_int_compare_and_exchange(&mixer->pending_thread, other, -1))
         {
-            fluid_profile_ref_var(prof_ref);
-            fluid_mixer_buffers_render_one(&mixer->buffers, rvoice, bufs, bufcount, local_buf, current_blockcount);
-            fluid_profile(FLUID_PROF_ONE_BLOCK_VOICE, prof_ref, 1,
-                          current_blockcount * FLUID_BUFSIZE);
-            //test++;
+            fluid_mixer_buffers_mix(&mixer->buffers, &mixer->threads[other], current_blockcount);
+            continue;
         }
-        else
+
+        if(!is_processing)
         {
-            // If no voices, wait for mixes. Make sure one is still processing to avoid deadlock
-            int is_processing = 0;
-            //waits++;
-            fluid_cond_mutex_lock(mixer->thread_ready_m);
+            break;
+        }
 
-            for(i = 0; i < extra_threads; i++)
-            {
-                if(fluid_atomic_int_get(&mixer->threads[i].ready) ==
-                        THREAD_BUF_PROCESSING)
-                {
-                    is_processing = 1;
-                }
-            }
+        if(spins < FLUID_MIXER_SPIN_COUNT)
+        {
+            spins++;
+            continue;
+        }
 
-            if(is_processing)
-            {
-                fluid_cond_wait(mixer->thread_ready, mixer->thread_ready_m);
-            }
+        fluid_cond_mutex_lock(mixer->thread_ready_m);
+        fluid_atomic_int_set(&mixer->main_waiting, TRUE);
 
-            fluid_cond_mutex_unlock(mixer->thread_ready_m);
+        // Make sure one is still processing to avoid deadlock
+        if(fluid_mixer_threads_processing(mixer, extra_threads))
+        {
+            fluid_cond_wait(mixer->thread_ready, mixer->thread_ready_m);
         }
-    }
 
-    //FLUID_LOG(FLUID_DBG, "Blockcount: %d, mixed %d of %d voices myself, waits = %d",
-    //	    current_blockcount, test, mixer->active_voices, waits);
+        fluid_atomic_int_set(&mixer->main_waiting, FALSE);
+        fluid_cond_mutex_unlock(mixer->thread_ready_m);
+    }
 }
 
 static void delete_rvoice_mixer_threads(fluid_rvoice_mixer_t *mixer)
@@ -1649,6 +2751,9 @@ static int fluid_rvoice_mixer_set_threads(fluid_rvoice_mixer_t *mixer, int threa
 
     // Now prepare the new threads
     fluid_atomic_int_set(&mixer->threads_should_terminate, 0);
+    fluid_atomic_int_set(&mixer->sleeping_threads, 0);
+    fluid_atomic_int_set(&mixer->main_waiting, FALSE);
+    fluid_atomic_int_set(&mixer->pending_thread, -1);
     mixer->threads = FLUID_ARRAY(fluid_mixer_buffers_t, thread_count);
 
     if(mixer->threads == NULL)
@@ -1685,7 +2790,7 @@ static int fluid_rvoice_mixer_set_threads(fluid_rvoice_mixer_t *mixer, int threa
 
 /**
  * Synthesize audio into buffers
- * @param blockcount number of blocks to render, each having FLUID_BUFSIZE samples
+ * @param blockcount number of blocks to render, each having mixer->block_size samples
  * @return number of blocks rendered
  */
 int
@@ -1696,9 +2801,9 @@ fluid_rvoice_mixer_render(fluid_rvoice_mixer_t *mixer, int blockcount)
     mixer->current_blockcount = blockcount;
 
     // Zero buffers
-    fluid_mixer_buffers_zero(&mixer->buffers, blockcount);
+    fluid_mixer_buffers_zero_dirty(&mixer->buffers, blockcount);
     fluid_profile(FLUID_PROF_ONE_BLOCK_CLEAR, prof_ref, mixer->active_voices,
-                  blockcount * FLUID_BUFSIZE);
+                  blockcount * mixer->block_size);
 
 #if ENABLE_MIXER_THREADS
 
@@ -1713,7 +2818,7 @@ fluid_rvoice_mixer_render(fluid_rvoice_mixer_t *mixer, int blockcount)
     }
 
     fluid_profile(FLUID_PROF_ONE_BLOCK_VOICES, prof_ref, mixer->active_voices,
-                  blockcount * FLUID_BUFSIZE);
+                  blockcount * mixer->block_size);
 
 
     // Process reverb & chorus
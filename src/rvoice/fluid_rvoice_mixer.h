@@ -24,6 +24,7 @@
 #include "fluidsynth_priv.h"
 #include "fluid_rvoice.h"
 #include "fluid_ladspa.h"
+#include "fluid_convrev.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -31,17 +32,37 @@ extern "C" {
 
 typedef struct _fluid_rvoice_mixer_t fluid_rvoice_mixer_t;
 
+/* Level (full scale being 1.0) below which the input and the tail of an
+ * effects unit are considered silent, i.e. -120 dB. */
+#define FLUID_MIXER_FX_SILENCE 1e-6f
+
+/*
+ * Convolution reverbs handed to the mixer by fluid_rvoice_mixer_set_reverb_convrev(),
+ * one for each of count fx groups from first (NULL restores the reverb unit).
+ * The mixer swaps them with the ones of the fx groups and then sets done, the
+ * API thread deletes the replaced ones from there.
+ */
+typedef struct
+{
+    int first;
+    int count;
+    fluid_convrev_t **convrev;
+    fluid_atomic_int_t done;
+} fluid_mixer_convrev_swap_t;
+
 int fluid_rvoice_mixer_render(fluid_rvoice_mixer_t *mixer, int blockcount);
 int fluid_rvoice_mixer_get_bufs(fluid_rvoice_mixer_t *mixer,
                                 fluid_real_t **left, fluid_real_t **right);
 int fluid_rvoice_mixer_get_fx_bufs(fluid_rvoice_mixer_t *mixer,
                                    fluid_real_t **fx_left, fluid_real_t **fx_right);
+int fluid_rvoice_mixer_is_buf_silent(fluid_rvoice_mixer_t *mixer, int index, int right);
+int fluid_rvoice_mixer_is_fx_buf_silent(fluid_rvoice_mixer_t *mixer, int index, int right);
 int fluid_rvoice_mixer_get_bufcount(fluid_rvoice_mixer_t *mixer);
 #if WITH_PROFILING
 int fluid_rvoice_mixer_get_active_voices(fluid_rvoice_mixer_t *mixer);
 #endif
 fluid_rvoice_mixer_t *new_fluid_rvoice_mixer(int buf_count, int fx_buf_count, int fx_units,
-        fluid_real_t sample_rate_max, fluid_real_t sample_rate,
+        fluid_real_t sample_rate_max, fluid_real_t sample_rate, int block_size,
         fluid_rvoice_eventhandler_t *, int, int);
 
 void delete_fluid_rvoice_mixer(fluid_rvoice_mixer_t *);
@@ -59,6 +80,12 @@ fluid_rvoice_mixer_set_chorus_full(const fluid_rvoice_mixer_t *mixer,
 double
 fluid_rvoice_mixer_chorus_get_param(const fluid_rvoice_mixer_t *mixer,
                                     int fx_group, int param);
+void
+fluid_rvoice_mixer_set_insert_fx_full(const fluid_rvoice_mixer_t *mixer,
+                                      int target, int index, int param, double value);
+double
+fluid_rvoice_mixer_insert_fx_get_param(const fluid_rvoice_mixer_t *mixer,
+                                       int target, int index, int param);
 
 
 DECLARE_FLUID_RVOICE_FUNCTION(fluid_rvoice_mixer_add_voice);
@@ -75,6 +102,8 @@ DECLARE_FLUID_RVOICE_FUNCTION(fluid_rvoice_mixer_chorus_enable);
 
 DECLARE_FLUID_RVOICE_FUNCTION(fluid_rvoice_mixer_set_chorus_params);
 DECLARE_FLUID_RVOICE_FUNCTION(fluid_rvoice_mixer_set_reverb_params);
+DECLARE_FLUID_RVOICE_FUNCTION(fluid_rvoice_mixer_set_reverb_convrev);
+DECLARE_FLUID_RVOICE_FUNCTION(fluid_rvoice_mixer_set_insert_fx_param);
 
 DECLARE_FLUID_RVOICE_FUNCTION(fluid_rvoice_mixer_reset_reverb);
 DECLARE_FLUID_RVOICE_FUNCTION(fluid_rvoice_mixer_reset_chorus);
@@ -82,6 +111,8 @@ DECLARE_FLUID_RVOICE_FUNCTION(fluid_rvoice_mixer_reset_chorus);
 
 
 void fluid_rvoice_mixer_set_mix_fx(fluid_rvoice_mixer_t *mixer, int on);
+void fluid_rvoice_mixer_set_cpu_isa(fluid_rvoice_mixer_t *mixer, int cpu_isa);
+int fluid_rvoice_mixer_get_cpu_isa(const fluid_rvoice_mixer_t *mixer);
 #ifdef LADSPA
 void fluid_rvoice_mixer_set_ladspa(fluid_rvoice_mixer_t *mixer,
                                    fluid_ladspa_fx_t *ladspa_fx, int audio_groups);
@@ -42,6 +42,7 @@ static void unload_sample(fluid_sample_t *sample);
 static int dynamic_samples_preset_notify(fluid_preset_t *preset, int reason, int chan);
 static int dynamic_samples_sample_notify(fluid_sample_t *sample, int reason);
 static int fluid_preset_zone_create_voice_zones(fluid_preset_zone_t *preset_zone);
+static int fluid_defpreset_index_zones(fluid_defpreset_t *defpreset, int count);
 static fluid_inst_t *find_inst_by_idx(fluid_defsfont_t *defsfont, int idx);
 
 
@@ -215,6 +216,7 @@ fluid_defsfont_t *new_fluid_defsfont(fluid_settings_t *settings)
 
     fluid_settings_getint(settings, "synth.lock-memory", &defsfont->mlock);
     fluid_settings_getint(settings, "synth.dynamic-sample-loading", &defsfont->dynamic_samples);
+    defsfont->float_samples = fluid_settings_str_equal(settings, "synth.sample-format", "float");
 
     return defsfont;
 }
@@ -319,7 +321,8 @@ int fluid_defsfont_load_sampledata(fluid_defsfont_t *defsfont, SFData *sfdata, f
 
     num_samples = fluid_samplecache_load(
                       sfdata, sample->source_start, sample->source_end, sample->sampletype,
-                      defsfont->mlock, &sample->data, &sample->data24);
+                      defsfont->mlock, &sample->data, &sample->data24,
+                      defsfont->float_samples ? &sample->data_float : NULL);
 
     if(num_samples < 0)
     {
@@ -368,7 +371,8 @@ int fluid_defsfont_load_all_sampledata(fluid_defsfont_t *defsfont, SFData *sfdat
         int num_samples = sfdata->samplesize / sizeof(short);
 
         read_samples = fluid_samplecache_load(sfdata, 0, num_samples - 1, 0, defsfont->mlock,
-                                              &defsfont->sampledata, &defsfont->sample24data);
+                                              &defsfont->sampledata, &defsfont->sample24data,
+                                              defsfont->float_samples ? &defsfont->samplefloat : NULL);
 
         if(read_samples != num_samples)
         {
@@ -409,6 +413,7 @@ int fluid_defsfont_load_all_sampledata(fluid_defsfont_t *defsfont, SFData *sfdat
                         }
                     }
                     fluid_voice_optimize_sample(sample);
+                    fluid_sample_build_loop_guard(sample);
                 }
             }
         }
@@ -420,6 +425,7 @@ int fluid_defsfont_load_all_sampledata(fluid_defsfont_t *defsfont, SFData *sfdat
                 /* Data pointers of SF2 samples point to large sample data block loaded above */
                 sample->data = defsfont->sampledata;
                 sample->data24 = defsfont->sample24data;
+                sample->data_float = defsfont->samplefloat;
                 modified = fluid_sample_sanitize_loop(sample, defsfont->samplesize);
                 if(modified)
                 {
@@ -429,6 +435,7 @@ int fluid_defsfont_load_all_sampledata(fluid_defsfont_t *defsfont, SFData *sfdat
                     }
                 }
                 fluid_voice_optimize_sample(sample);
+                fluid_sample_build_loop_guard(sample);
             }
         }
     }
@@ -688,6 +695,9 @@ new_fluid_defpreset(void)
     defpreset->global_zone = NULL;
     defpreset->zone = NULL;
     defpreset->pinned = FALSE;
+    defpreset->voice_zone = NULL;
+    defpreset->voice_zone_count = 0;
+    defpreset->zone_index = NULL;
     return defpreset;
 }
 
@@ -701,6 +711,9 @@ delete_fluid_defpreset(fluid_defpreset_t *defpreset)
 
     fluid_return_if_fail(defpreset != NULL);
 
+    delete_fluid_zone_index(defpreset->zone_index);
+    FLUID_FREE(defpreset->voice_zone);
+
     delete_fluid_preset_zone(defpreset->global_zone);
     defpreset->global_zone = NULL;
 
@@ -744,28 +757,21 @@ fluid_defpreset_next(fluid_defpreset_t *defpreset)
 }
 
 /*
- * Adds global and local modulators list to the voice. This is done in 2 steps:
- * - Step 1: Local modulators replace identical global modulators.
- * - Step 2: global + local modulators are added to the voice using mode.
+ * Merges global and local modulators lists (step 1 of SF 2.01 section 9.5.1):
+ * local modulators replace identical global modulators.
  *
- * Instrument zone list (local/global) must be added using FLUID_VOICE_OVERWRITE.
- * Preset zone list (local/global) must be added using FLUID_VOICE_ADD.
+ * Instrument zone list (local/global) must then be added to the voice using
+ * FLUID_VOICE_OVERWRITE, preset zone list (local/global) using FLUID_VOICE_ADD.
  *
- * @param voice voice instance.
  * @param global_mod global list of modulators.
  * @param local_mod local list of modulators.
- * @param mode Determines how to handle an existing identical modulator.
- *   #FLUID_VOICE_ADD to add (offset) the modulator amounts,
- *   #FLUID_VOICE_OVERWRITE to replace the modulator,
+ * @param mod_list array receiving the merged list.
+ * @return number of modulators in mod_list.
 */
-static void
-fluid_defpreset_noteon_add_mod_to_voice(fluid_voice_t *voice,
-                                        fluid_mod_t *global_mod, fluid_mod_t *local_mod,
-                                        int mode)
+static int
+fluid_zone_merge_mod_list(fluid_mod_t *global_mod, fluid_mod_t *local_mod,
+                          fluid_mod_t *mod_list[FLUID_NUM_MOD])
 {
-    fluid_mod_t *mod;
-    /* list for 'sorting' global/local modulators */
-    fluid_mod_t *mod_list[FLUID_NUM_MOD];
     int mod_list_count, i;
 
     /* identity_limit_count is the modulator upper limit number to handle with
@@ -773,13 +779,10 @@ fluid_defpreset_noteon_add_mod_to_voice(fluid_voice_t *voice,
      * When identity_limit_count is below the actual number of modulators, this
      * will restrict identity check to this upper limit,
      * This is useful when we know by advance that there is no duplicate with
-     * modulators at index above this limit. This avoid wasting cpu cycles at
-     * noteon.
+     * modulators at index above this limit.
      */
     int identity_limit_count;
 
-    /* Step 1: Local modulators replace identical global modulators. */
-
     /* local (instrument zone/preset zone), modulators: Put them all into a list. */
     mod_list_count = 0;
 
@@ -845,37 +848,141 @@ fluid_defpreset_noteon_add_mod_to_voice(fluid_voice_t *voice,
         global_mod = global_mod->next;
     }
 
-    /* Step 2: global + local modulators are added to the voice using mode. */
+    return mod_list_count;
+}
 
-    /*
-     * mod_list contains local and global modulators, we know that:
-     * - there is no global modulator identical to another global modulator,
-     * - there is no local modulator identical to another local modulator,
-     * So these local/global modulators are only checked against
-     * actual number of voice modulators.
-     */
+/*
+ * Compiles the voice recipe of a voice zone: everything fluid_defpreset_noteon()
+ * needs to set up a voice that doesn't depend on the note or on the synth.
+ *
+ * @param voice_zone the voice zone, its inst_zone belongs to preset_zone's instrument.
+ * @param preset_zone the preset zone holding voice_zone.
+ * @param global_preset_zone the global zone of the preset, may be NULL.
+ * @return FLUID_OK on success, FLUID_FAILED otherwise.
+ */
+static int
+fluid_voice_zone_compile(fluid_voice_zone_t *voice_zone,
+                         fluid_preset_zone_t *preset_zone,
+                         fluid_preset_zone_t *global_preset_zone)
+{
+    fluid_inst_zone_t *inst_zone = voice_zone->inst_zone;
+    fluid_inst_zone_t *global_inst_zone = fluid_inst_get_global_zone(preset_zone->inst);
+    fluid_mod_t *inst_list[FLUID_NUM_MOD];
+    fluid_mod_t *preset_list[FLUID_NUM_MOD];
+    int inst_count, preset_count, i, k;
+
+    /* Generators. The values are rounded to float the same way
+     * fluid_voice_gen_set() and fluid_voice_gen_incr() would do. */
+    voice_zone->gen_count = 0;
+
+    for(i = 0; i < GEN_LAST; i++)
+    {
+        fluid_real_t val = fluid_gen_get_default(i);
+        int set = FALSE;
+
+        /* SF 2.01 section 9.4 'bullet' 4:
+         *
+         * A generator in a local instrument zone supersedes a
+         * global instrument zone generator.  Both cases supersede
+         * the default generator. */
+        if(inst_zone->gen[i].flags)
+        {
+            val = (float)inst_zone->gen[i].val;
+            set = TRUE;
+        }
+        else if((global_inst_zone != NULL) && global_inst_zone->gen[i].flags)
+        {
+            val = (float)global_inst_zone->gen[i].val;
+            set = TRUE;
+        }
+
+        /* SF 2.01 section 9.4 'bullet' 9: A generator in a
+         * local preset zone supersedes a global preset zone
+         * generator.  The effect is -added- to the destination
+         * summing node.
+         *
+         * SF 2.01 section 8.5 page 58: If some generators are
+         * encountered at preset level, they should be ignored.
+         * Actually load_pgen() has already ignored them. */
+        if(preset_zone->gen[i].flags)
+        {
+            val += (float)preset_zone->gen[i].val;
+            set = TRUE;
+        }
+        else if((global_preset_zone != NULL) && global_preset_zone->gen[i].flags)
+        {
+            val += (float)global_preset_zone->gen[i].val;
+            set = TRUE;
+        }
+
+        if(set)
+        {
+            voice_zone->gen[voice_zone->gen_count] = (unsigned char)i;
+            voice_zone->gen_val[voice_zone->gen_count] = val;
+            voice_zone->gen_count++;
+        }
+    }
+
+    /* Modulators */
+    inst_count = fluid_zone_merge_mod_list(global_inst_zone ? global_inst_zone->mod : NULL,
+                                           inst_zone->mod, inst_list);
+    preset_count = fluid_zone_merge_mod_list(global_preset_zone ? global_preset_zone->mod : NULL,
+                                             preset_zone->mod, preset_list);
+
+    voice_zone->mod = NULL;
+    voice_zone->inst_mod_count = voice_zone->mod_count = 0;
 
-    /* Restrict identity check to the actual number of voice modulators */
-    /* Actual number of voice modulators : defaults + [instruments] */
-    identity_limit_count = voice->mod_count;
+    if(inst_count + preset_count == 0)
+    {
+        return FLUID_OK;
+    }
+
+    voice_zone->mod = FLUID_ARRAY(fluid_mod_t, inst_count + preset_count);
+
+    if(voice_zone->mod == NULL)
+    {
+        FLUID_LOG(FLUID_ERR, "Out of memory");
+        return FLUID_FAILED;
+    }
 
-    for(i = 0; i < mod_list_count; i++)
+    /* Instrument modulators -supersede- existing (default) modulators.
+       SF 2.01 page 69, 'bullet' 6.
+       In mode FLUID_VOICE_OVERWRITE disabled instruments modulators CANNOT be skipped. */
+    for(i = 0; i < inst_count; i++)
     {
+        fluid_mod_clone(&voice_zone->mod[i], inst_list[i]);
+    }
 
-        mod = mod_list[i];
-        /* in mode FLUID_VOICE_OVERWRITE disabled instruments modulators CANNOT be skipped. */
-        /* in mode FLUID_VOICE_ADD disabled preset modulators can be skipped. */
+    voice_zone->inst_mod_count = voice_zone->mod_count = inst_count;
 
-        if((mode == FLUID_VOICE_OVERWRITE) || (mod->amount != 0))
+    /* Preset modulators -add- to existing instrument modulators.
+       SF2.01 page 70 first bullet on page.
+       The ones identical to an instrument modulator are folded into it right here,
+       the others are added to the voice using FLUID_VOICE_ADD.
+       In mode FLUID_VOICE_ADD disabled preset modulators can be skipped. */
+    for(k = 0; k < preset_count; k++)
+    {
+        if(preset_list[k]->amount == 0)
         {
-            /* Instrument modulators -supersede- existing (default) modulators.
-               SF 2.01 page 69, 'bullet' 6 */
+            continue;
+        }
+
+        for(i = 0; i < inst_count; i++)
+        {
+            if(fluid_mod_test_identity(&voice_zone->mod[i], preset_list[k]))
+            {
+                voice_zone->mod[i].amount += preset_list[k]->amount;
+                break;
+            }
+        }
 
-            /* Preset modulators -add- to existing instrument modulators.
-               SF2.01 page 70 first bullet on page */
-            fluid_voice_add_mod_local(voice, mod, mode, identity_limit_count);
+        if(i >= inst_count)
+        {
+            fluid_mod_clone(&voice_zone->mod[voice_zone->mod_count++], preset_list[k]);
         }
     }
+
+    return FLUID_OK;
 }
 
 /*
@@ -884,14 +991,13 @@ fluid_defpreset_noteon_add_mod_to_voice(fluid_voice_t *voice,
 int
 fluid_defpreset_noteon(fluid_defpreset_t *defpreset, fluid_synth_t *synth, int chan, int key, int vel)
 {
-    fluid_preset_zone_t *preset_zone, *global_preset_zone;
-    fluid_inst_t *inst;
-    fluid_inst_zone_t *inst_zone, *global_inst_zone;
+    fluid_inst_zone_t *inst_zone;
     fluid_voice_zone_t *voice_zone;
-    fluid_list_t *list;
     fluid_voice_t *voice;
+    const int *entry;
     int tuned_key;
-    int i;
+    int default_mod_count;
+    int count, i, k;
 
     /* For detuned channels it might be better to use another key for Soundfont sample selection
      * giving better approximations for the pitch than the original key.
@@ -910,148 +1016,80 @@ fluid_defpreset_noteon(fluid_defpreset_t *defpreset, fluid_synth_t *synth, int c
         tuned_key = key;
     }
 
-    global_preset_zone = fluid_defpreset_get_global_zone(defpreset);
+    /* run thru the voice zones that could play this key. A voice zone range is the
+     * intersection of the ranges of its preset and instrument zones. */
+    count = fluid_zone_index_lookup(defpreset->zone_index, tuned_key, &entry);
 
-    /* run thru all the zones of this preset */
-    preset_zone = fluid_defpreset_get_zone(defpreset);
-
-    while(preset_zone != NULL)
+    for(k = 0; k < count; k++)
     {
+        voice_zone = defpreset->voice_zone[entry[k]];
 
-        /* check if the note falls into the key and velocity range of this
-           preset */
-        if(fluid_zone_inside_range(&preset_zone->range, tuned_key, vel))
+        /* check if the instrument zone is ignored and the note falls into
+           the key and velocity range of this  instrument zone.
+           An instrument zone must be ignored when its voice is already running
+           played by a legato passage (see fluid_synth_noteon_monopoly_legato()) */
+        if(fluid_zone_inside_range(&voice_zone->range, tuned_key, vel))
         {
 
-            inst = fluid_preset_zone_get_inst(preset_zone);
-            global_inst_zone = fluid_inst_get_global_zone(inst);
-
-            /* run thru all the zones of this instrument that could start a voice */
-            for(list = preset_zone->voice_zone; list != NULL; list = fluid_list_next(list))
-            {
-                voice_zone = fluid_list_get(list);
-
-                /* check if the instrument zone is ignored and the note falls into
-                   the key and velocity range of this  instrument zone.
-                   An instrument zone must be ignored when its voice is already running
-                   played by a legato passage (see fluid_synth_noteon_monopoly_legato()) */
-                if(fluid_zone_inside_range(&voice_zone->range, tuned_key, vel))
-                {
-
-                    inst_zone = voice_zone->inst_zone;
+            inst_zone = voice_zone->inst_zone;
 
-                    /* this is a good zone. allocate a new synthesis process and initialize it */
-                    voice = fluid_synth_alloc_voice_LOCAL(synth, inst_zone->sample, chan, key, vel, &voice_zone->range);
+            /* this is a good zone. allocate a new synthesis process and initialize it */
+            voice = fluid_synth_alloc_voice_LOCAL(synth, inst_zone->sample, chan, key, vel, &voice_zone->range);
 
-                    if(voice == NULL)
-                    {
-                        return FLUID_FAILED;
-                    }
+            if(voice == NULL)
+            {
+                return FLUID_FAILED;
+            }
 
 
-                    /* Instrument level, generators */
+            /* Generators of the instrument and preset zones, see fluid_voice_zone_compile() */
+            fluid_voice_set_gens(voice, voice_zone->gen, voice_zone->gen_val, voice_zone->gen_count);
 
-                    for(i = 0; i < GEN_LAST; i++)
-                    {
-                        /* SF 2.01 section 9.4 'bullet' 4:
-                         *
-                         * A generator in a local instrument zone supersedes a
-                         * global instrument zone generator.  Both cases supersede
-                         * the default generator -> voice_gen_set */
+            /* ...unless the default value has been overridden by an AWE32 NRPN */
+            for(i = 0; i < GEN_LAST; i++)
+            {
+                fluid_real_t awe_val;
 
-                        if(inst_zone->gen[i].flags)
-                        {
-                            fluid_voice_gen_set(voice, i, inst_zone->gen[i].val);
+                if(fluid_channel_get_override_gen_default(synth->channel[chan], i, &awe_val))
+                {
+                    fluid_voice_gen_set(voice, i, awe_val);
+                }
+            }
 
-                        }
-                        else if((global_inst_zone != NULL) && (global_inst_zone->gen[i].flags))
-                        {
-                            fluid_voice_gen_set(voice, i, global_inst_zone->gen[i].val);
+            /* Adds instrument and preset zone modulators (global and local) to the voice.
+             * They are only checked for identity against the default modulators, there
+             * are no duplicates among them (see fluid_voice_zone_compile()). */
+            default_mod_count = voice->mod_count;
 
-                        }
-                        else
-                        {
-                            /* The generator has not been defined in this instrument.
-                             * Do nothing, leave it at the default.
-                             */
-                        }
-                    } /* for all generators */
+            for(i = 0; i < voice_zone->mod_count; i++)
+            {
+                fluid_voice_add_mod_local(voice, &voice_zone->mod[i],
+                                          (i < voice_zone->inst_mod_count) ? FLUID_VOICE_OVERWRITE : FLUID_VOICE_ADD,
+                                          default_mod_count);
+            }
 
-                    /* Adds instrument zone modulators (global and local) to the voice.*/
-                    fluid_defpreset_noteon_add_mod_to_voice(voice,
-                                                            /* global instrument modulators */
-                                                            global_inst_zone ? global_inst_zone->mod : NULL,
-                                                            inst_zone->mod, /* local instrument modulators */
-                                                            FLUID_VOICE_OVERWRITE); /* mode */
+            /* add the synthesis process to the synthesis loop. */
+            fluid_synth_start_voice(synth, voice);
 
-                    /* Preset level, generators */
+            /* Store the ID of the first voice that was created by this noteon event.
+             * Exclusive class may only terminate older voices.
+             * That avoids killing voices, which have just been created.
+             * (a noteon event can create several voice processes with the same exclusive
+             * class - for example when using stereo samples)
+             */
+        }
+    }
 
-                    for(i = 0; i < GEN_LAST; i++)
-                    {
-                        fluid_real_t awe_val;
-                        /* SF 2.01 section 8.5 page 58: If some generators are
-                         encountered at preset level, they should be ignored.
-                         However this check is not necessary when the soundfont
-                         loader has ignored invalid preset generators.
-                         Actually load_pgen()has ignored these invalid preset
-                         generators:
-                           GEN_STARTADDROFS,      GEN_ENDADDROFS,
-                           GEN_STARTLOOPADDROFS,  GEN_ENDLOOPADDROFS,
-                           GEN_STARTADDRCOARSEOFS,GEN_ENDADDRCOARSEOFS,
-                           GEN_STARTLOOPADDRCOARSEOFS,
-                           GEN_KEYNUM, GEN_VELOCITY,
-                           GEN_ENDLOOPADDRCOARSEOFS,
-                           GEN_SAMPLEMODE, GEN_EXCLUSIVECLASS,GEN_OVERRIDEROOTKEY
-                        */
-
-                        /* SF 2.01 section 9.4 'bullet' 9: A generator in a
-                         * local preset zone supersedes a global preset zone
-                         * generator.  The effect is -added- to the destination
-                         * summing node -> voice_gen_incr */
-
-                        if(preset_zone->gen[i].flags)
-                        {
-                            fluid_voice_gen_incr(voice, i, preset_zone->gen[i].val);
-                        }
-                        else if((global_preset_zone != NULL) && global_preset_zone->gen[i].flags)
-                        {
-                            fluid_voice_gen_incr(voice, i, global_preset_zone->gen[i].val);
-                        }
-                        else
-                        {
-                            /* The generator has not been defined in this preset
-                             * Do nothing, leave it unchanged.
-                             */
-                        }
+    /* The legato code marks the zones to ignore by the untuned key, don't leave
+     * a mark behind on a zone that the tuned key didn't visit. */
+    if(tuned_key != key)
+    {
+        count = fluid_zone_index_lookup(defpreset->zone_index, key, &entry);
 
-                        /* ...unless the default value has been overridden by an AWE32 NRPN */
-                        if (fluid_channel_get_override_gen_default(synth->channel[chan], i, &awe_val))
-                        {
-                            fluid_voice_gen_set(voice, i, awe_val);
-                        }
-                    } /* for all generators */
-
-                    /* Adds preset zone modulators (global and local) to the voice.*/
-                    fluid_defpreset_noteon_add_mod_to_voice(voice,
-                                                            /* global preset modulators */
-                                                            global_preset_zone ? global_preset_zone->mod : NULL,
-                                                            preset_zone->mod, /* local preset modulators */
-                                                            FLUID_VOICE_ADD); /* mode */
-
-                    /* add the synthesis process to the synthesis loop. */
-                    fluid_synth_start_voice(synth, voice);
-
-                    /* Store the ID of the first voice that was created by this noteon event.
-                     * Exclusive class may only terminate older voices.
-                     * That avoids killing voices, which have just been created.
-                     * (a noteon event can create several voice processes with the same exclusive
-                     * class - for example when using stereo samples)
-                     */
-                }
-            }
+        for(k = 0; k < count; k++)
+        {
+            defpreset->voice_zone[entry[k]]->range.ignore = FALSE;
         }
-
-        preset_zone = fluid_preset_zone_next(preset_zone);
     }
 
     return FLUID_OK;
@@ -1127,7 +1165,62 @@ fluid_defpreset_import_sfont(fluid_defpreset_t *defpreset,
         count++;
     }
 
-    return FLUID_OK;
+    /* Now that all zones and their modulators are known, compile the voice recipes */
+    count = 0;
+
+    for(zone = defpreset->zone; zone != NULL; zone = fluid_preset_zone_next(zone))
+    {
+        for(p = zone->voice_zone; p != NULL; p = fluid_list_next(p))
+        {
+            if(fluid_voice_zone_compile(fluid_list_get(p), zone, defpreset->global_zone) != FLUID_OK)
+            {
+                return FLUID_FAILED;
+            }
+
+            count++;
+        }
+    }
+
+    return fluid_defpreset_index_zones(defpreset, count);
+}
+
+/*
+ * Collects the voice zones of all preset zones into an array and indexes them by key,
+ * so that fluid_defpreset_noteon() doesn't have to walk the zone lists.
+ */
+static int
+fluid_defpreset_index_zones(fluid_defpreset_t *defpreset, int count)
+{
+    fluid_preset_zone_t *zone;
+    fluid_zone_range_t **ranges;
+    fluid_list_t *p;
+    int i = 0;
+
+    defpreset->voice_zone = FLUID_ARRAY(fluid_voice_zone_t *, count + 1);
+    ranges = FLUID_ARRAY(fluid_zone_range_t *, count + 1);
+
+    if(defpreset->voice_zone == NULL || ranges == NULL)
+    {
+        FLUID_LOG(FLUID_ERR, "Out of memory");
+        FLUID_FREE(ranges);
+        return FLUID_FAILED;
+    }
+
+    for(zone = defpreset->zone; zone != NULL; zone = fluid_preset_zone_next(zone))
+    {
+        for(p = zone->voice_zone; p != NULL; p = fluid_list_next(p))
+        {
+            defpreset->voice_zone[i] = fluid_list_get(p);
+            ranges[i] = &defpreset->voice_zone[i]->range;
+            i++;
+        }
+    }
+
+    defpreset->voice_zone_count = count;
+    defpreset->zone_index = new_fluid_zone_index(ranges, count);
+    FLUID_FREE(ranges);
+
+    return (defpreset->zone_index != NULL) ? FLUID_OK : FLUID_FAILED;
 }
 
 /*
@@ -1237,7 +1330,10 @@ delete_fluid_preset_zone(fluid_preset_zone_t *zone)
 
     for(list = zone->voice_zone; list != NULL; list = fluid_list_next(list))
     {
-        FLUID_FREE(fluid_list_get(list));
+        fluid_voice_zone_t *voice_zone = fluid_list_get(list);
+
+        FLUID_FREE(voice_zone->mod);
+        FLUID_FREE(voice_zone);
     }
 
     delete_fluid_list(zone->voice_zone);
@@ -1280,6 +1376,9 @@ static int fluid_preset_zone_create_voice_zones(fluid_preset_zone_t *preset_zone
         }
 
         voice_zone->inst_zone = inst_zone;
+        voice_zone->gen_count = 0;
+        voice_zone->mod = NULL;
+        voice_zone->inst_mod_count = voice_zone->mod_count = 0;
 
         irange = &inst_zone->range;
 
@@ -2062,6 +2161,105 @@ fluid_zone_inside_range(fluid_zone_range_t *range, int key, int vel)
                             (range->velhi >= vel));
 }
 
+/* the keys of a zone range that are part of the zone index table */
+static void
+fluid_zone_index_keys(const fluid_zone_range_t *range, int *lo, int *hi)
+{
+    *lo = (range->keylo > 0) ? range->keylo : 0;
+    *hi = (range->keyhi < FLUID_ZONE_INDEX_KEYS - 1) ? range->keyhi : FLUID_ZONE_INDEX_KEYS - 1;
+}
+
+/*
+ * new_fluid_zone_index
+ *
+ * @param ranges the key and velocity ranges of the zones of a preset.
+ * @param count number of zones.
+ * @return the zone index, NULL if out of memory.
+ */
+fluid_zone_index_t *
+new_fluid_zone_index(fluid_zone_range_t *const *ranges, int count)
+{
+    fluid_zone_index_t *index;
+    int fill[FLUID_ZONE_INDEX_KEYS + 1];
+    int i, key, lo, hi, total = count;
+
+    FLUID_MEMSET(fill, 0, sizeof(fill));
+
+    /* count the zones of every key, the last list holds all of them */
+    for(i = 0; i < count; i++)
+    {
+        fluid_zone_index_keys(ranges[i], &lo, &hi);
+
+        for(key = lo; key <= hi; key++)
+        {
+            fill[key]++;
+            total++;
+        }
+    }
+
+    fill[FLUID_ZONE_INDEX_KEYS] = count;
+
+    index = FLUID_MALLOC(sizeof(fluid_zone_index_t) + total * sizeof(int));
+
+    if(index == NULL)
+    {
+        FLUID_LOG(FLUID_ERR, "Out of memory");
+        return NULL;
+    }
+
+    index->entry = (int *)(index + 1);
+    index->start[0] = 0;
+
+    for(key = 0; key <= FLUID_ZONE_INDEX_KEYS; key++)
+    {
+        index->start[key + 1] = index->start[key] + fill[key];
+        fill[key] = index->start[key];
+    }
+
+    /* zones are added in their order, as the lists must keep it */
+    for(i = 0; i < count; i++)
+    {
+        fluid_zone_index_keys(ranges[i], &lo, &hi);
+
+        for(key = lo; key <= hi; key++)
+        {
+            index->entry[fill[key]++] = i;
+        }
+
+        index->entry[fill[FLUID_ZONE_INDEX_KEYS]++] = i;
+    }
+
+    return index;
+}
+
+void
+delete_fluid_zone_index(fluid_zone_index_t *index)
+{
+    FLUID_FREE(index);
+}
+
+/*
+ * Gets the zones that could play a key, they still need to be checked with
+ * fluid_zone_inside_range().
+ *
+ * @param index the zone index.
+ * @param key the key (any value).
+ * @param entry receives the list of zones, as indices into the zone array of the preset.
+ * @return the number of zones in the list.
+ */
+int
+fluid_zone_index_lookup(const fluid_zone_index_t *index, int key, const int **entry)
+{
+    if(key < 0 || key >= FLUID_ZONE_INDEX_KEYS)
+    {
+        key = FLUID_ZONE_INDEX_KEYS;
+    }
+
+    *entry = &index->entry[index->start[key]];
+
+    return index->start[key + 1] - index->start[key];
+}
+
 /***************************************************************
  *
  *                           SAMPLE
@@ -2259,6 +2457,7 @@ static int load_preset_samples(fluid_defsfont_t *defsfont, fluid_preset_t *prese
                     {
                         fluid_sample_sanitize_loop(sample, (sample->end + 1) * sizeof(short));
                         fluid_voice_optimize_sample(sample);
+                        fluid_sample_build_loop_guard(sample);
                     }
                     else
                     {
@@ -2347,6 +2546,8 @@ static void unload_sample(fluid_sample_t *sample)
     {
         sample->data = NULL;
         sample->data24 = NULL;
+        sample->data_float = NULL;
+        fluid_sample_free_loop_guard(sample);
     }
 }
 
@@ -74,6 +74,18 @@ struct _fluid_voice_zone_t
 {
     fluid_inst_zone_t *inst_zone;
     fluid_zone_range_t range;
+
+    /* The voice recipe, compiled once the preset has been loaded (see fluid_voice_zone_compile()):
+     * the generators set by the instrument and preset zones with their final values ... */
+    int gen_count;
+    unsigned char gen[GEN_LAST];
+    fluid_real_t gen_val[GEN_LAST];
+
+    /* ... and the modulators of both zones. mod[0 .. inst_mod_count) supersede the
+     * default modulators, mod[inst_mod_count .. mod_count) add to them. */
+    fluid_mod_t *mod;
+    int inst_mod_count;
+    int mod_count;
 };
 
 /*
@@ -100,6 +112,23 @@ int fluid_defpreset_preset_noteon(fluid_preset_t *preset, fluid_synth_t *synth,
 
 int fluid_zone_inside_range(fluid_zone_range_t *zone_range, int key, int vel);
 
+/* Number of keys having their own list of zones in a zone index */
+#define FLUID_ZONE_INDEX_KEYS 128
+
+/* Key lookup table of the zones of a preset, built once at load time.
+ * The zones that could play key k are entry[start[k] .. start[k + 1]), given as
+ * indices into the zone array of the preset and in the same order. Keys outside
+ * of the table use the last list, which holds all zones. */
+typedef struct _fluid_zone_index_t
+{
+    int start[FLUID_ZONE_INDEX_KEYS + 2];
+    int *entry;
+} fluid_zone_index_t;
+
+fluid_zone_index_t *new_fluid_zone_index(fluid_zone_range_t *const *ranges, int count);
+void delete_fluid_zone_index(fluid_zone_index_t *index);
+int fluid_zone_index_lookup(const fluid_zone_index_t *index, int key, const int **entry);
+
 /*
  * fluid_defsfont_t
  */
@@ -114,6 +143,7 @@ struct _fluid_defsfont_t
     unsigned int sample24pos;       /* position within sffd of the sm24 chunk, set to zero if no 24 bit sample support */
     unsigned int sample24size;      /* length within sffd of the sm24 chunk */
     char *sample24data;        /* if not NULL, the least significant byte of the 24bit sample data, loaded in ram */
+    float *samplefloat;        /* if not NULL, the sample data converted to float (synth.sample-format=float) */
 
     fluid_sfont_t *sfont;           /* pointer to parent sfont */
     fluid_list_t *sample;           /* the samples in this soundfont */
@@ -121,6 +151,7 @@ struct _fluid_defsfont_t
     fluid_list_t *inst;             /* the instruments of this soundfont */
     int mlock;                      /* Should we try memlock (avoid swapping)? */
     int dynamic_samples;            /* Enables dynamic sample loading if set */
+    int float_samples;              /* Keep a pre-converted float copy of the sample data if set */
 
     fluid_list_t *preset_iter_cur;       /* the current preset in the iteration */
 };
@@ -152,6 +183,10 @@ struct _fluid_defpreset_t
     fluid_preset_zone_t *global_zone;        /* the global zone of the preset */
     fluid_preset_zone_t *zone;               /* the chained list of preset zones */
     int pinned;                           /* preset samples pinned to sample cache? */
+
+    fluid_voice_zone_t **voice_zone;      /* the voice zones of all preset zones, in order */
+    int voice_zone_count;
+    fluid_zone_index_t *zone_index;       /* the voice zones that could play a key */
 };
 
 fluid_defpreset_t *new_fluid_defpreset(void);
@@ -38,6 +38,7 @@
 #include <limits>
 #include <string>
 #include <array>
+#include <memory>
 
 using std::int16_t;
 using std::int32_t;
@@ -327,6 +328,28 @@ struct fluid_dls_region
     fluid_real_t gain_inherited{};        // gain from sample's wsmp, in cB
 };
 
+// frees the unrolled loop buffers of a list of samples, see fluid_sample_build_loop_guard()
+struct fluid_sample_loop_guards
+{
+    std::vector<fluid_sample_t> &samples;
+
+    ~fluid_sample_loop_guards() noexcept
+    {
+        for(auto &sample : samples)
+        {
+            fluid_sample_free_loop_guard(&sample);
+        }
+    }
+};
+
+struct fluid_zone_index_deleter
+{
+    void operator()(fluid_zone_index_t *index) const noexcept
+    {
+        delete_fluid_zone_index(index);
+    }
+};
+
 // SF2's instrument level does not exist in DLS, preset is called instrument in DLS
 struct fluid_dls_instrument
 {
@@ -337,6 +360,8 @@ struct fluid_dls_instrument
 
     std::string name;
     std::vector<fluid_dls_region> regions;
+    // the regions that could play a key, built once all regions are known
+    std::unique_ptr<fluid_zone_index_t, fluid_zone_index_deleter> zone_index;
 
     fluid_sample_t *samples_fluid;
     fluid_dls_articulation *articulations;
@@ -401,6 +426,8 @@ struct fluid_dls_font
     // this MUST NOT be modified after initialization, because of probable mlock
     std::vector<int16_t> sampledata;
     mlock_guard sampledata_mlock;
+    // if not empty, sampledata converted to float (synth.sample-format=float), same restrictions as sampledata
+    std::vector<float> samplefloat;
     std::vector<uint32_t> poolcues; // data of ptbl
 
     std::vector<fluid_dls_sample> samples;
@@ -412,6 +439,8 @@ struct fluid_dls_font
     std::vector<fluid_dls_instrument_fluid_data> instruments_fluid_data;
     // this MUST NOT be modified after initialization, because of instrument.samples_fluid pointer
     std::vector<fluid_sample_t> samples_fluid;
+    // frees the unrolled loops of samples_fluid, declared after it to be destroyed first
+    fluid_sample_loop_guards samples_fluid_loop_guards{ samples_fluid };
 
     // for 'pgal' chunk in MobileBAE DLS banks
     std::optional<std::array<uint8_t, 128>> drum_note_aliasing;
@@ -428,7 +457,8 @@ struct fluid_dls_font
                           const fluid_file_callbacks_t *fcbs,
                           const char *filename,
                           uint32_t output_sample_rate,
-                          bool try_mlock);
+                          bool try_mlock,
+                          bool float_samples);
 
     fluid_dls_font(const fluid_dls_font &) = delete;
     fluid_dls_font &operator=(const fluid_dls_font &) = delete;
@@ -1459,7 +1489,8 @@ fluid_dls_font::fluid_dls_font(fluid_synth_t *synth,
                                const fluid_file_callbacks_t *fcbs,
                                const char *filename,
                                uint32_t output_sample_rate,
-                               bool try_mlock)
+                               bool try_mlock,
+                               bool float_samples)
     : synth(synth), sfont(sfont), fcbs(fcbs), output_sample_rate(output_sample_rate), filename(filename)
 {
     // Get basic file information
@@ -1654,6 +1685,17 @@ fluid_dls_font::fluid_dls_font(fluid_synth_t *synth,
         }
     }
 
+    if(float_samples)
+    {
+        // keep the scale the dsp kernels use for 16 bit samples, see fluid_rvoice_get_sample16()
+        samplefloat.reserve(sampledata.size());
+
+        for(auto value : sampledata)
+        {
+            samplefloat.push_back(static_cast<float>(static_cast<int32_t>(static_cast<uint32_t>(value) << 8)));
+        }
+    }
+
     // Parse LIST[lins]
     try
     {
@@ -1724,8 +1766,12 @@ fluid_dls_font::fluid_dls_font(fluid_synth_t *synth,
         }
 
         fluid.data = sampledata.data();
+        fluid.data_float = samplefloat.empty() ? nullptr : samplefloat.data();
         fluid.sampletype = FLUID_SAMPLETYPE_MONO;
         fluid.default_modulators = this->sfont->default_mod_list;
+
+        // unroll short loops, failing to do so only costs performance
+        fluid_sample_build_loop_guard(&fluid);
     }
 
     // put info in dls_sample into region
@@ -1817,6 +1863,21 @@ fluid_dls_font::fluid_dls_font(fluid_synth_t *synth,
             instrument.drum_note_aliasing = nullptr;
         }
 
+        std::vector<fluid_zone_range_t *> ranges;
+        ranges.reserve(instrument.regions.size());
+
+        for(auto &region : instrument.regions)
+        {
+            ranges.push_back(&region.range);
+        }
+
+        instrument.zone_index.reset(new_fluid_zone_index(ranges.data(), static_cast<int>(ranges.size())));
+
+        if(instrument.zone_index == nullptr)
+        {
+            throw std::bad_alloc{};
+        }
+
         auto &self_data = instruments_fluid_data.emplace_back();
         self_data.banklsb = instrument.banklsb;
         self_data.bankmsb = instrument.bankmsb;
@@ -3038,6 +3099,7 @@ static fluid_sfont_t *fluid_dls_loader_load(fluid_sfloader_t *loader, const char
 
     uint32_t sample_rate = 44100;
     bool try_mlock = false;
+    bool float_samples = false;
     auto *sfloader_data = static_cast<fluid_dls_loader_data *>(fluid_sfloader_get_data(loader));
     auto *settings = sfloader_data->settings;
 
@@ -3056,10 +3118,13 @@ static fluid_sfont_t *fluid_dls_loader_load(fluid_sfloader_t *loader, const char
         {
             try_mlock = mlock != 0;
         }
+
+        float_samples = fluid_settings_str_equal(settings, "synth.sample-format", "float") != 0;
     }
 
     auto *dlsfont =
-        new_fluid_dls_font(sfloader_data->synth, sfont, &loader->file_callbacks, filename, sample_rate, try_mlock);
+        new_fluid_dls_font(sfloader_data->synth, sfont, &loader->file_callbacks, filename, sample_rate, try_mlock,
+                           float_samples);
 
     if(dlsfont == nullptr)
     {
@@ -3226,8 +3291,13 @@ static int fluid_dls_preset_noteon(fluid_preset_t *preset, fluid_synth_t *synth,
     // key with only key number generator applied
     const int adjusted_key = static_cast<int>(std::round(key * dlspreset->keynum_scale));
 
-    for(auto &region : dlspreset->regions)
+    const int *entry;
+    const int count = fluid_zone_index_lookup(dlspreset->zone_index.get(), tuned_key, &entry);
+
+    for(int k = 0; k < count; k++)
     {
+        auto &region = dlspreset->regions[entry[k]];
+
         if(!fluid_zone_inside_range(&region.range, tuned_key, vel))
         {
             continue;
@@ -3317,6 +3387,18 @@ static int fluid_dls_preset_noteon(fluid_preset_t *preset, fluid_synth_t *synth,
         fluid_synth_start_voice(synth, voice);
     }
 
+    // the legato code marks the regions to ignore by the untuned key, don't leave
+    // a mark behind on a region that the tuned key didn't visit
+    if(tuned_key != key)
+    {
+        const int untuned_count = fluid_zone_index_lookup(dlspreset->zone_index.get(), key, &entry);
+
+        for(int k = 0; k < untuned_count; k++)
+        {
+            dlspreset->regions[entry[k]].range.ignore = FALSE;
+        }
+    }
+
     return FLUID_OK;
 }
 
@@ -51,8 +51,13 @@ struct _fluid_samplecache_entry_t
     short *sample_data;
     char *sample_data24;
 
+    /* Pre-converted float copy of the sample data, only created on request */
+    float *sample_data_float_unaligned;
+    float *sample_data_float;
+
     int num_references;
     int mlocked;
+    int float_mlocked;
 };
 
 static fluid_list_t *samplecache_list = NULL;
@@ -65,13 +70,22 @@ static fluid_samplecache_entry_t *get_samplecache_entry(SFData *sf, unsigned int
 static void delete_samplecache_entry(fluid_samplecache_entry_t *entry);
 
 static int fluid_get_file_modification_time(char *filename, time_t *modification_time);
+static int fluid_samplecache_entry_convert_float(fluid_samplecache_entry_t *entry);
 
 
 /* PUBLIC INTERFACE */
 
+/*
+ * Returns the number of samples loaded, or -1 on error.
+ *
+ * If sample_data_float is not NULL, a copy of the sample data pre-converted to
+ * float is created (and shared across all users of this cache entry) as well.
+ * *sample_data_float is set to NULL if that copy could not be created.
+ */
 int fluid_samplecache_load(SFData *sf,
                            unsigned int sample_start, unsigned int sample_end, int sample_type,
-                           int try_mlock, short **sample_data, char **sample_data24)
+                           int try_mlock, short **sample_data, char **sample_data24,
+                           float **sample_data_float)
 {
     fluid_samplecache_entry_t *entry;
     int ret;
@@ -100,6 +114,13 @@ int fluid_samplecache_load(SFData *sf,
         fluid_mutex_lock(samplecache_mutex);
         samplecache_list = fluid_list_prepend(samplecache_list, entry);
     }
+
+    if(sample_data_float != NULL && entry->sample_data_float == NULL)
+    {
+        /* If this fails, the sample is still usable in its integer format */
+        fluid_samplecache_entry_convert_float(entry);
+    }
+
         fluid_mutex_unlock(samplecache_mutex);
 
     if(try_mlock && !entry->mlocked)
@@ -125,9 +146,20 @@ int fluid_samplecache_load(SFData *sf,
         }
     }
 
+    if(try_mlock && entry->sample_data_float != NULL && !entry->float_mlocked)
+    {
+        entry->float_mlocked = (fluid_mlock(entry->sample_data_float, entry->sample_count * sizeof(float)) == 0);
+    }
+
     entry->num_references++;
     *sample_data = entry->sample_data;
     *sample_data24 = entry->sample_data24;
+
+    if(sample_data_float != NULL)
+    {
+        *sample_data_float = entry->sample_data_float;
+    }
+
     ret = entry->sample_count;
 
 unlock_exit:
@@ -164,6 +196,11 @@ int fluid_samplecache_unload(const short *sample_data)
                     }
                 }
 
+                if(entry->float_mlocked)
+                {
+                    fluid_munlock(entry->sample_data_float, entry->sample_count * sizeof(float));
+                }
+
                 samplecache_list = fluid_list_remove(samplecache_list, entry);
                 delete_samplecache_entry(entry);
             }
@@ -242,9 +279,46 @@ static void delete_samplecache_entry(fluid_samplecache_entry_t *entry)
     FLUID_FREE(entry->filename);
     FLUID_FREE(entry->sample_data);
     FLUID_FREE(entry->sample_data24);
+    FLUID_FREE(entry->sample_data_float_unaligned);
     FLUID_FREE(entry);
 }
 
+/* Convert the 16 (or 24) bit sample data of a cache entry to float. The values
+ * keep the scale used by the dsp kernels, i.e. 24 bit integers, which are
+ * exactly representable in single precision. */
+static int fluid_samplecache_entry_convert_float(fluid_samplecache_entry_t *entry)
+{
+    int i;
+    float *data_float;
+
+    if(entry->sample_count <= 0)
+    {
+        return FLUID_OK;
+    }
+
+    entry->sample_data_float_unaligned = FLUID_ARRAY_ALIGNED(float, entry->sample_count, FLUID_DEFAULT_ALIGNMENT);
+
+    if(entry->sample_data_float_unaligned == NULL)
+    {
+        FLUID_LOG(FLUID_ERR, "Out of memory");
+        return FLUID_FAILED;
+    }
+
+    data_float = fluid_align_ptr(entry->sample_data_float_unaligned, FLUID_DEFAULT_ALIGNMENT);
+
+    for(i = 0; i < entry->sample_count; i++)
+    {
+        /* see fluid_rvoice_get_sample24() */
+        uint32_t msb = (uint32_t)entry->sample_data[i];
+        uint8_t lsb = entry->sample_data24 != NULL ? (uint8_t)entry->sample_data24[i] : 0;
+
+        data_float[i] = (float)(int32_t)((msb << 8) | lsb);
+    }
+
+    entry->sample_data_float = data_float;
+    return FLUID_OK;
+}
+
 static fluid_samplecache_entry_t *get_samplecache_entry(SFData *sf,
         unsigned int sample_start,
         unsigned int sample_end,
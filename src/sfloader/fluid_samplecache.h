@@ -26,7 +26,7 @@
 
 int fluid_samplecache_load(SFData *sf,
                            unsigned int sample_start, unsigned int sample_end, int sample_type,
-                           int try_mlock, short **data, char **data24);
+                           int try_mlock, short **data, char **data24, float **data_float);
 
 int fluid_samplecache_unload(const short *sample_data);
 
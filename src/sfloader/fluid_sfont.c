@@ -626,9 +626,85 @@ delete_fluid_sample(fluid_sample_t *sample)
         FLUID_FREE(sample->data24);
     }
 
+    fluid_sample_free_loop_guard(sample);
     FLUID_FREE(sample);
 }
 
+/*
+ * Creates the unrolled loop buffer of a sample with a short loop.
+ *
+ * The loop is repeated until it spans at least FLUID_LOOP_GUARD_SIZE points
+ * and FLUID_LOOP_GUARD_PAD guard points are added on either side, which hold
+ * the points that precede and follow them when the loop wraps around. The
+ * interpolators can then render a looping voice from this buffer without
+ * checking for the loop end on every output sample, see
+ * fluid_rvoice_dsp_interpolate().
+ *
+ * Samples with long loops, i.e. ones that rarely wrap within a block, are left
+ * alone. Failing to create the buffer is not an error, the voices simply use
+ * the sample data directly.
+ *
+ * @return #FLUID_OK on success, #FLUID_FAILED if out of memory
+ */
+int
+fluid_sample_build_loop_guard(fluid_sample_t *sample)
+{
+    unsigned int loop_len, size, i;
+    float *guard;
+
+    fluid_sample_free_loop_guard(sample);
+
+    if(sample->data == NULL
+            || sample->loopstart < sample->start
+            || sample->loopend <= sample->loopstart
+            || sample->loopend > sample->end + 1)
+    {
+        return FLUID_OK;
+    }
+
+    loop_len = sample->loopend - sample->loopstart;
+
+    if(loop_len >= FLUID_LOOP_GUARD_SIZE)
+    {
+        return FLUID_OK;
+    }
+
+    size = (FLUID_LOOP_GUARD_SIZE + loop_len - 1) / loop_len * loop_len;
+    guard = FLUID_ARRAY(float, size + 2 * FLUID_LOOP_GUARD_PAD);
+
+    if(guard == NULL)
+    {
+        FLUID_LOG(FLUID_ERR, "Out of memory");
+        return FLUID_FAILED;
+    }
+
+    for(i = 0; i < size + 2 * FLUID_LOOP_GUARD_PAD; i++)
+    {
+        /* loop point for index i - FLUID_LOOP_GUARD_PAD, see fluid_rvoice_get_sample24() */
+        unsigned int idx = sample->loopstart + (i + loop_len * FLUID_LOOP_GUARD_PAD - FLUID_LOOP_GUARD_PAD) % loop_len;
+        uint32_t msb = (uint32_t)sample->data[idx];
+        uint8_t lsb = sample->data24 != NULL ? (uint8_t)sample->data24[idx] : 0;
+
+        guard[i] = (float)(int32_t)((msb << 8) | lsb);
+    }
+
+    sample->loop_guard = guard;
+    sample->loop_guard_size = size;
+    return FLUID_OK;
+}
+
+/*
+ * Frees the unrolled loop buffer of a sample, if any. Must be called whenever the
+ * sample data or the loop points change.
+ */
+void
+fluid_sample_free_loop_guard(fluid_sample_t *sample)
+{
+    FLUID_FREE(sample->loop_guard);
+    sample->loop_guard = NULL;
+    sample->loop_guard_size = 0;
+}
+
 /**
  * Returns the size of the fluid_sample_t structure.
  *
@@ -700,6 +776,8 @@ fluid_sample_set_sound_data(fluid_sample_t *sample,
 
     sample->data = NULL;
     sample->data24 = NULL;
+    sample->data_float = NULL;
+    fluid_sample_free_loop_guard(sample);
 
     if(copy_data)
     {
@@ -783,6 +861,7 @@ int fluid_sample_set_loop(fluid_sample_t *sample, unsigned int loop_start, unsig
 
     sample->loopstart = loop_start;
     sample->loopend = loop_end;
+    fluid_sample_free_loop_guard(sample);
 
     return FLUID_OK;
 }
@@ -28,6 +28,16 @@ extern "C" {
 #endif
 int fluid_sample_validate(fluid_sample_t *sample, unsigned int max_end);
 int fluid_sample_sanitize_loop(fluid_sample_t *sample, unsigned int max_end);
+int fluid_sample_build_loop_guard(fluid_sample_t *sample);
+void fluid_sample_free_loop_guard(fluid_sample_t *sample);
+
+/*
+ * Loop guard buffers: the loop of a sample unrolled to at least
+ * FLUID_LOOP_GUARD_SIZE points, with FLUID_LOOP_GUARD_PAD wrapped points on
+ * either side, see fluid_sample_build_loop_guard().
+ */
+#define FLUID_LOOP_GUARD_SIZE 512
+#define FLUID_LOOP_GUARD_PAD  4
 
 /*
  * Utility macros to access soundfonts, presets, and samples
@@ -174,6 +184,9 @@ struct _fluid_sample_t
 
     short *data;                  /**< Pointer to the sample's 16 bit PCM data */
     char *data24;                 /**< If not NULL, pointer to the least significant byte counterparts of each sample data point in order to create 24 bit audio samples */
+    float *data_float;            /**< If not NULL, \a data and \a data24 pre-converted to 32 bit floats (same indices and scale), owned by the sample cache, see synth.sample-format */
+    float *loop_guard;            /**< If not NULL, the loop from \a loopstart to \a loopend unrolled as 32 bit floats, preceded by #FLUID_LOOP_GUARD_PAD guard points */
+    unsigned int loop_guard_size; /**< Number of unrolled loop points in \a loop_guard, a multiple of the loop length, excluding the guard points on either side */
     unsigned int samplerate;      /**< Sample rate */
     int origpitch;                /**< Original pitch (MIDI note number, 0-127) */
     int pitchadj;                 /**< Fine pitch adjustment (+/- 99 cents) */
@@ -55,6 +55,11 @@ new_fluid_channel(fluid_synth_t *synth, int num)
     chan->channum = num;
     chan->preset = NULL;
     chan->tuning = NULL;
+    chan->voices = NULL;
+    FLUID_MEMSET(chan->key_voices, 0, sizeof(chan->key_voices));
+    FLUID_MEMSET(chan->dirty_cc, 0, sizeof(chan->dirty_cc));
+    chan->dirty_gc = 0;
+    chan->dirty_all = FALSE;
 
     fluid_channel_init(chan);
     fluid_channel_init_ctrl(chan, 0);
@@ -90,6 +95,7 @@ fluid_channel_init(fluid_channel_t *chan)
     /*--- End of poly/mono initialization --------------------------------------*/
 
     chan->channel_type = (chan->channum == 9) ? CHANNEL_TYPE_DRUM : CHANNEL_TYPE_MELODIC;
+    chan->synth->overflow_heap_dirty = TRUE;
     prognum = 0;
     banknum = (chan->channel_type == CHANNEL_TYPE_DRUM) ? DRUM_INST_BANK : 0;
 
@@ -327,10 +333,18 @@ fluid_channel_set_bank_msb(fluid_channel_t *chan, int bankmsb)
 
     if(style == FLUID_BANK_STYLE_XG)
     {
+        enum fluid_midi_channel_type type = chan->channel_type;
+
         /* XG bank, do drum-channel auto-switch */
         /* The number "120" was based on several keyboards having drums at 120 - 127,
            reference: https://lists.nongnu.org/archive/html/fluid-dev/2011-02/msg00003.html */
         chan->channel_type = (120 == bankmsb || 126 == bankmsb || 127 == bankmsb) ? CHANNEL_TYPE_DRUM : CHANNEL_TYPE_MELODIC;
+
+        if(chan->channel_type != type)
+        {
+            chan->synth->overflow_heap_dirty = TRUE;
+        }
+
         if(chan->channel_type == CHANNEL_TYPE_MELODIC)
         {
             // bankMSB is ignored for meldodic channels
@@ -140,6 +140,18 @@ struct _fluid_channel_t
         enum fluid_gen_flags flags;
         fluid_real_t val;
     } override_gen_default[GEN_LAST];
+
+    /* Index of the voices assigned to this channel, i.e. all voices from
+     * fluid_voice_init() to fluid_voice_stop(), so that channel and note
+     * messages don't have to look through all voices of the synth. */
+    fluid_voice_t *voices;                /**< Voices of this channel, linked by fluid_voice_t::chan_next */
+    fluid_voice_t *key_voices[128];       /**< Voices per key (modulo 128), linked by fluid_voice_t::key_next */
+
+    /* Controllers changed since the voices of this channel have last been
+     * modulated, see synth.coalesce-controllers */
+    uint32_t dirty_cc[128 / 32];          /**< One bit per MIDI CC */
+    uint32_t dirty_gc;                    /**< One bit per general controller (#FLUID_MOD_PITCHWHEEL, ...) */
+    int dirty_all;                        /**< All controllers have been reset */
 };
 
 fluid_channel_t *new_fluid_channel(fluid_synth_t *synth, int num);
@@ -156,6 +168,9 @@ void fluid_channel_get_sfont_bank_prog(fluid_channel_t *chan, int *sfont,
 fluid_real_t fluid_channel_get_key_pitch(fluid_channel_t *chan, int key);
 
 #define fluid_channel_get_preset(chan)          ((chan)->preset)
+#define fluid_channel_first_voice(chan)         ((chan)->voices)
+#define fluid_channel_first_key_voice(chan, key) \
+  ((chan)->key_voices[(key) & 0x7f])
 #define fluid_channel_set_cc(chan, num, val) \
   ((chan)->cc[num] = (val))
 #define fluid_channel_get_cc(chan, num) \
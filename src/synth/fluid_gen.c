@@ -125,6 +125,11 @@ fluid_real_t fluid_gen_scale_nrpn(int gen, int data)
     return (fluid_real_t)(data * fluid_gen_info[gen].nrpn_scale);
 }
 
+fluid_real_t fluid_gen_get_default(int gen)
+{
+    return fluid_gen_info[gen].def;
+}
+
 
 const char *fluid_gen_name(int gen)
 {
@@ -63,6 +63,7 @@ enum fluid_gen_flags
 
 fluid_real_t fluid_gen_scale(int gen, float value);
 fluid_real_t fluid_gen_scale_nrpn(int gen, int nrpn);
+fluid_real_t fluid_gen_get_default(int gen);
 void fluid_gen_init(fluid_gen_t *gen, fluid_channel_t *channel);
 const char *fluid_gen_name(int gen);
 
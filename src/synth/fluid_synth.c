@@ -26,6 +26,8 @@
 #include "fluid_defsfont.h"
 #include "fluid_dls.h"
 #include "fluid_instpatch.h"
+#include "fluid_convrev.h"
+#include "fluid_insertfx.h"
 
 #ifdef TRAP_ON_FPE
 #define _GNU_SOURCE
@@ -54,6 +56,16 @@ extern int feenableexcept(int excepts);
     FLUID_API_RETURN(fail_value); \
   } \
 
+/* A channel message pushed into synth->midi_queue by fluid_synth_queue_event() */
+typedef struct
+{
+    short chan;
+    unsigned char type;         /* NOTE_ON, NOTE_OFF, CONTROL_CHANGE, ... */
+    unsigned char param1;
+    short param2;
+    unsigned int time;          /* frame at which the message takes effect, see fluid_synth_t::frames_output */
+} fluid_synth_queued_event_t;
+
 static void fluid_synth_init(void);
 static void fluid_synth_api_enter(fluid_synth_t *synth);
 static void fluid_synth_api_exit(fluid_synth_t *synth);
@@ -62,6 +74,10 @@ static int fluid_synth_noteon_LOCAL(fluid_synth_t *synth, int chan, int key,
                                     int vel);
 static int fluid_synth_noteoff_LOCAL(fluid_synth_t *synth, int chan, int key);
 static int fluid_synth_cc_LOCAL(fluid_synth_t *synth, int channum, int num);
+static int fluid_synth_queue_event(fluid_synth_t *synth, int frame_offset, int type, int chan,
+                                   int param1, int param2);
+static void fluid_synth_apply_queued_events_LOCAL(fluid_synth_t *synth);
+static void fluid_synth_apply_queued_events(fluid_synth_t *synth);
 static int fluid_synth_sysex_midi_tuning(fluid_synth_t *synth, const char *data,
         int len, char *response,
         int *response_len, int avail_response,
@@ -80,6 +96,8 @@ static int fluid_synth_system_reset_LOCAL(fluid_synth_t *synth);
 static int fluid_synth_modulate_voices_LOCAL(fluid_synth_t *synth, int chan,
         int is_cc, int ctrl);
 static int fluid_synth_modulate_voices_all_LOCAL(fluid_synth_t *synth, int chan);
+static void fluid_synth_modulate_dirty_voices_LOCAL(fluid_synth_t *synth);
+static void fluid_synth_modulate_dirty_voices(fluid_synth_t *synth);
 static int fluid_synth_update_channel_pressure_LOCAL(fluid_synth_t *synth, int channum);
 static int fluid_synth_update_key_pressure_LOCAL(fluid_synth_t *synth, int chan, int key);
 static int fluid_synth_update_pitch_bend_LOCAL(fluid_synth_t *synth, int chan);
@@ -88,8 +106,15 @@ static int fluid_synth_set_preset(fluid_synth_t *synth, int chan,
                                   fluid_preset_t *preset);
 static int fluid_synth_reverb_get_param(fluid_synth_t *synth, int fx_group,
                                         int param, double *value);
+static void fluid_synth_delete_convrev_swap(fluid_mixer_convrev_swap_t *swap);
+static void fluid_synth_check_convrev_swaps(fluid_synth_t *synth);
+static int fluid_synth_set_reverb_convrev_LOCAL(fluid_synth_t *synth, int fx_group,
+        const char *filename, const float *left, const float *right, int frames,
+        double sample_rate);
 static int fluid_synth_chorus_get_param(fluid_synth_t *synth, int fx_group,
                                         int param, double *value);
+static int fluid_synth_set_insert_fx_param_LOCAL(fluid_synth_t *synth, int target,
+        int index, int param, double value);
 
 static fluid_preset_t *
 fluid_synth_get_preset(fluid_synth_t *synth, int sfontnum,
@@ -142,6 +167,8 @@ static void fluid_synth_handle_important_channels(void *data, const char *name,
 static void fluid_synth_handle_portamento_mode(void *data, const char *name, const char *value);
 static void fluid_synth_handle_reverb_chorus_num(void *data, const char *name, double value);
 static void fluid_synth_handle_reverb_chorus_int(void *data, const char *name, int value);
+static void fluid_synth_handle_insert_fx_num(void *data, const char *name, double value);
+static void fluid_synth_handle_insert_fx_int(void *data, const char *name, int value);
 
 
 static void fluid_synth_reset_basic_channel_LOCAL(fluid_synth_t *synth, int chan, int nbr_chan);
@@ -206,6 +233,8 @@ static const fluid_revmodel_presets_t revmodel_preset[] =
 
 void fluid_synth_settings(fluid_settings_t *settings)
 {
+    int i;
+
     fluid_settings_register_int(settings, "synth.verbose", 0, 0, 1, FLUID_HINT_TOGGLED);
 
     fluid_settings_register_int(settings, "synth.reverb.active", 1, 0, 1, FLUID_HINT_TOGGLED);
@@ -213,6 +242,7 @@ void fluid_synth_settings(fluid_settings_t *settings)
     fluid_settings_register_num(settings, "synth.reverb.damp", FLUID_REVERB_DEFAULT_DAMP, 0.0, 1.0, 0);
     fluid_settings_register_num(settings, "synth.reverb.width", FLUID_REVERB_DEFAULT_WIDTH, 0.0, 100.0, 0);
     fluid_settings_register_num(settings, "synth.reverb.level", FLUID_REVERB_DEFAULT_LEVEL, 0.0, 1.0, 0);
+    fluid_settings_register_str(settings, "synth.reverb.impulse-response", "", 0);
 
     fluid_settings_register_int(settings, "synth.chorus.active", 1, 0, 1, FLUID_HINT_TOGGLED);
     fluid_settings_register_int(settings, "synth.chorus.nr", FLUID_CHORUS_DEFAULT_N, 0, 99, 0);
@@ -220,6 +250,27 @@ void fluid_synth_settings(fluid_settings_t *settings)
     fluid_settings_register_num(settings, "synth.chorus.speed", FLUID_CHORUS_DEFAULT_SPEED, 0.1, 5.0, 0);
     fluid_settings_register_num(settings, "synth.chorus.depth", FLUID_CHORUS_DEFAULT_DEPTH, 0.0, 256.0, 0);
 
+    /* insert effects of the audio groups, see fluid_insertfx_param_info() */
+    for(i = 0; i < FLUID_INSERT_FX_PARAM_LAST; i++)
+    {
+        char name[64];
+        const char *param_name;
+        double def, min, max;
+        int toggle;
+
+        fluid_insertfx_param_info(i, &param_name, &def, &min, &max, &toggle);
+        FLUID_SNPRINTF(name, sizeof(name), "synth.%s", param_name);
+
+        if(toggle)
+        {
+            fluid_settings_register_int(settings, name, (int)def, 0, 1, FLUID_HINT_TOGGLED);
+        }
+        else
+        {
+            fluid_settings_register_num(settings, name, def, min, max, 0);
+        }
+    }
+
     fluid_settings_register_int(settings, "synth.ladspa.active", 0, 0, 1, FLUID_HINT_TOGGLED);
     fluid_settings_register_int(settings, "synth.lock-memory", 1, 0, 1, FLUID_HINT_TOGGLED);
     fluid_settings_register_str(settings, "midi.portname", "", 0);
@@ -237,12 +288,21 @@ void fluid_synth_settings(fluid_settings_t *settings)
     fluid_settings_register_int(settings, "synth.effects-groups", 1, 1, 128, 0);
     fluid_settings_register_num(settings, "synth.sample-rate", 44100.0, 8000.0, 96000.0, 0);
     fluid_settings_register_int(settings, "synth.device-id", 16, 0, 127, 0);
+    fluid_settings_register_int(settings, "synth.block-size", FLUID_BUFSIZE, FLUID_BUFSIZE_MIN, FLUID_BUFSIZE_MAX, 0);
+    fluid_settings_register_int(settings, "synth.coalesce-controllers", 0, 0, 1, FLUID_HINT_TOGGLED);
+    fluid_settings_register_int(settings, "synth.midi-queue-size", 0, 0, 65536, 0);
 #ifdef ENABLE_MIXER_THREADS
     fluid_settings_register_int(settings, "synth.cpu-cores", 1, 1, 256, 0);
 #else
     fluid_settings_register_int(settings, "synth.cpu-cores", 1, 1, 1, 0);
 #endif
 
+    fluid_settings_register_str(settings, "synth.cpu-isa", "auto", 0);
+    fluid_settings_add_option(settings, "synth.cpu-isa", "auto");
+    fluid_settings_add_option(settings, "synth.cpu-isa", "generic");
+    fluid_settings_add_option(settings, "synth.cpu-isa", "avx2");
+    fluid_settings_add_option(settings, "synth.cpu-isa", "avx512");
+
     fluid_settings_register_int(settings, "synth.min-note-length", 10, 0, 65535, 0);
 
     fluid_settings_register_int(settings, "synth.threadsafe-api", FLUID_THREAD_SAFE_CAPABLE, 0, 1, FLUID_HINT_TOGGLED);
@@ -262,6 +322,9 @@ void fluid_synth_settings(fluid_settings_t *settings)
     fluid_settings_add_option(settings, "synth.midi-bank-select", "mma");
 
     fluid_settings_register_int(settings, "synth.dynamic-sample-loading", 0, 0, 1, FLUID_HINT_TOGGLED);
+    fluid_settings_register_str(settings, "synth.sample-format", "16bits", 0);
+    fluid_settings_add_option(settings, "synth.sample-format", "16bits");
+    fluid_settings_add_option(settings, "synth.sample-format", "float");
     fluid_settings_register_int(settings, "synth.note-cut", 0, 0, 2, 0);
     
     fluid_settings_register_str(settings, "synth.portamento-time", "auto", 0);
@@ -721,6 +784,8 @@ new_fluid_synth(fluid_settings_t *settings)
     fluid_settings_getnum_float(settings, "synth.gain", &synth->gain);
     fluid_settings_getint(settings, "synth.device-id", &synth->device_id);
     fluid_settings_getint(settings, "synth.cpu-cores", &synth->cores);
+    fluid_settings_getint(settings, "synth.block-size", &synth->block_size);
+    fluid_settings_getint(settings, "synth.coalesce-controllers", &synth->coalesce_controllers);
 
     fluid_settings_getnum_float(settings, "synth.overflow.percussion", &synth->overflow.percussion);
     fluid_settings_getnum_float(settings, "synth.overflow.released", &synth->overflow.released);
@@ -773,6 +838,26 @@ new_fluid_synth(fluid_settings_t *settings)
                                 fluid_synth_handle_reverb_chorus_num, synth);
     fluid_settings_callback_num(settings, "synth.chorus.speed",
                                 fluid_synth_handle_reverb_chorus_num, synth);
+
+    for(i = 0; i < FLUID_INSERT_FX_PARAM_LAST; i++)
+    {
+        char name[64];
+        const char *param_name;
+        int toggle;
+
+        fluid_insertfx_param_info(i, &param_name, NULL, NULL, NULL, &toggle);
+        FLUID_SNPRINTF(name, sizeof(name), "synth.%s", param_name);
+
+        if(toggle)
+        {
+            fluid_settings_callback_int(settings, name, fluid_synth_handle_insert_fx_int, synth);
+        }
+        else
+        {
+            fluid_settings_callback_num(settings, name, fluid_synth_handle_insert_fx_num, synth);
+        }
+    }
+
     fluid_settings_callback_str(settings, "synth.portamento-time",
                                 fluid_synth_handle_portamento_mode, synth);
 
@@ -820,6 +905,20 @@ new_fluid_synth(fluid_settings_t *settings)
         synth->effects_channels = 2;
     }
 
+    if((synth->block_size & (synth->block_size - 1)) != 0)
+    {
+        int n = FLUID_BUFSIZE_MIN;
+
+        while(n * 2 <= synth->block_size)
+        {
+            n *= 2;
+        }
+
+        FLUID_LOG(FLUID_WARN, "Requested block size (%d) is not a power of two. "
+                  "Rounding it down to %d.", synth->block_size, n);
+        synth->block_size = n;
+    }
+
     /*
      number of buffers rendered by the mixer is determined by synth->audio_groups.
      audio from MIDI channel is rendered, mapped and mixed in these buffers.
@@ -881,8 +980,22 @@ new_fluid_synth(fluid_settings_t *settings)
     }
 
     fluid_atomic_int_set(&synth->ticks_since_start, 0);
+    fluid_atomic_int_set(&synth->frames_output, 0);
     synth->tuning = NULL;
     fluid_private_init(synth->tuning_iter);
+    fluid_private_init(synth->midi_queue_draining);
+
+    fluid_settings_getint(settings, "synth.midi-queue-size", &i);
+
+    if(i > 0)
+    {
+        synth->midi_queue = new_fluid_mpsc_queue(i, sizeof(fluid_synth_queued_event_t));
+
+        if(synth->midi_queue == NULL)
+        {
+            goto error_recovery;
+        }
+    }
 
     /* Initialize multi-core variables if multiple cores enabled */
     if(synth->cores > 1)
@@ -895,7 +1008,7 @@ new_fluid_synth(fluid_settings_t *settings)
     synth->eventhandler = new_fluid_rvoice_eventhandler(synth->polyphony * 64,
                           synth->polyphony, synth->audio_groups,
                           synth->effects_channels, synth->effects_groups,
-                          (fluid_real_t)sample_rate_max, synth->sample_rate,
+                          (fluid_real_t)sample_rate_max, synth->sample_rate, synth->block_size,
                           synth->cores - 1, prio_level);
 
     if(synth->eventhandler == NULL)
@@ -903,6 +1016,17 @@ new_fluid_synth(fluid_settings_t *settings)
         goto error_recovery;
     }
 
+    /* Select the dsp kernels best suited for this CPU */
+    {
+        char *cpu_isa_str;
+
+        if(fluid_settings_dupstr(settings, "synth.cpu-isa", &cpu_isa_str) == FLUID_OK)
+        {
+            fluid_rvoice_mixer_set_cpu_isa(synth->eventhandler->mixer, fluid_cpu_isa_parse(cpu_isa_str));
+            FLUID_FREE(cpu_isa_str);
+        }
+    }
+
     /* Setup the list of default modulators.
      * Needs to happen after eventhandler has been set up, as fluid_synth_enter_api is called in the process */
     synth->default_mod = NULL;
@@ -1011,12 +1135,22 @@ new_fluid_synth(fluid_settings_t *settings)
     FLUID_MEMSET(synth->voice, 0, synth->nvoice * sizeof(*synth->voice));
     for(i = 0; i < synth->nvoice; i++)
     {
-        synth->voice[i] = new_fluid_voice(synth->eventhandler, synth->sample_rate, synth->iir_sincos_table);
+        synth->voice[i] = new_fluid_voice(synth->eventhandler, synth->sample_rate, synth->block_size, synth->iir_sincos_table);
 
         if(synth->voice[i] == NULL)
         {
             goto error_recovery;
         }
+
+        synth->voice[i]->synth_index = i;
+    }
+
+    synth->overflow_heap = FLUID_ARRAY(fluid_voice_t *, synth->nvoice);
+    synth->overflow_frontier = FLUID_ARRAY(int, synth->nvoice);
+
+    if(synth->overflow_heap == NULL || synth->overflow_frontier == NULL)
+    {
+        goto error_recovery;
     }
 
     /* sets a default basic channel */
@@ -1034,10 +1168,22 @@ new_fluid_synth(fluid_settings_t *settings)
     fluid_synth_reverb_on(synth, -1, synth->with_reverb);
     fluid_synth_chorus_on(synth, -1, synth->with_chorus);
 
-    synth->cur = FLUID_BUFSIZE;
+    synth->cur = synth->block_size;
     synth->curmax = 0;
+    synth->event_offset = 0;
+    fluid_atomic_int_set(&synth->controllers_dirty, FALSE);
     synth->dither_index = 0;
 
+    synth->process_audible = FLUID_ARRAY(char, (synth->audio_channels + synth->effects_channels * synth->effects_groups) * 2);
+
+    if(synth->process_audible == NULL)
+    {
+        FLUID_LOG(FLUID_ERR, "Out of memory");
+        goto error_recovery;
+    }
+
+    FLUID_MEMSET(synth->process_audible, FALSE, (synth->audio_channels + synth->effects_channels * synth->effects_groups) * 2);
+
     {
         double values[FLUID_REVERB_PARAM_LAST];
 
@@ -1049,6 +1195,19 @@ new_fluid_synth(fluid_settings_t *settings)
         fluid_synth_set_reverb_full(synth, -1, FLUID_REVMODEL_SET_ALL, values);
     }
 
+    {
+        char *impulse_response = NULL;
+
+        if(fluid_settings_dupstr(settings, "synth.reverb.impulse-response", &impulse_response) == FLUID_OK
+                && impulse_response != NULL && impulse_response[0] != '\0'
+                && fluid_synth_set_reverb_convrev_LOCAL(synth, -1, impulse_response, NULL, NULL, 0, 0) != FLUID_OK)
+        {
+            FLUID_LOG(FLUID_WARN, "Failed to load impulse response '%s', using the built-in reverb", impulse_response);
+        }
+
+        FLUID_FREE(impulse_response);
+    }
+
     {
         double values[FLUID_CHORUS_PARAM_LAST];
 
@@ -1062,6 +1221,34 @@ new_fluid_synth(fluid_settings_t *settings)
         fluid_synth_set_chorus_full(synth, -1, FLUID_CHORUS_SET_ALL, values);
     }
 
+    /* insert effects of the audio groups, those of the fx groups start switched off */
+    for(i = 0; i < FLUID_INSERT_FX_PARAM_LAST; i++)
+    {
+        char name[64];
+        const char *param_name;
+        double def, value;
+        int toggle;
+
+        fluid_insertfx_param_info(i, &param_name, &def, NULL, NULL, &toggle);
+        FLUID_SNPRINTF(name, sizeof(name), "synth.%s", param_name);
+
+        if(toggle)
+        {
+            int ival;
+            fluid_settings_getint(settings, name, &ival);
+            value = ival;
+        }
+        else
+        {
+            fluid_settings_getnum(settings, name, &value);
+        }
+
+        if(value != def)
+        {
+            fluid_synth_set_insert_fx_param_LOCAL(synth, FLUID_INSERT_FX_AUDIO_GROUP, -1, i, value);
+        }
+    }
+
 
     synth->bank_select = FLUID_BANK_STYLE_GS;
 
@@ -1159,6 +1346,25 @@ delete_fluid_synth(fluid_synth_t *synth)
     fluid_settings_callback_num(synth->settings, "synth.chorus.speed",
                                 NULL, NULL);
 
+    for(i = 0; i < FLUID_INSERT_FX_PARAM_LAST; i++)
+    {
+        char name[64];
+        const char *param_name;
+        int toggle;
+
+        fluid_insertfx_param_info(i, &param_name, NULL, NULL, NULL, &toggle);
+        FLUID_SNPRINTF(name, sizeof(name), "synth.%s", param_name);
+
+        if(toggle)
+        {
+            fluid_settings_callback_int(synth->settings, name, NULL, NULL);
+        }
+        else
+        {
+            fluid_settings_callback_num(synth->settings, name, NULL, NULL);
+        }
+    }
+
     /* turn off all voices, needed to unload SoundFont data */
     if(synth->voice != NULL)
     {
@@ -1210,6 +1416,14 @@ delete_fluid_synth(fluid_synth_t *synth)
 
     delete_fluid_rvoice_eventhandler(synth->eventhandler);
 
+    /* delete the convolution reverbs the mixer didn't own */
+    for(list = synth->convrev_swaps; list; list = fluid_list_next(list))
+    {
+        fluid_synth_delete_convrev_swap(fluid_list_get(list));
+    }
+
+    delete_fluid_list(synth->convrev_swaps);
+
     /* delete all the SoundFonts */
     for(list = synth->sfont; list; list = fluid_list_next(list))
     {
@@ -1262,6 +1476,11 @@ delete_fluid_synth(fluid_synth_t *synth)
         FLUID_FREE(synth->voice);
     }
 
+    FLUID_FREE(synth->overflow_heap);
+    FLUID_FREE(synth->overflow_frontier);
+
+    FLUID_FREE(synth->process_audible);
+
 
     /* free the tunings, if any */
     if(synth->tuning != NULL)
@@ -1283,6 +1502,8 @@ delete_fluid_synth(fluid_synth_t *synth)
     }
 
     fluid_private_free(synth->tuning_iter);
+    fluid_private_free(synth->midi_queue_draining);
+    delete_fluid_mpsc_queue(synth->midi_queue);
 
 #ifdef LADSPA
     /* Release the LADSPA effects unit */
@@ -1339,12 +1560,58 @@ fluid_synth_noteon(fluid_synth_t *synth, int chan, int key, int vel)
     int result;
     fluid_return_val_if_fail(key >= 0 && key <= 127, FLUID_FAILED);
     fluid_return_val_if_fail(vel >= 0 && vel <= 127, FLUID_FAILED);
+
+    if(fluid_synth_queue_event(synth, 0, NOTE_ON, chan, key, vel) == FLUID_OK)
+    {
+        return FLUID_OK;
+    }
+
+    FLUID_API_ENTRY_CHAN(FLUID_FAILED);
+
+    /* Allowed only on MIDI channel enabled */
+    FLUID_API_RETURN_IF_CHAN_DISABLED(FLUID_FAILED);
+
+    result = fluid_synth_noteon_LOCAL(synth, chan, key, vel);
+    FLUID_API_RETURN(result);
+}
+
+/**
+ * Send a note-on event to a FluidSynth object, to be played at a given frame.
+ *
+ * Same as fluid_synth_noteon(), except that the voices of the note start at
+ * the given frame rather than with the next block of fluid_synth_get_internal_bufsize()
+ * samples. This allows e.g. an audio driver to play the MIDI events it received
+ * during the last period with sample accurate timing.
+ * @param synth FluidSynth instance
+ * @param frame_offset Offset in sample frames (>= 0), relative to the next frame that
+ *   will be output by the synth (i.e. the first frame returned by the next call
+ *   to fluid_synth_process(), fluid_synth_write_float(), etc.)
+ * @param chan MIDI channel number (0 to MIDI channel count - 1)
+ * @param key MIDI note number (0-127)
+ * @param vel MIDI velocity (0-127, 0=noteoff)
+ * @return #FLUID_OK on success, #FLUID_FAILED otherwise
+ */
+int
+fluid_synth_noteon_at(fluid_synth_t *synth, int frame_offset, int chan, int key, int vel)
+{
+    int result;
+    fluid_return_val_if_fail(frame_offset >= 0, FLUID_FAILED);
+    fluid_return_val_if_fail(key >= 0 && key <= 127, FLUID_FAILED);
+    fluid_return_val_if_fail(vel >= 0 && vel <= 127, FLUID_FAILED);
+
+    if(fluid_synth_queue_event(synth, frame_offset, NOTE_ON, chan, key, vel) == FLUID_OK)
+    {
+        return FLUID_OK;
+    }
+
     FLUID_API_ENTRY_CHAN(FLUID_FAILED);
 
     /* Allowed only on MIDI channel enabled */
     FLUID_API_RETURN_IF_CHAN_DISABLED(FLUID_FAILED);
 
+    synth->event_offset = frame_offset;
     result = fluid_synth_noteon_LOCAL(synth, chan, key, vel);
+    synth->event_offset = 0;
     FLUID_API_RETURN(result);
 }
 
@@ -1422,12 +1689,54 @@ fluid_synth_noteoff(fluid_synth_t *synth, int chan, int key)
 {
     int result;
     fluid_return_val_if_fail(key >= 0 && key <= 127, FLUID_FAILED);
+
+    if(fluid_synth_queue_event(synth, 0, NOTE_OFF, chan, key, 0) == FLUID_OK)
+    {
+        return FLUID_OK;
+    }
+
+    FLUID_API_ENTRY_CHAN(FLUID_FAILED);
+
+    /* Allowed only on MIDI channel enabled */
+    FLUID_API_RETURN_IF_CHAN_DISABLED(FLUID_FAILED);
+
+    result = fluid_synth_noteoff_LOCAL(synth, chan, key);
+    FLUID_API_RETURN(result);
+}
+
+/**
+ * Sends a note-off event to a FluidSynth object, to be played at a given frame.
+ *
+ * Same as fluid_synth_noteoff(), except that the release of the voices is
+ * delayed to the given frame. As the envelopes of a voice advance blockwise,
+ * the release starts at the block boundary nearest to that frame.
+ * @param synth FluidSynth instance
+ * @param frame_offset Offset in sample frames (>= 0), see fluid_synth_noteon_at()
+ * @param chan MIDI channel number (0 to MIDI channel count - 1)
+ * @param key MIDI note number (0-127)
+ * @return #FLUID_OK on success, #FLUID_FAILED otherwise (may just mean that no
+ *   voices matched the note off event)
+ */
+int
+fluid_synth_noteoff_at(fluid_synth_t *synth, int frame_offset, int chan, int key)
+{
+    int result;
+    fluid_return_val_if_fail(frame_offset >= 0, FLUID_FAILED);
+    fluid_return_val_if_fail(key >= 0 && key <= 127, FLUID_FAILED);
+
+    if(fluid_synth_queue_event(synth, frame_offset, NOTE_OFF, chan, key, 0) == FLUID_OK)
+    {
+        return FLUID_OK;
+    }
+
     FLUID_API_ENTRY_CHAN(FLUID_FAILED);
 
     /* Allowed only on MIDI channel enabled */
     FLUID_API_RETURN_IF_CHAN_DISABLED(FLUID_FAILED);
 
+    synth->event_offset = frame_offset;
     result = fluid_synth_noteoff_LOCAL(synth, chan, key);
+    synth->event_offset = 0;
     FLUID_API_RETURN(result);
 }
 
@@ -1467,14 +1776,13 @@ static int
 fluid_synth_damp_voices_by_sustain_LOCAL(fluid_synth_t *synth, int chan)
 {
     fluid_channel_t *channel = synth->channel[chan];
-    fluid_voice_t *voice;
-    int i;
+    fluid_voice_t *voice, *next;
 
-    for(i = 0; i < synth->polyphony; i++)
+    for(voice = fluid_channel_first_voice(channel); voice != NULL; voice = next)
     {
-        voice = synth->voice[i];
+        next = voice->chan_next;
 
-        if((fluid_voice_get_channel(voice) == chan) && fluid_voice_is_sustained(voice))
+        if(fluid_voice_is_sustained(voice))
         {
             if(voice->key == channel->key_mono_sustained)
             {
@@ -1497,14 +1805,13 @@ static int
 fluid_synth_damp_voices_by_sostenuto_LOCAL(fluid_synth_t *synth, int chan)
 {
     fluid_channel_t *channel = synth->channel[chan];
-    fluid_voice_t *voice;
-    int i;
+    fluid_voice_t *voice, *next;
 
-    for(i = 0; i < synth->polyphony; i++)
+    for(voice = fluid_channel_first_voice(channel); voice != NULL; voice = next)
     {
-        voice = synth->voice[i];
+        next = voice->chan_next;
 
-        if((fluid_voice_get_channel(voice) == chan) && fluid_voice_is_sostenuto(voice))
+        if(fluid_voice_is_sostenuto(voice))
         {
             if(voice->key == channel->key_mono_sustained)
             {
@@ -1673,6 +1980,12 @@ fluid_synth_cc(fluid_synth_t *synth, int chan, int num, int val)
     fluid_channel_t *channel;
     fluid_return_val_if_fail(num >= 0 && num <= 127, FLUID_FAILED);
     fluid_return_val_if_fail(val >= 0 && val <= 127, FLUID_FAILED);
+
+    if(fluid_synth_queue_event(synth, 0, CONTROL_CHANGE, chan, num, val) == FLUID_OK)
+    {
+        return FLUID_OK;
+    }
+
     FLUID_API_ENTRY_CHAN(FLUID_FAILED);
 
     channel = synth->channel[chan];
@@ -2644,6 +2957,7 @@ fluid_synth_sysex_gs_dt1(fluid_synth_t *synth, const char *data, int len,
             chan = chan >= 0x0a ? chan : (chan == 0 ? 9 : chan - 1);
             type = data[7] == 0x00 ? CHANNEL_TYPE_MELODIC : CHANNEL_TYPE_DRUM;
             synth->channel[chan]->channel_type = type;
+            synth->overflow_heap_dirty = TRUE;
 
             FLUID_LOG(FLUID_DBG, "SysEx GS DT1: setting MIDI channel %d to type %d", chan, (int)synth->channel[chan]->channel_type);
             // Roland synths seem to "remember" the last instrument a channel
@@ -2746,14 +3060,29 @@ fluid_synth_all_notes_off(fluid_synth_t *synth, int chan)
 int
 fluid_synth_all_notes_off_LOCAL(fluid_synth_t *synth, int chan)
 {
-    fluid_voice_t *voice;
+    fluid_voice_t *voice, *next;
     int i;
 
+    if(chan != -1)
+    {
+        for(voice = fluid_channel_first_voice(synth->channel[chan]); voice != NULL; voice = next)
+        {
+            next = voice->chan_next;
+
+            if(fluid_voice_is_playing(voice))
+            {
+                fluid_voice_noteoff(voice);
+            }
+        }
+
+        return FLUID_OK;
+    }
+
     for(i = 0; i < synth->polyphony; i++)
     {
         voice = synth->voice[i];
 
-        if(fluid_voice_is_playing(voice) && ((-1 == chan) || (chan == fluid_voice_get_channel(voice))))
+        if(fluid_voice_is_playing(voice))
         {
             fluid_voice_noteoff(voice);
         }
@@ -2795,14 +3124,29 @@ fluid_synth_all_sounds_off(fluid_synth_t *synth, int chan)
 static int
 fluid_synth_all_sounds_off_LOCAL(fluid_synth_t *synth, int chan)
 {
-    fluid_voice_t *voice;
+    fluid_voice_t *voice, *next;
     int i;
 
+    if(chan != -1)
+    {
+        for(voice = fluid_channel_first_voice(synth->channel[chan]); voice != NULL; voice = next)
+        {
+            next = voice->chan_next;
+
+            if(fluid_voice_is_playing(voice))
+            {
+                fluid_voice_off(voice);
+            }
+        }
+
+        return FLUID_OK;
+    }
+
     for(i = 0; i < synth->polyphony; i++)
     {
         voice = synth->voice[i];
 
-        if(fluid_voice_is_playing(voice) && ((-1 == chan) || (chan == fluid_voice_get_channel(voice))))
+        if(fluid_voice_is_playing(voice))
         {
             fluid_voice_off(voice);
         }
@@ -2901,17 +3245,28 @@ fluid_synth_system_reset_LOCAL(fluid_synth_t *synth)
 static int
 fluid_synth_modulate_voices_LOCAL(fluid_synth_t *synth, int chan, int is_cc, int ctrl)
 {
+    fluid_channel_t *channel = synth->channel[chan];
     fluid_voice_t *voice;
-    int i;
 
-    for(i = 0; i < synth->polyphony; i++)
+    if(synth->coalesce_controllers && ctrl >= 0 && ctrl < (is_cc ? 128 : 32))
     {
-        voice = synth->voice[i];
-
-        if(fluid_voice_get_channel(voice) == chan)
+        /* applied once per block by fluid_synth_modulate_dirty_voices_LOCAL() */
+        if(is_cc)
+        {
+            channel->dirty_cc[ctrl >> 5] |= 1u << (ctrl & 31);
+        }
+        else
         {
-            fluid_voice_modulate(voice, is_cc, ctrl);
+            channel->dirty_gc |= 1u << ctrl;
         }
+
+        fluid_atomic_int_set(&synth->controllers_dirty, TRUE);
+        return FLUID_OK;
+    }
+
+    for(voice = fluid_channel_first_voice(synth->channel[chan]); voice != NULL; voice = voice->chan_next)
+    {
+        fluid_voice_modulate(voice, is_cc, ctrl);
     }
 
     return FLUID_OK;
@@ -2927,53 +3282,153 @@ static int
 fluid_synth_modulate_voices_all_LOCAL(fluid_synth_t *synth, int chan)
 {
     fluid_voice_t *voice;
-    int i;
 
-    for(i = 0; i < synth->polyphony; i++)
+    if(synth->coalesce_controllers)
     {
-        voice = synth->voice[i];
+        synth->channel[chan]->dirty_all = TRUE;
+        fluid_atomic_int_set(&synth->controllers_dirty, TRUE);
+        return FLUID_OK;
+    }
 
-        if(fluid_voice_get_channel(voice) == chan)
-        {
-            fluid_voice_modulate_all(voice);
-        }
+    for(voice = fluid_channel_first_voice(synth->channel[chan]); voice != NULL; voice = voice->chan_next)
+    {
+        fluid_voice_modulate_all(voice);
     }
 
     return FLUID_OK;
 }
 
-/**
- * Set the MIDI channel pressure controller value.
- * @param synth FluidSynth instance
- * @param chan MIDI channel number (0 to MIDI channel count - 1)
- * @param val MIDI channel pressure value (0-127)
- * @return #FLUID_OK on success, #FLUID_FAILED otherwise
- */
-int
-fluid_synth_channel_pressure(fluid_synth_t *synth, int chan, int val)
+/* Called by the synthesis thread, before rendering a block. Only takes the
+ * API when some controller has actually changed, and never waits for it: when
+ * another thread holds the mutex, the flag stays set and the voices are
+ * modulated before the next block. */
+static void
+fluid_synth_modulate_dirty_voices(fluid_synth_t *synth)
 {
-    int result;
-    fluid_return_val_if_fail(val >= 0 && val <= 127, FLUID_FAILED);
-
-    FLUID_API_ENTRY_CHAN(FLUID_FAILED);
-
-    /* Allowed only on MIDI channel enabled */
-    FLUID_API_RETURN_IF_CHAN_DISABLED(FLUID_FAILED);
+    if(!synth->coalesce_controllers || !fluid_atomic_int_get(&synth->controllers_dirty))
+    {
+        return;
+    }
 
-    if(synth->verbose)
+    if(synth->use_mutex && !fluid_rec_mutex_trylock(synth->mutex))
     {
-        FLUID_LOG(FLUID_INFO, "channelpressure\t%d\t%d", chan, val);
+        return;
     }
 
-    fluid_channel_set_channel_pressure(synth->channel[chan], val);
-    result = fluid_synth_update_channel_pressure_LOCAL(synth, chan);
+    fluid_synth_api_enter(synth);
+    fluid_synth_modulate_dirty_voices_LOCAL(synth);
+    fluid_synth_api_exit(synth);
 
-    FLUID_API_RETURN(result);
+    if(synth->use_mutex)
+    {
+        fluid_rec_mutex_unlock(synth->mutex);
+    }
 }
 
-/* Updates channel pressure from within synthesis thread */
-static int
-fluid_synth_update_channel_pressure_LOCAL(fluid_synth_t *synth, int chan)
+/*
+ * Modulates the voices by the controllers that have changed since the last
+ * call, when synth.coalesce-controllers is enabled. As every modulation
+ * is computed from the current controller values, doing it once per block
+ * gives the same result as doing it for every single controller message.
+ */
+static void
+fluid_synth_modulate_dirty_voices_LOCAL(fluid_synth_t *synth)
+{
+    fluid_channel_t *channel;
+    fluid_voice_t *voice;
+    uint32_t bits;
+    int i, k, ctrl;
+
+    if(!fluid_atomic_int_get(&synth->controllers_dirty))
+    {
+        return;
+    }
+
+    fluid_atomic_int_set(&synth->controllers_dirty, FALSE);
+
+    for(i = 0; i < synth->midi_channels; i++)
+    {
+        channel = synth->channel[i];
+
+        if(!(channel->dirty_all || channel->dirty_gc || channel->dirty_cc[0] || channel->dirty_cc[1]
+                || channel->dirty_cc[2] || channel->dirty_cc[3]))
+        {
+            continue;
+        }
+
+        for(voice = fluid_channel_first_voice(channel); voice != NULL; voice = voice->chan_next)
+        {
+            if(channel->dirty_all)
+            {
+                fluid_voice_modulate_all(voice);
+                continue;
+            }
+
+            for(bits = channel->dirty_gc; bits != 0; bits &= bits - 1)
+            {
+                for(ctrl = 0; !(bits & (1u << ctrl)); ctrl++)
+                {
+                }
+
+                fluid_voice_modulate(voice, 0, ctrl);
+            }
+
+            for(k = 0; k < 128 / 32; k++)
+            {
+                for(bits = channel->dirty_cc[k]; bits != 0; bits &= bits - 1)
+                {
+                    for(ctrl = 0; !(bits & (1u << ctrl)); ctrl++)
+                    {
+                    }
+
+                    fluid_voice_modulate(voice, 1, k * 32 + ctrl);
+                }
+            }
+        }
+
+        FLUID_MEMSET(channel->dirty_cc, 0, sizeof(channel->dirty_cc));
+        channel->dirty_gc = 0;
+        channel->dirty_all = FALSE;
+    }
+}
+
+/**
+ * Set the MIDI channel pressure controller value.
+ * @param synth FluidSynth instance
+ * @param chan MIDI channel number (0 to MIDI channel count - 1)
+ * @param val MIDI channel pressure value (0-127)
+ * @return #FLUID_OK on success, #FLUID_FAILED otherwise
+ */
+int
+fluid_synth_channel_pressure(fluid_synth_t *synth, int chan, int val)
+{
+    int result;
+    fluid_return_val_if_fail(val >= 0 && val <= 127, FLUID_FAILED);
+
+    if(fluid_synth_queue_event(synth, 0, CHANNEL_PRESSURE, chan, val, 0) == FLUID_OK)
+    {
+        return FLUID_OK;
+    }
+
+    FLUID_API_ENTRY_CHAN(FLUID_FAILED);
+
+    /* Allowed only on MIDI channel enabled */
+    FLUID_API_RETURN_IF_CHAN_DISABLED(FLUID_FAILED);
+
+    if(synth->verbose)
+    {
+        FLUID_LOG(FLUID_INFO, "channelpressure\t%d\t%d", chan, val);
+    }
+
+    fluid_channel_set_channel_pressure(synth->channel[chan], val);
+    result = fluid_synth_update_channel_pressure_LOCAL(synth, chan);
+
+    FLUID_API_RETURN(result);
+}
+
+/* Updates channel pressure from within synthesis thread */
+static int
+fluid_synth_update_channel_pressure_LOCAL(fluid_synth_t *synth, int chan)
 {
     return fluid_synth_modulate_voices_LOCAL(synth, chan, 0, FLUID_MOD_CHANNELPRESSURE);
 }
@@ -2994,6 +3449,11 @@ fluid_synth_key_pressure(fluid_synth_t *synth, int chan, int key, int val)
     fluid_return_val_if_fail(key >= 0 && key <= 127, FLUID_FAILED);
     fluid_return_val_if_fail(val >= 0 && val <= 127, FLUID_FAILED);
 
+    if(fluid_synth_queue_event(synth, 0, KEY_PRESSURE, chan, key, val) == FLUID_OK)
+    {
+        return FLUID_OK;
+    }
+
     FLUID_API_ENTRY_CHAN(FLUID_FAILED);
 
     /* Allowed only on MIDI channel enabled */
@@ -3015,14 +3475,11 @@ static int
 fluid_synth_update_key_pressure_LOCAL(fluid_synth_t *synth, int chan, int key)
 {
     fluid_voice_t *voice;
-    int i;
     int result = FLUID_OK;
 
-    for(i = 0; i < synth->polyphony; i++)
+    for(voice = fluid_channel_first_key_voice(synth->channel[chan], key); voice != NULL; voice = voice->key_next)
     {
-        voice = synth->voice[i];
-
-        if(voice->chan == chan && voice->key == key)
+        if(voice->key == key)
         {
             result = fluid_voice_modulate(voice, 0, FLUID_MOD_KEYPRESSURE);
 
@@ -3048,6 +3505,12 @@ fluid_synth_pitch_bend(fluid_synth_t *synth, int chan, int val)
 {
     int result;
     fluid_return_val_if_fail(val >= 0 && val <= 16383, FLUID_FAILED);
+
+    if(fluid_synth_queue_event(synth, 0, PITCH_BEND, chan, 0, val) == FLUID_OK)
+    {
+        return FLUID_OK;
+    }
+
     FLUID_API_ENTRY_CHAN(FLUID_FAILED);
 
     /* Allowed only on MIDI channel enabled */
@@ -3269,6 +3732,12 @@ fluid_synth_program_change(fluid_synth_t *synth, int chan, int prognum)
     int subst_bank, subst_prog, banknum = 0, result = FLUID_FAILED;
 
     fluid_return_val_if_fail(prognum >= 0 && prognum <= 128, FLUID_FAILED);
+
+    if(fluid_synth_queue_event(synth, 0, PROGRAM_CHANGE, chan, prognum, 0) == FLUID_OK)
+    {
+        return FLUID_OK;
+    }
+
     FLUID_API_ENTRY_CHAN(FLUID_FAILED);
 
     /* Allowed only on MIDI channel enabled */
@@ -3835,6 +4304,8 @@ fluid_synth_update_polyphony_LOCAL(fluid_synth_t *synth, int new_polyphony)
         /* Create more voices */
         fluid_voice_t **new_voices = FLUID_REALLOC(synth->voice,
                                      sizeof(fluid_voice_t *) * new_polyphony);
+        fluid_voice_t **new_heap;
+        int *new_frontier;
 
         if(new_voices == NULL)
         {
@@ -3843,15 +4314,34 @@ fluid_synth_update_polyphony_LOCAL(fluid_synth_t *synth, int new_polyphony)
 
         synth->voice = new_voices;
 
+        new_heap = FLUID_REALLOC(synth->overflow_heap, sizeof(fluid_voice_t *) * new_polyphony);
+
+        if(new_heap == NULL)
+        {
+            return FLUID_FAILED;
+        }
+
+        synth->overflow_heap = new_heap;
+
+        new_frontier = FLUID_REALLOC(synth->overflow_frontier, sizeof(int) * new_polyphony);
+
+        if(new_frontier == NULL)
+        {
+            return FLUID_FAILED;
+        }
+
+        synth->overflow_frontier = new_frontier;
+
         for(i = synth->nvoice; i < new_polyphony; i++)
         {
-            synth->voice[i] = new_fluid_voice(synth->eventhandler, synth->sample_rate, synth->iir_sincos_table);
+            synth->voice[i] = new_fluid_voice(synth->eventhandler, synth->sample_rate, synth->block_size, synth->iir_sincos_table);
 
             if(synth->voice[i] == NULL)
             {
                 return FLUID_FAILED;
             }
 
+            synth->voice[i]->synth_index = i;
             fluid_voice_set_custom_filter(synth->voice[i], synth->custom_filter_type, synth->custom_filter_flags);
         }
 
@@ -3859,6 +4349,7 @@ fluid_synth_update_polyphony_LOCAL(fluid_synth_t *synth, int new_polyphony)
     }
 
     synth->polyphony = new_polyphony;
+    synth->overflow_heap_dirty = TRUE;
 
     /* turn off any voices above the new limit */
     for(i = synth->polyphony; i < synth->nvoice; i++)
@@ -3930,11 +4421,13 @@ fluid_synth_get_active_voice_count(fluid_synth_t *synth)
  *
  * Audio is synthesized at this number of frames at a time. Defaults to 64 frames. I.e. the synth can only react to notes,
  * control changes, and other audio affecting events after having processed 64 audio frames.
+ * The value can be chosen at synth creation time with the setting \ref settings_synth_block-size.
  */
 int
 fluid_synth_get_internal_bufsize(fluid_synth_t *synth)
 {
-    return FLUID_BUFSIZE;
+    fluid_return_val_if_fail(synth != NULL, FLUID_FAILED);
+    return synth->block_size;
 }
 
 /**
@@ -4044,9 +4537,9 @@ fluid_synth_nwrite_float(fluid_synth_t *synth, int len,
     count = 0;
     num = synth->cur;
 
-    if(synth->cur < FLUID_BUFSIZE)
+    if(synth->cur < synth->block_size)
     {
-        available = FLUID_BUFSIZE - synth->cur;
+        available = synth->block_size - synth->cur;
         fluid_rvoice_mixer_get_bufs(synth->eventhandler->mixer, &left_in, &right_in);
         fluid_rvoice_mixer_get_fx_bufs(synth->eventhandler->mixer, &fx_left_in, &fx_right_in);
 
@@ -4120,7 +4613,7 @@ fluid_synth_nwrite_float(fluid_synth_t *synth, int len,
         fluid_rvoice_mixer_get_bufs(synth->eventhandler->mixer, &left_in, &right_in);
         fluid_rvoice_mixer_get_fx_bufs(synth->eventhandler->mixer, &fx_left_in, &fx_right_in);
 
-        num = (FLUID_BUFSIZE > len - count) ? len - count : FLUID_BUFSIZE;
+        num = (synth->block_size > len - count) ? len - count : synth->block_size;
 #ifdef WITH_FLOAT
         bytes = num * sizeof(float);
 #endif
@@ -4182,6 +4675,7 @@ fluid_synth_nwrite_float(fluid_synth_t *synth, int len,
     }
 
     synth->cur = num;
+    fluid_atomic_int_add(&synth->frames_output, len);
 
     time = fluid_utime() - time;
     cpu_load = 0.5 * (fluid_atomic_float_get(&synth->cpu_load) + time * synth->sample_rate / len / 10000.0);
@@ -4218,6 +4712,84 @@ static FLUID_INLINE void fluid_synth_mix_single_buffer(float *FLUID_RESTRICT out
     }
 }
 
+/*
+ * Mix num samples of all the mixer buffers that aren't silent, starting at
+ * ioff, to the buffers passed to fluid_synth_process(), starting at ooff.
+ */
+static void
+fluid_synth_mix_buffers(fluid_synth_t *synth, int nfx, float *fx[], int nout, float *out[],
+                        int ooff, int ioff, int num)
+{
+    fluid_rvoice_mixer_t *mixer = synth->eventhandler->mixer;
+    fluid_real_t *left_in, *fx_left_in;
+    fluid_real_t *right_in, *fx_right_in;
+    int i, f;
+
+    /* get internal mixer audio dry buffer's pointer (left and right channel) */
+    fluid_rvoice_mixer_get_bufs(mixer, &left_in, &right_in);
+    /* get internal mixer audio effect buffer's pointer (left and right channel) */
+    fluid_rvoice_mixer_get_fx_bufs(mixer, &fx_left_in, &fx_right_in);
+
+    /* mixing dry samples (or skip if requested by the caller) */
+    if(nout != 0)
+    {
+        for(i = 0; i < synth->audio_channels; i++)
+        {
+            if(!fluid_rvoice_mixer_is_buf_silent(mixer, i, FALSE))
+            {
+                /* mix num left samples from input mixer buffer (left_in) at input offset
+                   ioff to output buffer (out_buf) at offset ooff */
+                float *out_buf = out[(i * 2) % nout];
+                fluid_synth_mix_single_buffer(out_buf, ooff, left_in, ioff, i, num);
+                synth->process_audible[i * 2] = TRUE;
+            }
+
+            if(!fluid_rvoice_mixer_is_buf_silent(mixer, i, TRUE))
+            {
+                /* mix num right samples from input mixer buffer (right_in) at input offset
+                   ioff to output buffer (out_buf) at offset ooff */
+                float *out_buf = out[(i * 2 + 1) % nout];
+                fluid_synth_mix_single_buffer(out_buf, ooff, right_in, ioff, i, num);
+                synth->process_audible[i * 2 + 1] = TRUE;
+            }
+        }
+    }
+
+    /* mixing effects samples (or skip if requested by the caller) */
+    if(nfx != 0)
+    {
+        char *fx_audible = &synth->process_audible[synth->audio_channels * 2];
+
+        // loop over all effects units
+        for(f = 0; f < synth->effects_groups; f++)
+        {
+            // write out all effects (i.e. reverb and chorus)
+            for(i = 0; i < synth->effects_channels; i++)
+            {
+                int buf_idx = f * synth->effects_channels + i;
+
+                if(!fluid_rvoice_mixer_is_fx_buf_silent(mixer, buf_idx, FALSE))
+                {
+                    /* mix num left samples from input mixer buffer (fx_left_in) at input offset
+                       ioff to output buffer (out_buf) at offset ooff */
+                    float *out_buf = fx[(buf_idx * 2) % nfx];
+                    fluid_synth_mix_single_buffer(out_buf, ooff, fx_left_in, ioff, buf_idx, num);
+                    fx_audible[buf_idx * 2] = TRUE;
+                }
+
+                if(!fluid_rvoice_mixer_is_fx_buf_silent(mixer, buf_idx, TRUE))
+                {
+                    /* mix num right samples from input mixer buffer (fx_right_in) at input offset
+                       ioff to output buffer (out_buf) at offset ooff */
+                    float *out_buf = fx[(buf_idx * 2 + 1) % nfx];
+                    fluid_synth_mix_single_buffer(out_buf, ooff, fx_right_in, ioff, buf_idx, num);
+                    fx_audible[buf_idx * 2 + 1] = TRUE;
+                }
+            }
+        }
+    }
+}
+
 /**
  * Synthesize floating point audio to stereo audio channels
  * (implements the default interface #fluid_audio_func_t).
@@ -4327,12 +4899,10 @@ int
 fluid_synth_process_LOCAL(fluid_synth_t *synth, int len, int nfx, float *fx[],
                     int nout, float *out[], int (*block_render_func)(fluid_synth_t *, int))
 {
-    fluid_real_t *left_in, *fx_left_in;
-    fluid_real_t *right_in, *fx_right_in;
     int nfxchan, nfxunits, naudchan;
 
     double time = fluid_utime();
-    int i, f, num, count, buffered_blocks;
+    int num, count, buffered_blocks;
 
     float cpu_load;
 
@@ -4364,11 +4934,6 @@ fluid_synth_process_LOCAL(fluid_synth_t *synth, int len, int nfx, float *fx[],
     fluid_return_val_if_fail(0 <= nfx / 2 && nfx / 2 <= nfxchan * nfxunits, FLUID_FAILED);
     fluid_return_val_if_fail(0 <= nout / 2 && nout / 2 <= naudchan, FLUID_FAILED);
 
-    /* get internal mixer audio dry buffer's pointer (left and right channel) */
-    fluid_rvoice_mixer_get_bufs(synth->eventhandler->mixer, &left_in, &right_in);
-    /* get internal mixer audio effect buffer's pointer (left and right channel) */
-    fluid_rvoice_mixer_get_fx_bufs(synth->eventhandler->mixer, &fx_left_in, &fx_right_in);
-
     /* Conversely to fluid_synth_write_float(),fluid_synth_write_s16() (which handle only one
        stereo output) we don't want rendered audio effect mixed in internal audio dry buffers.
        FALSE instructs the mixer that internal audio effects will be mixed in respective internal
@@ -4376,59 +4941,24 @@ fluid_synth_process_LOCAL(fluid_synth_t *synth, int len, int nfx, float *fx[],
     */
     fluid_rvoice_mixer_set_mix_fx(synth->eventhandler->mixer, FALSE);
 
+    /* nothing has been mixed by this call so far */
+    FLUID_MEMSET(synth->process_audible, FALSE, (naudchan + nfxchan * nfxunits) * 2);
 
     /* First, take what's still available in the buffer */
     count = 0;
     /* synth->cur indicates if available samples are still in internal mixer buffer */
     num = synth->cur;
 
-    buffered_blocks = (synth->cur + FLUID_BUFSIZE - 1) / FLUID_BUFSIZE;
-    if(synth->cur < buffered_blocks * FLUID_BUFSIZE)
+    buffered_blocks = (synth->cur + synth->block_size - 1) / synth->block_size;
+    if(synth->cur < buffered_blocks * synth->block_size)
     {
         /* yes, available sample are in internal mixer buffer */
-        int available = (buffered_blocks * FLUID_BUFSIZE) - synth->cur;
+        int available = (buffered_blocks * synth->block_size) - synth->cur;
         num = (available > len) ? len : available;
 
-        /* mixing dry samples (or skip if requested by the caller) */
-        if(nout != 0)
-        {
-            for(i = 0; i < naudchan; i++)
-            {
-                /* mix num left samples from input mixer buffer (left_in) at input offset
-                   synth->cur to output buffer (out_buf) at offset 0 */
-                float *out_buf = out[(i * 2) % nout];
-                fluid_synth_mix_single_buffer(out_buf, 0, left_in, synth->cur, i, num);
-
-                /* mix num right samples from input mixer buffer (right_in) at input offset
-                   synth->cur to output buffer (out_buf) at offset 0 */
-                out_buf = out[(i * 2 + 1) % nout];
-                fluid_synth_mix_single_buffer(out_buf, 0, right_in, synth->cur, i, num);
-            }
-        }
-
-        /* mixing effects samples (or skip if requested by the caller) */
-        if(nfx != 0)
-        {
-            // loop over all effects units
-            for(f = 0; f < nfxunits; f++)
-            {
-                // write out all effects (i.e. reverb and chorus)
-                for(i = 0; i < nfxchan; i++)
-                {
-                    int buf_idx = f * nfxchan + i;
-
-                    /* mix num left samples from input mixer buffer (fx_left_in) at input offset
-                       synth->cur to output buffer (out_buf) at offset 0 */
-                    float *out_buf = fx[(buf_idx * 2) % nfx];
-                    fluid_synth_mix_single_buffer(out_buf, 0, fx_left_in, synth->cur, buf_idx, num);
-
-                    /* mix num right samples from input mixer buffer (fx_right_in) at input offset
-                       synth->cur to output buffer (out_buf) at offset 0 */
-                    out_buf = fx[(buf_idx * 2 + 1) % nfx];
-                    fluid_synth_mix_single_buffer(out_buf, 0, fx_right_in, synth->cur, buf_idx, num);
-                }
-            }
-        }
+        /* mix num samples from the mixer buffers at input offset synth->cur
+           to the output buffers at offset 0 */
+        fluid_synth_mix_buffers(synth, nfx, fx, nout, out, 0, synth->cur, num);
 
         count += num;
         num += synth->cur; /* if we're now done, num becomes the new synth->cur below */
@@ -4437,58 +4967,22 @@ fluid_synth_process_LOCAL(fluid_synth_t *synth, int len, int nfx, float *fx[],
     /* Then, render blocks and copy till we have 'len' samples  */
     while(count < len)
     {
-        /* always render full block multiple of FLUID_BUFSIZE */
-        int blocksleft = (len - count + FLUID_BUFSIZE - 1) / FLUID_BUFSIZE;
+        /* always render full block multiple of the block size */
+        int blocksleft = (len - count + synth->block_size - 1) / synth->block_size;
         /* render audio (dry and effect) to respective internal dry and effect buffers */
         int blockcount = block_render_func(synth, blocksleft);
 
-        num = (blockcount * FLUID_BUFSIZE > len - count) ? len - count : blockcount * FLUID_BUFSIZE;
-
-        /* mixing dry samples (or skip if requested by the caller) */
-        if(nout != 0)
-        {
-            for(i = 0; i < naudchan; i++)
-            {
-                /* mix num left samples from input mixer buffer (left_in) at input offset
-                   0 to output buffer (out_buf) at offset count */
-                float *out_buf = out[(i * 2) % nout];
-                fluid_synth_mix_single_buffer(out_buf, count, left_in, 0, i, num);
-
-                /* mix num right samples from input mixer buffer (right_in) at input offset
-                   0 to output buffer (out_buf) at offset count */
-                out_buf = out[(i * 2 + 1) % nout];
-                fluid_synth_mix_single_buffer(out_buf, count, right_in, 0, i, num);
-            }
-        }
-
-        /* mixing effects samples (or skip if requested by the caller) */
-        if(nfx != 0)
-        {
-            // loop over all effects units
-            for(f = 0; f < nfxunits; f++)
-            {
-                // write out all effects (i.e. reverb and chorus)
-                for(i = 0; i < nfxchan; i++)
-                {
-                    int buf_idx = f * nfxchan + i;
-
-                    /* mix num left samples from input mixer buffer (fx_left_in) at input offset
-                       0 to output buffer (out_buf) at offset count */
-                    float *out_buf = fx[(buf_idx * 2) % nfx];
-                    fluid_synth_mix_single_buffer(out_buf, count, fx_left_in, 0, buf_idx, num);
+        num = (blockcount * synth->block_size > len - count) ? len - count : blockcount * synth->block_size;
 
-                    /* mix num right samples from input mixer buffer (fx_right_in) at input offset
-                       0 to output buffer (out_buf) at offset count */
-                    out_buf = fx[(buf_idx * 2 + 1) % nfx];
-                    fluid_synth_mix_single_buffer(out_buf, count, fx_right_in, 0, buf_idx, num);
-                }
-            }
-        }
+        /* mix num samples from the mixer buffers at input offset 0
+           to the output buffers at offset count */
+        fluid_synth_mix_buffers(synth, nfx, fx, nout, out, count, 0, num);
 
         count += num;
     }
 
     synth->cur = num;
+    fluid_atomic_int_add(&synth->frames_output, len);
 
     time = fluid_utime() - time;
     cpu_load = 0.5 * (fluid_atomic_float_get(&synth->cpu_load) + time * synth->sample_rate / len / 10000.0);
@@ -4498,6 +4992,74 @@ fluid_synth_process_LOCAL(fluid_synth_t *synth, int len, int nfx, float *fx[],
 }
 
 
+/**
+ * Tell which of the buffers passed to the last call of fluid_synth_process() did not receive any audio.
+ *
+ * @param synth FluidSynth instance
+ * @param nfx Count of elements in \c fx_silent, the same as passed to fluid_synth_process()
+ * @param fx_silent Array receiving one flag per effects buffer: TRUE if no audio has been mixed into
+ * the respective buffer of \c fx, FALSE otherwise
+ * @param nout Count of elements in \c out_silent, the same as passed to fluid_synth_process()
+ * @param out_silent Array receiving one flag per dry buffer: TRUE if no audio has been mixed into
+ * the respective buffer of \c out, FALSE otherwise
+ * @return #FLUID_OK on success,
+ * #FLUID_FAILED otherwise,
+ *  - <code>fx_silent == NULL</code> while <code>nfx > 0</code>, or <code>out_silent == NULL</code> while <code>nout > 0</code>.
+ *  - \c nfx or \c nout not multiple of 2 or out of the range explained at fluid_synth_process().
+ *
+ * The flags follow the buffer layout explained at fluid_synth_process(), including the wrap around
+ * of audio and effects channels. Since fluid_synth_process() only mixes audio into the buffers,
+ * a buffer flagged silent still holds whatever it held before that call (i.e. typically zeros).
+ * An audio driver may use this to skip the postprocessing or conversion of such buffers.
+ *
+ * @note Should only be called from synthesis thread.
+ */
+int
+fluid_synth_get_silent_buffers(fluid_synth_t *synth, int nfx, int fx_silent[],
+                               int nout, int out_silent[])
+{
+    int i;
+    const char *fx_audible;
+
+    fluid_return_val_if_fail(synth != NULL, FLUID_FAILED);
+    fluid_return_val_if_fail((fx_silent != NULL) || (nfx == 0), FLUID_FAILED);
+    fluid_return_val_if_fail((out_silent != NULL) || (nout == 0), FLUID_FAILED);
+    fluid_return_val_if_fail(nfx % 2 == 0 && 0 <= nfx / 2
+                             && nfx / 2 <= synth->effects_channels * synth->effects_groups, FLUID_FAILED);
+    fluid_return_val_if_fail(nout % 2 == 0 && 0 <= nout / 2 && nout / 2 <= synth->audio_channels, FLUID_FAILED);
+
+    for(i = 0; i < nout; i++)
+    {
+        out_silent[i] = TRUE;
+    }
+
+    for(i = 0; nout != 0 && i < synth->audio_channels * 2; i++)
+    {
+        if(synth->process_audible[i])
+        {
+            out_silent[i % nout] = FALSE;
+        }
+    }
+
+    for(i = 0; i < nfx; i++)
+    {
+        fx_silent[i] = TRUE;
+    }
+
+    fx_audible = &synth->process_audible[synth->audio_channels * 2];
+
+    for(i = 0; nfx != 0 && i < synth->effects_channels * synth->effects_groups * 2; i++)
+    {
+        if(fx_audible[i])
+        {
+            fx_silent[i % nfx] = FALSE;
+        }
+    }
+
+    return FLUID_OK;
+}
+
+
 /**
  * Synthesize a block of floating point audio samples to audio buffers.
  * @param synth FluidSynth instance
@@ -4643,9 +5205,9 @@ fluid_synth_write_float_channels_LOCAL(fluid_synth_t *synth, int len,
         if(cur >= synth->curmax)
         {
             /* render audio (dry and effect) to internal dry buffers */
-            /* always render full blocks multiple of FLUID_BUFSIZE */
-            int blocksleft = (size + FLUID_BUFSIZE - 1) / FLUID_BUFSIZE;
-            synth->curmax = FLUID_BUFSIZE * block_render_func(synth, blocksleft);
+            /* always render full blocks multiple of the block size */
+            int blocksleft = (size + synth->block_size - 1) / synth->block_size;
+            synth->curmax = synth->block_size * block_render_func(synth, blocksleft);
 
             /* get first internal mixer audio dry buffer's pointer (left and right channel) */
             fluid_rvoice_mixer_get_bufs(synth->eventhandler->mixer, &left_in, &right_in);
@@ -4699,6 +5261,7 @@ fluid_synth_write_float_channels_LOCAL(fluid_synth_t *synth, int len,
     while(size);
 
     synth->cur = cur; /* save current sample position. It will be used on next call */
+    fluid_atomic_int_add(&synth->frames_output, len);
 
     /* save average cpu load, use by API for real time cpu load meter */
     time = fluid_utime() - time;
@@ -4921,9 +5484,9 @@ fluid_synth_write_s16_channels(fluid_synth_t *synth, int len,
         if(cur >= synth->curmax)
         {
             /* render audio (dry and effect) to internal dry buffers */
-            /* always render full blocks multiple of FLUID_BUFSIZE */
-            int blocksleft = (size + FLUID_BUFSIZE - 1) / FLUID_BUFSIZE;
-            synth->curmax = FLUID_BUFSIZE * fluid_synth_render_blocks(synth, blocksleft);
+            /* always render full blocks multiple of the block size */
+            int blocksleft = (size + synth->block_size - 1) / synth->block_size;
+            synth->curmax = synth->block_size * fluid_synth_render_blocks(synth, blocksleft);
 
             /* get first internal mixer audio dry buffer's pointer (left and right channel) */
             fluid_rvoice_mixer_get_bufs(synth->eventhandler->mixer, &left_in, &right_in);
@@ -4983,6 +5546,7 @@ fluid_synth_write_s16_channels(fluid_synth_t *synth, int len,
     while(size);
 
     synth->cur = cur; /* save current sample position. It will be used on next call */
+    fluid_atomic_int_add(&synth->frames_output, len);
     synth->dither_index = di;	/* keep dither buffer continuous */
 
     /* save average cpu load, used by API for real time cpu load meter */
@@ -5091,8 +5655,155 @@ void fluid_synth_process_event_queue(fluid_synth_t *synth)
 }
 
 
+/* samples left in the internal buffers from the last block rendered */
+static int fluid_synth_get_buffered_frames(fluid_synth_t *synth)
+{
+    return (synth->block_size - synth->cur % synth->block_size) % synth->block_size;
+}
+
+/*
+ * Returns the offset in frames of the event currently processed, relative to
+ * the first frame of the next block to be rendered. Frames that have been
+ * rendered already, but not yet been output, are accounted for. Called by
+ * the voices when they are started or released.
+ */
+int fluid_synth_get_event_offset_LOCAL(fluid_synth_t *synth)
+{
+    int buffered = fluid_synth_get_buffered_frames(synth);
+
+    return synth->event_offset > buffered ? synth->event_offset - buffered : 0;
+}
+
+/*
+ * Pushes a channel message into the MIDI queue instead of handling it right
+ * away, when synth.midi-queue-size is enabled. Called by the public channel
+ * message functions after checking their arguments.
+ *
+ * Apart from the queue, only the atomic count of frames output is read, so that
+ * producers never wait for each other nor for the rendering.
+ *
+ * @param frame_offset offset of the message in frames, see fluid_synth_noteon_at()
+ * @return #FLUID_OK if the message has been queued, #FLUID_FAILED if the caller
+ *   must handle it (no queue, invalid channel, queue full or called while
+ *   applying the queued messages)
+ */
+static int
+fluid_synth_queue_event(fluid_synth_t *synth, int frame_offset, int type, int chan,
+                        int param1, int param2)
+{
+    fluid_synth_queued_event_t event;
+
+    if(synth == NULL || synth->midi_queue == NULL
+            || chan < 0 || chan >= synth->midi_channels
+            || fluid_private_get(synth->midi_queue_draining) != NULL)
+    {
+        return FLUID_FAILED;
+    }
+
+    event.chan = (short)chan;
+    event.type = (unsigned char)type;
+    event.param1 = (unsigned char)param1;
+    event.param2 = (short)param2;
+    event.time = (unsigned int)fluid_atomic_int_get(&synth->frames_output) + (unsigned int)frame_offset;
+
+    /* When the queue is full, the caller handles the message with the API held.
+     * Entering the API applies the queued messages first, so that it doesn't
+     * overtake them. */
+    return fluid_mpsc_queue_push(synth->midi_queue, &event);
+}
+
+/*
+ * Applies the channel messages of the MIDI queue, in the order they were pushed.
+ * The caller holds the API, which makes it the only consumer of the queue.
+ */
+static void
+fluid_synth_apply_queued_events_LOCAL(fluid_synth_t *synth)
+{
+    fluid_synth_queued_event_t event;
+    int event_offset = synth->event_offset;
+    int count = synth->midi_queue->mask + 1;
+    int offset;
+
+    /* the public functions handle the messages themselves from now on */
+    fluid_private_set(synth->midi_queue_draining, FLUID_INT_TO_POINTER(1));
+
+    /* at most one queue full, producers may keep on pushing */
+    while(count-- > 0 && fluid_mpsc_queue_pop(synth->midi_queue, &event) == FLUID_OK)
+    {
+        /* frames output since the message was pushed count towards its offset */
+        offset = (int)(event.time - (unsigned int)fluid_atomic_int_get(&synth->frames_output));
+        synth->event_offset = (offset > 0) ? offset : 0;
+
+        switch(event.type)
+        {
+        case NOTE_ON:
+            fluid_synth_noteon(synth, event.chan, event.param1, event.param2);
+            break;
+
+        case NOTE_OFF:
+            fluid_synth_noteoff(synth, event.chan, event.param1);
+            break;
+
+        case CONTROL_CHANGE:
+            fluid_synth_cc(synth, event.chan, event.param1, event.param2);
+            break;
+
+        case PROGRAM_CHANGE:
+            fluid_synth_program_change(synth, event.chan, event.param1);
+            break;
+
+        case CHANNEL_PRESSURE:
+            fluid_synth_channel_pressure(synth, event.chan, event.param1);
+            break;
+
+        case KEY_PRESSURE:
+            fluid_synth_key_pressure(synth, event.chan, event.param1, event.param2);
+            break;
+
+        case PITCH_BEND:
+            fluid_synth_pitch_bend(synth, event.chan, event.param2);
+            break;
+
+        default:
+            break;
+        }
+    }
+
+    synth->event_offset = event_offset;
+    fluid_private_set(synth->midi_queue_draining, NULL);
+}
+
+/*
+ * Applies the queued channel messages from the render thread. The API is only
+ * entered if there is something to apply, and the render thread never waits
+ * for the mutex: when another thread holds it, that thread has applied the
+ * messages queued before, the ones queued since then wait for the next block.
+ */
+static void
+fluid_synth_apply_queued_events(fluid_synth_t *synth)
+{
+    if(synth->midi_queue == NULL || !fluid_mpsc_queue_ready(synth->midi_queue))
+    {
+        return;
+    }
+
+    if(synth->use_mutex && !fluid_rec_mutex_trylock(synth->mutex))
+    {
+        return;
+    }
+
+    /* fluid_synth_api_enter() applies them */
+    fluid_synth_api_enter(synth);
+    fluid_synth_api_exit(synth);
+
+    if(synth->use_mutex)
+    {
+        fluid_rec_mutex_unlock(synth->mutex);
+    }
+}
+
 /**
- * Process blocks (FLUID_BUFSIZE) of audio.
+ * Process blocks (synth->block_size samples each) of audio.
  * Must be called from renderer thread only!
  * @return number of blocks rendered. Might (often) return less than requested
  */
@@ -5107,6 +5818,8 @@ fluid_synth_render_blocks(fluid_synth_t *synth, int blockcount)
 
     fluid_check_fpe("??? Just starting up ???");
 
+    fluid_synth_apply_queued_events(synth);
+    fluid_synth_modulate_dirty_voices(synth);
     fluid_rvoice_eventhandler_dispatch_all(synth->eventhandler);
 
     /* do not render more blocks than we can store internally */
@@ -5120,7 +5833,9 @@ fluid_synth_render_blocks(fluid_synth_t *synth, int blockcount)
     for(i = 0; i < blockcount; i++)
     {
         fluid_sample_timer_process(synth);
-        fluid_synth_add_ticks(synth, FLUID_BUFSIZE);
+        fluid_synth_apply_queued_events(synth);
+        fluid_synth_modulate_dirty_voices(synth);
+        fluid_synth_add_ticks(synth, synth->block_size);
 
         /* If events have been queued waiting for fluid_rvoice_eventhandler_dispatch_all()
          * (should only happen with parallel render) stop processing and go for rendering
@@ -5151,7 +5866,7 @@ fluid_synth_render_blocks(fluid_synth_t *synth, int blockcount)
     fluid_check_fpe("??? Remainder of synth_one_block ???");
     fluid_profile(FLUID_PROF_ONE_BLOCK, prof_ref,
                   fluid_rvoice_mixer_get_active_voices(synth->eventhandler->mixer),
-                  blockcount * FLUID_BUFSIZE);
+                  blockcount * synth->block_size);
     return blockcount;
 }
 
@@ -5215,6 +5930,28 @@ static void fluid_synth_handle_reverb_chorus_int(void *data, const char *name, i
     }
 }
 
+/*
+ * Handler for the double settings of the insert effects, e.g. synth.limiter.ceiling.
+ */
+static void fluid_synth_handle_insert_fx_num(void *data, const char *name, double value)
+{
+    static const char prefix[] = "synth.";
+    fluid_synth_t *synth = (fluid_synth_t *)data;
+    fluid_return_if_fail(synth != NULL);
+    fluid_return_if_fail(FLUID_STRNCMP(name, prefix, FLUID_STRLEN(prefix)) == 0);
+
+    fluid_synth_set_insert_fx_param(synth, FLUID_INSERT_FX_AUDIO_GROUP, -1,
+                                    fluid_insertfx_param_index(name + FLUID_STRLEN(prefix)), value);
+}
+
+/*
+ * Handler for the integer settings of the insert effects, e.g. synth.limiter.active.
+ */
+static void fluid_synth_handle_insert_fx_int(void *data, const char *name, int value)
+{
+    fluid_synth_handle_insert_fx_num(data, name, (double)value);
+}
+
 /*
  * Handler for synth.overflow.* settings.
  */
@@ -5231,69 +5968,367 @@ static void fluid_synth_handle_overflow(void *data, const char *name, double val
     }
     else if(FLUID_STRCMP(name, "synth.overflow.released") == 0)
     {
-        synth->overflow.released = value;
+        synth->overflow.released = value;
+    }
+    else if(FLUID_STRCMP(name, "synth.overflow.sustained") == 0)
+    {
+        synth->overflow.sustained = value;
+    }
+    else if(FLUID_STRCMP(name, "synth.overflow.volume") == 0)
+    {
+        synth->overflow.volume = value;
+    }
+    else if(FLUID_STRCMP(name, "synth.overflow.age") == 0)
+    {
+        synth->overflow.age = value;
+    }
+    else if(FLUID_STRCMP(name, "synth.overflow.important") == 0)
+    {
+        synth->overflow.important = value;
+    }
+
+    synth->overflow_heap_dirty = TRUE;
+
+    fluid_synth_api_exit(synth);
+}
+
+/*
+ * Voice stealing.
+ *
+ * The playing voices are kept in a binary min-heap ordered by the part of their
+ * overflow priority that doesn't change while they play (see
+ * fluid_voice_get_overflow_base_prio()), and in a list ordered by their start
+ * time. The age score only decreases as a voice gets older, so the age score of
+ * the oldest voice is a lower bound for all of them. This lets
+ * fluid_synth_free_voice_by_kill_LOCAL() evaluate the exact priority of only the
+ * few voices whose base priority plus that bound can still beat the best
+ * candidate found so far, instead of all of them.
+ */
+
+static int
+fluid_synth_overflow_less(const fluid_voice_t *a, const fluid_voice_t *b)
+{
+    if(a->overflow_base_prio != b->overflow_base_prio)
+    {
+        return a->overflow_base_prio < b->overflow_base_prio;
+    }
+
+    /* older voices first, they can't score higher for their age */
+    return a->start_time < b->start_time;
+}
+
+static void
+fluid_synth_overflow_heap_set(fluid_synth_t *synth, int pos, fluid_voice_t *voice)
+{
+    synth->overflow_heap[pos] = voice;
+    voice->overflow_heap_index = pos;
+}
+
+/* Moves the voice at heap position pos up or down to where it belongs */
+static void
+fluid_synth_overflow_heap_fix(fluid_synth_t *synth, int pos)
+{
+    fluid_voice_t **heap = synth->overflow_heap;
+    fluid_voice_t *voice = heap[pos];
+    int child;
+
+    while(pos > 0 && fluid_synth_overflow_less(voice, heap[(pos - 1) / 2]))
+    {
+        fluid_synth_overflow_heap_set(synth, pos, heap[(pos - 1) / 2]);
+        pos = (pos - 1) / 2;
+    }
+
+    while((child = 2 * pos + 1) < synth->overflow_heap_count)
+    {
+        if(child + 1 < synth->overflow_heap_count && fluid_synth_overflow_less(heap[child + 1], heap[child]))
+        {
+            child++;
+        }
+
+        if(!fluid_synth_overflow_less(heap[child], voice))
+        {
+            break;
+        }
+
+        fluid_synth_overflow_heap_set(synth, pos, heap[child]);
+        pos = child;
+    }
+
+    fluid_synth_overflow_heap_set(synth, pos, voice);
+}
+
+/* Adds a started voice to the candidates for voice stealing */
+void
+fluid_synth_overflow_add_LOCAL(fluid_synth_t *synth, fluid_voice_t *voice)
+{
+    fluid_voice_t *prev;
+
+    if(voice->overflow_heap_index >= 0)
+    {
+        fluid_synth_overflow_update_LOCAL(synth, voice);
+        return;
+    }
+
+    voice->overflow_base_prio = fluid_voice_get_overflow_base_prio(voice, &synth->overflow);
+    fluid_synth_overflow_heap_set(synth, synth->overflow_heap_count++, voice);
+    fluid_synth_overflow_heap_fix(synth, voice->overflow_heap_index);
+
+    /* voices are almost always started in order, so this rarely walks */
+    for(prev = synth->overflow_newest;
+            prev != NULL && prev->start_time > voice->start_time;
+            prev = prev->age_prev)
+    {
+    }
+
+    voice->age_prev = prev;
+    voice->age_next = (prev != NULL) ? prev->age_next : synth->overflow_oldest;
+
+    if(voice->age_next != NULL)
+    {
+        voice->age_next->age_prev = voice;
+    }
+    else
+    {
+        synth->overflow_newest = voice;
+    }
+
+    if(prev != NULL)
+    {
+        prev->age_next = voice;
+    }
+    else
+    {
+        synth->overflow_oldest = voice;
+    }
+}
+
+/* Removes a voice from the candidates for voice stealing, if it is one */
+void
+fluid_synth_overflow_remove_LOCAL(fluid_synth_t *synth, fluid_voice_t *voice)
+{
+    int pos = voice->overflow_heap_index;
+    fluid_voice_t *last;
+
+    if(pos < 0)
+    {
+        return;
+    }
+
+    voice->overflow_heap_index = -1;
+    last = synth->overflow_heap[--synth->overflow_heap_count];
+
+    if(last != voice)
+    {
+        fluid_synth_overflow_heap_set(synth, pos, last);
+        fluid_synth_overflow_heap_fix(synth, pos);
+    }
+
+    if(voice->age_prev != NULL)
+    {
+        voice->age_prev->age_next = voice->age_next;
+    }
+    else
+    {
+        synth->overflow_oldest = voice->age_next;
+    }
+
+    if(voice->age_next != NULL)
+    {
+        voice->age_next->age_prev = voice->age_prev;
+    }
+    else
+    {
+        synth->overflow_newest = voice->age_prev;
+    }
+
+    voice->age_prev = voice->age_next = NULL;
+}
+
+/* Reorders a voice after something its overflow base priority depends on has changed */
+void
+fluid_synth_overflow_update_LOCAL(fluid_synth_t *synth, fluid_voice_t *voice)
+{
+    float prio;
+
+    if(voice->overflow_heap_index < 0)
+    {
+        return;
+    }
+
+    prio = fluid_voice_get_overflow_base_prio(voice, &synth->overflow);
+
+    if(prio != voice->overflow_base_prio)
+    {
+        voice->overflow_base_prio = prio;
+        fluid_synth_overflow_heap_fix(synth, voice->overflow_heap_index);
     }
-    else if(FLUID_STRCMP(name, "synth.overflow.sustained") == 0)
+}
+
+/* Recreates the overflow heap, after a change of the scores, the channel types or the polyphony */
+static void
+fluid_synth_overflow_rebuild_LOCAL(fluid_synth_t *synth)
+{
+    int i;
+
+    for(i = 0; i < synth->nvoice; i++)
     {
-        synth->overflow.sustained = value;
+        synth->voice[i]->overflow_heap_index = -1;
+        synth->voice[i]->age_prev = synth->voice[i]->age_next = NULL;
     }
-    else if(FLUID_STRCMP(name, "synth.overflow.volume") == 0)
+
+    synth->overflow_heap_count = 0;
+    synth->overflow_oldest = synth->overflow_newest = NULL;
+
+    for(i = 0; i < synth->polyphony; i++)
     {
-        synth->overflow.volume = value;
+        if(!_AVAILABLE(synth->voice[i]))
+        {
+            fluid_synth_overflow_add_LOCAL(synth, synth->voice[i]);
+        }
     }
-    else if(FLUID_STRCMP(name, "synth.overflow.age") == 0)
+
+    synth->overflow_heap_dirty = FALSE;
+}
+
+/* Pops the heap position with the lowest overflow base priority off the search frontier */
+static int
+fluid_synth_overflow_frontier_pop(fluid_synth_t *synth, int *count)
+{
+    fluid_voice_t **heap = synth->overflow_heap;
+    int *frontier = synth->overflow_frontier;
+    int top = frontier[0];
+    int last = frontier[--(*count)];
+    int pos = 0, child;
+
+    while((child = 2 * pos + 1) < *count)
     {
-        synth->overflow.age = value;
+        if(child + 1 < *count
+                && heap[frontier[child + 1]]->overflow_base_prio < heap[frontier[child]]->overflow_base_prio)
+        {
+            child++;
+        }
+
+        if(heap[last]->overflow_base_prio <= heap[frontier[child]]->overflow_base_prio)
+        {
+            break;
+        }
+
+        frontier[pos] = frontier[child];
+        pos = child;
     }
-    else if(FLUID_STRCMP(name, "synth.overflow.important") == 0)
+
+    frontier[pos] = last;
+
+    return top;
+}
+
+static void
+fluid_synth_overflow_frontier_push(fluid_synth_t *synth, int *count, int heap_pos)
+{
+    fluid_voice_t **heap = synth->overflow_heap;
+    int *frontier = synth->overflow_frontier;
+    int pos = (*count)++;
+
+    while(pos > 0 && heap[heap_pos]->overflow_base_prio < heap[frontier[(pos - 1) / 2]]->overflow_base_prio)
     {
-        synth->overflow.important = value;
+        frontier[pos] = frontier[(pos - 1) / 2];
+        pos = (pos - 1) / 2;
     }
 
-    fluid_synth_api_exit(synth);
+    frontier[pos] = heap_pos;
+}
+
+/* Among voices of equal priority, the first one in fluid_synth_t::voice is killed */
+static int
+fluid_synth_overflow_better(const fluid_voice_t *voice, float prio,
+                            const fluid_voice_t *best_voice, float best_prio)
+{
+    return prio < best_prio
+           || (prio == best_prio && best_voice != NULL && voice->synth_index < best_voice->synth_index);
 }
 
 /* Selects a voice for killing. */
 static fluid_voice_t *
 fluid_synth_free_voice_by_kill_LOCAL(fluid_synth_t *synth)
 {
-    int i;
+    int i, count;
     float best_prio = OVERFLOW_PRIO_CANNOT_KILL - 1;
-    float this_voice_prio;
+    float this_voice_prio, age_bound;
     fluid_voice_t *voice;
-    int best_voice_index = -1;
+    fluid_voice_t *best_voice = NULL;
     unsigned int ticks = fluid_synth_get_ticks(synth);
 
-    for(i = 0; i < synth->polyphony; i++)
-    {
+    /* the volume of the voices must be up to date */
+    fluid_synth_modulate_dirty_voices_LOCAL(synth);
 
-        voice = synth->voice[i];
+    if(synth->overflow_heap_dirty)
+    {
+        fluid_synth_overflow_rebuild_LOCAL(synth);
+    }
 
-        /* safeguard against an available voice. */
-        if(_AVAILABLE(voice))
+    if(synth->overflow.age < 0)
+    {
+        /* younger voices score lower, there is no bound to prune with */
+        for(i = 0; i < synth->overflow_heap_count; i++)
         {
-            return voice;
+            voice = synth->overflow_heap[i];
+            this_voice_prio = fluid_voice_get_overflow_prio(voice, &synth->overflow, ticks);
+
+            if(fluid_synth_overflow_better(voice, this_voice_prio, best_voice, best_prio))
+            {
+                best_voice = voice;
+                best_prio = this_voice_prio;
+            }
         }
+    }
+    else if(synth->overflow_heap_count > 0)
+    {
+        age_bound = fluid_voice_get_overflow_age_prio(synth->overflow_oldest, &synth->overflow, ticks);
 
-        this_voice_prio = fluid_voice_get_overflow_prio(voice, &synth->overflow,
-                          ticks);
+        count = 0;
+        fluid_synth_overflow_frontier_push(synth, &count, 0);
 
-        /* check if this voice has less priority than the previous candidate. */
-        if(this_voice_prio < best_prio)
+        while(count > 0)
         {
-            best_voice_index = i;
-            best_prio = this_voice_prio;
+            i = fluid_synth_overflow_frontier_pop(synth, &count);
+            voice = synth->overflow_heap[i];
+
+            /* nothing left in the frontier or below it can score lower, the
+             * priority is computed as the very same sum with a larger age score */
+            if(voice->overflow_base_prio >= OVERFLOW_PRIO_CANNOT_KILL
+                    || voice->overflow_base_prio + age_bound > best_prio)
+            {
+                break;
+            }
+
+            this_voice_prio = fluid_voice_get_overflow_prio(voice, &synth->overflow, ticks);
+
+            if(fluid_synth_overflow_better(voice, this_voice_prio, best_voice, best_prio))
+            {
+                best_voice = voice;
+                best_prio = this_voice_prio;
+            }
+
+            if(2 * i + 1 < synth->overflow_heap_count)
+            {
+                fluid_synth_overflow_frontier_push(synth, &count, 2 * i + 1);
+            }
+
+            if(2 * i + 2 < synth->overflow_heap_count)
+            {
+                fluid_synth_overflow_frontier_push(synth, &count, 2 * i + 2);
+            }
         }
     }
 
-    if(best_voice_index < 0)
+    if(best_voice == NULL)
     {
         return NULL;
     }
 
-    voice = synth->voice[best_voice_index];
-    FLUID_LOG(FLUID_DBG, "Killing voice %d, index %d, chan %d, key %d ",
-              fluid_voice_get_id(voice), best_voice_index, fluid_voice_get_channel(voice), fluid_voice_get_key(voice));
+    voice = best_voice;
+    FLUID_LOG(FLUID_DBG, "Killing voice %d, chan %d, key %d ",
+              fluid_voice_get_id(voice), fluid_voice_get_channel(voice), fluid_voice_get_key(voice));
     fluid_voice_off(voice);
 
     return voice;
@@ -5443,7 +6478,7 @@ fluid_synth_kill_by_exclusive_class_LOCAL(fluid_synth_t *synth,
         fluid_voice_t *new_voice)
 {
     int excl_class = fluid_voice_gen_value(new_voice, GEN_EXCLUSIVECLASS);
-    int i;
+    fluid_voice_t *existing_voice, *next;
 
     /* Excl. class 0: No exclusive class */
     if(excl_class == 0)
@@ -5452,15 +6487,14 @@ fluid_synth_kill_by_exclusive_class_LOCAL(fluid_synth_t *synth,
     }
 
     /* Kill all notes on the same channel with the same exclusive class */
-    for(i = 0; i < synth->polyphony; i++)
+    for(existing_voice = fluid_channel_first_voice(new_voice->channel); existing_voice != NULL; existing_voice = next)
     {
-        fluid_voice_t *existing_voice = synth->voice[i];
+        next = existing_voice->chan_next;
 
-        /* If voice is playing, on the same channel, has same exclusive
-         * class and is not part of the same noteon event (voice group), then kill it */
+        /* If voice is playing, has same exclusive class and is not part
+         * of the same noteon event (voice group), then kill it */
 
         if(fluid_voice_is_playing(existing_voice)
-                && fluid_voice_get_channel(existing_voice) == fluid_voice_get_channel(new_voice)
                 && fluid_voice_gen_value(existing_voice, GEN_EXCLUSIVECLASS) == excl_class
                 && fluid_voice_get_id(existing_voice) != fluid_voice_get_id(new_voice))
         {
@@ -6325,6 +7359,217 @@ fluid_synth_set_reverb_full(fluid_synth_t *synth, int fx_group, int set,
                                          param);
 }
 
+/*
+ * Deletes a swap of convolution reverbs, and the ones it holds: the replaced
+ * ones once the mixer is done with it, or those never handed to the mixer.
+ */
+static void
+fluid_synth_delete_convrev_swap(fluid_mixer_convrev_swap_t *swap)
+{
+    int i;
+
+    fluid_return_if_fail(swap != NULL);
+
+    if(swap->convrev != NULL)
+    {
+        for(i = 0; i < swap->count; i++)
+        {
+            delete_fluid_convrev(swap->convrev[i]);
+        }
+    }
+
+    FLUID_FREE(swap->convrev);
+    FLUID_FREE(swap);
+}
+
+/*
+ * Deletes the convolution reverbs the mixer has replaced since the last call.
+ */
+static void
+fluid_synth_check_convrev_swaps(fluid_synth_t *synth)
+{
+    fluid_list_t *list, *next;
+    fluid_mixer_convrev_swap_t *swap;
+
+    for(list = synth->convrev_swaps; list; list = next)
+    {
+        next = fluid_list_next(list);
+        swap = fluid_list_get(list);
+
+        if(fluid_atomic_int_get(&swap->done))
+        {
+            synth->convrev_swaps = fluid_list_remove(synth->convrev_swaps, swap);
+            fluid_synth_delete_convrev_swap(swap);
+        }
+    }
+}
+
+/*
+ * Hands new convolution reverbs to the mixer for fx_group, or for every fx
+ * group if -1. The impulse response is read from filename if not NULL, from
+ * left and right otherwise, and transformed once for all the groups. If both
+ * filename and left are NULL, the built-in reverb is restored.
+ * Nothing is handed to the mixer unless the reverbs of all the groups could
+ * be created.
+ */
+static int
+fluid_synth_set_reverb_convrev_LOCAL(fluid_synth_t *synth, int fx_group,
+                                     const char *filename, const float *left, const float *right,
+                                     int frames, double sample_rate)
+{
+    fluid_rvoice_param_t param[MAX_EVENT_PARAMS];
+    fluid_mixer_convrev_swap_t *swap;
+    fluid_convrev_ir_t *ir = NULL;
+    int i;
+
+    if(fx_group < -1 || fx_group >= synth->effects_groups)
+    {
+        return FLUID_FAILED;
+    }
+
+    if(filename != NULL)
+    {
+        ir = new_fluid_convrev_ir_from_file(filename, synth->sample_rate);
+    }
+    else if(left != NULL)
+    {
+        ir = new_fluid_convrev_ir(left, right, frames, sample_rate, synth->sample_rate);
+    }
+
+    if((filename != NULL || left != NULL) && ir == NULL)
+    {
+        return FLUID_FAILED;
+    }
+
+    swap = FLUID_NEW(fluid_mixer_convrev_swap_t);
+
+    if(swap == NULL)
+    {
+        FLUID_LOG(FLUID_ERR, "Out of memory");
+        delete_fluid_convrev_ir(ir);
+        return FLUID_FAILED;
+    }
+
+    FLUID_MEMSET(swap, 0, sizeof(*swap));
+    swap->first = (fx_group < 0) ? 0 : fx_group;
+    swap->count = (fx_group < 0) ? synth->effects_groups : 1;
+    fluid_atomic_int_set(&swap->done, FALSE);
+    swap->convrev = FLUID_ARRAY(fluid_convrev_t *, swap->count);
+
+    if(swap->convrev == NULL)
+    {
+        FLUID_LOG(FLUID_ERR, "Out of memory");
+        goto error_recovery;
+    }
+
+    FLUID_MEMSET(swap->convrev, 0, swap->count * sizeof(*swap->convrev));
+
+    /* every group has its own state, sharing the impulse response */
+    for(i = 0; ir != NULL && i < swap->count; i++)
+    {
+        swap->convrev[i] = new_fluid_convrev(ir);
+
+        if(swap->convrev[i] == NULL)
+        {
+            goto error_recovery;
+        }
+
+        fluid_convrev_set(swap->convrev[i], FLUID_REVMODEL_SET_WIDTH | FLUID_REVMODEL_SET_LEVEL,
+                          fluid_rvoice_mixer_reverb_get_param(synth->eventhandler->mixer, swap->first + i, FLUID_REVERB_WIDTH),
+                          fluid_rvoice_mixer_reverb_get_param(synth->eventhandler->mixer, swap->first + i, FLUID_REVERB_LEVEL));
+    }
+
+    param[0].ptr = swap;
+
+    if(fluid_rvoice_eventhandler_push(synth->eventhandler,
+                                      fluid_rvoice_mixer_set_reverb_convrev,
+                                      synth->eventhandler->mixer,
+                                      param) != FLUID_OK)
+    {
+        goto error_recovery;
+    }
+
+    synth->convrev_swaps = fluid_list_prepend(synth->convrev_swaps, swap);
+    delete_fluid_convrev_ir(ir);
+
+    return FLUID_OK;
+
+error_recovery:
+    fluid_synth_delete_convrev_swap(swap);
+    delete_fluid_convrev_ir(ir);
+    return FLUID_FAILED;
+}
+
+/**
+ * Replace the reverb of one or all fx groups by a convolution reverb.
+ * @param synth FluidSynth instance.
+ * @param fx_group Index of the fx group.
+ *  Must be in the range <code>-1 to (fluid_synth_count_effects_groups()-1)</code>. If -1 the
+ *  impulse response will be used by all fx groups.
+ * @param filename Sound file holding the impulse response (mono or stereo, any format supported
+ *  by libsndfile), NULL to restore the built-in reverb.
+ * @return #FLUID_OK on success, #FLUID_FAILED otherwise, e.g. if the file can't be read or
+ *  fluidsynth has been compiled without libsndfile support.
+ *
+ * The impulse response is resampled to the synth's sample rate and normalized to unit energy.
+ * The convolution doesn't add any latency. The width and level of the reverb (see
+ * fluid_synth_set_reverb_group_width() and fluid_synth_set_reverb_group_level()) still apply,
+ * the room size and damping are up to the impulse response.
+ *
+ * @note The impulse response is loaded and transformed by the calling thread, which may take a
+ * while for long ones.
+ * The impulse response isn't resampled again by fluid_synth_set_sample_rate(), it has to be
+ * loaded again after a change of the sample rate.
+ * @since 2.5.0
+ */
+int
+fluid_synth_set_reverb_group_impulse_response(fluid_synth_t *synth, int fx_group,
+                                              const char *filename)
+{
+    int ret;
+
+    fluid_return_val_if_fail(synth != NULL, FLUID_FAILED);
+    fluid_synth_api_enter(synth);
+
+    ret = fluid_synth_set_reverb_convrev_LOCAL(synth, fx_group, filename, NULL, NULL, 0, 0);
+
+    FLUID_API_RETURN(ret);
+}
+
+/**
+ * Replace the reverb of one or all fx groups by a convolution reverb, taking the impulse
+ * response from memory.
+ * @param synth FluidSynth instance.
+ * @param fx_group Index of the fx group.
+ *  Must be in the range <code>-1 to (fluid_synth_count_effects_groups()-1)</code>. If -1 the
+ *  impulse response will be used by all fx groups.
+ * @param left Left channel of the impulse response, NULL to restore the built-in reverb.
+ * @param right Right channel of the impulse response, NULL for a mono impulse response.
+ * @param frames Length of the impulse response, in frames.
+ * @param sample_rate Sample rate of the impulse response, in Hz.
+ * @return #FLUID_OK on success, #FLUID_FAILED otherwise.
+ *
+ * See fluid_synth_set_reverb_group_impulse_response(). The samples are copied, the caller
+ * keeps the ownership of \c left and \c right.
+ *
+ * @since 2.5.0
+ */
+int
+fluid_synth_set_reverb_group_impulse_response_data(fluid_synth_t *synth, int fx_group,
+                                                   const float *left, const float *right,
+                                                   int frames, double sample_rate)
+{
+    int ret;
+
+    fluid_return_val_if_fail(synth != NULL, FLUID_FAILED);
+    fluid_return_val_if_fail(left == NULL || (frames > 0 && sample_rate > 0), FLUID_FAILED);
+    fluid_synth_api_enter(synth);
+
+    ret = fluid_synth_set_reverb_convrev_LOCAL(synth, fx_group, NULL, left, right, frames, sample_rate);
+
+    FLUID_API_RETURN(ret);
+}
+
 /**
  * Get reverb room size of all fx groups.
  * @param synth FluidSynth instance
@@ -7019,6 +8264,103 @@ static int fluid_synth_chorus_get_param(fluid_synth_t *synth, int fx_group,
     FLUID_API_RETURN(FLUID_OK);
 }
 
+/*
+ * Hands a parameter of the insert effects of one or all groups of target to the mixer.
+ */
+static int
+fluid_synth_set_insert_fx_param_LOCAL(fluid_synth_t *synth, int target, int index,
+                                      int param, double value)
+{
+    fluid_rvoice_param_t param_list[MAX_EVENT_PARAMS];
+
+    /* shadow values are set here so that they will be returned if queried */
+    fluid_rvoice_mixer_set_insert_fx_full(synth->eventhandler->mixer, target, index, param, value);
+
+    param_list[0].i = target;
+    param_list[1].i = index;
+    param_list[2].i = param;
+    param_list[3].real = value;
+
+    return fluid_rvoice_eventhandler_push(synth->eventhandler,
+                                          fluid_rvoice_mixer_set_insert_fx_param,
+                                          synth->eventhandler->mixer,
+                                          param_list);
+}
+
+/**
+ * Set a parameter of the insert effects of one or all audio groups or fx groups.
+ * @param synth FluidSynth instance.
+ * @param target Where the insert effects are (#fluid_insert_fx_target).
+ * @param index Index of the audio group (up to fluid_synth_count_audio_groups()-1) or of the
+ *  fx group (up to fluid_synth_count_effects_groups()-1). If -1 the parameter is set for all
+ *  groups of \c target.
+ * @param param The parameter to set (#fluid_insert_fx_param).
+ * @param value The value of the parameter, see the matching setting for its range.
+ * @return #FLUID_OK on success, #FLUID_FAILED otherwise, e.g. if the value is out of range.
+ *
+ * The settings of the insert effects, e.g. synth.limiter.active, apply to all audio groups.
+ * The insert effects of the fx groups can only be set by this function.
+ *
+ * @since 2.5.0
+ */
+int
+fluid_synth_set_insert_fx_param(fluid_synth_t *synth, int target, int index,
+                                int param, double value)
+{
+    double min, max;
+    int count, ret;
+
+    fluid_return_val_if_fail(synth != NULL, FLUID_FAILED);
+    fluid_return_val_if_fail(target == FLUID_INSERT_FX_AUDIO_GROUP || target == FLUID_INSERT_FX_EFFECTS_GROUP, FLUID_FAILED);
+    fluid_return_val_if_fail(fluid_insertfx_param_info(param, NULL, NULL, &min, &max, NULL) == FLUID_OK, FLUID_FAILED);
+    fluid_synth_api_enter(synth);
+
+    count = (target == FLUID_INSERT_FX_AUDIO_GROUP) ? synth->audio_groups : synth->effects_groups;
+
+    if(index < -1 || index >= count || value < min || value > max)
+    {
+        FLUID_API_RETURN(FLUID_FAILED);
+    }
+
+    ret = fluid_synth_set_insert_fx_param_LOCAL(synth, target, index, param, value);
+    FLUID_API_RETURN(ret);
+}
+
+/**
+ * Get a parameter of the insert effects of one audio group or fx group.
+ * @param synth FluidSynth instance.
+ * @param target Where the insert effects are (#fluid_insert_fx_target).
+ * @param index Index of the audio group (up to fluid_synth_count_audio_groups()-1) or of the
+ *  fx group (up to fluid_synth_count_effects_groups()-1).
+ * @param param The parameter to get (#fluid_insert_fx_param).
+ * @param value Pointer on the value to return.
+ * @return #FLUID_OK on success, #FLUID_FAILED otherwise.
+ *
+ * @since 2.5.0
+ */
+int
+fluid_synth_get_insert_fx_param(fluid_synth_t *synth, int target, int index,
+                                int param, double *value)
+{
+    int count;
+
+    fluid_return_val_if_fail(synth != NULL, FLUID_FAILED);
+    fluid_return_val_if_fail(target == FLUID_INSERT_FX_AUDIO_GROUP || target == FLUID_INSERT_FX_EFFECTS_GROUP, FLUID_FAILED);
+    fluid_return_val_if_fail((param >= 0) && (param < FLUID_INSERT_FX_PARAM_LAST), FLUID_FAILED);
+    fluid_return_val_if_fail(value != NULL, FLUID_FAILED);
+    fluid_synth_api_enter(synth);
+
+    count = (target == FLUID_INSERT_FX_AUDIO_GROUP) ? synth->audio_groups : synth->effects_groups;
+
+    if(index < 0 || index >= count)
+    {
+        FLUID_API_RETURN(FLUID_FAILED);
+    }
+
+    *value = fluid_rvoice_mixer_insert_fx_get_param(synth->eventhandler->mixer, target, index, param);
+    FLUID_API_RETURN(FLUID_OK);
+}
+
 /*
  * If the same note is hit twice on the same channel, then the older
  * voice process is advanced to the release stage.  Using a mechanical
@@ -7032,8 +8374,7 @@ void
 fluid_synth_release_voice_on_same_note_LOCAL(fluid_synth_t *synth, int chan,
         int key)
 {
-    int i;
-    fluid_voice_t *voice;
+    fluid_voice_t *voice, *next;
 
     /* storeid is a parameter for fluid_voice_init() */
     synth->storeid = synth->noteid++;
@@ -7045,12 +8386,11 @@ fluid_synth_release_voice_on_same_note_LOCAL(fluid_synth_t *synth, int chan,
         return;
     }
 
-    for(i = 0; i < synth->polyphony; i++)
+    for(voice = fluid_channel_first_key_voice(synth->channel[chan], key); voice != NULL; voice = next)
     {
-        voice = synth->voice[i];
+        next = voice->key_next;
 
         if(fluid_voice_is_playing(voice)
-                && (fluid_voice_get_channel(voice) == chan)
                 && (fluid_voice_get_key(voice) == key)
                 && (fluid_voice_get_id(voice) != synth->noteid))
         {
@@ -7327,13 +8667,10 @@ static void
 fluid_synth_update_voice_tuning_LOCAL(fluid_synth_t *synth, fluid_channel_t *channel)
 {
     fluid_voice_t *voice;
-    int i;
 
-    for(i = 0; i < synth->polyphony; i++)
+    for(voice = fluid_channel_first_voice(channel); voice != NULL; voice = voice->chan_next)
     {
-        voice = synth->voice[i];
-
-        if(fluid_voice_is_on(voice) && (voice->channel == channel))
+        if(fluid_voice_is_on(voice))
         {
             fluid_voice_calculate_gen_pitch(voice);
             fluid_voice_update_param(voice, GEN_PITCH);
@@ -7771,18 +9108,12 @@ static void
 fluid_synth_set_gen_LOCAL(fluid_synth_t *synth, int chan, int param, float value)
 {
     fluid_voice_t *voice;
-    int i;
 
     fluid_channel_set_gen(synth->channel[chan], param, value);
 
-    for(i = 0; i < synth->polyphony; i++)
+    for(voice = fluid_channel_first_voice(synth->channel[chan]); voice != NULL; voice = voice->chan_next)
     {
-        voice = synth->voice[i];
-
-        if(fluid_voice_get_channel(voice) == chan)
-        {
-            fluid_voice_set_param(voice, param, value);
-        }
+        fluid_voice_set_param(voice, param, value);
     }
 }
 
@@ -8015,12 +9346,12 @@ fluid_synth_handle_midi_event(void *data, fluid_midi_event_t *event)
     switch(type)
     {
     case NOTE_ON:
-        return fluid_synth_noteon(synth, chan,
-                                  fluid_midi_event_get_key(event),
-                                  fluid_midi_event_get_velocity(event));
+        return fluid_synth_noteon_at(synth, event->frame_offset, chan,
+                                     fluid_midi_event_get_key(event),
+                                     fluid_midi_event_get_velocity(event));
 
     case NOTE_OFF:
-        return fluid_synth_noteoff(synth, chan, fluid_midi_event_get_key(event));
+        return fluid_synth_noteoff_at(synth, event->frame_offset, chan, fluid_midi_event_get_key(event));
 
     case CONTROL_CHANGE:
         return fluid_synth_cc(synth, chan,
@@ -8229,9 +9560,16 @@ fluid_synth_api_enter(fluid_synth_t *synth)
     if(!synth->public_api_count)
     {
         fluid_synth_check_finished_voices(synth);
+        fluid_synth_check_convrev_swaps(synth);
     }
 
     synth->public_api_count++;
+
+    /* Channel messages queued before this call take effect first */
+    if(synth->public_api_count == 1 && synth->midi_queue != NULL && fluid_mpsc_queue_ready(synth->midi_queue))
+    {
+        fluid_synth_apply_queued_events_LOCAL(synth);
+    }
 }
 
 void fluid_synth_api_exit(fluid_synth_t *synth)
@@ -8264,6 +9602,7 @@ int fluid_synth_set_channel_type(fluid_synth_t *synth, int chan, int type)
     FLUID_API_ENTRY_CHAN(FLUID_FAILED);
 
     synth->channel[chan]->channel_type = type;
+    synth->overflow_heap_dirty = TRUE;
 
     FLUID_API_RETURN(FLUID_OK);
 }
@@ -8350,6 +9689,7 @@ static int fluid_synth_set_important_channels(fluid_synth_t *synth, const char *
 
     FLUID_MEMSET(scores->important_channels, FALSE,
                  sizeof(*scores->important_channels) * scores->num_important_channels);
+    synth->overflow_heap_dirty = TRUE;
 
     if(channels != NULL)
     {
@@ -35,6 +35,7 @@
 #include "fluid_ladspa.h"
 #include "fluid_midi_router.h"
 #include "fluid_rvoice_event.h"
+#include "fluid_mpsc_queue.h"
 
 /***************************************************************
  *
@@ -137,11 +138,18 @@ struct _fluid_synth_t
     fluid_list_t *sfont;          /**< List of fluid_sfont_info_t for each loaded SoundFont (remains until SoundFont is unloaded) */
     int sfont_id;             /**< Incrementing ID assigned to each loaded SoundFont */
     fluid_list_t *fonts_to_be_unloaded; /**< list of timers that try to unload a soundfont */
+    fluid_list_t *convrev_swaps;       /**< fluid_mixer_convrev_swap_t handed to the mixer, deleted once done */
 
     float gain;                        /**< master gain */
     fluid_channel_t **channel;         /**< the channels */
     int nvoice;                        /**< the length of the synthesis process array (max polyphony allowed) */
     fluid_voice_t **voice;             /**< the synthesis voices */
+    fluid_voice_t **overflow_heap;     /**< min-heap of the playing voices, ordered by their overflow base priority */
+    int *overflow_frontier;            /**< scratch heap for searching the overflow heap */
+    int overflow_heap_count;           /**< number of voices in the overflow heap */
+    int overflow_heap_dirty;           /**< overflow heap has to be rebuilt before its next use */
+    fluid_voice_t *overflow_oldest;    /**< voices of the overflow heap, in the order they were started */
+    fluid_voice_t *overflow_newest;
     int active_voice_count;            /**< count of active voices */
     unsigned int noteid;               /**< the id is incremented for every new note. it's used for noteoff's  */
     unsigned int storeid;
@@ -156,6 +164,19 @@ struct _fluid_synth_t
 
     int cur;                           /**< the current sample in the audio buffers to be output */
     int curmax;                        /**< current amount of samples present in the audio buffers */
+    int event_offset;                  /**< Frame offset, relative to the next sample to be output, at which the event
+                                            currently processed takes effect. Only set while the API is held by
+                                            fluid_synth_noteon_at() and fluid_synth_noteoff_at() */
+    fluid_mpsc_queue_t *midi_queue;    /**< Channel messages pushed without locking the synth, applied before the
+                                            next block or API call, see synth.midi-queue-size */
+    fluid_atomic_uint_t frames_output; /**< the number of frames output so far, set by the rendering thread when an
+                                            output call returns. Stamps the messages of the MIDI queue */
+    fluid_private_t midi_queue_draining; /**< Set in the thread applying the queued channel messages */
+    int coalesce_controllers;          /**< Defer the modulation of the voices by controller changes to the next block */
+    fluid_atomic_int_t controllers_dirty; /**< Some channel has controller changes pending, see fluid_channel_t::dirty_cc.
+                                            Set with the API held, tested by the rendering thread before taking it */
+    char *process_audible;             /**< One flag per left and right dry buffer of each audio channel, followed by those
+                                            of each effects buffer: TRUE if the last fluid_synth_process() has mixed audio from it */
     int dither_index;		     /**< current index in random dither value buffer: fluid_synth_(write_s16|dither_s16) */
 
     fluid_atomic_float_t cpu_load;                    /**< CPU load in percent (CPU time required / audio synthesized time * 100) */
@@ -167,6 +188,7 @@ struct _fluid_synth_t
     unsigned int min_note_length_ticks; /**< If note-offs are triggered just after a note-on, they will be delayed */
 
     int cores;                         /**< Number of CPU cores (1 by default) */
+    int block_size;                    /**< Internal block size in samples, a power of two (#FLUID_BUFSIZE by default) */
 
     fluid_mod_t *default_mod;          /**< the (dynamic) list of default modulators */
 
@@ -263,6 +285,11 @@ void delete_fluid_sample_timer(fluid_synth_t *synth, fluid_sample_timer_t *timer
 void fluid_sample_timer_reset(fluid_synth_t *synth, fluid_sample_timer_t *timer);
 
 void fluid_synth_process_event_queue(fluid_synth_t *synth);
+int fluid_synth_get_event_offset_LOCAL(fluid_synth_t *synth);
+
+void fluid_synth_overflow_add_LOCAL(fluid_synth_t *synth, fluid_voice_t *voice);
+void fluid_synth_overflow_remove_LOCAL(fluid_synth_t *synth, fluid_voice_t *voice);
+void fluid_synth_overflow_update_LOCAL(fluid_synth_t *synth, fluid_voice_t *voice);
 
 int
 fluid_synth_process_LOCAL(fluid_synth_t *synth, int len, int nfx, float *fx[],
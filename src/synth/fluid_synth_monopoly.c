@@ -541,8 +541,7 @@ int fluid_synth_noteoff_monopoly(fluid_synth_t *synth, int chan, int key,
                                  char Mono)
 {
     int status = FLUID_FAILED;
-    fluid_voice_t *voice;
-    int i;
+    fluid_voice_t *voice, *next;
     fluid_channel_t *channel = synth->channel[chan];
 
     /* Key_sustained is prepared to return no note sustained (INVALID_NOTE) */
@@ -552,12 +551,11 @@ int fluid_synth_noteoff_monopoly(fluid_synth_t *synth, int chan, int key,
     }
 
     /* noteoff for all voices with same chan and same key */
-    for(i = 0; i < synth->polyphony; i++)
+    for(voice = fluid_channel_first_key_voice(channel, key); voice != NULL; voice = next)
     {
-        voice = synth->voice[i];
+        next = voice->key_next;
 
         if(fluid_voice_is_on(voice) &&
-                fluid_voice_get_channel(voice) == chan &&
                 fluid_voice_get_key(voice) == key)
         {
             if(synth->verbose)
@@ -653,20 +651,19 @@ int fluid_synth_noteon_monopoly_legato(fluid_synth_t *synth, int chan,
 {
     fluid_channel_t *channel = synth->channel[chan];
     enum fluid_channel_legato_mode legatomode = channel->legatomode;
-    fluid_voice_t *voice;
-    int i ;
+    fluid_voice_t *voice, *next;
     /* Gets possible 'fromkey portamento' and possible 'fromkey legato' note  */
     fromkey = fluid_synth_get_fromkey_portamento_legato(channel, fromkey);
 
     if(fluid_channel_is_valid_note(fromkey))
     {
-        for(i = 0; i < synth->polyphony; i++)
+        for(voice = fluid_channel_first_key_voice(channel, fromkey); voice != NULL; voice = next)
         {
             /* searching fromkey voices: only those who don't have 'note off' */
-            voice = synth->voice[i];
+            /* the voice moves to the index of tokey when retriggered */
+            next = voice->key_next;
 
             if(fluid_voice_is_on(voice) &&
-                    fluid_voice_get_channel(voice) == chan &&
                     fluid_voice_get_key(voice) == fromkey)
             {
                 fluid_zone_range_t *zone_range = voice->zone_range;
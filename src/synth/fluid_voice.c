@@ -181,6 +181,7 @@ static void fluid_voice_initialize_rvoice(fluid_voice_t *voice, fluid_real_t out
     fluid_rvoice_param_t param[MAX_EVENT_PARAMS];
 
     FLUID_MEMSET(voice->rvoice, 0, sizeof(fluid_rvoice_t));
+    voice->rvoice->dsp.block_size = voice->block_size;
 
     /* The 'sustain' and 'finished' segments of the volume / modulation
      * envelope are constant. They are never affected by any modulator
@@ -202,7 +203,7 @@ static void fluid_voice_initialize_rvoice(fluid_voice_t *voice, fluid_real_t out
     voice->rvoice->resonant_filter.sincos_table = sincos_table;
 
     param[0].i = FLUID_IIR_DISABLED;
-    fluid_iir_filter_init(&voice->rvoice->resonant_custom_filter, param);
+    fluid_rvoice_set_custom_filter(voice->rvoice, param);
     voice->rvoice->resonant_custom_filter.sincos_table = sincos_table;
 
     param[0].real = output_rate;
@@ -213,7 +214,8 @@ static void fluid_voice_initialize_rvoice(fluid_voice_t *voice, fluid_real_t out
  * new_fluid_voice
  */
 fluid_voice_t *
-new_fluid_voice(fluid_rvoice_eventhandler_t *handler, fluid_real_t output_rate, fluid_iir_sincos_t *sincos_table)
+new_fluid_voice(fluid_rvoice_eventhandler_t *handler, fluid_real_t output_rate, int block_size,
+                fluid_iir_sincos_t *sincos_table)
 {
     fluid_voice_t *voice;
     voice = FLUID_NEW(fluid_voice_t);
@@ -239,6 +241,7 @@ new_fluid_voice(fluid_rvoice_eventhandler_t *handler, fluid_real_t output_rate,
 
     voice->status = FLUID_VOICE_CLEAN;
     voice->chan = NO_CHANNEL;
+    voice->overflow_heap_index = -1;
     voice->key = 0;
     voice->vel = 0;
     voice->eventhandler = handler;
@@ -246,6 +249,7 @@ new_fluid_voice(fluid_rvoice_eventhandler_t *handler, fluid_real_t output_rate,
     voice->sample = NULL;
     voice->overflow_sample = NULL;
     voice->output_rate = output_rate;
+    voice->block_size = block_size;
 
     /* Initialize both the rvoice and overflow_rvoice */
     fluid_voice_initialize_rvoice(voice, output_rate, sincos_table);
@@ -273,6 +277,95 @@ delete_fluid_voice(fluid_voice_t *voice)
     FLUID_FREE(voice);
 }
 
+/*
+ * Tells the synth that the overflow priority of a voice may have changed,
+ * see fluid_voice_get_overflow_base_prio().
+ */
+static void
+fluid_voice_overflow_prio_changed(fluid_voice_t *voice)
+{
+    if(voice->overflow_heap_index >= 0)
+    {
+        fluid_synth_overflow_update_LOCAL(voice->channel->synth, voice);
+    }
+}
+
+/*
+ * Voice index of the channels, see fluid_channel_t::voices.
+ * A voice is part of it as long as voice->chan is valid.
+ */
+static void
+fluid_voice_key_index_add(fluid_voice_t *voice)
+{
+    fluid_voice_t **head = &fluid_channel_first_key_voice(voice->channel, voice->key);
+
+    voice->key_prev = NULL;
+    voice->key_next = *head;
+
+    if(*head != NULL)
+    {
+        (*head)->key_prev = voice;
+    }
+
+    *head = voice;
+}
+
+static void
+fluid_voice_key_index_remove(fluid_voice_t *voice)
+{
+    if(voice->key_prev != NULL)
+    {
+        voice->key_prev->key_next = voice->key_next;
+    }
+    else
+    {
+        fluid_channel_first_key_voice(voice->channel, voice->key) = voice->key_next;
+    }
+
+    if(voice->key_next != NULL)
+    {
+        voice->key_next->key_prev = voice->key_prev;
+    }
+}
+
+static void
+fluid_voice_index_add(fluid_voice_t *voice)
+{
+    fluid_channel_t *channel = voice->channel;
+
+    voice->chan_prev = NULL;
+    voice->chan_next = channel->voices;
+
+    if(channel->voices != NULL)
+    {
+        channel->voices->chan_prev = voice;
+    }
+
+    channel->voices = voice;
+
+    fluid_voice_key_index_add(voice);
+}
+
+static void
+fluid_voice_index_remove(fluid_voice_t *voice)
+{
+    if(voice->chan_prev != NULL)
+    {
+        voice->chan_prev->chan_next = voice->chan_next;
+    }
+    else
+    {
+        voice->channel->voices = voice->chan_next;
+    }
+
+    if(voice->chan_next != NULL)
+    {
+        voice->chan_next->chan_prev = voice->chan_prev;
+    }
+
+    fluid_voice_key_index_remove(voice);
+}
+
 /* fluid_voice_init
  *
  * Initialize the synthesis process
@@ -313,13 +406,24 @@ fluid_voice_init(fluid_voice_t *voice, fluid_sample_t *sample,
         fluid_voice_off(voice);
     }
 
+    /* a stolen voice is up for stealing again only once it has been restarted */
+    fluid_synth_overflow_remove_LOCAL(channel->synth, voice);
+
+    if(voice->chan != NO_CHANNEL)
+    {
+        /* the voice is reused without having been stopped */
+        fluid_voice_index_remove(voice);
+    }
+
     voice->zone_range = inst_zone_range; /* Instrument zone range for legato */
     voice->id = id;
     voice->chan = fluid_channel_get_num(channel);
     voice->key = (unsigned char) key;
     voice->vel = (unsigned char) vel;
     voice->channel = channel;
+    fluid_voice_index_add(voice);
     voice->mod_count = 0;
+    voice->mod_routing_valid = FALSE;
     voice->start_time = start_time;
     voice->has_noteoff = 0;
     UPDATE_RVOICE0(fluid_rvoice_reset);
@@ -407,6 +511,32 @@ fluid_voice_gen_set(fluid_voice_t *voice, int i, float val)
     }
 }
 
+/*
+ * Sets the values of several generators at once, without rounding them
+ * to float (see fluid_voice_zone_compile()).
+ *
+ * @param voice Voice instance
+ * @param gen Generator IDs (#fluid_gen_type)
+ * @param val New values of the generators
+ * @param count Number of generators
+ */
+void
+fluid_voice_set_gens(fluid_voice_t *voice, const unsigned char *gen, const fluid_real_t *val, int count)
+{
+    int i;
+
+    for(i = 0; i < count; i++)
+    {
+        voice->gen[gen[i]].val = val[i];
+        voice->gen[gen[i]].flags = GEN_SET;
+
+        if(gen[i] == GEN_SAMPLEMODE)
+        {
+            UPDATE_RVOICE_I1(fluid_rvoice_set_samplemode, (int) val[i]);
+        }
+    }
+}
+
 /**
  * Offset the value of a generator.
  *
@@ -449,6 +579,11 @@ void fluid_voice_start(fluid_voice_t *voice)
      * for the first time.*/
 
     fluid_voice_calculate_runtime_synthesis_parameters(voice);
+    fluid_voice_update_mod_routing(voice);
+
+    /* sample accurate start, see fluid_synth_noteon_at() */
+    voice->start_offset = fluid_synth_get_event_offset_LOCAL(voice->channel->synth);
+    voice->rvoice->dsp.start_offset = voice->start_offset;
 
 #ifdef WITH_PROFILING
     voice->ref = fluid_profile_ref();
@@ -458,6 +593,8 @@ void fluid_voice_start(fluid_voice_t *voice)
 
     /* Increment voice count */
     voice->channel->synth->active_voice_count++;
+
+    fluid_synth_overflow_add_LOCAL(voice->channel->synth, voice);
 }
 
 /**
@@ -720,11 +857,11 @@ calculate_hold_decay_buffers(fluid_voice_t *voice, int gen_base,
     }
 
     seconds = fluid_tc2sec(timecents);
-    /* Each DSP loop processes FLUID_BUFSIZE samples. */
+    /* Each DSP loop processes voice->block_size samples. */
 
     /* round to next full number of buffers */
     buffers = (int)(((fluid_real_t)voice->output_rate * seconds)
-                    / (fluid_real_t)FLUID_BUFSIZE
+                    / (fluid_real_t)voice->block_size
                     + 0.5f);
 
     return buffers;
@@ -788,6 +925,7 @@ fluid_voice_update_param(fluid_voice_t *voice, int gen)
          * OHPiano.SF2 sets initial attenuation to a whooping -96 dB */
         fluid_clip(voice->attenuation, 0.f, 1440.f);
         UPDATE_RVOICE_R1(fluid_rvoice_set_attenuation, voice->attenuation);
+        fluid_voice_overflow_prio_changed(voice);
         break;
 
     /* The pitch is calculated from three different generators.
@@ -900,22 +1038,22 @@ fluid_voice_update_param(fluid_voice_t *voice, int gen)
         break;
 
     case GEN_MODLFOFREQ:
-        /* - the frequency is converted into a delta value, per buffer of FLUID_BUFSIZE samples
+        /* - the frequency is converted into a delta value, per buffer of voice->block_size samples
          * - the delay into a sample delay
          */
         fluid_clip(x, -16000.0f, 4500.0f);
-        x = (4.0f * FLUID_BUFSIZE * fluid_ct2hz_real(x) / voice->output_rate);
+        x = (4.0f * voice->block_size * fluid_ct2hz_real(x) / voice->output_rate);
         UPDATE_RVOICE_ENVLFO_R1(fluid_lfo_set_incr, modlfo, x);
         break;
 
     case GEN_VIBLFOFREQ:
         /* vib lfo
          *
-         * - the frequency is converted into a delta value, per buffer of FLUID_BUFSIZE samples
+         * - the frequency is converted into a delta value, per buffer of voice->block_size samples
          * - the delay into a sample delay
          */
         fluid_clip(x, -16000.0f, 4500.0f);
-        x = 4.0f * FLUID_BUFSIZE * fluid_ct2hz_real(x) / voice->output_rate;
+        x = 4.0f * voice->block_size * fluid_ct2hz_real(x) / voice->output_rate;
         UPDATE_RVOICE_ENVLFO_R1(fluid_lfo_set_incr, viblfo, x);
         break;
 
@@ -1057,9 +1195,9 @@ fluid_voice_update_param(fluid_voice_t *voice, int gen)
         break;
 
         /* Conversion functions differ in range limit */
-#define NUM_BUFFERS_DELAY(_v)   (unsigned int) (voice->output_rate * fluid_tc2sec_delay(_v) / FLUID_BUFSIZE)
-#define NUM_BUFFERS_ATTACK(_v)  (unsigned int) (voice->output_rate * fluid_tc2sec_attack(_v) / FLUID_BUFSIZE)
-#define NUM_BUFFERS_RELEASE(_v) (unsigned int) (voice->output_rate * fluid_tc2sec_release(_v) / FLUID_BUFSIZE)
+#define NUM_BUFFERS_DELAY(_v)   (unsigned int) (voice->output_rate * fluid_tc2sec_delay(_v) / voice->block_size)
+#define NUM_BUFFERS_ATTACK(_v)  (unsigned int) (voice->output_rate * fluid_tc2sec_attack(_v) / voice->block_size)
+#define NUM_BUFFERS_RELEASE(_v) (unsigned int) (voice->output_rate * fluid_tc2sec_release(_v) / voice->block_size)
 
     /* volume envelope
      *
@@ -1193,54 +1331,175 @@ fluid_voice_update_param(fluid_voice_t *voice, int gen)
 #define is_gen_updated(bit,gen)  (bit[gen >> NBR_BIT_BY_VAR_LN2] &  (1 << (gen & NBR_BIT_BY_VAR_ANDMASK)))
 #define set_gen_updated(bit,gen) (bit[gen >> NBR_BIT_BY_VAR_LN2] |= (1 << (gen & NBR_BIT_BY_VAR_ANDMASK)))
 
-int fluid_voice_modulate(fluid_voice_t *voice, int cc, int ctrl)
+/* source key of a modulator source, see fluid_mod_has_source() */
+#define FLUID_MOD_SRC_CC 0x100
+#define fluid_mod_src_key(cc, ctrl) ((ctrl) | ((cc) ? FLUID_MOD_SRC_CC : 0))
+
+/* returns the index of a source in voice->mod_src, adding it if needed */
+static int
+fluid_voice_mod_src_index(fluid_voice_t *voice, int key)
 {
-    int i, k;
+    int i;
+
+    for(i = 0; i < voice->mod_src_count; i++)
+    {
+        if(voice->mod_src[i] == key)
+        {
+            return i;
+        }
+    }
+
+    voice->mod_src[i] = key;
+    voice->mod_src_start[i + 1] = 0;
+    voice->mod_src_count++;
+
+    return i;
+}
+
+/*
+ * Builds the routing tables of the modulators of the voice: for every source
+ * the modulators reading it, and for every generator the modulators writing
+ * to it, both in the order of voice->mod. This lets fluid_voice_modulate()
+ * visit only the modulators concerned by a controller change.
+ *
+ * Done at voice start and again whenever a modulator has been added since.
+ */
+void
+fluid_voice_update_mod_routing(fluid_voice_t *voice)
+{
+    unsigned char src1[FLUID_NUM_MOD], src2[FLUID_NUM_MOD];
+    unsigned char pos[2 * FLUID_NUM_MOD];
     fluid_mod_t *mod;
+    int i;
+
+    FLUID_MEMSET(voice->mod_dest_first, FLUID_NUM_MOD, sizeof(voice->mod_dest_first));
+    voice->mod_src_count = 0;
+
+    /* count the modulators of each source, in mod_src_start[source + 1] */
+    for(i = voice->mod_count - 1; i >= 0; i--)
+    {
+        mod = &voice->mod[i];
+        voice->mod_dest_next[i] = voice->mod_dest_first[mod->dest];
+        voice->mod_dest_first[mod->dest] = i;
+
+        src1[i] = fluid_voice_mod_src_index(voice, fluid_mod_src_key(mod->flags1 & FLUID_MOD_CC, mod->src1));
+        src2[i] = fluid_voice_mod_src_index(voice, fluid_mod_src_key(mod->flags2 & FLUID_MOD_CC, mod->src2));
+        voice->mod_src_start[src1[i] + 1]++;
+
+        if(src2[i] != src1[i])
+        {
+            voice->mod_src_start[src2[i] + 1]++;
+        }
+    }
+
+    voice->mod_src_start[0] = 0;
+
+    for(i = 0; i < voice->mod_src_count; i++)
+    {
+        voice->mod_src_start[i + 1] += voice->mod_src_start[i];
+        pos[i] = voice->mod_src_start[i];
+    }
+
+    for(i = 0; i < voice->mod_count; i++)
+    {
+        voice->mod_src_mods[pos[src1[i]]++] = i;
+
+        if(src2[i] != src1[i])
+        {
+            voice->mod_src_mods[pos[src2[i]]++] = i;
+        }
+    }
+
+    voice->mod_routing_valid = TRUE;
+}
+
+/* Sums up the modulators of generator gen and updates the parameters depending on it */
+static void
+fluid_voice_modulate_gen(fluid_voice_t *voice, int gen)
+{
+    fluid_real_t modval = 0.0;
+    int k;
+
+    /* step 2: for every attached modulator, calculate the modulation
+     * value for the generator gen */
+    for(k = voice->mod_dest_first[gen]; k < FLUID_NUM_MOD; k = voice->mod_dest_next[k])
+    {
+        modval += fluid_mod_get_value(&voice->mod[k], voice);
+    }
+
+    fluid_gen_set_mod(&voice->gen[gen], modval);
+
+    /* now recalculate the parameter values that are derived from the
+       generator */
+    fluid_voice_update_param(voice, gen);
+}
+
+int fluid_voice_modulate(fluid_voice_t *voice, int cc, int ctrl)
+{
+    int i, k, key;
     uint32_t gen;
-    fluid_real_t modval;
 
     /* Clears registered bits table of updated generators */
     uint32_t updated_gen_bit[SIZE_UPDATED_GEN_BIT] = {0};
 
     /*    printf("Chan=%d, CC=%d, Src=%d, Val=%d\n", voice->channel->channum, cc, ctrl, val); */
 
-    for(i = 0; i < voice->mod_count; i++)
+    if(!voice->mod_routing_valid)
     {
-        mod = &voice->mod[i];
+        fluid_voice_update_mod_routing(voice);
+    }
 
-        /* step 1: find all the modulators that have the changed controller
-           as input source. When ctrl is -1 all modulators destination
-           are updated */
-        if(ctrl < 0 || fluid_mod_has_source(mod, cc, ctrl))
+    if(ctrl < 0)
+    {
+        /* all modulators destination are updated */
+        for(i = 0; i < voice->mod_count; i++)
         {
-            gen = fluid_mod_get_dest(mod);
+            gen = fluid_mod_get_dest(&voice->mod[i]);
 
             /* Skip if this generator has already been updated */
             if(!is_gen_updated(updated_gen_bit, gen))
             {
-                modval = 0.0;
-
-                /* step 2: for every attached modulator, calculate the modulation
-                 * value for the generator gen */
-                for(k = 0; k < voice->mod_count; k++)
-                {
-                    if(fluid_mod_has_dest(&voice->mod[k], gen))
-                    {
-                        modval += fluid_mod_get_value(&voice->mod[k], voice);
-                    }
-                }
-
-                fluid_gen_set_mod(&voice->gen[gen], modval);
-
-                /* now recalculate the parameter values that are derived from the
-                   generator */
-                fluid_voice_update_param(voice, gen);
+                fluid_voice_modulate_gen(voice, gen);
 
                 /* set the bit that indicates this generator is updated */
                 set_gen_updated(updated_gen_bit, gen);
             }
         }
+
+        return FLUID_OK;
+    }
+
+    /* modulator sources are 8 bits */
+    if(ctrl > 0xff)
+    {
+        return FLUID_OK;
+    }
+
+    /* step 1: find all the modulators that have the changed controller
+       as input source. */
+    key = fluid_mod_src_key(cc, ctrl);
+
+    for(k = 0; k < voice->mod_src_count && voice->mod_src[k] != key; k++)
+    {
+    }
+
+    if(k == voice->mod_src_count)
+    {
+        return FLUID_OK;
+    }
+
+    for(i = voice->mod_src_start[k]; i < voice->mod_src_start[k + 1]; i++)
+    {
+        gen = fluid_mod_get_dest(&voice->mod[voice->mod_src_mods[i]]);
+
+        /* Skip if this generator has already been updated */
+        if(!is_gen_updated(updated_gen_bit, gen))
+        {
+            fluid_voice_modulate_gen(voice, gen);
+
+            /* set the bit that indicates this generator is updated */
+            set_gen_updated(updated_gen_bit, gen);
+        }
     }
 
     return FLUID_OK;
@@ -1285,7 +1544,7 @@ void fluid_voice_update_portamento(fluid_voice_t *voice, int fromkey, int tokey)
     fluid_real_t ms = fluid_channel_portamentotime_with_mode(channel, tm, channel->synth->portamento_time_has_seen_lsb, fromkey, tokey);
 
     countinc = (unsigned int)(((fluid_real_t)voice->output_rate * 0.001f * ms) /
-                                            (fluid_real_t)FLUID_BUFSIZE + 0.5f);
+                                            (fluid_real_t)voice->block_size + 0.5f);
 
     /* Send portamento parameters to the voice dsp */
     UPDATE_RVOICE_GENERIC_IR(fluid_rvoice_set_portamento, voice->rvoice, countinc, pitchoffset);
@@ -1304,7 +1563,9 @@ void fluid_voice_update_portamento(fluid_voice_t *voice, int fromkey, int tokey)
 void fluid_voice_update_multi_retrigger_attack(fluid_voice_t *voice,
         int tokey, int vel)
 {
+    fluid_voice_key_index_remove(voice);
     voice->key = tokey;  /* new note */
+    fluid_voice_key_index_add(voice);
     voice->vel = vel; /* new velocity */
     /* Updates generators dependent of velocity */
     /* Modulates GEN_ATTENUATION (and others ) before calling
@@ -1336,9 +1597,29 @@ void fluid_voice_update_multi_retrigger_attack(fluid_voice_t *voice,
 void
 fluid_voice_release(fluid_voice_t *voice)
 {
+    fluid_synth_t *synth = voice->channel->synth;
     unsigned int at_tick = fluid_channel_get_min_note_length_ticks(voice->channel);
+    int offset = fluid_synth_get_event_offset_LOCAL(synth);
+
+    if(offset > 0)
+    {
+        /* Sample accurate release, see fluid_synth_noteoff_at(). The envelopes
+         * advance blockwise, so round to the nearest block boundary. at_tick
+         * is counted from the first block the rvoice rendered, i.e. after any
+         * blocks it waited for its start_offset. */
+        int pos = (int)(fluid_atomic_int_get(&synth->ticks_since_start) - voice->start_time)
+                  - (int)(voice->start_offset / voice->block_size) * voice->block_size;
+        int tick = pos + (offset + voice->block_size / 2) / voice->block_size * voice->block_size;
+
+        if(tick > (int)at_tick)
+        {
+            at_tick = tick;
+        }
+    }
+
     UPDATE_RVOICE_I1(fluid_rvoice_noteoff, at_tick);
     voice->has_noteoff = 1; // voice is marked as noteoff occurred
+    fluid_voice_overflow_prio_changed(voice);
 }
 
 /*
@@ -1362,11 +1643,13 @@ fluid_voice_noteoff(fluid_voice_t *voice)
     {
         // Sostenuto depressed after note
         voice->status = FLUID_VOICE_HELD_BY_SOSTENUTO;
+        fluid_voice_overflow_prio_changed(voice);
     }
     /* Or sustain a note under Sustain pedal */
     else if(fluid_channel_sustained(channel))
     {
         voice->status = FLUID_VOICE_SUSTAINED;
+        fluid_voice_overflow_prio_changed(voice);
     }
     /* Or force the voice to release stage */
     else
@@ -1432,6 +1715,9 @@ void fluid_voice_overflow_rvoice_finished(fluid_voice_t *voice)
     /* Decrement the reference count of the sample to indicate
        that this sample isn't owned by the rvoice anymore */
     fluid_voice_sample_unref(&voice->overflow_sample);
+
+    /* the voice may be stolen again */
+    fluid_voice_overflow_prio_changed(voice);
 }
 
 /*
@@ -1457,6 +1743,11 @@ fluid_voice_stop(fluid_voice_t *voice)
 {
     fluid_profile(FLUID_PROF_VOICE_RELEASE, voice->ref, 0, 0);
 
+    if(voice->chan != NO_CHANNEL)
+    {
+        fluid_voice_index_remove(voice);
+    }
+
     voice->chan = NO_CHANNEL;
 
     /* Decrement the reference count of the sample, to indicate
@@ -1469,6 +1760,8 @@ fluid_voice_stop(fluid_voice_t *voice)
 
     /* Decrement voice count */
     voice->channel->synth->active_voice_count--;
+
+    fluid_synth_overflow_remove_LOCAL(voice->channel->synth, voice);
 }
 
 /**
@@ -1552,6 +1845,7 @@ fluid_voice_add_mod_local(fluid_voice_t *voice, fluid_mod_t *mod, int mode, int
     if(voice->mod_count < FLUID_NUM_MOD)
     {
         fluid_mod_clone(&voice->mod[voice->mod_count++], mod);
+        voice->mod_routing_valid = FALSE;
     }
     else
     {
@@ -1956,10 +2250,40 @@ fluid_voice_optimize_sample(fluid_sample_t *s)
     return FLUID_OK;
 }
 
+/**
+ * Get the overflow priority of a voice, the voice with the lowest priority is
+ * killed first when the polyphony is exceeded.
+ *
+ * It is the sum of fluid_voice_get_overflow_base_prio() and
+ * fluid_voice_get_overflow_age_prio(), computed the very same way, so that the
+ * synth can bound it from the parts.
+ */
 float
 fluid_voice_get_overflow_prio(fluid_voice_t *voice,
                               fluid_overflow_prio_t *score,
                               unsigned int cur_time)
+{
+    float base_prio = fluid_voice_get_overflow_base_prio(voice, score);
+
+    /* Are we already overflowing? */
+    if(!voice->can_access_overflow_rvoice)
+    {
+        return base_prio;
+    }
+
+    return base_prio + fluid_voice_get_overflow_age_prio(voice, score, cur_time);
+}
+
+/**
+ * Get the part of the overflow priority of a voice that doesn't change over time,
+ * i.e. fluid_voice_get_overflow_prio() without the age score.
+ *
+ * The synth keeps its voices ordered by this value, so it must be told about
+ * any change of the state it depends on, see fluid_synth_overflow_update_LOCAL().
+ */
+float
+fluid_voice_get_overflow_base_prio(fluid_voice_t *voice,
+                                   fluid_overflow_prio_t *score)
 {
     float this_voice_prio = 0;
     int channel;
@@ -1994,21 +2318,6 @@ fluid_voice_get_overflow_prio(fluid_voice_t *voice,
         this_voice_prio += score->sustained;
     }
 
-    /* We are not enthusiastic about releasing voices, which have just been started.
-     * Otherwise hitting a chord may result in killing notes belonging to that very same
-     * chord. So give newer voices a higher score. */
-    if(score->age)
-    {
-        cur_time -= voice->start_time;
-
-        if(cur_time < 1)
-        {
-            cur_time = 1; // Avoid div by zero
-        }
-
-        this_voice_prio += (score->age * voice->output_rate) / cur_time;
-    }
-
     /* take a rough estimate of loudness into account. Louder voices are more important. */
     if(score->volume)
     {
@@ -2039,9 +2348,36 @@ fluid_voice_get_overflow_prio(fluid_voice_t *voice,
     return this_voice_prio;
 }
 
+/**
+ * Get the age score of the overflow priority of a voice.
+ *
+ * For a positive score->age, it never increases as the voice gets older.
+ */
+float
+fluid_voice_get_overflow_age_prio(fluid_voice_t *voice,
+                                  fluid_overflow_prio_t *score,
+                                  unsigned int cur_time)
+{
+    /* We are not enthusiastic about releasing voices, which have just been started.
+     * Otherwise hitting a chord may result in killing notes belonging to that very same
+     * chord. So give newer voices a higher score. */
+    if(!score->age)
+    {
+        return 0;
+    }
+
+    cur_time -= voice->start_time;
+
+    if(cur_time < 1)
+    {
+        cur_time = 1; // Avoid div by zero
+    }
+
+    return (score->age * voice->output_rate) / cur_time;
+}
 
 void fluid_voice_set_custom_filter(fluid_voice_t *voice, enum fluid_iir_filter_type type, enum fluid_iir_filter_flags flags)
 {
-    UPDATE_RVOICE_GENERIC_I2(fluid_iir_filter_init, &voice->rvoice->resonant_custom_filter, type, flags);
+    UPDATE_RVOICE_GENERIC_I2(fluid_rvoice_set_custom_filter, voice->rvoice, type, flags);
 }
 
@@ -72,18 +72,35 @@ struct _fluid_voice_t
     unsigned char key;              /* the key of the noteon event, quick access for noteoff */
     unsigned char vel;              /* the velocity of the noteon event */
     fluid_channel_t *channel;
+    fluid_voice_t *chan_prev, *chan_next; /* voice index of the channel, see fluid_channel_t::voices */
+    fluid_voice_t *key_prev, *key_next;   /* voice index of the key, see fluid_channel_t::key_voices */
     fluid_rvoice_eventhandler_t *eventhandler;
     fluid_zone_range_t *zone_range;  /* instrument zone range*/
     fluid_sample_t *sample;          /* Pointer to sample (dupe in rvoice) */
     fluid_sample_t *overflow_sample; /* Pointer to sample (dupe in overflow_rvoice) */
 
     unsigned int start_time;
+    int synth_index;                 /* position in fluid_synth_t::voice */
+    int overflow_heap_index;         /* position in fluid_synth_t::overflow_heap, -1 if not in it */
+    float overflow_base_prio;        /* heap key, see fluid_voice_get_overflow_base_prio() */
+    fluid_voice_t *age_prev, *age_next; /* voices of the overflow heap in the order they were started */
+    unsigned int start_offset;       /* frames the voice waits for before its first block (dupe in rvoice) */
     int mod_count;
     fluid_mod_t mod[FLUID_NUM_MOD];
     fluid_gen_t gen[GEN_LAST];
 
+    /* modulator routing, see fluid_voice_update_mod_routing() */
+    int mod_routing_valid;           /* routing matches the modulators */
+    int mod_src_count;               /* number of distinct modulator sources */
+    unsigned short mod_src[2 * FLUID_NUM_MOD];         /* source controller, FLUID_MOD_SRC_CC for CCs */
+    unsigned char mod_src_start[2 * FLUID_NUM_MOD + 1]; /* start of the modulators of each source in mod_src_mods */
+    unsigned char mod_src_mods[2 * FLUID_NUM_MOD];     /* modulator indices, grouped by source, ascending */
+    unsigned char mod_dest_first[GEN_LAST];            /* first modulator of each generator, FLUID_NUM_MOD if none */
+    unsigned char mod_dest_next[FLUID_NUM_MOD];        /* next modulator with the same destination */
+
     /* basic parameters */
     fluid_real_t output_rate;        /* the sample rate of the synthesizer (dupe in rvoice) */
+    int block_size;                  /* samples rendered per block (dupe in rvoice) */
 
     /* basic parameters */
     fluid_real_t pitch;              /* the pitch in midicents (dupe in rvoice) */
@@ -119,7 +136,8 @@ struct _fluid_voice_t
 };
 
 
-fluid_voice_t *new_fluid_voice(fluid_rvoice_eventhandler_t *handler, fluid_real_t output_rate, fluid_iir_sincos_t *sincos_table);
+fluid_voice_t *new_fluid_voice(fluid_rvoice_eventhandler_t *handler, fluid_real_t output_rate, int block_size,
+                               fluid_iir_sincos_t *sincos_table);
 void delete_fluid_voice(fluid_voice_t *voice);
 
 void fluid_voice_start(fluid_voice_t *voice);
@@ -131,6 +149,7 @@ int fluid_voice_init(fluid_voice_t *voice, fluid_sample_t *sample,
                      unsigned int id, unsigned int time, fluid_real_t gain);
 
 int fluid_voice_modulate(fluid_voice_t *voice, int cc, int ctrl);
+void fluid_voice_update_mod_routing(fluid_voice_t *voice);
 int fluid_voice_modulate_all(fluid_voice_t *voice);
 
 /** Set the NRPN value of a generator. */
@@ -161,12 +180,18 @@ void fluid_voice_noteoff(fluid_voice_t *voice);
 void fluid_voice_off(fluid_voice_t *voice);
 void fluid_voice_stop(fluid_voice_t *voice);
 void fluid_voice_add_mod_local(fluid_voice_t *voice, fluid_mod_t *mod, int mode, int check_limit_count);
+void fluid_voice_set_gens(fluid_voice_t *voice, const unsigned char *gen, const fluid_real_t *val, int count);
 void fluid_voice_overflow_rvoice_finished(fluid_voice_t *voice);
 
 int fluid_voice_kill_excl(fluid_voice_t *voice);
 float fluid_voice_get_overflow_prio(fluid_voice_t *voice,
                                     fluid_overflow_prio_t *score,
                                     unsigned int cur_time);
+float fluid_voice_get_overflow_base_prio(fluid_voice_t *voice,
+        fluid_overflow_prio_t *score);
+float fluid_voice_get_overflow_age_prio(fluid_voice_t *voice,
+                                        fluid_overflow_prio_t *score,
+                                        unsigned int cur_time);
 
 #define OVERFLOW_PRIO_CANNOT_KILL 999999.
 
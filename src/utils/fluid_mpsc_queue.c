@@ -0,0 +1,170 @@
+/* FluidSynth - A Software Synthesizer
+ *
+ * Copyright (C) 2003  Peter Hanappe and others.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1 of
+ * the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see
+ * <https://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Bounded multi-producer queue, the push is the sequence number scheme
+ * described by Dmitry Vyukov: every element carries a sequence number telling
+ * the producers whether it is free for the current position, and the consumer
+ * whether it has been completely written.
+ */
+
+#include "fluid_mpsc_queue.h"
+#include "fluid_sys.h"
+
+
+/**
+ * Create a lock free multi-producer queue.
+ * @param count Count of elements in queue, rounded up to a power of two
+ * @param elementsize Size of each element
+ * @return New lock free queue or NULL if out of memory (error message logged)
+ *
+ * Any number of threads may push elements at the same time without waiting
+ * for each other. Elements may only be popped by one thread at a time, the
+ * caller is responsible for this (e.g. by holding a mutex).
+ */
+fluid_mpsc_queue_t *
+new_fluid_mpsc_queue(int count, size_t elementsize)
+{
+    fluid_mpsc_queue_t *queue;
+    int i, size = 1;
+
+    fluid_return_val_if_fail(count > 0 && count <= (1 << 24), NULL);
+
+    while(size < count)
+    {
+        size <<= 1;
+    }
+
+    queue = FLUID_NEW(fluid_mpsc_queue_t);
+
+    if(!queue)
+    {
+        FLUID_LOG(FLUID_ERR, "Out of memory");
+        return NULL;
+    }
+
+    FLUID_MEMSET(queue, 0, sizeof(*queue));
+    queue->array = FLUID_MALLOC(elementsize * size);
+    queue->seq = FLUID_ARRAY(fluid_atomic_int_t, size);
+
+    if(!queue->array || !queue->seq)
+    {
+        FLUID_LOG(FLUID_ERR, "Out of memory");
+        delete_fluid_mpsc_queue(queue);
+        return NULL;
+    }
+
+    for(i = 0; i < size; i++)
+    {
+        fluid_atomic_int_set(&queue->seq[i], i);
+    }
+
+    queue->mask = size - 1;
+    queue->elementsize = elementsize;
+    fluid_atomic_int_set(&queue->in, 0);
+    fluid_atomic_int_set(&queue->out, 0);
+
+    return queue;
+}
+
+/**
+ * Free a multi-producer queue.
+ * @param queue Lockless queue instance
+ *
+ * Care must be taken when freeing a queue, to ensure that the consumer and
+ * producer threads will no longer access it.
+ */
+void
+delete_fluid_mpsc_queue(fluid_mpsc_queue_t *queue)
+{
+    fluid_return_if_fail(queue != NULL);
+    FLUID_FREE(queue->array);
+    FLUID_FREE(queue->seq);
+    FLUID_FREE(queue);
+}
+
+/**
+ * Push an element into the queue, from any thread.
+ * @param queue Lockless queue instance
+ * @param element The element to copy into the queue
+ * @return #FLUID_OK on success, #FLUID_FAILED if the queue is full
+ */
+int
+fluid_mpsc_queue_push(fluid_mpsc_queue_t *queue, const void *element)
+{
+    int pos = fluid_atomic_int_get(&queue->in);
+    int index, diff;
+
+    for(;;)
+    {
+        index = pos & queue->mask;
+        diff = (int)((unsigned int)fluid_atomic_int_get(&queue->seq[index]) - (unsigned int)pos);
+
+        if(diff == 0)
+        {
+            /* the element is free, claim the position */
+            if(fluid_atomic_int_compare_and_exchange(&queue->in, pos, (int)((unsigned int)pos + 1)))
+            {
+                break;
+            }
+        }
+        else if(diff < 0)
+        {
+            /* the element still holds the one pushed a lap ago */
+            return FLUID_FAILED;
+        }
+
+        /* another producer was faster */
+        pos = fluid_atomic_int_get(&queue->in);
+    }
+
+    FLUID_MEMCPY(queue->array + queue->elementsize * index, element, queue->elementsize);
+
+    /* publish the element to the consumer */
+    fluid_atomic_int_set(&queue->seq[index], (int)((unsigned int)pos + 1));
+
+    return FLUID_OK;
+}
+
+/**
+ * Pop the oldest element from the queue.
+ * @param queue Lockless queue instance
+ * @param element Where to copy the element to
+ * @return #FLUID_OK on success, #FLUID_FAILED if the queue is empty or the
+ *   oldest element is still being written by its producer
+ */
+int
+fluid_mpsc_queue_pop(fluid_mpsc_queue_t *queue, void *element)
+{
+    int out = fluid_atomic_int_get(&queue->out);
+    int index = out & queue->mask;
+
+    if(fluid_atomic_int_get(&queue->seq[index]) != (int)((unsigned int)out + 1))
+    {
+        return FLUID_FAILED;
+    }
+
+    FLUID_MEMCPY(element, queue->array + queue->elementsize * index, queue->elementsize);
+
+    /* hand the element over to the producers of the next lap */
+    fluid_atomic_int_set(&queue->seq[index], (int)((unsigned int)out + queue->mask + 1));
+    fluid_atomic_int_set(&queue->out, (int)((unsigned int)out + 1));
+
+    return FLUID_OK;
+}
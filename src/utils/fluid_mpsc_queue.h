@@ -0,0 +1,72 @@
+/* FluidSynth - A Software Synthesizer
+ *
+ * Copyright (C) 2003  Peter Hanappe and others.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1 of
+ * the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see
+ * <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef _FLUID_MPSC_QUEUE_H
+#define _FLUID_MPSC_QUEUE_H
+
+#include "fluid_sys.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Lockless bounded queue with any number of producer threads and a single
+ * consumer at a time.
+ */
+struct _fluid_mpsc_queue_t
+{
+    char *array;                /**< Queue array of fixed size elements */
+    fluid_atomic_int_t *seq;    /**< Sequence number of each element, tells whether it may be pushed or popped */
+    int mask;                   /**< Count of elements in array minus one, the count is a power of two */
+    size_t elementsize;         /**< Size of each element */
+    fluid_atomic_int_t in;      /**< Position of the next pushed element, shared by the producers */
+    fluid_atomic_int_t out;     /**< Position of the next popped element, only written by the consumer */
+};
+
+typedef struct _fluid_mpsc_queue_t fluid_mpsc_queue_t;
+
+
+fluid_mpsc_queue_t *new_fluid_mpsc_queue(int count, size_t elementsize);
+void delete_fluid_mpsc_queue(fluid_mpsc_queue_t *queue);
+
+int fluid_mpsc_queue_push(fluid_mpsc_queue_t *queue, const void *element);
+int fluid_mpsc_queue_pop(fluid_mpsc_queue_t *queue, void *element);
+
+/**
+ * Check whether the queue has an element ready to be popped.
+ * @param queue Lockless queue instance
+ * @return TRUE if fluid_mpsc_queue_pop() would succeed, FALSE otherwise
+ *
+ * Only the consumer gets a reliable answer. Any other thread may call it as
+ * a hint, e.g. to find out whether it's worth becoming the consumer.
+ */
+static FLUID_INLINE int
+fluid_mpsc_queue_ready(fluid_mpsc_queue_t *queue)
+{
+    int out = fluid_atomic_int_get(&queue->out);
+
+    return fluid_atomic_int_get(&queue->seq[out & queue->mask]) == (int)((unsigned int)out + 1);
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _FLUID_MPSC_QUEUE_H */
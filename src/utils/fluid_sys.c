@@ -550,6 +550,84 @@ void fluid_clear_fpe_i386(void)
 #endif	// #if defined(FPE_CHECK) && !defined(_WIN32) && !defined(__OS2__)
 
 
+/***************************************************************
+ *
+ *               Runtime CPU dispatch
+ */
+
+static const char *const fluid_cpu_isa_names[FLUID_CPU_ISA_LAST] =
+{
+    "generic",
+    "avx2",
+    "avx512"
+};
+
+/**
+ * Detect the best instruction set level supported by the running CPU.
+ * @return One of #fluid_cpu_isa
+ */
+int fluid_cpu_isa_detect(void)
+{
+#if FLUID_CPU_DISPATCH
+    __builtin_cpu_init();
+
+    if(__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+    {
+        return FLUID_CPU_ISA_AVX512;
+    }
+
+    if(__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+    {
+        return FLUID_CPU_ISA_AVX2;
+    }
+
+#endif
+    return FLUID_CPU_ISA_GENERIC;
+}
+
+/**
+ * Resolve the value of the setting synth.cpu-isa.
+ *
+ * "auto" selects the best level supported by the CPU. A level that is not
+ * supported by the CPU (or not compiled in) falls back to the best supported one.
+ *
+ * @param name Name of the instruction set level
+ * @return One of #fluid_cpu_isa
+ */
+int fluid_cpu_isa_parse(const char *name)
+{
+    int detected = fluid_cpu_isa_detect();
+    int i;
+
+    for(i = 0; i < FLUID_CPU_ISA_LAST; i++)
+    {
+        if(FLUID_STRCMP(name, fluid_cpu_isa_names[i]) == 0)
+        {
+            break;
+        }
+    }
+
+    if(i == FLUID_CPU_ISA_LAST)
+    {
+        if(FLUID_STRCMP(name, "auto") != 0)
+        {
+            FLUID_LOG(FLUID_WARN, "Unknown instruction set '%s', using '%s'", name, fluid_cpu_isa_names[detected]);
+        }
+
+        return detected;
+    }
+
+    if(i > detected)
+    {
+        FLUID_LOG(FLUID_WARN, "Instruction set '%s' is not supported by this CPU, using '%s'",
+                  name, fluid_cpu_isa_names[detected]);
+        return detected;
+    }
+
+    return i;
+}
+
+
 /***************************************************************
  *
  *               Profiling (Linux, i586 only)
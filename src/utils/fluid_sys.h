@@ -541,6 +541,39 @@ void fluid_clear_fpe_i386(void);
 /* System control */
 void fluid_msleep(unsigned int msecs);
 
+/**
+
+    Runtime CPU dispatch
+
+    Performance critical dsp kernels are compiled several times for
+    different instruction set levels, the best one supported by the
+    running CPU is chosen at runtime (see setting synth.cpu-isa).
+
+    The AVX2 and AVX-512 variants are allowed to contract multiplies and
+    adds into FMA instructions, which round only once. Their output may
+    therefore differ from the generic kernels in the last bits, i.e. the
+    output is only bit-exact for a given instruction set level.
+*/
+enum fluid_cpu_isa
+{
+    FLUID_CPU_ISA_GENERIC, /* whatever the compiler targets by default */
+    FLUID_CPU_ISA_AVX2,    /* x86 AVX2 and FMA */
+    FLUID_CPU_ISA_AVX512,  /* x86 AVX-512F */
+    FLUID_CPU_ISA_LAST
+};
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define FLUID_CPU_DISPATCH 1
+/* Flatten inlines all callees, so that they are compiled for the same target as well */
+#define FLUID_TARGET_AVX2 __attribute__((target("avx2,fma"), flatten))
+#define FLUID_TARGET_AVX512 __attribute__((target("avx512f,avx2,fma"), flatten))
+#else
+#define FLUID_CPU_DISPATCH 0
+#endif
+
+int fluid_cpu_isa_detect(void);
+int fluid_cpu_isa_parse(const char *name);
+
 /**
  * Advances the given \c ptr to the next \c alignment byte boundary.
  * Make sure you've allocated an extra of \c alignment bytes to avoid a buffer overflow.
@@ -93,6 +93,7 @@ typedef int fluid_rec_mutex_t;
 #define fluid_rec_mutex_init(_m)      (_m = 0)
 #define fluid_rec_mutex_destroy(_m)   (_m = 0)
 #define fluid_rec_mutex_lock(_m)      (_m++)
+#define fluid_rec_mutex_trylock(_m)   (_m++, TRUE)
 #define fluid_rec_mutex_unlock(_m)    (_m--)
 
 /* Dynamically allocated mutex suitable for fluid_cond_t use */
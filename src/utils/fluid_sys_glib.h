@@ -97,6 +97,7 @@ typedef GRecMutex fluid_rec_mutex_t;
 #define fluid_rec_mutex_init(_m)      g_rec_mutex_init(&(_m))
 #define fluid_rec_mutex_destroy(_m)   g_rec_mutex_clear(&(_m))
 #define fluid_rec_mutex_lock(_m)      g_rec_mutex_lock(&(_m))
+#define fluid_rec_mutex_trylock(_m)   g_rec_mutex_trylock(&(_m))
 #define fluid_rec_mutex_unlock(_m)    g_rec_mutex_unlock(&(_m))
 
 /* Dynamically allocated mutex suitable for fluid_cond_t use */
@@ -172,6 +173,7 @@ typedef GStaticMutex fluid_mutex_t;
 typedef GStaticRecMutex fluid_rec_mutex_t;
 #define fluid_rec_mutex_destroy(_m)   g_static_rec_mutex_free(&(_m))
 #define fluid_rec_mutex_lock(_m)      g_static_rec_mutex_lock(&(_m))
+#define fluid_rec_mutex_trylock(_m)   g_static_rec_mutex_trylock(&(_m))
 #define fluid_rec_mutex_unlock(_m)    g_static_rec_mutex_unlock(&(_m))
 
 #define fluid_rec_mutex_init(_m)      do { \
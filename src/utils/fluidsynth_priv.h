@@ -125,7 +125,9 @@ typedef void (*fluid_rvoice_function_t)(void *obj, const fluid_rvoice_param_t pa
  *                      CONSTANTS
  */
 
-#define FLUID_BUFSIZE                64         /**< FluidSynth internal buffer size (in samples) */
+#define FLUID_BUFSIZE                64         /**< Default FluidSynth internal buffer size (in samples), see synth.block-size */
+#define FLUID_BUFSIZE_MIN            16         /**< Smallest selectable internal buffer size */
+#define FLUID_BUFSIZE_MAX            256        /**< Largest selectable internal buffer size */
 #define FLUID_MIXER_MAX_BUFFERS_DEFAULT (8192/FLUID_BUFSIZE) /**< Number of buffers that can be processed in one rendering run */
 #define FLUID_MAX_EVENTS_PER_BUFSIZE 1024       /**< Maximum queued MIDI events per #FLUID_BUFSIZE */
 #define FLUID_MAX_RETURN_EVENTS      1024       /**< Maximum queued synthesis thread return events */
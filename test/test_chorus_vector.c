@@ -0,0 +1,83 @@
+#include "test.h"
+#include "test_fx.h"
+#include "fluidsynth.h"
+#include "rvoice/fluid_chorus.h"
+#include "utils/fluid_sys.h"
+
+enum { FRAMES = 44100, SAMPLE_RATE = 44100 };
+
+static fluid_real_t in[FRAMES];
+static fluid_real_t ref_left[FRAMES], ref_right[FRAMES];
+static fluid_real_t left[FRAMES], right[FRAMES];
+
+static void chorus_process(void *fx, const fluid_real_t *in, fluid_real_t *l, fluid_real_t *r, int count, int mix)
+{
+    if(mix)
+    {
+        fluid_chorus_processmix(fx, in, l, r, count);
+    }
+    else
+    {
+        fluid_chorus_processreplace(fx, in, l, r, count);
+    }
+}
+
+// runs the chorus in periods of varying length, replacing or mixing the output
+static void process(int cpu_isa, int mix, int nr, fluid_real_t depth_ms, int type,
+                    fluid_real_t *l, fluid_real_t *r)
+{
+    fluid_chorus_t *chorus = new_fluid_chorus(SAMPLE_RATE);
+
+    TEST_ASSERT(chorus != NULL);
+    fluid_chorus_set_cpu_isa(chorus, cpu_isa);
+    fluid_chorus_set(chorus, FLUID_CHORUS_SET_ALL, nr, 2.0, 4.5, depth_ms, type);
+
+    test_fx_fill(l, r, FRAMES, mix);
+    test_fx_process_periods(chorus_process, chorus, in, l, r, FRAMES, mix);
+
+    delete_fluid_chorus(chorus);
+}
+
+// the all-pass interpolators are close to instability, the rounding of fused
+// multiply-adds adds up to about a float resolution
+static void compare(void)
+{
+    int i;
+
+    for(i = 0; i < FRAMES; i++)
+    {
+        TEST_ASSERT(FLUID_FABS(left[i] - ref_left[i]) < 1e-7);
+        TEST_ASSERT(FLUID_FABS(right[i] - ref_right[i]) < 1e-7);
+    }
+}
+
+// this test makes sure that the vectorized chorus matches the scalar one
+int main(void)
+{
+    static const int nrs[] = { 0, 1, 2, 3, 4, 99 };
+    int cpu_isa = fluid_cpu_isa_detect();
+    int i;
+
+    // a few bursts of noise, then the tail
+    for(i = 0; i < FRAMES; i++)
+    {
+        in[i] = (i % 5000 < 700) ? ((i * 7919) % 2003) / 1001.5 - 1 : 0;
+    }
+
+    for(; cpu_isa > FLUID_CPU_ISA_GENERIC; cpu_isa--)
+    {
+        for(i = 0; i < (int)(sizeof(nrs) / sizeof(nrs[0])); i++)
+        {
+            process(FLUID_CPU_ISA_GENERIC, FALSE, nrs[i], 8.0, FLUID_CHORUS_MOD_SINE, ref_left, ref_right);
+            process(cpu_isa, FALSE, nrs[i], 8.0, FLUID_CHORUS_MOD_SINE, left, right);
+            compare();
+
+            // the deepest modulation reads the oldest sample of the line
+            process(FLUID_CPU_ISA_GENERIC, TRUE, nrs[i], 46.4, FLUID_CHORUS_MOD_TRIANGLE, ref_left, ref_right);
+            process(cpu_isa, TRUE, nrs[i], 46.4, FLUID_CHORUS_MOD_TRIANGLE, left, right);
+            compare();
+        }
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,195 @@
+#include "test.h"
+#include "test_fx.h"
+#include "fluidsynth.h"
+#include "rvoice/fluid_rev.h"
+#include "rvoice/fluid_convrev.h"
+#include "utils/fluid_sys.h"
+
+// long enough for the impulse response to reach the last partition stage
+enum { IR_FRAMES = 20000, FRAMES = 48000, SAMPLE_RATE = 44100, NIMPULSES = 40 };
+
+static float ir_left[IR_FRAMES], ir_right[IR_FRAMES];
+static fluid_real_t in[FRAMES];
+static fluid_real_t ref_left[FRAMES], ref_right[FRAMES];
+static fluid_real_t left[FRAMES], right[FRAMES];
+static float synth_left[FRAMES], synth_right[FRAMES];
+
+// straight time domain convolution of the sparse input with the normalized impulse response
+static void convolve(fluid_real_t wet)
+{
+    fluid_real_t energy_l = 0, energy_r = 0, norm;
+    int i, k;
+
+    for(i = 0; i < IR_FRAMES; i++)
+    {
+        energy_l += (fluid_real_t)ir_left[i] * ir_left[i];
+        energy_r += (fluid_real_t)ir_right[i] * ir_right[i];
+    }
+
+    norm = wet / FLUID_SQRT(energy_l > energy_r ? energy_l : energy_r);
+
+    for(i = 0; i < FRAMES; i++)
+    {
+        ref_left[i] = ref_right[i] = 0;
+    }
+
+    for(i = 0; i < FRAMES; i++)
+    {
+        if(in[i] == 0)
+        {
+            continue;
+        }
+
+        for(k = 0; k < IR_FRAMES && i + k < FRAMES; k++)
+        {
+            ref_left[i + k] += in[i] * ir_left[k] * norm;
+            ref_right[i + k] += in[i] * ir_right[k] * norm;
+        }
+    }
+}
+
+static void convrev_process(void *fx, const fluid_real_t *in, fluid_real_t *l, fluid_real_t *r, int count, int mix)
+{
+    if(mix)
+    {
+        fluid_convrev_processmix(fx, in, l, r, count);
+    }
+    else
+    {
+        fluid_convrev_processreplace(fx, in, l, r, count);
+    }
+}
+
+// runs the reverb in periods of varying length, replacing or mixing the output
+static void process(fluid_convrev_t *conv, int mix)
+{
+    int i, k, len;
+
+    fluid_convrev_reset(conv);
+
+    test_fx_fill(left, right, FRAMES, mix);
+    test_fx_process_periods(convrev_process, conv, in, left, right, FRAMES, mix);
+
+    for(i = 0; i < FRAMES; i++)
+    {
+        fluid_real_t offset = mix ? 0.25 : 0;
+
+        TEST_ASSERT(FLUID_FABS(left[i] - offset - ref_left[i]) < 1e-6);
+        TEST_ASSERT(FLUID_FABS(right[i] - offset - ref_right[i]) < 1e-6);
+    }
+
+    // the tail level bounds what comes out once the input stops
+    for(k = 0; k < 4 * IR_FRAMES; k += len)
+    {
+        fluid_real_t bound = fluid_convrev_get_tail_level(conv);
+        fluid_real_t zero[64] = { 0 };
+
+        len = 64;
+        fluid_convrev_processreplace(conv, zero, left, right, len);
+
+        for(i = 0; i < len; i++)
+        {
+            TEST_ASSERT(FLUID_FABS(left[i]) <= bound + 1e-9 && FLUID_FABS(right[i]) <= bound + 1e-9);
+        }
+    }
+
+    TEST_ASSERT(fluid_convrev_get_tail_level(conv) == 0);
+}
+
+// this test makes sure that the partitioned convolution matches a direct one, with no latency
+int main(void)
+{
+    fluid_settings_t *settings;
+    fluid_synth_t *synth;
+    fluid_convrev_ir_t *ir;
+    fluid_convrev_t *conv, *conv2;
+    float peak = 0;
+    unsigned int seed = 1;
+    int i, blk;
+
+    for(i = 0; i < IR_FRAMES; i++)
+    {
+        fluid_real_t env = FLUID_POW(0.9996, i);
+
+        ir_left[i] = (float)(test_fx_noise(&seed) * env);
+        ir_right[i] = (float)(test_fx_noise(&seed) * env);
+    }
+
+    for(i = 0; i < NIMPULSES; i++)
+    {
+        in[(i * 7919) % FRAMES] = test_fx_noise(&seed);
+    }
+
+    in[0] = 1;
+    in[FRAMES - 1] = -1;
+
+    ir = new_fluid_convrev_ir(ir_left, ir_right, IR_FRAMES, SAMPLE_RATE, SAMPLE_RATE);
+    TEST_ASSERT(ir != NULL);
+    conv = new_fluid_convrev(ir);
+    TEST_ASSERT(conv != NULL);
+    conv2 = new_fluid_convrev(ir);
+    TEST_ASSERT(conv2 != NULL);
+    delete_fluid_convrev_ir(ir);
+    TEST_ASSERT(fluid_convrev_get_tail_length(conv) >= IR_FRAMES);
+
+    // at width 1 each channel only gets its own impulse response
+    fluid_convrev_set(conv, FLUID_REVMODEL_SET_WIDTH | FLUID_REVMODEL_SET_LEVEL, 1.0, 1.0);
+    convolve(1.0 / (1.0 + 0.2));
+    process(conv, FALSE);
+    process(conv, TRUE);
+
+    fluid_convrev_set(conv, FLUID_REVMODEL_SET_LEVEL, 1.0, 0.5);
+    convolve(0.5 / (1.0 + 0.2));
+    process(conv, FALSE);
+
+    // a reverb sharing the impulse response keeps its own state
+    fluid_convrev_set(conv2, FLUID_REVMODEL_SET_WIDTH | FLUID_REVMODEL_SET_LEVEL, 1.0, 0.5);
+    process(conv2, TRUE);
+
+    delete_fluid_convrev(conv);
+    delete_fluid_convrev(conv2);
+
+    TEST_ASSERT(new_fluid_convrev_ir(NULL, NULL, IR_FRAMES, SAMPLE_RATE, SAMPLE_RATE) == NULL);
+    TEST_ASSERT(new_fluid_convrev_ir(ir_left, NULL, 0, SAMPLE_RATE, SAMPLE_RATE) == NULL);
+
+    // the synth takes the impulse response for one or all fx groups
+    settings = new_fluid_settings();
+    TEST_ASSERT(settings != NULL);
+    synth = new_fluid_synth(settings);
+    TEST_ASSERT(synth != NULL);
+    TEST_ASSERT(fluid_synth_sfload(synth, TEST_SOUNDFONT, 1) != FLUID_FAILED);
+
+    TEST_ASSERT(fluid_synth_set_reverb_group_impulse_response_data(synth, fluid_synth_count_effects_groups(synth),
+                ir_left, ir_right, IR_FRAMES, SAMPLE_RATE) == FLUID_FAILED);
+    TEST_ASSERT(fluid_synth_set_reverb_group_impulse_response_data(synth, -1, ir_left, NULL, 0, SAMPLE_RATE) == FLUID_FAILED);
+    TEST_SUCCESS(fluid_synth_set_reverb_group_impulse_response_data(synth, -1, ir_left, ir_right, IR_FRAMES, 22050));
+    TEST_SUCCESS(fluid_synth_set_reverb_group_impulse_response_data(synth, 0, ir_left, NULL, IR_FRAMES, SAMPLE_RATE));
+
+    TEST_SUCCESS(fluid_synth_noteon(synth, 0, 60, 127));
+
+    for(blk = 0; blk < FRAMES / 1024; blk++)
+    {
+        TEST_SUCCESS(fluid_synth_write_float(synth, 1024, synth_left, blk * 1024, 1, synth_right, blk * 1024, 1));
+    }
+
+    for(i = 0; i < FRAMES / 1024 * 1024; i++)
+    {
+        TEST_ASSERT(synth_left[i] == synth_left[i] && synth_right[i] == synth_right[i]);
+        peak = (FLUID_FABS(synth_left[i]) > peak) ? FLUID_FABS(synth_left[i]) : peak;
+    }
+
+    TEST_ASSERT(peak > 0);
+
+    // back to the built-in reverb
+    TEST_SUCCESS(fluid_synth_set_reverb_group_impulse_response_data(synth, -1, NULL, NULL, 0, 0));
+    TEST_SUCCESS(fluid_synth_write_float(synth, 1024, synth_left, 0, 1, synth_right, 0, 1));
+
+    // no impulse response can be loaded from a missing file
+    TEST_ASSERT(fluid_synth_set_reverb_group_impulse_response(synth, -1, "no such file.wav") == FLUID_FAILED);
+    TEST_SUCCESS(fluid_synth_set_reverb_group_impulse_response(synth, -1, NULL));
+
+    delete_fluid_synth(synth);
+    delete_fluid_settings(settings);
+
+    return EXIT_SUCCESS;
+}
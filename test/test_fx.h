@@ -0,0 +1,49 @@
+
+#pragma once
+
+#include "utils/fluid_sys.h"
+
+/*
+ * Helpers shared by the tests of the effects units.
+ */
+
+/* Processes count samples of in into left and right, mixing with or replacing what's there */
+typedef void (*test_fx_process_t)(void *fx, const fluid_real_t *in,
+                                  fluid_real_t *left, fluid_real_t *right, int count, int mix);
+
+/* Reproducible white noise between -1 and 1, seed being the state of the generator */
+static FLUID_INLINE fluid_real_t test_fx_noise(unsigned int *seed)
+{
+    *seed = *seed * 1103515245 + 12345;
+    return ((*seed >> 16) & 0x7fff) / 16384.0 - 1.0;
+}
+
+/* Fills the output with what the unit mixes with (0.25), or replaces (0) */
+static FLUID_INLINE void test_fx_fill(fluid_real_t *left, fluid_real_t *right, int frames, int mix)
+{
+    int i;
+
+    for(i = 0; i < frames; i++)
+    {
+        left[i] = right[i] = mix ? 0.25 : 0;
+    }
+}
+
+/* Runs a unit over frames samples in periods of varying length, 1 to 173 samples */
+static FLUID_INLINE void test_fx_process_periods(test_fx_process_t process, void *fx, const fluid_real_t *in,
+                                                 fluid_real_t *left, fluid_real_t *right, int frames, int mix)
+{
+    int i, len;
+
+    for(i = 0; i < frames; i += len)
+    {
+        len = 1 + (i * 7) % 173;
+
+        if(len > frames - i)
+        {
+            len = frames - i;
+        }
+
+        process(fx, (in != NULL) ? in + i : NULL, left + i, right + i, len, mix);
+    }
+}
@@ -0,0 +1,278 @@
+#include "test.h"
+#include "test_fx.h"
+#include "fluidsynth.h"
+#include "rvoice/fluid_insertfx.h"
+#include "utils/fluid_sys.h"
+
+enum { FRAMES = 44100, SAMPLE_RATE = 44100 };
+
+static fluid_real_t in_left[FRAMES], in_right[FRAMES];
+static fluid_real_t left[FRAMES], right[FRAMES];
+static float synth_left[FRAMES], synth_right[FRAMES];
+
+static void sine(fluid_real_t freq, fluid_real_t amp)
+{
+    int i;
+
+    for(i = 0; i < FRAMES; i++)
+    {
+        in_left[i] = in_right[i] = amp * FLUID_SIN(2 * FLUID_M_PI * freq * i / SAMPLE_RATE);
+    }
+}
+
+// the insert effects process their stereo input in place
+static void insertfx_process(void *fx, const fluid_real_t *in, fluid_real_t *l, fluid_real_t *r, int count, int mix)
+{
+    fluid_insertfx_process(fx, l, r, count);
+}
+
+// runs the insert effects in periods of varying length
+static void process(fluid_insertfx_t *fx)
+{
+    int i;
+
+    fluid_insertfx_reset(fx);
+
+    for(i = 0; i < FRAMES; i++)
+    {
+        left[i] = in_left[i];
+        right[i] = in_right[i];
+    }
+
+    test_fx_process_periods(insertfx_process, fx, NULL, left, right, FRAMES, FALSE);
+}
+
+// peak of the output in the second half, where the effects have settled
+static fluid_real_t settled_peak(void)
+{
+    fluid_real_t peak = 0;
+    int i;
+
+    for(i = FRAMES / 2; i < FRAMES; i++)
+    {
+        peak = (FLUID_FABS(left[i]) > peak) ? FLUID_FABS(left[i]) : peak;
+        TEST_ASSERT(left[i] == right[i]);
+    }
+
+    return peak;
+}
+
+// this test checks the equalizer, compressor and limiter on their own and inserted into the synth
+int main(void)
+{
+    fluid_settings_t *settings;
+    fluid_synth_t *synth;
+    fluid_insertfx_t *fx;
+    const char *name;
+    double value, def;
+    fluid_real_t ceiling, peak;
+    unsigned int seed = 1;
+    int i, param, blk, latency;
+
+    for(param = 0; param < FLUID_INSERT_FX_PARAM_LAST; param++)
+    {
+        TEST_SUCCESS(fluid_insertfx_param_info(param, &name, &def, NULL, NULL, NULL));
+        TEST_ASSERT(fluid_insertfx_param_index(name) == param);
+    }
+
+    TEST_ASSERT(fluid_insertfx_param_info(FLUID_INSERT_FX_PARAM_LAST, &name, NULL, NULL, NULL, NULL) == FLUID_FAILED);
+    TEST_ASSERT(fluid_insertfx_param_index("no.such.param") == -1);
+
+    fx = new_fluid_insertfx(SAMPLE_RATE, SAMPLE_RATE);
+    TEST_ASSERT(fx != NULL);
+    TEST_ASSERT(!fluid_insertfx_is_active(fx));
+
+    // an equalizer without gain leaves the signal untouched
+    for(i = 0; i < FRAMES; i++)
+    {
+        in_left[i] = test_fx_noise(&seed);
+        in_right[i] = test_fx_noise(&seed);
+    }
+
+    fluid_insertfx_set_param(fx, FLUID_INSERT_EQ_ACTIVE, 1);
+    TEST_ASSERT(fluid_insertfx_is_active(fx));
+    process(fx);
+
+    for(i = 0; i < FRAMES; i++)
+    {
+        TEST_ASSERT(left[i] == in_left[i] && right[i] == in_right[i]);
+    }
+
+    // the low shelf boosts the bass by 12 dB and lets the treble pass
+    fluid_insertfx_set_param(fx, FLUID_INSERT_EQ_LOW_GAIN, 12);
+    sine(40, 0.1);
+    process(fx);
+    peak = settled_peak();
+    TEST_ASSERT(peak > 0.1 * 3.5 && peak < 0.1 * 4.5);
+
+    sine(10000, 0.1);
+    process(fx);
+    peak = settled_peak();
+    TEST_ASSERT(peak > 0.1 * 0.9 && peak < 0.1 * 1.1);
+
+    fluid_insertfx_set_param(fx, FLUID_INSERT_EQ_ACTIVE, 0);
+    TEST_ASSERT(!fluid_insertfx_is_active(fx));
+
+    // a full scale sine is 20 dB over the threshold, which a 4:1 ratio brings down to 5 dB
+    fluid_insertfx_set_param(fx, FLUID_INSERT_COMPRESSOR_ACTIVE, 1);
+    sine(1000, 1.0);
+    process(fx);
+    peak = settled_peak();
+    TEST_ASSERT(peak > 0.12 && peak < 0.25);
+
+    // in RMS mode the level is 3 dB lower, so is the reduction
+    fluid_insertfx_set_param(fx, FLUID_INSERT_COMPRESSOR_RMS, 1);
+    process(fx);
+    TEST_ASSERT(settled_peak() > peak);
+    fluid_insertfx_set_param(fx, FLUID_INSERT_COMPRESSOR_ACTIVE, 0);
+
+    // the limiter never lets the output exceed the ceiling
+    fluid_insertfx_set_param(fx, FLUID_INSERT_LIMITER_ACTIVE, 1);
+    fluid_insertfx_set_param(fx, FLUID_INSERT_LIMITER_CEILING, -6);
+    ceiling = FLUID_POW(10, -6 / 20.0);
+
+    for(i = 0; i < FRAMES; i++)
+    {
+        in_left[i] = 2 * test_fx_noise(&seed) * ((i / 5000) % 2);
+        in_right[i] = test_fx_noise(&seed) * 0.25;
+    }
+
+    process(fx);
+
+    for(i = 0; i < FRAMES; i++)
+    {
+        TEST_ASSERT(FLUID_FABS(left[i]) <= ceiling + 1e-9 && FLUID_FABS(right[i]) <= ceiling + 1e-9);
+    }
+
+    // signals below the ceiling only get delayed by the lookahead
+    latency = (int)(2 * SAMPLE_RATE / 1000.0 + 0.5);
+
+    for(i = 0; i < FRAMES; i++)
+    {
+        in_left[i] = in_right[i] = (i % 1000 == 0) ? 0.25 : 0;
+    }
+
+    process(fx);
+
+    for(i = 0; i < FRAMES; i++)
+    {
+        fluid_real_t expect = (i >= latency) ? in_left[i - latency] : 0;
+
+        TEST_ASSERT(FLUID_FABS(left[i] - expect) < 1e-9 && FLUID_FABS(right[i] - expect) < 1e-9);
+    }
+
+    // switching another effect on leaves the delay line of the limiter alone
+    fluid_insertfx_reset(fx);
+    fluid_insertfx_set_param(fx, FLUID_INSERT_EQ_LOW_GAIN, 0);
+
+    for(i = 0; i < latency; i++)
+    {
+        left[i] = right[i] = (i == 0) ? 0.25 : 0;
+    }
+
+    fluid_insertfx_process(fx, left, right, latency);
+    fluid_insertfx_set_param(fx, FLUID_INSERT_EQ_ACTIVE, 1);
+
+    for(i = 0; i < latency; i++)
+    {
+        left[i] = right[i] = 0;
+    }
+
+    fluid_insertfx_process(fx, left, right, latency);
+    TEST_ASSERT(FLUID_FABS(left[0] - 0.25) < 1e-9 && FLUID_FABS(right[0] - 0.25) < 1e-9);
+    fluid_insertfx_set_param(fx, FLUID_INSERT_EQ_ACTIVE, 0);
+
+    // once the delay line has been flushed the limiter has nothing to do anymore
+    for(i = 0; i < 1024; i++)
+    {
+        left[i] = right[i] = 0;
+    }
+
+    fluid_insertfx_process(fx, left, right, 1024);
+    TEST_ASSERT(fluid_insertfx_is_idle(fx));
+
+    delete_fluid_insertfx(fx);
+
+    // the settings set up the insert effects of all audio groups
+    settings = new_fluid_settings();
+    TEST_ASSERT(settings != NULL);
+    TEST_SUCCESS(fluid_settings_setint(settings, "synth.audio-groups", 2));
+    TEST_SUCCESS(fluid_settings_setint(settings, "synth.limiter.active", 1));
+    TEST_SUCCESS(fluid_settings_setnum(settings, "synth.limiter.ceiling", -12));
+    TEST_SUCCESS(fluid_settings_setnum(settings, "synth.gain", 5));
+
+    synth = new_fluid_synth(settings);
+    TEST_ASSERT(synth != NULL);
+    TEST_ASSERT(fluid_synth_sfload(synth, TEST_SOUNDFONT, 1) != FLUID_FAILED);
+
+    TEST_SUCCESS(fluid_synth_get_insert_fx_param(synth, FLUID_INSERT_FX_AUDIO_GROUP, 1, FLUID_INSERT_LIMITER_CEILING, &value));
+    TEST_ASSERT(value == -12);
+    TEST_SUCCESS(fluid_synth_get_insert_fx_param(synth, FLUID_INSERT_FX_EFFECTS_GROUP, 0, FLUID_INSERT_LIMITER_ACTIVE, &value));
+    TEST_ASSERT(value == 0);
+
+    // invalid groups, parameters and values
+    TEST_ASSERT(fluid_synth_set_insert_fx_param(synth, FLUID_INSERT_FX_AUDIO_GROUP, 2, FLUID_INSERT_EQ_ACTIVE, 1) == FLUID_FAILED);
+    TEST_ASSERT(fluid_synth_set_insert_fx_param(synth, FLUID_INSERT_FX_EFFECTS_GROUP, -2, FLUID_INSERT_EQ_ACTIVE, 1) == FLUID_FAILED);
+    TEST_ASSERT(fluid_synth_set_insert_fx_param(synth, 2, 0, FLUID_INSERT_EQ_ACTIVE, 1) == FLUID_FAILED);
+    TEST_ASSERT(fluid_synth_set_insert_fx_param(synth, FLUID_INSERT_FX_AUDIO_GROUP, 0, FLUID_INSERT_FX_PARAM_LAST, 1) == FLUID_FAILED);
+    TEST_ASSERT(fluid_synth_set_insert_fx_param(synth, FLUID_INSERT_FX_AUDIO_GROUP, 0, FLUID_INSERT_EQ_LOW_GAIN, 25) == FLUID_FAILED);
+    TEST_ASSERT(fluid_synth_get_insert_fx_param(synth, FLUID_INSERT_FX_AUDIO_GROUP, -1, FLUID_INSERT_EQ_ACTIVE, &value) == FLUID_FAILED);
+
+    // one group or all of them
+    TEST_SUCCESS(fluid_synth_set_insert_fx_param(synth, FLUID_INSERT_FX_EFFECTS_GROUP, -1, FLUID_INSERT_LIMITER_ACTIVE, 1));
+    TEST_SUCCESS(fluid_synth_set_insert_fx_param(synth, FLUID_INSERT_FX_EFFECTS_GROUP, 0, FLUID_INSERT_LIMITER_CEILING, -12));
+    TEST_SUCCESS(fluid_synth_get_insert_fx_param(synth, FLUID_INSERT_FX_EFFECTS_GROUP, 0, FLUID_INSERT_LIMITER_ACTIVE, &value));
+    TEST_ASSERT(value == 1);
+
+    TEST_SUCCESS(fluid_synth_set_insert_fx_param(synth, FLUID_INSERT_FX_AUDIO_GROUP, 0, FLUID_INSERT_EQ_ACTIVE, 1));
+    TEST_SUCCESS(fluid_synth_get_insert_fx_param(synth, FLUID_INSERT_FX_AUDIO_GROUP, 1, FLUID_INSERT_EQ_ACTIVE, &value));
+    TEST_ASSERT(value == 0);
+
+    // real-time settings change all audio groups
+    TEST_SUCCESS(fluid_settings_setnum(settings, "synth.limiter.ceiling", -6));
+    TEST_SUCCESS(fluid_synth_get_insert_fx_param(synth, FLUID_INSERT_FX_AUDIO_GROUP, 0, FLUID_INSERT_LIMITER_CEILING, &value));
+    TEST_ASSERT(value == -6);
+    TEST_SUCCESS(fluid_settings_setnum(settings, "synth.limiter.ceiling", -12));
+
+    // the effects are mixed into the audio groups before their limiters, so a loud chord stays below the ceiling
+    for(i = 0; i < 8; i++)
+    {
+        TEST_SUCCESS(fluid_synth_noteon(synth, 0, 48 + i * 4, 127));
+    }
+
+    ceiling = FLUID_POW(10, -12 / 20.0);
+    peak = 0;
+
+    for(blk = 0; blk < FRAMES / 1024; blk++)
+    {
+        TEST_SUCCESS(fluid_synth_write_float(synth, 1024, synth_left, blk * 1024, 1, synth_right, blk * 1024, 1));
+    }
+
+    for(i = 0; i < FRAMES / 1024 * 1024; i++)
+    {
+        TEST_ASSERT(synth_left[i] == synth_left[i] && synth_right[i] == synth_right[i]);
+        peak = (FLUID_FABS(synth_left[i]) > peak) ? FLUID_FABS(synth_left[i]) : peak;
+        peak = (FLUID_FABS(synth_right[i]) > peak) ? FLUID_FABS(synth_right[i]) : peak;
+    }
+
+    TEST_ASSERT(peak > 0 && peak <= ceiling + 1e-6);
+
+    // the same without the effects
+    TEST_SUCCESS(fluid_synth_reverb_on(synth, -1, FALSE));
+    TEST_SUCCESS(fluid_synth_chorus_on(synth, -1, FALSE));
+
+    for(blk = 0; blk < FRAMES / 1024; blk++)
+    {
+        TEST_SUCCESS(fluid_synth_write_float(synth, 1024, synth_left, blk * 1024, 1, synth_right, blk * 1024, 1));
+    }
+
+    for(i = 0; i < FRAMES / 1024 * 1024; i++)
+    {
+        TEST_ASSERT(FLUID_FABS(synth_left[i]) <= ceiling + 1e-6 && FLUID_FABS(synth_right[i]) <= ceiling + 1e-6);
+    }
+
+    delete_fluid_synth(synth);
+    delete_fluid_settings(settings);
+
+    return EXIT_SUCCESS;
+}
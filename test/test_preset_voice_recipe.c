@@ -0,0 +1,303 @@
+#include "test.h"
+#include "fluidsynth.h"
+#include "sfloader/fluid_sfont.h"
+#include "sfloader/fluid_defsfont.h"
+#include "sfloader/fluid_sffile.h"
+#include "synth/fluid_synth.h"
+#include "synth/fluid_voice.h"
+#include "synth/fluid_mod.h"
+#include "utils/fluid_sys.h"
+
+// an instrument index the test soundfont doesn't use
+enum { INST_IDX = 0x7fff, MAX_VOICES = 16 };
+
+// SF2 modulator sources: index, bit 7 CC, bit 8 negative, bit 9 bipolar, type from bit 10
+#define CC(n) (0x80 | (n))
+#define VEL2ATT (FLUID_MOD_VELOCITY | 0x100 | 0x400)
+#define CC10_PAN (CC(10) | 0x200)
+
+static SFGen global_inst_gen[] =
+{
+    { GEN_FILTERFC, { 9000 } },
+    { GEN_ATTENUATION, { 100 } },
+    { GEN_PAN, { -200 } },
+    { GEN_VOLENVRELEASE, { -1200 } },
+};
+
+static SFMod global_inst_mod[] =
+{
+    { CC(1), GEN_FILTERFC, -2400, 0, 0 },
+    { CC(74), GEN_FILTERQ, 100, 0, 0 },
+};
+
+static SFGen inst_gen[] =
+{
+    { GEN_PAN, { 150 } },
+    { GEN_REVERBSEND, { 200 } },
+    { GEN_SAMPLEMODE, { 1 } },
+    { GEN_SAMPLEID, { 0 } },
+};
+
+static SFMod inst_mod[] =
+{
+    // supersedes the global one
+    { CC(1), GEN_FILTERFC, -1200, 0, 0 },
+    // supersedes the default modulator
+    { VEL2ATT, GEN_ATTENUATION, 480, 0, 0 },
+    { CC(11), GEN_VOLENVSUSTAIN, 200, 0, 0 },
+};
+
+static SFGen global_preset_gen[] =
+{
+    { GEN_ATTENUATION, { 20 } },
+    { GEN_CHORUSSEND, { 100 } },
+    { GEN_FILTERFC, { -300 } },
+    { GEN_COARSETUNE, { 1 } },
+};
+
+static SFMod global_preset_mod[] =
+{
+    // identical to an instrument modulator, adds to it
+    { CC(1), GEN_FILTERFC, 600, 0, 0 },
+    // identical to a default modulator, adds to it
+    { CC10_PAN, GEN_PAN, 100, 0, 0 },
+    { CC(11), GEN_VOLENVSUSTAIN, 100, 0, 0 },
+};
+
+static SFGen preset_gen[] =
+{
+    { GEN_CHORUSSEND, { 300 } },
+    { GEN_COARSETUNE, { 2 } },
+    { GEN_VOLENVRELEASE, { 100 } },
+    { GEN_INSTRUMENT, { INST_IDX } },
+};
+
+static SFMod preset_mod[] =
+{
+    // identical to a global instrument modulator, adds to it
+    { CC(74), GEN_FILTERQ, 30, 0, 0 },
+    { CC(91), GEN_REVERBSEND, 50, 0, 0 },
+    // supersedes the global one, and being disabled removes it
+    { CC(11), GEN_VOLENVSUSTAIN, 0, 0, 0 },
+};
+
+static fluid_voice_t *voices[MAX_VOICES];
+
+static void make_zone(SFZone *zone, SFGen *gen, int gen_count, SFMod *mod, int mod_count)
+{
+    int i;
+
+    zone->gen = zone->mod = NULL;
+
+    for(i = 0; i < gen_count; i++)
+    {
+        zone->gen = fluid_list_append(zone->gen, &gen[i]);
+    }
+
+    for(i = 0; i < mod_count; i++)
+    {
+        zone->mod = fluid_list_append(zone->mod, &mod[i]);
+    }
+}
+
+static void free_zone(SFZone *zone)
+{
+    delete_fluid_list(zone->gen);
+    delete_fluid_list(zone->mod);
+}
+
+// merges the global and local modulators of a zone and adds them to the voice, note by note
+static void add_mods(fluid_voice_t *voice, fluid_mod_t *global_mod, fluid_mod_t *local_mod, int mode)
+{
+    fluid_mod_t *list[FLUID_NUM_MOD];
+    int count = 0, local_count, limit, i;
+
+    for(; local_mod != NULL; local_mod = local_mod->next)
+    {
+        list[count++] = local_mod;
+    }
+
+    local_count = count;
+
+    for(; global_mod != NULL; global_mod = global_mod->next)
+    {
+        for(i = 0; i < local_count; i++)
+        {
+            if(fluid_mod_test_identity(global_mod, list[i]))
+            {
+                break;
+            }
+        }
+
+        if(i == local_count)
+        {
+            list[count++] = global_mod;
+        }
+    }
+
+    limit = voice->mod_count;
+
+    for(i = 0; i < count; i++)
+    {
+        if(mode == FLUID_VOICE_OVERWRITE || list[i]->amount != 0)
+        {
+            fluid_voice_add_mod_local(voice, list[i], mode, limit);
+        }
+    }
+}
+
+// sets up the voice from the four zones the way noteon did before the voice recipes
+static void reference_noteon(fluid_voice_t *voice, fluid_defpreset_t *defpreset)
+{
+    fluid_preset_zone_t *preset_zone = fluid_defpreset_get_zone(defpreset);
+    fluid_preset_zone_t *global_preset_zone = fluid_defpreset_get_global_zone(defpreset);
+    fluid_inst_t *inst = fluid_preset_zone_get_inst(preset_zone);
+    fluid_inst_zone_t *inst_zone = fluid_inst_get_zone(inst);
+    fluid_inst_zone_t *global_inst_zone = fluid_inst_get_global_zone(inst);
+    int i;
+
+    TEST_ASSERT(global_preset_zone != NULL && global_inst_zone != NULL);
+
+    for(i = 0; i < GEN_LAST; i++)
+    {
+        if(inst_zone->gen[i].flags)
+        {
+            fluid_voice_gen_set(voice, i, inst_zone->gen[i].val);
+        }
+        else if(global_inst_zone->gen[i].flags)
+        {
+            fluid_voice_gen_set(voice, i, global_inst_zone->gen[i].val);
+        }
+    }
+
+    add_mods(voice, global_inst_zone->mod, inst_zone->mod, FLUID_VOICE_OVERWRITE);
+
+    for(i = 0; i < GEN_LAST; i++)
+    {
+        if(preset_zone->gen[i].flags)
+        {
+            fluid_voice_gen_incr(voice, i, preset_zone->gen[i].val);
+        }
+        else if(global_preset_zone->gen[i].flags)
+        {
+            fluid_voice_gen_incr(voice, i, global_preset_zone->gen[i].val);
+        }
+    }
+
+    add_mods(voice, global_preset_zone->mod, preset_zone->mod, FLUID_VOICE_ADD);
+}
+
+// this test makes sure that a voice set up from the precompiled voice recipe gets
+// the same generators and modulators as one set up from the zones at every noteon
+int main(void)
+{
+    fluid_settings_t *settings = new_fluid_settings();
+    fluid_synth_t *synth;
+    fluid_defsfont_t *defsfont;
+    fluid_defpreset_t *defpreset;
+    fluid_voice_t *voice, *ref;
+    SFData sfdata;
+    SFSample sfsample;
+    SFInst sfinst;
+    SFPreset sfpreset;
+    SFZone zones[4];
+    fluid_list_t *list;
+    int id, i, folded = FALSE;
+
+    TEST_ASSERT(settings != NULL);
+    // fluid_defpreset_noteon() is called directly, without entering the API
+    TEST_SUCCESS(fluid_settings_setint(settings, "synth.threadsafe-api", 0));
+    synth = new_fluid_synth(settings);
+    TEST_ASSERT(synth != NULL);
+    id = fluid_synth_sfload(synth, TEST_SOUNDFONT, 1);
+    TEST_ASSERT(id != FLUID_FAILED);
+    defsfont = fluid_sfont_get_data(fluid_synth_get_sfont_by_id(synth, id));
+    TEST_ASSERT(defsfont != NULL);
+
+    // an instrument and a preset with a global and a local zone each, playing a sample of the test soundfont
+    FLUID_MEMSET(&sfdata, 0, sizeof(sfdata));
+    FLUID_MEMSET(&sfsample, 0, sizeof(sfsample));
+    FLUID_MEMSET(&sfinst, 0, sizeof(sfinst));
+    FLUID_MEMSET(&sfpreset, 0, sizeof(sfpreset));
+
+    for(list = defsfont->sample; list != NULL; list = fluid_list_next(list))
+    {
+        sfsample.fluid_sample = fluid_list_get(list);
+
+        if(!(sfsample.fluid_sample->sampletype & FLUID_SAMPLETYPE_ROM))
+        {
+            break;
+        }
+    }
+
+    TEST_ASSERT(list != NULL);
+    sfsample.idx = 0;
+    sfdata.sample = fluid_list_append(NULL, &sfsample);
+
+    make_zone(&zones[0], global_inst_gen, FLUID_N_ELEMENTS(global_inst_gen), global_inst_mod, FLUID_N_ELEMENTS(global_inst_mod));
+    make_zone(&zones[1], inst_gen, FLUID_N_ELEMENTS(inst_gen), inst_mod, FLUID_N_ELEMENTS(inst_mod));
+    FLUID_STRCPY(sfinst.name, "layered");
+    sfinst.idx = INST_IDX;
+    sfinst.zone = fluid_list_append(fluid_list_append(NULL, &zones[0]), &zones[1]);
+    sfdata.inst = fluid_list_append(NULL, &sfinst);
+
+    make_zone(&zones[2], global_preset_gen, FLUID_N_ELEMENTS(global_preset_gen), global_preset_mod, FLUID_N_ELEMENTS(global_preset_mod));
+    make_zone(&zones[3], preset_gen, FLUID_N_ELEMENTS(preset_gen), preset_mod, FLUID_N_ELEMENTS(preset_mod));
+    FLUID_STRCPY(sfpreset.name, "layered");
+    sfpreset.zone = fluid_list_append(fluid_list_append(NULL, &zones[2]), &zones[3]);
+
+    defpreset = new_fluid_defpreset();
+    TEST_ASSERT(defpreset != NULL);
+    TEST_SUCCESS(fluid_defpreset_import_sfont(defpreset, &sfpreset, defsfont, &sfdata));
+
+    // the voice recipe
+    TEST_SUCCESS(fluid_defpreset_noteon(defpreset, synth, 0, 60, 100));
+    fluid_synth_get_voicelist(synth, voices, MAX_VOICES, -1);
+    voice = voices[0];
+    TEST_ASSERT(voice != NULL && voices[1] == NULL);
+
+    // the zones, note by note
+    ref = fluid_synth_alloc_voice(synth, sfsample.fluid_sample, 0, 60, 100);
+    TEST_ASSERT(ref != NULL);
+    reference_noteon(ref, defpreset);
+    fluid_synth_start_voice(synth, ref);
+
+    for(i = 0; i < GEN_LAST; i++)
+    {
+        TEST_ASSERT(voice->gen[i].flags == ref->gen[i].flags);
+        TEST_ASSERT(voice->gen[i].val == ref->gen[i].val);
+    }
+
+    TEST_ASSERT(voice->mod_count == ref->mod_count);
+
+    for(i = 0; i < voice->mod_count; i++)
+    {
+        TEST_ASSERT(fluid_mod_test_identity(&voice->mod[i], &ref->mod[i]));
+        TEST_ASSERT(voice->mod[i].amount == ref->mod[i].amount);
+
+        // the preset modulator identical to an instrument one has been folded into it
+        if(voice->mod[i].src1 == 1 && voice->mod[i].dest == GEN_FILTERFC)
+        {
+            TEST_ASSERT(voice->mod[i].amount == -1200 + 600);
+            folded = TRUE;
+        }
+    }
+
+    TEST_ASSERT(folded);
+
+    delete_fluid_defpreset(defpreset);
+    delete_fluid_list(sfdata.sample);
+    delete_fluid_list(sfdata.inst);
+    delete_fluid_list(sfinst.zone);
+    delete_fluid_list(sfpreset.zone);
+
+    for(i = 0; i < 4; i++)
+    {
+        free_zone(&zones[i]);
+    }
+
+    delete_fluid_synth(synth);
+    delete_fluid_settings(settings);
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,75 @@
+#include "test.h"
+#include "test_fx.h"
+#include "fluidsynth.h"
+#include "rvoice/fluid_rev.h"
+#include "utils/fluid_sys.h"
+
+enum { FRAMES = 44100, SAMPLE_RATE = 44100 };
+
+static fluid_real_t in[FRAMES];
+static fluid_real_t ref_left[FRAMES], ref_right[FRAMES];
+static fluid_real_t left[FRAMES], right[FRAMES];
+
+static void reverb_process(void *fx, const fluid_real_t *in, fluid_real_t *l, fluid_real_t *r, int count, int mix)
+{
+    if(mix)
+    {
+        fluid_revmodel_processmix(fx, in, l, r, count);
+    }
+    else
+    {
+        fluid_revmodel_processreplace(fx, in, l, r, count);
+    }
+}
+
+// runs the reverb in periods of varying length, replacing or mixing the output
+static void process(int cpu_isa, int mix, fluid_real_t roomsize, fluid_real_t *l, fluid_real_t *r)
+{
+    fluid_revmodel_t *rev = new_fluid_revmodel(SAMPLE_RATE, SAMPLE_RATE);
+
+    TEST_ASSERT(rev != NULL);
+    fluid_revmodel_set_cpu_isa(rev, cpu_isa);
+    fluid_revmodel_set(rev, FLUID_REVMODEL_SET_ALL, roomsize, 0.3, 0.8, 0.9);
+
+    test_fx_fill(l, r, FRAMES, mix);
+    test_fx_process_periods(reverb_process, rev, in, l, r, FRAMES, mix);
+
+    delete_fluid_revmodel(rev);
+}
+
+static void compare(void)
+{
+    int i;
+
+    for(i = 0; i < FRAMES; i++)
+    {
+        TEST_ASSERT(FLUID_FABS(left[i] - ref_left[i]) < 1e-9);
+        TEST_ASSERT(FLUID_FABS(right[i] - ref_right[i]) < 1e-9);
+    }
+}
+
+// this test makes sure that the vectorized fdn reverb matches the scalar one
+int main(void)
+{
+    int cpu_isa = fluid_cpu_isa_detect();
+    int i;
+
+    // a few bursts of noise, then the tail
+    for(i = 0; i < FRAMES; i++)
+    {
+        in[i] = (i % 5000 < 700) ? ((i * 7919) % 2003) / 1001.5 - 1 : 0;
+    }
+
+    for(; cpu_isa > FLUID_CPU_ISA_GENERIC; cpu_isa--)
+    {
+        process(FLUID_CPU_ISA_GENERIC, FALSE, 0.6, ref_left, ref_right);
+        process(cpu_isa, FALSE, 0.6, left, right);
+        compare();
+
+        process(FLUID_CPU_ISA_GENERIC, TRUE, 1.0, ref_left, ref_right);
+        process(cpu_isa, TRUE, 1.0, left, right);
+        compare();
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,65 @@
+#include "test.h"
+#include "fluidsynth.h" // use local fluidsynth header
+#include "utils/fluid_sys.h"
+
+
+// this test makes sure that synthesizing from the pre-converted float sample store
+// (synth.sample-format=float) sounds exactly the same as synthesizing from the 16 bit data,
+// even if both synths share the same sample cache entry
+int main(void)
+{
+    enum { FRAMES = 4096 };
+    static float buf_int[FRAMES * 2], buf_float[FRAMES * 2];
+    static const int methods[] =
+    {
+        FLUID_INTERP_NONE, FLUID_INTERP_LINEAR, FLUID_INTERP_4THORDER, FLUID_INTERP_7THORDER
+    };
+    int i, interp;
+
+    fluid_settings_t *settings_int = new_fluid_settings();
+    fluid_settings_t *settings_float = new_fluid_settings();
+    fluid_synth_t *synth_int, *synth_float;
+
+    TEST_ASSERT(settings_int != NULL);
+    TEST_ASSERT(settings_float != NULL);
+
+    TEST_SUCCESS(fluid_settings_setstr(settings_float, "synth.sample-format", "float"));
+
+    synth_int = new_fluid_synth(settings_int);
+    synth_float = new_fluid_synth(settings_float);
+    TEST_ASSERT(synth_int != NULL);
+    TEST_ASSERT(synth_float != NULL);
+
+    TEST_SUCCESS(fluid_synth_sfload(synth_int, TEST_SOUNDFONT, 1));
+    TEST_SUCCESS(fluid_synth_sfload(synth_float, TEST_SOUNDFONT, 1));
+
+    for(interp = 0; interp < (int)(sizeof(methods) / sizeof(methods[0])); interp++)
+    {
+        TEST_SUCCESS(fluid_synth_set_interp_method(synth_int, -1, methods[interp]));
+        TEST_SUCCESS(fluid_synth_set_interp_method(synth_float, -1, methods[interp]));
+
+        for(i = 0; i < 8; i++)
+        {
+            TEST_SUCCESS(fluid_synth_noteon(synth_int, i, 36 + 7 * i, 100));
+            TEST_SUCCESS(fluid_synth_noteon(synth_float, i, 36 + 7 * i, 100));
+        }
+
+        TEST_SUCCESS(fluid_synth_write_float(synth_int, FRAMES, buf_int, 0, 2, buf_int, 1, 2));
+        TEST_SUCCESS(fluid_synth_write_float(synth_float, FRAMES, buf_float, 0, 2, buf_float, 1, 2));
+
+        for(i = 0; i < FRAMES * 2; i++)
+        {
+            TEST_ASSERT(buf_int[i] == buf_float[i]);
+        }
+
+        TEST_SUCCESS(fluid_synth_all_notes_off(synth_int, -1));
+        TEST_SUCCESS(fluid_synth_all_notes_off(synth_float, -1));
+    }
+
+    delete_fluid_synth(synth_float);
+    delete_fluid_synth(synth_int);
+    delete_fluid_settings(settings_float);
+    delete_fluid_settings(settings_int);
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,130 @@
+#include "test.h"
+#include "fluidsynth.h"
+#include "utils/fluid_sys.h"
+#include "sfloader/fluid_sfont.h"
+#include "sfloader/fluid_defsfont.h"
+#include "synth/fluid_voice.h"
+
+enum { FRAMES = 22050 };
+
+static float ref_left[FRAMES], ref_right[FRAMES];
+static float left[FRAMES], right[FRAMES];
+
+// plays a note whose samples have short loops, with or without their unrolled loop buffers
+static void render_note(int interp, int guarded)
+{
+    fluid_settings_t *settings = new_fluid_settings();
+    fluid_synth_t *synth;
+    fluid_defsfont_t *defsfont;
+    fluid_voice_t *voices[4] = { NULL };
+    fluid_list_t *list;
+    int id, i;
+
+    TEST_ASSERT(settings != NULL);
+    TEST_SUCCESS(fluid_settings_setint(settings, "synth.reverb.active", 0));
+    TEST_SUCCESS(fluid_settings_setint(settings, "synth.chorus.active", 0));
+
+    synth = new_fluid_synth(settings);
+    TEST_ASSERT(synth != NULL);
+    TEST_SUCCESS(id = fluid_synth_sfload(synth, TEST_SOUNDFONT, 1));
+    TEST_SUCCESS(fluid_synth_set_interp_method(synth, -1, interp));
+
+    defsfont = fluid_sfont_get_data(fluid_synth_get_sfont_by_id(synth, id));
+
+    for(list = defsfont->sample; list != NULL && !guarded; list = fluid_list_next(list))
+    {
+        fluid_sample_free_loop_guard(fluid_list_get(list));
+    }
+
+    TEST_SUCCESS(fluid_synth_noteon(synth, 0, 60, 100));
+    fluid_synth_get_voicelist(synth, voices, FLUID_N_ELEMENTS(voices), -1);
+    TEST_ASSERT(voices[0] != NULL);
+
+    for(i = 0; i < (int)FLUID_N_ELEMENTS(voices) && voices[i] != NULL; i++)
+    {
+        TEST_ASSERT((voices[i]->sample->loop_guard != NULL) == guarded);
+    }
+
+    TEST_SUCCESS(fluid_synth_write_float(synth, FRAMES, left, 0, 1, right, 0, 1));
+
+    delete_fluid_synth(synth);
+    delete_fluid_settings(settings);
+}
+
+
+// this test makes sure that the unrolled loop buffer of a sample repeats the loop and wraps around
+// correctly in its guard points, as the interpolators rely on that when rendering looping voices,
+// and that they render the same with and without it
+int main(void)
+{
+    enum { SAMPLE_COUNT = 64, LOOP_START = 20, LOOP_END = 27 };
+    static const int interps[] =
+    {
+        FLUID_INTERP_NONE, FLUID_INTERP_LINEAR, FLUID_INTERP_4THORDER, FLUID_INTERP_7THORDER
+    };
+    short data[SAMPLE_COUNT];
+    fluid_sample_t *sample = new_fluid_sample();
+    unsigned int loop_len = LOOP_END - LOOP_START;
+    int i;
+
+    TEST_ASSERT(sample != NULL);
+
+    for(i = 0; i < SAMPLE_COUNT; i++)
+    {
+        data[i] = (short)(i * 100 - 3000);
+    }
+
+    TEST_SUCCESS(fluid_sample_set_sound_data(sample, data, NULL, SAMPLE_COUNT, 44100, FALSE));
+    TEST_SUCCESS(fluid_sample_set_loop(sample, LOOP_START, LOOP_END));
+
+    TEST_SUCCESS(fluid_sample_build_loop_guard(sample));
+    TEST_ASSERT(sample->loop_guard != NULL);
+    TEST_ASSERT(sample->loop_guard_size >= FLUID_LOOP_GUARD_SIZE);
+    TEST_ASSERT(sample->loop_guard_size % loop_len == 0);
+
+    for(i = -FLUID_LOOP_GUARD_PAD; i < (int)sample->loop_guard_size + FLUID_LOOP_GUARD_PAD; i++)
+    {
+        int idx = LOOP_START + (i + (int)loop_len * FLUID_LOOP_GUARD_PAD) % (int)loop_len;
+        float expected = (float)(data[idx] * 256);
+
+        TEST_ASSERT(sample->loop_guard[i + FLUID_LOOP_GUARD_PAD] == expected);
+    }
+
+    // changing the loop invalidates the buffer
+    TEST_SUCCESS(fluid_sample_set_loop(sample, LOOP_START, LOOP_END + 1));
+    TEST_ASSERT(sample->loop_guard == NULL);
+    TEST_ASSERT(sample->loop_guard_size == 0);
+
+    // long loops are not unrolled
+    sample->loopstart = sample->start;
+    sample->loopend = sample->start + FLUID_LOOP_GUARD_SIZE;
+    sample->end = sample->loopend;
+    TEST_SUCCESS(fluid_sample_build_loop_guard(sample));
+    TEST_ASSERT(sample->loop_guard == NULL);
+
+    // neither are invalid loops
+    TEST_SUCCESS(fluid_sample_set_loop(sample, LOOP_END, LOOP_START));
+    TEST_SUCCESS(fluid_sample_build_loop_guard(sample));
+    TEST_ASSERT(sample->loop_guard == NULL);
+
+    delete_fluid_sample(sample);
+
+    // voices reading from the unrolled loop sound exactly like voices reading the sample data
+    for(i = 0; i < (int)FLUID_N_ELEMENTS(interps); i++)
+    {
+        int j;
+
+        render_note(interps[i], TRUE);
+        FLUID_MEMCPY(ref_left, left, sizeof(left));
+        FLUID_MEMCPY(ref_right, right, sizeof(right));
+
+        render_note(interps[i], FALSE);
+
+        for(j = 0; j < FRAMES; j++)
+        {
+            TEST_ASSERT(left[j] == ref_left[j] && right[j] == ref_right[j]);
+        }
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,83 @@
+#include "test.h"
+#include "fluidsynth.h"
+#include "sfloader/fluid_defsfont.h"
+#include "utils/fluid_sys.h"
+
+enum { ZONES = 6 };
+
+static fluid_zone_range_t range[ZONES] =
+{
+    /* keylo, keyhi, vello, velhi, ignore */
+    { 0, 128, 0, 127, FALSE },
+    { 0, 59, 0, 127, FALSE },
+    { 60, 127, 0, 63, FALSE },
+    { 60, 127, 64, 127, FALSE },
+    { 64, 60, 0, 127, FALSE },  // empty
+    { 120, 255, 0, 127, FALSE },
+};
+
+// the zones found for a key must be exactly those of a linear scan, in the same order
+static void check_key(const fluid_zone_index_t *index, int key)
+{
+    const int *entry;
+    int count = fluid_zone_index_lookup(index, key, &entry);
+    int i, n = 0;
+
+    // keys outside of the table get all zones, fluid_zone_inside_range() sorts them out
+    if(key < 0 || key >= FLUID_ZONE_INDEX_KEYS)
+    {
+        TEST_ASSERT(count == ZONES);
+
+        for(i = 0; i < ZONES; i++)
+        {
+            TEST_ASSERT(entry[i] == i);
+        }
+
+        return;
+    }
+
+    for(i = 0; i < ZONES; i++)
+    {
+        if(range[i].keylo <= key && key <= range[i].keyhi)
+        {
+            TEST_ASSERT(n < count);
+            TEST_ASSERT(entry[n] == i);
+            n++;
+        }
+    }
+
+    TEST_ASSERT(count == n);
+}
+
+// this test makes sure that the zone index finds the zones of a key
+int main(void)
+{
+    fluid_zone_range_t *ranges[ZONES];
+    fluid_zone_index_t *index;
+    const int *entry;
+    int i, key;
+
+    for(i = 0; i < ZONES; i++)
+    {
+        ranges[i] = &range[i];
+    }
+
+    index = new_fluid_zone_index(ranges, ZONES);
+    TEST_ASSERT(index != NULL);
+
+    for(key = -10; key < 300; key++)
+    {
+        check_key(index, key);
+    }
+
+    delete_fluid_zone_index(index);
+
+    // a preset without zones
+    index = new_fluid_zone_index(ranges, 0);
+    TEST_ASSERT(index != NULL);
+    TEST_ASSERT(fluid_zone_index_lookup(index, 60, &entry) == 0);
+    TEST_ASSERT(fluid_zone_index_lookup(index, -1, &entry) == 0);
+    delete_fluid_zone_index(index);
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,97 @@
+#include "test.h"
+#include "fluidsynth.h" // use local fluidsynth header
+#include "utils/fluid_sys.h"
+
+// program 46 plays a single, long looped sample per note
+enum { FRAMES = 4096, NOTES = 4, PROGRAM = 46 };
+
+static float ref_bufs[2 * NOTES][FRAMES];
+static float bufs[2 * NOTES][FRAMES];
+
+static const int keys[NOTES] = { 48, 55, 64, 71 };
+
+static fluid_synth_t *create_synth(fluid_settings_t *settings, int interp)
+{
+    fluid_synth_t *synth = new_fluid_synth(settings);
+
+    TEST_ASSERT(synth != NULL);
+    TEST_SUCCESS(fluid_synth_sfload(synth, TEST_SOUNDFONT, 1));
+    TEST_SUCCESS(fluid_synth_set_interp_method(synth, -1, interp));
+
+    return synth;
+}
+
+static void render(fluid_synth_t *synth, float data[2 * NOTES][FRAMES])
+{
+    float *out[2 * NOTES];
+    int i;
+
+    FLUID_MEMSET(data, 0, sizeof(bufs));
+
+    for(i = 0; i < 2 * NOTES; i++)
+    {
+        out[i] = data[i];
+    }
+
+    TEST_SUCCESS(fluid_synth_process(synth, FRAMES, 0, NULL, 2 * NOTES, out));
+}
+
+// this test makes sure that voices rendered side by side in a batch sound exactly
+// like the same voices rendered one at a time
+int main(void)
+{
+    static const int interps[] =
+    {
+        FLUID_INTERP_NONE, FLUID_INTERP_LINEAR, FLUID_INTERP_4THORDER, FLUID_INTERP_7THORDER
+    };
+
+    fluid_settings_t *settings = new_fluid_settings();
+    fluid_synth_t *synth;
+    unsigned int m;
+    int i, k;
+
+    TEST_ASSERT(settings != NULL);
+    TEST_SUCCESS(fluid_settings_setint(settings, "synth.reverb.active", 0));
+    TEST_SUCCESS(fluid_settings_setint(settings, "synth.chorus.active", 0));
+    // every MIDI channel gets its own stereo output, so that the voices are not summed
+    TEST_SUCCESS(fluid_settings_setint(settings, "synth.audio-channels", NOTES));
+    TEST_SUCCESS(fluid_settings_setint(settings, "synth.audio-groups", NOTES));
+
+    for(m = 0; m < FLUID_N_ELEMENTS(interps); m++)
+    {
+        // all notes at once, their voices are batched
+        synth = create_synth(settings, interps[m]);
+
+        for(k = 0; k < NOTES; k++)
+        {
+            TEST_SUCCESS(fluid_synth_program_change(synth, k, PROGRAM));
+            TEST_SUCCESS(fluid_synth_noteon(synth, k, keys[k], 100));
+        }
+
+        TEST_ASSERT(fluid_synth_get_active_voice_count(synth) == NOTES);
+        render(synth, ref_bufs);
+        delete_fluid_synth(synth);
+
+        // one note after the other, each voice takes the single voice path
+        for(k = 0; k < NOTES; k++)
+        {
+            synth = create_synth(settings, interps[m]);
+
+            TEST_SUCCESS(fluid_synth_program_change(synth, k, PROGRAM));
+            TEST_SUCCESS(fluid_synth_noteon(synth, k, keys[k], 100));
+            TEST_ASSERT(fluid_synth_get_active_voice_count(synth) == 1);
+            render(synth, bufs);
+            delete_fluid_synth(synth);
+
+            for(i = 0; i < FRAMES; i++)
+            {
+                TEST_ASSERT(bufs[2 * k][i] == ref_bufs[2 * k][i]);
+                TEST_ASSERT(bufs[2 * k + 1][i] == ref_bufs[2 * k + 1][i]);
+            }
+        }
+    }
+
+    delete_fluid_settings(settings);
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,165 @@
+#include "test.h"
+#include "fluidsynth.h" // use local fluidsynth header
+#include "utils/fluid_sys.h"
+#include "synth/fluid_synth.h"
+
+enum { FRAMES = 22050, CHUNK = 1000 };
+
+static float left[FRAMES], right[FRAMES];
+static float ref_left[FRAMES], ref_right[FRAMES];
+
+static fluid_synth_t *create_synth(fluid_settings_t *settings)
+{
+    fluid_synth_t *synth = new_fluid_synth(settings);
+
+    TEST_ASSERT(synth != NULL);
+    TEST_SUCCESS(fluid_synth_sfload(synth, TEST_SOUNDFONT, 1));
+
+    return synth;
+}
+
+static void render(fluid_synth_t *synth, int start, int len)
+{
+    int n;
+
+    for(; len > 0; start += n, len -= n)
+    {
+        n = (len > CHUNK) ? CHUNK : len;
+        TEST_SUCCESS(fluid_synth_write_float(synth, n, left, start, 1, right, start, 1));
+    }
+}
+
+// checks that notes scheduled with fluid_synth_noteon_at() start at the very frame requested
+static void check_note_timing(int block_size)
+{
+    fluid_settings_t *settings = new_fluid_settings();
+    fluid_synth_t *synth;
+    int i, first;
+
+    TEST_ASSERT(settings != NULL);
+    TEST_SUCCESS(fluid_settings_setint(settings, "synth.block-size", block_size));
+    TEST_SUCCESS(fluid_settings_setint(settings, "synth.reverb.active", 0));
+    TEST_SUCCESS(fluid_settings_setint(settings, "synth.chorus.active", 0));
+
+    // a note scheduled at a block boundary sounds exactly like a note started right before that block
+    synth = create_synth(settings);
+    render(synth, 0, 2 * block_size);
+    TEST_SUCCESS(fluid_synth_noteon(synth, 0, 60, 100));
+    render(synth, 2 * block_size, FRAMES - 2 * block_size);
+    delete_fluid_synth(synth);
+    FLUID_MEMCPY(ref_left, left, sizeof(left));
+    FLUID_MEMCPY(ref_right, right, sizeof(right));
+
+    synth = create_synth(settings);
+    TEST_SUCCESS(fluid_synth_noteon_at(synth, 2 * block_size, 0, 60, 100));
+    render(synth, 0, FRAMES);
+    delete_fluid_synth(synth);
+
+    for(i = 0; i < FRAMES; i++)
+    {
+        TEST_ASSERT(left[i] == ref_left[i] && right[i] == ref_right[i]);
+    }
+
+    // a note scheduled within a block is silent up to the requested frame, and moving
+    // it by one block moves the output by exactly that many frames
+    synth = create_synth(settings);
+    TEST_SUCCESS(fluid_synth_noteon_at(synth, block_size + 5, 0, 60, 100));
+    render(synth, 0, FRAMES);
+    delete_fluid_synth(synth);
+    FLUID_MEMCPY(ref_left, left, sizeof(left));
+    FLUID_MEMCPY(ref_right, right, sizeof(right));
+
+    for(first = 0; first < FRAMES && left[first] == 0 && right[first] == 0; first++)
+    {
+    }
+
+    TEST_ASSERT(first >= block_size + 5);
+    // the volume envelope rises from zero, give it a block or two to become audible
+    TEST_ASSERT(first < 3 * block_size + 5);
+
+    synth = create_synth(settings);
+    TEST_SUCCESS(fluid_synth_noteon_at(synth, 2 * block_size + 5, 0, 60, 100));
+    render(synth, 0, FRAMES);
+    delete_fluid_synth(synth);
+
+    for(i = 0; i < block_size; i++)
+    {
+        TEST_ASSERT(left[i] == 0 && right[i] == 0);
+    }
+
+    for(i = block_size; i < FRAMES; i++)
+    {
+        TEST_ASSERT(left[i] == ref_left[i - block_size] && right[i] == ref_right[i - block_size]);
+    }
+
+    delete_fluid_settings(settings);
+}
+
+// renders half a second of a note in odd sized chunks and returns its RMS
+static double render_note(int block_size)
+{
+    fluid_settings_t *settings = new_fluid_settings();
+    fluid_synth_t *synth;
+    double sum = 0;
+    int ticks, i;
+
+    TEST_ASSERT(settings != NULL);
+    TEST_SUCCESS(fluid_settings_setint(settings, "synth.block-size", block_size));
+    TEST_SUCCESS(fluid_settings_setint(settings, "synth.reverb.active", 0));
+    TEST_SUCCESS(fluid_settings_setint(settings, "synth.chorus.active", 0));
+
+    synth = create_synth(settings);
+    TEST_ASSERT(fluid_synth_get_internal_bufsize(synth) == block_size);
+
+    TEST_SUCCESS(fluid_synth_noteon(synth, 0, 60, 100));
+    render(synth, 0, FRAMES);
+
+    // ticks advance by whole blocks, never more than one block ahead of the output
+    ticks = fluid_atomic_int_get(&synth->ticks_since_start);
+    TEST_ASSERT(ticks >= FRAMES);
+    TEST_ASSERT(ticks < FRAMES + block_size);
+    TEST_ASSERT(ticks % block_size == 0);
+
+    for(i = 0; i < FRAMES; i++)
+    {
+        TEST_ASSERT(left[i] == left[i] && right[i] == right[i]);
+        sum += left[i] * left[i] + right[i] * right[i];
+    }
+
+    delete_fluid_synth(synth);
+    delete_fluid_settings(settings);
+
+    return FLUID_SQRT(sum / (2 * FRAMES));
+}
+
+// this test makes sure that the block size can be chosen at runtime without changing the sound
+int main(void)
+{
+    static const int sizes[] = { 16, 32, 128, 256 };
+    fluid_settings_t *settings = new_fluid_settings();
+    fluid_synth_t *synth;
+    double ref;
+    int i;
+
+    // values that are not a power of two are rounded down
+    TEST_ASSERT(settings != NULL);
+    TEST_SUCCESS(fluid_settings_setint(settings, "synth.block-size", 100));
+    synth = new_fluid_synth(settings);
+    TEST_ASSERT(synth != NULL);
+    TEST_ASSERT(fluid_synth_get_internal_bufsize(synth) == 64);
+    delete_fluid_synth(synth);
+    delete_fluid_settings(settings);
+
+    ref = render_note(64);
+    TEST_ASSERT(ref > 0);
+
+    for(i = 0; i < (int)(sizeof(sizes) / sizeof(sizes[0])); i++)
+    {
+        double rms = render_note(sizes[i]);
+        TEST_ASSERT(FLUID_FABS(rms - ref) < 0.05 * ref);
+
+        check_note_timing(sizes[i]);
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,76 @@
+#include "test.h"
+#include "fluidsynth.h" // use local fluidsynth header
+#include "utils/fluid_sys.h"
+
+enum { BLOCKS = 64, FRAMES = 300 };
+
+static float ref_left[BLOCKS * FRAMES], ref_right[BLOCKS * FRAMES];
+static float left[BLOCKS * FRAMES], right[BLOCKS * FRAMES];
+
+// plays notes under a burst of controller messages before every period
+static void render(int coalesce, float *l, float *r)
+{
+    fluid_settings_t *settings = new_fluid_settings();
+    fluid_synth_t *synth;
+    int blk, i, chan;
+
+    TEST_ASSERT(settings != NULL);
+    TEST_SUCCESS(fluid_settings_setint(settings, "synth.coalesce-controllers", coalesce));
+
+    synth = new_fluid_synth(settings);
+    TEST_ASSERT(synth != NULL);
+    TEST_ASSERT(fluid_synth_sfload(synth, TEST_SOUNDFONT, 1) != FLUID_FAILED);
+
+    for(blk = 0; blk < BLOCKS; blk++)
+    {
+        chan = blk % 3;
+
+        if(blk % 4 == 0)
+        {
+            TEST_SUCCESS(fluid_synth_noteon(synth, chan, 48 + blk % 24, 100));
+        }
+
+        for(i = 0; i < 100; i++)
+        {
+            TEST_SUCCESS(fluid_synth_cc(synth, chan, 1, (blk * 7 + i) % 128));
+            TEST_SUCCESS(fluid_synth_cc(synth, chan, 7, 127 - (blk + i) % 64));
+            TEST_SUCCESS(fluid_synth_cc(synth, chan, 74, (blk * 3 + i) % 128));
+            TEST_SUCCESS(fluid_synth_pitch_bend(synth, chan, (blk * 500 + i * 37) % 16384));
+            TEST_SUCCESS(fluid_synth_channel_pressure(synth, chan, i % 128));
+        }
+
+        // the channel follows right away
+        TEST_ASSERT(fluid_synth_get_cc(synth, chan, 7, &i) == FLUID_OK && i == 127 - (blk + 99) % 64);
+
+        if(blk % 16 == 15)
+        {
+            TEST_SUCCESS(fluid_synth_cc(synth, chan, 121, 0));
+        }
+
+        if(blk % 8 == 6)
+        {
+            TEST_SUCCESS(fluid_synth_noteoff(synth, (blk - 6) % 3, 48 + (blk - 6) % 24));
+        }
+
+        TEST_SUCCESS(fluid_synth_write_float(synth, FRAMES, l, blk * FRAMES, 1, r, blk * FRAMES, 1));
+    }
+
+    delete_fluid_synth(synth);
+    delete_fluid_settings(settings);
+}
+
+// this test makes sure that coalescing controller changes doesn't change the sound
+int main(void)
+{
+    int i;
+
+    render(0, ref_left, ref_right);
+    render(1, left, right);
+
+    for(i = 0; i < BLOCKS * FRAMES; i++)
+    {
+        TEST_ASSERT(left[i] == ref_left[i] && right[i] == ref_right[i]);
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,72 @@
+#include "test.h"
+#include "fluidsynth.h" // use local fluidsynth header
+#include "utils/fluid_sys.h"
+#include "synth/fluid_synth.h"
+#include "rvoice/fluid_rvoice_mixer.h"
+
+enum { FRAMES = 8192 };
+
+static float ref_left[FRAMES], ref_right[FRAMES];
+static float left[FRAMES], right[FRAMES];
+
+// renders a chord through the voices, the reverb and the chorus using the given instruction set
+static void render(const char *isa, int expected)
+{
+    fluid_settings_t *settings = new_fluid_settings();
+    fluid_synth_t *synth;
+    int i;
+
+    TEST_ASSERT(settings != NULL);
+    TEST_SUCCESS(fluid_settings_setstr(settings, "synth.cpu-isa", isa));
+
+    synth = new_fluid_synth(settings);
+    TEST_ASSERT(synth != NULL);
+    TEST_ASSERT(fluid_rvoice_mixer_get_cpu_isa(synth->eventhandler->mixer) == expected);
+    TEST_SUCCESS(fluid_synth_sfload(synth, TEST_SOUNDFONT, 1));
+
+    for(i = 0; i < 12; i++)
+    {
+        TEST_SUCCESS(fluid_synth_noteon(synth, i % 4, 48 + 5 * i, 100));
+    }
+
+    TEST_SUCCESS(fluid_synth_write_float(synth, FRAMES, left, 0, 1, right, 0, 1));
+
+    delete_fluid_synth(synth);
+    delete_fluid_settings(settings);
+}
+
+// this test makes sure that synth.cpu-isa selects the requested dsp kernels (or the best supported
+// ones), and that all of them sound like the generic kernels
+int main(void)
+{
+    static const char *const names[FLUID_CPU_ISA_LAST] = { "generic", "avx2", "avx512" };
+    int detected = fluid_cpu_isa_detect();
+    int isa, i, audible;
+
+    render("auto", detected);
+
+    render("generic", FLUID_CPU_ISA_GENERIC);
+    FLUID_MEMCPY(ref_left, left, sizeof(left));
+    FLUID_MEMCPY(ref_right, right, sizeof(right));
+
+    for(audible = FALSE, i = 0; i < FRAMES; i++)
+    {
+        audible |= (ref_left[i] != 0.0f);
+    }
+
+    TEST_ASSERT(audible);
+
+    for(isa = FLUID_CPU_ISA_AVX2; isa < FLUID_CPU_ISA_LAST; isa++)
+    {
+        render(names[isa], isa > detected ? detected : isa);
+
+        // FMA contraction may change the rounding, but nothing else
+        for(i = 0; i < FRAMES; i++)
+        {
+            TEST_ASSERT(FLUID_FABS(left[i] - ref_left[i]) < 1e-4f);
+            TEST_ASSERT(FLUID_FABS(right[i] - ref_right[i]) < 1e-4f);
+        }
+    }
+
+    return EXIT_SUCCESS;
+}
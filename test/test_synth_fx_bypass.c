@@ -0,0 +1,97 @@
+#include "test.h"
+#include "fluidsynth.h" // use local fluidsynth header
+#include "utils/fluid_sys.h"
+
+enum { FRAMES = 4096, NFX = 4 };
+
+static float fx_bufs[NFX][FRAMES];
+static float out_bufs[2][FRAMES];
+
+// renders one period, returns the peak of the effects output
+static float process(fluid_synth_t *synth, int fx_silent[NFX])
+{
+    float *out[2], *fx[NFX];
+    int out_silent[2];
+    float peak = 0;
+    int i, j;
+
+    FLUID_MEMSET(out_bufs, 0, sizeof(out_bufs));
+    FLUID_MEMSET(fx_bufs, 0, sizeof(fx_bufs));
+
+    out[0] = out_bufs[0];
+    out[1] = out_bufs[1];
+
+    for(i = 0; i < NFX; i++)
+    {
+        fx[i] = fx_bufs[i];
+    }
+
+    TEST_SUCCESS(fluid_synth_process(synth, FRAMES, NFX, fx, 2, out));
+    TEST_SUCCESS(fluid_synth_get_silent_buffers(synth, NFX, fx_silent, 2, out_silent));
+
+    for(i = 0; i < NFX; i++)
+    {
+        for(j = 0; j < FRAMES; j++)
+        {
+            if(FLUID_FABS(fx_bufs[i][j]) > peak)
+            {
+                peak = FLUID_FABS(fx_bufs[i][j]);
+            }
+        }
+    }
+
+    return peak;
+}
+
+// this test makes sure that the reverb and chorus are skipped once their tail has faded out,
+// and that they resume as soon as they get some input again
+int main(void)
+{
+    int fx_silent[NFX];
+    int i, periods;
+    float peak, last_peak = 0;
+
+    fluid_settings_t *settings = new_fluid_settings();
+    fluid_synth_t *synth;
+
+    TEST_ASSERT(settings != NULL);
+    TEST_SUCCESS(fluid_settings_setint(settings, "synth.effects-channels", NFX / 2));
+    TEST_SUCCESS(fluid_settings_setint(settings, "synth.effects-groups", 1));
+
+    synth = new_fluid_synth(settings);
+    TEST_ASSERT(synth != NULL);
+    TEST_SUCCESS(fluid_synth_sfload(synth, TEST_SOUNDFONT, 1));
+    TEST_SUCCESS(fluid_synth_cc(synth, 0, 91, 127));
+    TEST_SUCCESS(fluid_synth_cc(synth, 0, 93, 127));
+
+    for(i = 0; i < 3; i++)
+    {
+        TEST_SUCCESS(fluid_synth_noteon(synth, 0, 60, 127));
+        TEST_ASSERT(process(synth, fx_silent) > 0.01f);
+        TEST_ASSERT(!fx_silent[0] && !fx_silent[1] && !fx_silent[2] && !fx_silent[3]);
+
+        // let the voice and the effects fade out
+        TEST_SUCCESS(fluid_synth_noteoff(synth, 0, 60));
+
+        for(periods = 0; periods < 1000; periods++)
+        {
+            peak = process(synth, fx_silent);
+
+            if(fx_silent[0] && fx_silent[1] && fx_silent[2] && fx_silent[3])
+            {
+                break;
+            }
+
+            last_peak = peak;
+        }
+
+        TEST_ASSERT(periods < 1000);
+        // the units only stop once their tail is inaudible
+        TEST_ASSERT(last_peak < 1e-6f);
+    }
+
+    delete_fluid_synth(synth);
+    delete_fluid_settings(settings);
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,166 @@
+#include "test.h"
+#include "fluidsynth.h" // use local fluidsynth header
+#include "utils/fluid_sys.h"
+
+enum { BLOCKS = 48, FRAMES = 300, THREADS = 4, NOTES = 300, POLYPHONY = 256 };
+
+static float ref_left[BLOCKS * FRAMES], ref_right[BLOCKS * FRAMES];
+static float left[BLOCKS * FRAMES], right[BLOCKS * FRAMES];
+static fluid_voice_t *voices[POLYPHONY];
+
+static fluid_synth_t *create_synth(int queue_size)
+{
+    fluid_settings_t *settings = new_fluid_settings();
+    fluid_synth_t *synth;
+
+    TEST_ASSERT(settings != NULL);
+    TEST_SUCCESS(fluid_settings_setint(settings, "synth.midi-queue-size", queue_size));
+    TEST_SUCCESS(fluid_settings_setint(settings, "synth.polyphony", POLYPHONY));
+
+    synth = new_fluid_synth(settings);
+    TEST_ASSERT(synth != NULL);
+    TEST_ASSERT(fluid_synth_sfload(synth, TEST_SOUNDFONT, 1) != FLUID_FAILED);
+
+    return synth;
+}
+
+static void delete_synth(fluid_synth_t *synth)
+{
+    fluid_settings_t *settings = fluid_synth_get_settings(synth);
+
+    delete_fluid_synth(synth);
+    delete_fluid_settings(settings);
+}
+
+// plays a few notes and controller changes before every period
+static void render(int queue_size, float *l, float *r)
+{
+    fluid_synth_t *synth = create_synth(queue_size);
+    int blk, i, chan;
+
+    for(blk = 0; blk < BLOCKS; blk++)
+    {
+        chan = blk % 3;
+
+        if(blk % 4 == 0)
+        {
+            TEST_SUCCESS(fluid_synth_program_change(synth, chan, blk % 5));
+            TEST_SUCCESS(fluid_synth_noteon(synth, chan, 48 + blk % 24, 100));
+            TEST_SUCCESS(fluid_synth_noteon_at(synth, 70, chan, 60 + blk % 12, 90));
+        }
+
+        for(i = 0; i < 20; i++)
+        {
+            TEST_SUCCESS(fluid_synth_cc(synth, chan, 1, (blk * 7 + i) % 128));
+            TEST_SUCCESS(fluid_synth_pitch_bend(synth, chan, (blk * 500 + i * 37) % 16384));
+            TEST_SUCCESS(fluid_synth_channel_pressure(synth, chan, i % 128));
+            TEST_SUCCESS(fluid_synth_key_pressure(synth, chan, 48 + blk % 24, i % 128));
+        }
+
+        // getting a value applies the queued messages first
+        TEST_ASSERT(fluid_synth_get_cc(synth, chan, 1, &i) == FLUID_OK && i == (blk * 7 + 19) % 128);
+
+        if(blk % 8 == 6)
+        {
+            // (the note may have ended already, the queue can't tell)
+            fluid_synth_noteoff(synth, (blk - 6) % 3, 48 + (blk - 6) % 24);
+            fluid_synth_noteoff_at(synth, 130, (blk - 6) % 3, 60 + (blk - 6) % 12);
+        }
+
+        TEST_SUCCESS(fluid_synth_write_float(synth, FRAMES, l, blk * FRAMES, 1, r, blk * FRAMES, 1));
+    }
+
+    delete_synth(synth);
+}
+
+static fluid_atomic_int_t producers_done;
+
+static fluid_thread_return_t produce(void *data)
+{
+    fluid_synth_t *synth = (fluid_synth_t *)data;
+    int chan = fluid_atomic_int_add(&producers_done, 1);
+    int i;
+
+    for(i = 0; i < NOTES; i++)
+    {
+        // (the notes may run out of voices when handled right away)
+        fluid_synth_noteon(synth, chan, 40 + i % 40, 100);
+        TEST_SUCCESS(fluid_synth_cc(synth, chan, 7, i % 128));
+        fluid_synth_noteoff(synth, chan, 40 + i % 40);
+
+        // give the renderer a chance to keep up
+        if(i % 10 == 9)
+        {
+            fluid_msleep(1);
+        }
+    }
+
+    fluid_atomic_int_add(&producers_done, THREADS);
+    return FLUID_THREAD_RETURN_VALUE;
+}
+
+// this test makes sure that queued MIDI messages sound like the ones handled right away,
+// and that no message gets lost or reordered when several threads push them at once
+int main(void)
+{
+    fluid_thread_t *threads[THREADS];
+    fluid_synth_t *synth;
+    int i, val;
+
+    render(0, ref_left, ref_right);
+
+    // a queue large enough, and one that overflows all the time
+    render(1024, left, right);
+
+    for(i = 0; i < BLOCKS * FRAMES; i++)
+    {
+        TEST_ASSERT(left[i] == ref_left[i] && right[i] == ref_right[i]);
+    }
+
+    render(4, left, right);
+
+    for(i = 0; i < BLOCKS * FRAMES; i++)
+    {
+        TEST_ASSERT(left[i] == ref_left[i] && right[i] == ref_right[i]);
+    }
+
+    // several producers, while rendering
+    synth = create_synth(64);
+    fluid_atomic_int_set(&producers_done, 0);
+
+    for(i = 0; i < THREADS; i++)
+    {
+        threads[i] = new_fluid_thread("producer", produce, synth, 0, FALSE);
+        TEST_ASSERT(threads[i] != NULL);
+    }
+
+    while(fluid_atomic_int_get(&producers_done) < THREADS * (THREADS + 1))
+    {
+        TEST_SUCCESS(fluid_synth_write_float(synth, 64, left, 0, 1, right, 0, 1));
+    }
+
+    for(i = 0; i < THREADS; i++)
+    {
+        fluid_thread_join(threads[i]);
+        delete_fluid_thread(threads[i]);
+    }
+
+    TEST_SUCCESS(fluid_synth_write_float(synth, 64, left, 0, 1, right, 0, 1));
+
+    // every note-off came after its note-on
+    fluid_synth_get_voicelist(synth, voices, POLYPHONY, -1);
+
+    for(i = 0; i < POLYPHONY && voices[i] != NULL; i++)
+    {
+        TEST_ASSERT(!fluid_voice_is_on(voices[i]));
+    }
+
+    for(i = 0; i < THREADS; i++)
+    {
+        TEST_ASSERT(fluid_synth_get_cc(synth, i, 7, &val) == FLUID_OK && val == (NOTES - 1) % 128);
+    }
+
+    delete_synth(synth);
+
+    return EXIT_SUCCESS;
+}
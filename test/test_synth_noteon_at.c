@@ -0,0 +1,105 @@
+#include "test.h"
+#include "fluidsynth.h" // use local fluidsynth header
+#include "utils/fluid_sys.h"
+#include "midi/fluid_midi.h"
+
+enum { FRAMES = 4096, OFFSET = 150 };
+
+static float ref_left[FRAMES], ref_right[FRAMES];
+static float left[FRAMES], right[FRAMES];
+
+static fluid_synth_t *create_synth(fluid_settings_t *settings)
+{
+    fluid_synth_t *synth = new_fluid_synth(settings);
+
+    TEST_ASSERT(synth != NULL);
+    TEST_ASSERT(fluid_synth_sfload(synth, TEST_SOUNDFONT, 1) != FLUID_FAILED);
+
+    return synth;
+}
+
+static void render(fluid_synth_t *synth, int start, int len)
+{
+    TEST_SUCCESS(fluid_synth_write_float(synth, len, left, start, 1, right, start, 1));
+}
+
+// this test makes sure that notes can be started and released at a given frame
+int main(void)
+{
+    fluid_settings_t *settings = new_fluid_settings();
+    fluid_synth_t *synth;
+    fluid_midi_event_t *event;
+    int i, first;
+
+    TEST_ASSERT(settings != NULL);
+    TEST_SUCCESS(fluid_settings_setint(settings, "synth.reverb.active", 0));
+    TEST_SUCCESS(fluid_settings_setint(settings, "synth.chorus.active", 0));
+
+    synth = create_synth(settings);
+    TEST_ASSERT(fluid_synth_noteon_at(synth, -1, 0, 60, 100) == FLUID_FAILED);
+
+    // a note started at a block boundary sounds exactly like a note started
+    // right before rendering that block
+    TEST_SUCCESS(fluid_synth_noteon_at(synth, 2 * fluid_synth_get_internal_bufsize(synth), 0, 60, 100));
+    TEST_SUCCESS(fluid_synth_noteoff_at(synth, 1000, 0, 60));
+    render(synth, 0, FRAMES);
+    FLUID_MEMCPY(ref_left, left, sizeof(left));
+    FLUID_MEMCPY(ref_right, right, sizeof(right));
+    delete_fluid_synth(synth);
+
+    synth = create_synth(settings);
+    render(synth, 0, 2 * fluid_synth_get_internal_bufsize(synth));
+    TEST_SUCCESS(fluid_synth_noteon(synth, 0, 60, 100));
+    // the note-off is rounded to the nearest block boundary, i.e. frame 1024
+    render(synth, 2 * fluid_synth_get_internal_bufsize(synth), 1024 - 2 * fluid_synth_get_internal_bufsize(synth));
+    TEST_SUCCESS(fluid_synth_noteoff(synth, 0, 60));
+    render(synth, 1024, FRAMES - 1024);
+    delete_fluid_synth(synth);
+
+    for(i = 0; i < FRAMES; i++)
+    {
+        TEST_ASSERT(left[i] == ref_left[i] && right[i] == ref_right[i]);
+    }
+
+    // a note started within a block, while some frames of the last block are still buffered
+    synth = create_synth(settings);
+    render(synth, 0, 100);
+    TEST_SUCCESS(fluid_synth_noteon_at(synth, OFFSET - 100, 0, 60, 100));
+    render(synth, 100, FRAMES - 100);
+    delete_fluid_synth(synth);
+
+    for(first = 0; first < FRAMES && left[first] == 0 && right[first] == 0; first++)
+    {
+    }
+
+    TEST_ASSERT(first >= OFFSET);
+    TEST_ASSERT(first < OFFSET + 8);
+
+    // MIDI drivers pass the frame along with the event, which ends up at fluid_synth_noteon_at()
+    FLUID_MEMCPY(ref_left, left, sizeof(left));
+    FLUID_MEMCPY(ref_right, right, sizeof(right));
+
+    event = new_fluid_midi_event();
+    TEST_ASSERT(event != NULL);
+    TEST_SUCCESS(fluid_midi_event_set_type(event, NOTE_ON));
+    TEST_SUCCESS(fluid_midi_event_set_channel(event, 0));
+    TEST_SUCCESS(fluid_midi_event_set_key(event, 60));
+    TEST_SUCCESS(fluid_midi_event_set_velocity(event, 100));
+    event->frame_offset = OFFSET - 100;
+
+    synth = create_synth(settings);
+    render(synth, 0, 100);
+    TEST_SUCCESS(fluid_synth_handle_midi_event(synth, event));
+    render(synth, 100, FRAMES - 100);
+    delete_fluid_synth(synth);
+    delete_fluid_midi_event(event);
+
+    for(i = 0; i < FRAMES; i++)
+    {
+        TEST_ASSERT(left[i] == ref_left[i] && right[i] == ref_right[i]);
+    }
+
+    delete_fluid_settings(settings);
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,168 @@
+#include "test.h"
+#include "fluidsynth.h" // use local fluidsynth header
+#include "utils/fluid_sys.h"
+
+enum { POLYPHONY = 8 };
+
+static fluid_voice_t *voices[POLYPHONY];
+static float buf[1024];
+
+// counts the voices that are playing a given channel and key
+static int count_voices(fluid_synth_t *synth, int chan, int key)
+{
+    int i, count = 0;
+
+    fluid_synth_get_voicelist(synth, voices, POLYPHONY, -1);
+
+    for(i = 0; i < POLYPHONY && voices[i] != NULL; i++)
+    {
+        if(fluid_voice_is_playing(voices[i])
+                && fluid_voice_get_channel(voices[i]) == chan
+                && fluid_voice_get_key(voices[i]) == key)
+        {
+            count++;
+        }
+    }
+
+    return count;
+}
+
+static void render(fluid_synth_t *synth)
+{
+    TEST_SUCCESS(fluid_synth_write_float(synth, 256, buf, 0, 2, buf, 1, 2));
+}
+
+static void reset(fluid_synth_t *synth)
+{
+    int i;
+
+    // let the stolen voices fade out first, the mixer can only finish POLYPHONY voices at once
+    for(i = 0; i < 8; i++)
+    {
+        render(synth);
+    }
+
+    TEST_SUCCESS(fluid_synth_all_sounds_off(synth, -1));
+
+    for(i = 0; i < 8; i++)
+    {
+        render(synth);
+    }
+
+    fluid_synth_get_voicelist(synth, voices, POLYPHONY, -1);
+    TEST_ASSERT(voices[0] == NULL);
+}
+
+// this test makes sure that voices are stolen in the order of their overflow priority
+int main(void)
+{
+    fluid_settings_t *settings = new_fluid_settings();
+    fluid_synth_t *synth;
+    int per_note;
+
+    TEST_ASSERT(settings != NULL);
+    TEST_SUCCESS(fluid_settings_setint(settings, "synth.polyphony", POLYPHONY));
+    TEST_SUCCESS(fluid_settings_setint(settings, "synth.reverb.active", 0));
+    TEST_SUCCESS(fluid_settings_setint(settings, "synth.chorus.active", 0));
+
+    synth = new_fluid_synth(settings);
+    TEST_ASSERT(synth != NULL);
+    TEST_ASSERT(fluid_synth_sfload(synth, TEST_SOUNDFONT, 1) != FLUID_FAILED);
+
+    TEST_SUCCESS(fluid_synth_noteon(synth, 0, 60, 100));
+    per_note = count_voices(synth, 0, 60);
+    TEST_ASSERT(per_note > 0 && POLYPHONY % per_note == 0);
+    reset(synth);
+
+    // the oldest voice goes first
+    TEST_SUCCESS(fluid_synth_noteon(synth, 0, 60, 100));
+    render(synth);
+    TEST_SUCCESS(fluid_synth_noteon(synth, 0, 62, 100));
+    render(synth);
+    TEST_SUCCESS(fluid_synth_noteon(synth, 0, 64, 100));
+    render(synth);
+    TEST_SUCCESS(fluid_synth_noteon(synth, 0, 65, 100));
+    render(synth);
+    TEST_SUCCESS(fluid_synth_noteon(synth, 0, 67, 100));
+    TEST_ASSERT(count_voices(synth, 0, 60) == 0);
+    TEST_ASSERT(count_voices(synth, 0, 62) == per_note);
+    TEST_ASSERT(count_voices(synth, 0, 67) == per_note);
+    render(synth);
+
+    // from here on the age of the voices only breaks ties between the other scores
+    TEST_SUCCESS(fluid_settings_setnum(settings, "synth.overflow.age", 1));
+
+    // a released voice goes before an older held one
+    TEST_SUCCESS(fluid_synth_noteoff(synth, 0, 65));
+    TEST_SUCCESS(fluid_synth_noteon(synth, 0, 69, 100));
+    TEST_ASSERT(count_voices(synth, 0, 65) == 0);
+    TEST_ASSERT(count_voices(synth, 0, 62) == per_note);
+    TEST_ASSERT(count_voices(synth, 0, 69) == per_note);
+    reset(synth);
+
+    // a sustained voice goes before an older held one
+    TEST_SUCCESS(fluid_synth_noteon(synth, 0, 60, 100));
+    render(synth);
+    TEST_SUCCESS(fluid_synth_cc(synth, 1, 64, 127));
+    TEST_SUCCESS(fluid_synth_noteon(synth, 1, 62, 100));
+    TEST_SUCCESS(fluid_synth_noteoff(synth, 1, 62));
+    render(synth);
+    TEST_SUCCESS(fluid_synth_noteon(synth, 0, 64, 100));
+    TEST_SUCCESS(fluid_synth_noteon(synth, 0, 65, 100));
+    render(synth);
+    TEST_SUCCESS(fluid_synth_noteon(synth, 0, 67, 100));
+    TEST_ASSERT(count_voices(synth, 1, 62) == 0);
+    TEST_ASSERT(count_voices(synth, 0, 60) == per_note);
+    TEST_SUCCESS(fluid_synth_cc(synth, 1, 64, 0));
+    reset(synth);
+
+    // percussion and important channels are kept
+    // (a melodic preset on a drum channel, the drums of the test soundfont don't last)
+    TEST_SUCCESS(fluid_settings_setstr(settings, "synth.overflow.important-channels", "3"));
+    TEST_SUCCESS(fluid_synth_set_channel_type(synth, 3, CHANNEL_TYPE_DRUM));
+    TEST_SUCCESS(fluid_synth_noteon(synth, 3, 60, 100));
+    render(synth);
+    TEST_SUCCESS(fluid_synth_noteon(synth, 2, 60, 100));
+    render(synth);
+    TEST_SUCCESS(fluid_synth_noteon(synth, 0, 62, 100));
+    render(synth);
+    TEST_SUCCESS(fluid_synth_noteon(synth, 0, 64, 100));
+    render(synth);
+    TEST_SUCCESS(fluid_synth_noteon(synth, 0, 65, 100));
+    TEST_ASSERT(count_voices(synth, 3, 60) == per_note);
+    TEST_ASSERT(count_voices(synth, 2, 60) == per_note);
+    TEST_ASSERT(count_voices(synth, 0, 62) == 0);
+
+    // unless the channel is no longer important
+    TEST_SUCCESS(fluid_settings_setstr(settings, "synth.overflow.important-channels", ""));
+    TEST_SUCCESS(fluid_synth_noteon(synth, 0, 67, 100));
+    TEST_ASSERT(count_voices(synth, 2, 60) == 0);
+    TEST_ASSERT(count_voices(synth, 3, 60) == per_note);
+
+    // or a drum channel is turned into a melodic one
+    TEST_SUCCESS(fluid_synth_set_channel_type(synth, 3, CHANNEL_TYPE_MELODIC));
+    TEST_SUCCESS(fluid_synth_noteon(synth, 0, 69, 100));
+    TEST_ASSERT(count_voices(synth, 3, 60) == 0);
+    TEST_ASSERT(count_voices(synth, 0, 64) == per_note);
+    reset(synth);
+
+    // voices can be stolen after the polyphony has been raised
+    TEST_SUCCESS(fluid_synth_set_polyphony(synth, POLYPHONY / 2));
+    TEST_SUCCESS(fluid_synth_noteon(synth, 0, 60, 100));
+    render(synth);
+    TEST_SUCCESS(fluid_synth_noteon(synth, 0, 62, 100));
+    render(synth);
+    TEST_SUCCESS(fluid_synth_set_polyphony(synth, POLYPHONY));
+    TEST_SUCCESS(fluid_synth_noteon(synth, 0, 64, 100));
+    render(synth);
+    TEST_SUCCESS(fluid_synth_noteon(synth, 0, 65, 100));
+    render(synth);
+    TEST_SUCCESS(fluid_synth_noteon(synth, 0, 67, 100));
+    TEST_ASSERT(count_voices(synth, 0, 60) == 0);
+    TEST_ASSERT(count_voices(synth, 0, 62) == per_note);
+
+    delete_fluid_synth(synth);
+    delete_fluid_settings(settings);
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,129 @@
+#include "test.h"
+#include "fluidsynth.h" // use local fluidsynth header
+#include "utils/fluid_sys.h"
+
+enum { FRAMES = 1000, NOUT = 4, NFX = 4 };
+
+static float out_bufs[NOUT][FRAMES];
+static float fx_bufs[NFX][FRAMES];
+
+static void process(fluid_synth_t *synth, int out_silent[NOUT], int fx_silent[NFX])
+{
+    float *out[NOUT], *fx[NFX];
+    int i, j;
+
+    FLUID_MEMSET(out_bufs, 0, sizeof(out_bufs));
+    FLUID_MEMSET(fx_bufs, 0, sizeof(fx_bufs));
+
+    for(i = 0; i < NOUT; i++)
+    {
+        out[i] = out_bufs[i];
+    }
+
+    for(i = 0; i < NFX; i++)
+    {
+        fx[i] = fx_bufs[i];
+    }
+
+    TEST_SUCCESS(fluid_synth_process(synth, FRAMES, NFX, fx, NOUT, out));
+    TEST_SUCCESS(fluid_synth_get_silent_buffers(synth, NFX, fx_silent, NOUT, out_silent));
+
+    // buffers flagged silent must not have received anything
+    for(i = 0; i < NOUT; i++)
+    {
+        for(j = 0; out_silent[i] && j < FRAMES; j++)
+        {
+            TEST_ASSERT(out_bufs[i][j] == 0.0f);
+        }
+    }
+
+    for(i = 0; i < NFX; i++)
+    {
+        for(j = 0; fx_silent[i] && j < FRAMES; j++)
+        {
+            TEST_ASSERT(fx_bufs[i][j] == 0.0f);
+        }
+    }
+}
+
+// this test makes sure that fluid_synth_get_silent_buffers() reports the buffers that
+// fluid_synth_process() did not mix anything into
+int main(void)
+{
+    int out_silent[NOUT], fx_silent[NFX];
+    int i, j, audible;
+
+    fluid_settings_t *settings = new_fluid_settings();
+    fluid_synth_t *synth;
+
+    TEST_ASSERT(settings != NULL);
+    TEST_SUCCESS(fluid_settings_setint(settings, "synth.audio-channels", NOUT / 2));
+    TEST_SUCCESS(fluid_settings_setint(settings, "synth.audio-groups", NOUT / 2));
+    TEST_SUCCESS(fluid_settings_setint(settings, "synth.effects-channels", NFX / 2));
+    TEST_SUCCESS(fluid_settings_setint(settings, "synth.effects-groups", 1));
+
+    synth = new_fluid_synth(settings);
+    TEST_ASSERT(synth != NULL);
+    TEST_SUCCESS(fluid_synth_sfload(synth, TEST_SOUNDFONT, 1));
+
+    // invalid arguments
+    TEST_ASSERT(fluid_synth_get_silent_buffers(NULL, 0, NULL, 0, NULL) == FLUID_FAILED);
+    TEST_ASSERT(fluid_synth_get_silent_buffers(synth, 2, NULL, 0, NULL) == FLUID_FAILED);
+    TEST_ASSERT(fluid_synth_get_silent_buffers(synth, 0, NULL, 3, out_silent) == FLUID_FAILED);
+    TEST_ASSERT(fluid_synth_get_silent_buffers(synth, 0, NULL, NOUT + 2, out_silent) == FLUID_FAILED);
+
+    // nothing is playing yet: everything is silent
+    process(synth, out_silent, fx_silent);
+
+    for(i = 0; i < NOUT; i++)
+    {
+        TEST_ASSERT(out_silent[i]);
+    }
+
+    for(i = 0; i < NFX; i++)
+    {
+        TEST_ASSERT(fx_silent[i]);
+    }
+
+    // a note on MIDI channel 0 only sounds on the first audio channel
+    TEST_SUCCESS(fluid_synth_noteon(synth, 0, 60, 127));
+    process(synth, out_silent, fx_silent);
+
+    TEST_ASSERT(!out_silent[0]);
+    TEST_ASSERT(!out_silent[1]);
+    TEST_ASSERT(out_silent[2]);
+    TEST_ASSERT(out_silent[3]);
+
+    for(audible = FALSE, j = 0; j < FRAMES; j++)
+    {
+        audible |= (out_bufs[0][j] != 0.0f);
+    }
+
+    TEST_ASSERT(audible);
+
+    // the flags wrap around like the buffers do
+    TEST_SUCCESS(fluid_synth_get_silent_buffers(synth, 2, fx_silent, 2, out_silent));
+    TEST_ASSERT(!out_silent[0]);
+    TEST_ASSERT(!out_silent[1]);
+
+    // the reverb keeps sounding after the voice has finished, give it a few blocks to do so
+    TEST_SUCCESS(fluid_synth_all_sounds_off(synth, -1));
+
+    for(i = 0; i < 4; i++)
+    {
+        process(synth, out_silent, fx_silent);
+    }
+
+    for(i = 0; i < NOUT; i++)
+    {
+        TEST_ASSERT(out_silent[i]);
+    }
+
+    TEST_ASSERT(!fx_silent[0]);
+    TEST_ASSERT(!fx_silent[1]);
+
+    delete_fluid_synth(synth);
+    delete_fluid_settings(settings);
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,138 @@
+#include "test.h"
+#include "fluidsynth.h" // use local fluidsynth header
+#include "utils/fluid_sys.h"
+
+enum { POLYPHONY = 512, CHANNELS = 16, KEYS = 100 };
+
+static fluid_voice_t *voices[POLYPHONY];
+static float buf[1024];
+
+// counts the voices that are on, optionally only those of a given channel and key
+static int count_voices(fluid_synth_t *synth, int chan, int key)
+{
+    int i, count = 0;
+
+    fluid_synth_get_voicelist(synth, voices, POLYPHONY, -1);
+
+    for(i = 0; i < POLYPHONY && voices[i] != NULL; i++)
+    {
+        if(fluid_voice_is_on(voices[i])
+                && (chan < 0 || fluid_voice_get_channel(voices[i]) == chan)
+                && (key < 0 || fluid_voice_get_key(voices[i]) == key))
+        {
+            count++;
+        }
+    }
+
+    return count;
+}
+
+static void render(fluid_synth_t *synth)
+{
+    TEST_SUCCESS(fluid_synth_write_float(synth, 512, buf, 0, 2, buf, 1, 2));
+}
+
+// this test makes sure that note and channel messages reach exactly the voices they refer to
+int main(void)
+{
+    fluid_settings_t *settings = new_fluid_settings();
+    fluid_synth_t *synth;
+    int chan, key, per_note;
+
+    TEST_ASSERT(settings != NULL);
+    TEST_SUCCESS(fluid_settings_setint(settings, "synth.polyphony", POLYPHONY));
+    TEST_SUCCESS(fluid_settings_setint(settings, "synth.midi-channels", CHANNELS));
+
+    synth = new_fluid_synth(settings);
+    TEST_ASSERT(synth != NULL);
+    TEST_ASSERT(fluid_synth_sfload(synth, TEST_SOUNDFONT, 1) != FLUID_FAILED);
+
+    // a voice retriggered in legato mode moves to its new key
+    TEST_SUCCESS(fluid_synth_reset_basic_channel(synth, -1));
+    TEST_SUCCESS(fluid_synth_set_basic_channel(synth, 0, FLUID_CHANNEL_MODE_OMNIOFF_MONO, 1));
+    TEST_SUCCESS(fluid_synth_set_legato_mode(synth, 0, FLUID_CHANNEL_LEGATO_MODE_MULTI_RETRIGGER));
+    TEST_SUCCESS(fluid_synth_noteon(synth, 0, 60, 100));
+    TEST_SUCCESS(fluid_synth_noteon(synth, 0, 62, 100));
+    TEST_ASSERT(count_voices(synth, 0, 60) == 0);
+    TEST_ASSERT(count_voices(synth, 0, 62) > 0);
+    TEST_SUCCESS(fluid_synth_noteoff(synth, 0, 60));
+    TEST_ASSERT(count_voices(synth, 0, 62) > 0);
+    TEST_SUCCESS(fluid_synth_noteoff(synth, 0, 62));
+    TEST_ASSERT(count_voices(synth, -1, -1) == 0);
+    TEST_SUCCESS(fluid_synth_reset_basic_channel(synth, -1));
+    TEST_SUCCESS(fluid_synth_set_basic_channel(synth, 0, FLUID_CHANNEL_MODE_OMNION_POLY, CHANNELS));
+    render(synth);
+
+    TEST_SUCCESS(fluid_synth_noteon(synth, 0, 60, 100));
+    per_note = count_voices(synth, 0, 60);
+    TEST_ASSERT(per_note > 0);
+
+    // a few notes on every melodic channel
+    for(chan = 0; chan < CHANNELS; chan++)
+    {
+        if(chan == 9)
+        {
+            continue;
+        }
+
+        for(key = 60; key < 64; key++)
+        {
+            TEST_SUCCESS(fluid_synth_noteon(synth, chan, key, 100));
+        }
+    }
+
+    render(synth);
+    TEST_ASSERT(count_voices(synth, -1, -1) == (CHANNELS - 1) * 4 * per_note);
+
+    // a note-off only releases its own note
+    TEST_SUCCESS(fluid_synth_noteoff(synth, 3, 61));
+    TEST_ASSERT(count_voices(synth, 3, 61) == 0);
+    TEST_ASSERT(count_voices(synth, 3, -1) == 3 * per_note);
+    TEST_ASSERT(count_voices(synth, 4, 61) == per_note);
+
+    // sustained notes are released with the pedal of their own channel
+    TEST_SUCCESS(fluid_synth_cc(synth, 5, 64, 127));
+    TEST_SUCCESS(fluid_synth_noteoff(synth, 5, 60));
+    TEST_ASSERT(count_voices(synth, 5, -1) == 3 * per_note);
+    TEST_SUCCESS(fluid_synth_cc(synth, 6, 64, 0));
+    TEST_ASSERT(count_voices(synth, 5, -1) == 3 * per_note);
+    TEST_SUCCESS(fluid_synth_cc(synth, 5, 64, 0));
+    TEST_ASSERT(count_voices(synth, 5, 60) == 0);
+    TEST_ASSERT(count_voices(synth, 5, -1) == 3 * per_note);
+
+    // all notes off only affects its channel
+    TEST_SUCCESS(fluid_synth_all_notes_off(synth, 7));
+    TEST_ASSERT(count_voices(synth, 7, -1) == 0);
+    TEST_ASSERT(count_voices(synth, 8, -1) == 4 * per_note);
+
+    // voices are reused once they have finished, the index must follow
+    TEST_SUCCESS(fluid_synth_all_sounds_off(synth, -1));
+    render(synth);
+    TEST_ASSERT(count_voices(synth, -1, -1) == 0);
+
+    // (the test soundfont has no zones above KEYS)
+    for(key = 0; key < KEYS; key++)
+    {
+        TEST_SUCCESS(fluid_synth_noteon(synth, 2, key, 100));
+    }
+
+    for(key = 0; key < KEYS; key += 2)
+    {
+        TEST_SUCCESS(fluid_synth_noteoff(synth, 2, key));
+    }
+
+    TEST_ASSERT(count_voices(synth, 2, -1) == KEYS / 2 * per_note);
+
+    for(key = 1; key < KEYS; key += 2)
+    {
+        TEST_ASSERT(count_voices(synth, 2, key) == per_note);
+        TEST_SUCCESS(fluid_synth_noteoff(synth, 2, key));
+    }
+
+    TEST_ASSERT(count_voices(synth, -1, -1) == 0);
+
+    delete_fluid_synth(synth);
+    delete_fluid_settings(settings);
+
+    return EXIT_SUCCESS;
+}
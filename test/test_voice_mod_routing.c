@@ -0,0 +1,126 @@
+#include "test.h"
+#include "fluidsynth.h"
+#include "synth/fluid_synth.h"
+#include "synth/fluid_voice.h"
+#include "synth/fluid_mod.h"
+#include "utils/fluid_sys.h"
+
+enum { MAX_VOICES = 16 };
+
+static fluid_voice_t *voices[MAX_VOICES];
+
+// every generator must carry the sum of the modulators writing to it, in their order
+static void verify_modulation(fluid_synth_t *synth)
+{
+    int i, k, gen, n = 0;
+
+    fluid_synth_get_voicelist(synth, voices, MAX_VOICES, -1);
+
+    for(i = 0; i < MAX_VOICES && voices[i] != NULL; i++)
+    {
+        fluid_voice_t *voice = voices[i];
+
+        for(gen = 0; gen < GEN_LAST; gen++)
+        {
+            fluid_real_t modval = 0.0;
+
+            for(k = 0; k < voice->mod_count; k++)
+            {
+                if(fluid_mod_has_dest(&voice->mod[k], gen))
+                {
+                    modval += fluid_mod_get_value(&voice->mod[k], voice);
+                }
+            }
+
+            TEST_ASSERT(voice->gen[gen].mod == modval);
+        }
+
+        n++;
+    }
+
+    TEST_ASSERT(n > 0);
+}
+
+static void add_mod(fluid_synth_t *synth, int src1, int flags1, int src2, int flags2, int dest, double amount)
+{
+    fluid_mod_t *mod = new_fluid_mod();
+
+    TEST_ASSERT(mod != NULL);
+    fluid_mod_set_source1(mod, src1, flags1);
+    fluid_mod_set_source2(mod, src2, flags2);
+    fluid_mod_set_dest(mod, dest);
+    fluid_mod_set_amount(mod, amount);
+    TEST_SUCCESS(fluid_synth_add_default_mod(synth, mod, FLUID_SYNTH_ADD));
+    delete_fluid_mod(mod);
+}
+
+// this test makes sure that controller changes reach all the generators modulated by them, and only them
+int main(void)
+{
+    static const int ccs[] = { 1, 2, 7, 10, 11, 20, 21, 71, 74, 91, 93 };
+    fluid_settings_t *settings = new_fluid_settings();
+    fluid_synth_t *synth;
+    fluid_mod_t *mod;
+    int i, val;
+
+    TEST_ASSERT(settings != NULL);
+    synth = new_fluid_synth(settings);
+    TEST_ASSERT(synth != NULL);
+    TEST_ASSERT(fluid_synth_sfload(synth, TEST_SOUNDFONT, 1) != FLUID_FAILED);
+
+    // a CC and the pitch wheel on the same generator as the default modulators
+    add_mod(synth, 20, FLUID_MOD_CC | FLUID_MOD_UNIPOLAR | FLUID_MOD_POSITIVE,
+            FLUID_MOD_PITCHWHEEL, FLUID_MOD_GC | FLUID_MOD_BIPOLAR | FLUID_MOD_POSITIVE,
+            GEN_FILTERFC, 1000);
+    // the same CC twice
+    add_mod(synth, 20, FLUID_MOD_CC | FLUID_MOD_BIPOLAR | FLUID_MOD_POSITIVE,
+            20, FLUID_MOD_CC | FLUID_MOD_UNIPOLAR | FLUID_MOD_NEGATIVE,
+            GEN_PAN, 300);
+    // a CC whose number is also a general controller
+    add_mod(synth, FLUID_MOD_CHANNELPRESSURE, FLUID_MOD_CC | FLUID_MOD_UNIPOLAR | FLUID_MOD_POSITIVE,
+            FLUID_MOD_NONE, FLUID_MOD_GC,
+            GEN_ATTENUATION, 200);
+
+    TEST_SUCCESS(fluid_synth_noteon(synth, 0, 60, 100));
+    TEST_SUCCESS(fluid_synth_noteon(synth, 0, 64, 80));
+    verify_modulation(synth);
+
+    for(val = 0; val < 128; val += 37)
+    {
+        for(i = 0; i < (int)(sizeof(ccs) / sizeof(ccs[0])); i++)
+        {
+            TEST_SUCCESS(fluid_synth_cc(synth, 0, ccs[i], val));
+            verify_modulation(synth);
+        }
+
+        TEST_SUCCESS(fluid_synth_pitch_bend(synth, 0, val * 128));
+        verify_modulation(synth);
+        TEST_SUCCESS(fluid_synth_channel_pressure(synth, 0, val));
+        verify_modulation(synth);
+        TEST_SUCCESS(fluid_synth_key_pressure(synth, 0, 60, val));
+        verify_modulation(synth);
+        TEST_SUCCESS(fluid_synth_pitch_wheel_sens(synth, 0, val / 8));
+        verify_modulation(synth);
+    }
+
+    // a modulator added to a playing voice is routed as well
+    fluid_synth_get_voicelist(synth, voices, MAX_VOICES, -1);
+    TEST_ASSERT(voices[0] != NULL);
+    mod = new_fluid_mod();
+    TEST_ASSERT(mod != NULL);
+    fluid_mod_set_source1(mod, 22, FLUID_MOD_CC | FLUID_MOD_UNIPOLAR | FLUID_MOD_POSITIVE);
+    fluid_mod_set_source2(mod, FLUID_MOD_NONE, FLUID_MOD_GC);
+    fluid_mod_set_dest(mod, GEN_REVERBSEND);
+    fluid_mod_set_amount(mod, 500);
+    fluid_voice_add_mod(voices[0], mod, FLUID_VOICE_ADD);
+    delete_fluid_mod(mod);
+
+    TEST_SUCCESS(fluid_synth_cc(synth, 0, 22, 100));
+    verify_modulation(synth);
+    TEST_ASSERT(voices[0]->gen[GEN_REVERBSEND].mod > 0);
+
+    delete_fluid_synth(synth);
+    delete_fluid_settings(settings);
+
+    return EXIT_SUCCESS;
+}